@@ -0,0 +1,88 @@
+#include "base/eventing/file/chrome_trace.h"
+
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace vertexai {
+namespace eventing {
+namespace file {
+namespace {
+
+double ToMicros(const google::protobuf::Duration& duration) {
+  return duration.seconds() * 1e6 + duration.nanos() / 1e3;
+}
+
+std::string JsonEscape(const std::string& str) {
+  std::ostringstream escaped;
+  for (char c : str) {
+    switch (c) {
+      case '"':
+        escaped << "\\\"";
+        break;
+      case '\\':
+        escaped << "\\\\";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          escaped << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        } else {
+          escaped << c;
+        }
+    }
+  }
+  return escaped.str();
+}
+
+}  // namespace
+
+ChromeTrace::ChromeTrace(const std::string& filename) : out_{filename} {
+  if (!out_) {
+    throw std::runtime_error(std::string("unable to open \"") + filename + "\" for writing");
+  }
+  out_ << std::fixed << std::setprecision(3) << "[";
+}
+
+ChromeTrace::~ChromeTrace() { Close(); }
+
+void ChromeTrace::Add(int tid, const context::proto::Event& event) {
+  auto index = event.activity_id().index();
+  if (event.verb().size() && event.has_start_time()) {
+    Pending activity{event.verb(), ToMicros(event.start_time()), event.clock_id().index(), tid};
+    if (event.has_end_time()) {
+      Write(activity, ToMicros(event.end_time()));
+    } else {
+      pending_.emplace(index, std::move(activity));
+    }
+    return;
+  }
+  if (event.has_end_time()) {
+    auto it = pending_.find(index);
+    if (it != pending_.end()) {
+      Write(it->second, ToMicros(event.end_time()));
+      pending_.erase(it);
+    }
+  }
+}
+
+void ChromeTrace::Close() {
+  if (!out_.is_open()) {
+    return;
+  }
+  out_ << "\n]\n";
+  out_.close();
+  pending_.clear();
+}
+
+void ChromeTrace::Write(const Pending& activity, double end_us) {
+  out_ << (first_ ? "\n" : ",\n");
+  first_ = false;
+  out_ << R"({"name":")" << JsonEscape(activity.verb) << R"(","cat":"plaidml","ph":"X","ts":)" << activity.start_us
+       << R"(,"dur":)" << (end_us - activity.start_us) << R"(,"pid":)" << activity.clock << R"(,"tid":)"
+       << activity.tid << "}";
+}
+
+}  // namespace file
+}  // namespace eventing
+}  // namespace vertexai
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+
+#include "base/context/context.pb.h"
+
+namespace vertexai {
+namespace eventing {
+namespace file {
+
+// Writes activities in Chrome trace_event JSON format (as read by chrome://tracing and Perfetto).
+//
+// Activities are usually logged as a start event followed later by a completion event carrying only the activity's
+// index and end time; each pair is written as a single complete ("X") event once the completion arrives.  Activities
+// timed by different clocks are placed in different processes, since their timestamps are not comparable.
+//
+// This class must be externally synchronized.
+class ChromeTrace final {
+ public:
+  explicit ChromeTrace(const std::string& filename);
+  ~ChromeTrace();
+
+  // Adds an event logged by the thread with the supplied index.
+  void Add(int tid, const context::proto::Event& event);
+
+  // Terminates the trace; activities that have not completed are not written.
+  void Close();
+
+ private:
+  struct Pending {
+    std::string verb;
+    double start_us;
+    std::uint64_t clock;
+    int tid;
+  };
+
+  void Write(const Pending& activity, double end_us);
+
+  std::ofstream out_;
+  bool first_ = true;
+  std::unordered_map<std::uint64_t, Pending> pending_;
+};
+
+}  // namespace file
+}  // namespace eventing
+}  // namespace vertexai
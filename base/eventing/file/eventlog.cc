@@ -1,11 +1,14 @@
 #include "base/eventing/file/eventlog.h"
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <utility>
 
 #include "base/util/compat.h"
 #include "base/util/logging.h"
+#include "base/util/perf_counter.h"
 #include "base/util/uuid.h"
 
 namespace gpi = google::protobuf::io;
@@ -13,44 +16,204 @@ namespace gpi = google::protobuf::io;
 namespace vertexai {
 namespace eventing {
 namespace file {
+namespace {
+
+PerfCounter eventlog_dropped_events("eventlog_dropped_events");
+
+constexpr std::size_t kDefaultRingCapacity = 4096;
+
+// How often the background writer drains the rings.
+constexpr std::chrono::milliseconds kDrainPeriod{20};
+
+// Compress in large blocks when writing in the background, since the writer thread is the only one waiting.
+constexpr int kAsyncGzipBufferSize = 1 << 20;
+
+std::atomic<std::uint64_t> next_log_id{1};
+std::atomic<int> next_thread_index{1};
+
+// A small, stable index for the calling thread, used as its thread ID in traces.
+int ThreadIndex() {
+  thread_local int index = next_thread_index++;
+  return index;
+}
+
+gpi::GzipOutputStream::Options GzipOptions(const proto::EventLog& config) {
+  gpi::GzipOutputStream::Options options;
+  if (config.async()) {
+    options.buffer_size = kAsyncGzipBufferSize;
+  }
+  return options;
+}
+
+}  // namespace
+
+// A single-producer, single-consumer ring of events: the producer is the thread that owns it, and the consumer is
+// the log's writer thread.
+class EventLog::Ring final {
+ public:
+  explicit Ring(std::size_t capacity) : tid_{ThreadIndex()} {
+    std::size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    slots_.resize(size);
+  }
+
+  // Queues the event, returning false if the ring is full.
+  bool Push(context::proto::Event* event) {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == slots_.size()) {
+      return false;
+    }
+    slots_[tail & (slots_.size() - 1)].Swap(event);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Passes each queued event to fn, in order.
+  template <typename F>
+  void Drain(const F& fn) {
+    auto head = head_.load(std::memory_order_relaxed);
+    auto tail = tail_.load(std::memory_order_acquire);
+    for (; head != tail; ++head) {
+      auto slot = &slots_[head & (slots_.size() - 1)];
+      fn(tid_, slot);
+      slot->Clear();
+    }
+    head_.store(head, std::memory_order_release);
+  }
+
+  bool Empty() const { return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire); }
+
+ private:
+  int tid_;
+  std::vector<context::proto::Event> slots_;
+  std::atomic<std::size_t> head_{0};
+  std::atomic<std::size_t> tail_{0};
+};
 
 EventLog::EventLog(const proto::EventLog& config)
     : config_{config},
+      log_id_{next_log_id++},
       std_file_out_{config.filename(), std::ios::binary},
       ostr_out_{std::make_unique<gpi::OstreamOutputStream>(&std_file_out_)},
-      gzip_out_{std::make_unique<gpi::GzipOutputStream>(ostr_out_.get(), gpi::GzipOutputStream::Options())},
+      gzip_out_{std::make_unique<gpi::GzipOutputStream>(ostr_out_.get(), GzipOptions(config))},
       coded_out_{std::make_unique<gpi::CodedOutputStream>(gzip_out_.get())} {
   if (!std_file_out_) {
     throw std::runtime_error(std::string("unable to open \"") + config.filename() + "\" for writing");
   }
   LOG(INFO) << "Writing event log to " << config.filename();
+  if (config.chrome_trace_filename().size()) {
+    trace_ = std::make_unique<ChromeTrace>(config.chrome_trace_filename());
+    LOG(INFO) << "Writing Chrome trace to " << config.chrome_trace_filename();
+  }
   proto::Record record;
   record.mutable_magic()->set_value(proto::Magic::Eventlog);
   LogRecordLocked(std::move(record));
+  if (config.async()) {
+    writer_ = std::thread{[this] { WriterLoop(); }};
+  }
 }
 
 EventLog::~EventLog() { FlushAndClose(); }
 
 void EventLog::LogEvent(context::proto::Event event) {
+  if (config_.async()) {
+    if (stopping_) {
+      return;
+    }
+    if (!ThreadRing()->Push(&event)) {
+      dropped_++;
+      eventlog_dropped_events.inc();
+    }
+    return;
+  }
   std::lock_guard<std::mutex> lock{mu_};
   if (closed_) {
     return;
   }
+  proto::Record record;
+  WriteEventLocked(ThreadIndex(), &event, &record);
+  LogRecordLocked(std::move(record));
+}
+
+EventLog::Ring* EventLog::ThreadRing() {
+  struct Cached {
+    std::uint64_t log_id = 0;
+    std::shared_ptr<Ring> ring;
+  };
+  thread_local Cached cached;
+  if (cached.log_id != log_id_) {
+    auto capacity = config_.ring_capacity() ? config_.ring_capacity() : kDefaultRingCapacity;
+    cached.ring = std::make_shared<Ring>(capacity);
+    cached.log_id = log_id_;
+    std::lock_guard<std::mutex> lock{rings_mu_};
+    rings_.emplace_back(cached.ring);
+  }
+  return cached.ring.get();
+}
+
+void EventLog::WriterLoop() {
+  std::unique_lock<std::mutex> lock{mu_};
+  while (!stopping_) {
+    cv_.wait_for(lock, kDrainPeriod);
+    DrainLocked();
+  }
+  DrainLocked();
+}
+
+void EventLog::DrainLocked() {
+  std::vector<std::shared_ptr<Ring>> rings;
+  {
+    std::lock_guard<std::mutex> lock{rings_mu_};
+    rings = rings_;
+  }
+  proto::Record record;
+  for (const auto& ring : rings) {
+    ring->Drain([&](int tid, context::proto::Event* event) { WriteEventLocked(tid, event, &record); });
+  }
+  if (record.event_size()) {
+    LogRecordLocked(std::move(record));
+  }
+  {
+    // Forget the rings of threads that have exited, once everything they queued has been written.
+    std::lock_guard<std::mutex> lock{rings_mu_};
+    rings.clear();
+    auto exited = [](const std::shared_ptr<Ring>& ring) { return ring.use_count() == 1 && ring->Empty(); };
+    rings_.erase(std::remove_if(rings_.begin(), rings_.end(), exited), rings_.end());
+  }
+}
+
+void EventLog::WriteEventLocked(int tid, context::proto::Event* event, proto::Record* record) {
   if (!wrote_uuid_) {
-    event.mutable_activity_id()->set_stream_uuid(ToByteString(stream_uuid()));
+    event->mutable_activity_id()->set_stream_uuid(ToByteString(stream_uuid()));
     wrote_uuid_ = true;
   }
-  proto::Record record;
-  *record.add_event() = std::move(event);
-  LogRecordLocked(std::move(record));
+  if (trace_) {
+    trace_->Add(tid, *event);
+  }
+  record->add_event()->Swap(event);
 }
 
 void EventLog::FlushAndClose() {
+  std::call_once(stop_once_, [this] {
+    {
+      std::lock_guard<std::mutex> lock{mu_};
+      stopping_ = true;
+    }
+    cv_.notify_all();
+    if (writer_.joinable()) {
+      writer_.join();
+    }
+  });
   std::lock_guard<std::mutex> lock{mu_};
   if (closed_) {
     return;
   }
   closed_ = true;
+  if (trace_) {
+    trace_->Close();
+  }
   coded_out_.reset();
   gzip_out_.reset();
   ostr_out_.reset();
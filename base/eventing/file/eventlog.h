@@ -4,18 +4,29 @@
 #include <google/protobuf/io/gzip_stream.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <fstream>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "base/context/eventlog.h"
+#include "base/eventing/file/chrome_trace.h"
 #include "base/eventing/file/eventlog.pb.h"
 
 namespace vertexai {
 namespace eventing {
 namespace file {
 
+// Writes events to a gzipped file of length-prefixed Record messages.
+//
+// By default, events are written on the logging thread.  In asynchronous mode, each logging thread instead queues
+// its events on its own single-producer ring buffer, which a background thread drains periodically, writing each
+// drain as one Record; logging an event then never takes a lock or compresses anything.
 class EventLog final : public context::EventLog {
  public:
   explicit EventLog(const proto::EventLog& config);
@@ -25,13 +36,40 @@ class EventLog final : public context::EventLog {
 
   void FlushAndClose() override;
 
+  // The number of events dropped because their thread's ring buffer was full.
+  std::uint64_t dropped_events() const { return dropped_; }
+
  private:
+  class Ring;
+
+  // Returns the calling thread's ring, creating it if needed.
+  Ring* ThreadRing();
+
+  void WriterLoop();
+
+  void DrainLocked();
+
+  void WriteEventLocked(int tid, context::proto::Event* event, proto::Record* record);
+
   void LogRecordLocked(proto::Record record);
 
   // The client configuration.
   proto::EventLog config_;
 
+  // Distinguishes this log from any other the process creates, so that threads can cache their rings.
+  std::uint64_t log_id_;
+
   std::mutex mu_;
+  std::condition_variable cv_;
+  std::atomic<bool> stopping_{false};
+  std::atomic<std::uint64_t> dropped_{0};
+  std::once_flag stop_once_;
+  std::thread writer_;
+
+  std::mutex rings_mu_;
+  std::vector<std::shared_ptr<Ring>> rings_;
+
+  std::unique_ptr<ChromeTrace> trace_;
 
   // The output stream chain.  Note that for portability, we use a OstreamOutputStream; if this becomes an issue,
   // FileOutputStream is slightly faster.
@@ -2,7 +2,11 @@
 #include <gtest/gtest.h>
 
 #include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include "base/eventing/file/eventlog.h"
 #include "base/eventing/file/eventlog.pb.h"
@@ -12,6 +16,7 @@
 
 using ::testing::Eq;
 using ::testing::EqualsProtoText;
+using ::testing::HasSubstr;
 
 namespace vertexai {
 namespace eventing {
@@ -19,6 +24,7 @@ namespace file {
 namespace {
 
 constexpr static char kTestFilename[] = "eventlog.gz";
+constexpr static char kTraceFilename[] = "eventlog.json";
 
 class EventLogTest : public ::testing::Test {
  protected:
@@ -49,6 +55,78 @@ TEST_F(EventLogTest, CanReport) {
   }
 }
 
+TEST(AsyncEventLogTest, WritesEventsFromEveryThread) {
+  proto::EventLog config;
+  config.set_filename(kTestFilename);
+  config.set_async(true);
+  {
+    EventLog eventlog{config};
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < 4; ++tid) {
+      threads.emplace_back([&eventlog]() {
+        for (int idx = 0; idx < 100; ++idx) {
+          context::proto::Event event;
+          event.set_verb("Event");
+          eventlog.LogEvent(std::move(event));
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    EXPECT_THAT(eventlog.dropped_events(), Eq(0));
+  }
+
+  Reader reader{kTestFilename};
+  context::proto::Event event;
+  int count = 0;
+  while (reader.Read(&event)) {
+    EXPECT_THAT(event.verb(), Eq("Event"));
+    count++;
+  }
+  EXPECT_THAT(count, Eq(400));
+}
+
+TEST(AsyncEventLogTest, DropsEventsWhenRingIsFull) {
+  proto::EventLog config;
+  config.set_filename(kTestFilename);
+  config.set_async(true);
+  config.set_ring_capacity(4);
+  EventLog eventlog{config};
+  std::uint64_t logged = 0;
+  // The writer drains periodically, so a burst much larger than the ring must overflow it.
+  for (int idx = 0; idx < 100000 && !eventlog.dropped_events(); ++idx) {
+    eventlog.LogEvent(context::proto::Event{});
+    logged++;
+  }
+  EXPECT_THAT(eventlog.dropped_events() > 0, Eq(true));
+  EXPECT_THAT(eventlog.dropped_events() <= logged, Eq(true));
+}
+
+TEST(ChromeTraceTest, PairsActivityStartsAndEnds) {
+  proto::EventLog config;
+  config.set_filename(kTestFilename);
+  config.set_chrome_trace_filename(kTraceFilename);
+  {
+    EventLog eventlog{config};
+    context::proto::Event start;
+    start.mutable_activity_id()->set_index(7);
+    start.set_verb("tile::\"Run\"");
+    start.mutable_start_time()->set_seconds(1);
+    eventlog.LogEvent(std::move(start));
+    context::proto::Event end;
+    end.mutable_activity_id()->set_index(7);
+    end.mutable_end_time()->set_seconds(1);
+    end.mutable_end_time()->set_nanos(2500);
+    eventlog.LogEvent(std::move(end));
+  }
+
+  std::ifstream in{kTraceFilename};
+  std::string trace{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+  EXPECT_THAT(trace, HasSubstr(R"({"name":"tile::\"Run\"","cat":"plaidml","ph":"X","ts":1000000.000,"dur":2.500,)"));
+  EXPECT_THAT(trace.back(), Eq('\n'));
+}
+
 }  // namespace
 }  // namespace file
 }  // namespace eventing
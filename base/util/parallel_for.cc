@@ -0,0 +1,40 @@
+// Copyright 2020 Intel Corporation.
+
+#include "base/util/parallel_for.h"
+
+#include <algorithm>
+#include <exception>
+#include <vector>
+
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+
+namespace vertexai {
+
+void ParallelFor(std::size_t count, std::size_t parallelism, const std::function<void(std::size_t)>& task) {
+  std::vector<std::exception_ptr> errors(count);
+  auto run = [&](std::size_t i) {
+    try {
+      task(i);
+    } catch (...) {
+      errors[i] = std::current_exception();
+    }
+  };
+  std::size_t workers = std::min(count, parallelism);
+  if (workers > 1) {
+    // The arena only caps how many of the shared workers this loop may occupy; it does not start threads of its own.
+    tbb::task_arena arena(static_cast<int>(workers));
+    arena.execute([&] { tbb::parallel_for(std::size_t{0}, count, run); });
+  } else {
+    for (std::size_t i = 0; i < count; ++i) {
+      run(i);
+    }
+  }
+  for (const auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+}  // namespace vertexai
@@ -0,0 +1,15 @@
+// Copyright 2020 Intel Corporation.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace vertexai {
+
+// Runs task(i) for each i in [0, count) on up to 'parallelism' threads of the process-wide TBB worker pool; the
+// calling thread takes part, and nested calls share the same workers.  Every task runs even if an earlier one throws;
+// once all are done, the exception from the lowest-numbered failing task is rethrown.
+void ParallelFor(std::size_t count, std::size_t parallelism, const std::function<void(std::size_t)>& task);
+
+}  // namespace vertexai
@@ -0,0 +1,17 @@
+// Copyright 2020, Intel Corporation
+
+#include "base/util/symbol.h"
+
+#include "base/util/intern.h"
+
+namespace vertexai {
+
+Symbol::Symbol() {
+  // Never destroyed, so that the empty symbol (the value of every default-constructed symbol) is interned only once.
+  static const auto* empty = new std::shared_ptr<const Name>(Interned<Name>::make(std::string()));
+  name_ = *empty;
+}
+
+Symbol::Symbol(const std::string& str) : name_{Interned<Name>::make(str)} {}
+
+}  // namespace vertexai
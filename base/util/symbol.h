@@ -0,0 +1,122 @@
+// Copyright 2020, Intel Corporation
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace vertexai {
+
+// An interned string.
+//
+// Every live Symbol with a given spelling refers to the same copy of it, interned through Interned<T>, so symbols
+// compare equal (and hash) by identity, and copying one copies a reference-counted pointer.  Interning takes a lock, so
+// hot paths should construct a Symbol once and reuse it rather than converting strings repeatedly.  A spelling is
+// released once no symbol refers to it.
+class Symbol {
+ public:
+  Symbol();  // The empty string
+  explicit Symbol(const std::string& str);
+  explicit Symbol(const char* str) : Symbol(std::string(str)) {}
+
+  const std::string& str() const { return name_->str; }
+  bool empty() const { return name_->str.empty(); }
+
+  bool operator==(const Symbol& rhs) const { return name_ == rhs.name_; }
+  bool operator!=(const Symbol& rhs) const { return name_ != rhs.name_; }
+
+  // Symbols order as their strings do, so that containers keyed by symbols iterate in a stable, readable order.
+  bool operator<(const Symbol& rhs) const { return name_ != rhs.name_ && name_->str < rhs.name_->str; }
+
+  std::size_t hash() const { return std::hash<std::shared_ptr<const Name>>()(name_); }
+
+  // The free operators are hidden friends, found only for symbols, so that they don't hide other overloads of the same
+  // operators from code anywhere in the vertexai namespace.
+  friend std::ostream& operator<<(std::ostream& os, const Symbol& sym) { return os << sym.str(); }
+  friend std::string to_string(const Symbol& sym) { return sym.str(); }
+
+ private:
+  struct Name {
+    std::string str;
+  };
+
+  std::shared_ptr<const Name> name_;
+};
+
+// A string field of the IR, stored as a Symbol.
+//
+// It reads as a const std::string& and is assigned from strings, so IR fields can be interned without changing the
+// code that uses them.  Copying one copies a Symbol, and comparing two compares their identities.
+class InternedString {
+ public:
+  InternedString() = default;
+  InternedString(const std::string& str) : sym_{str} {}  // NOLINT(runtime/explicit)
+  InternedString(const char* str) : sym_{str} {}         // NOLINT(runtime/explicit)
+  explicit InternedString(const Symbol& sym) : sym_{sym} {}
+
+  operator const std::string&() const { return sym_.str(); }  // NOLINT(runtime/explicit)
+  const std::string& str() const { return sym_.str(); }
+  const Symbol& symbol() const { return sym_; }
+
+  bool empty() const { return sym_.empty(); }
+  std::size_t size() const { return sym_.str().size(); }
+  const char* c_str() const { return sym_.str().c_str(); }
+  char operator[](std::size_t pos) const { return sym_.str()[pos]; }
+  std::size_t find(char ch, std::size_t pos = 0) const { return sym_.str().find(ch, pos); }
+  std::size_t find(const std::string& str, std::size_t pos = 0) const { return sym_.str().find(str, pos); }
+  std::size_t rfind(char ch, std::size_t pos = std::string::npos) const { return sym_.str().rfind(ch, pos); }
+  std::size_t rfind(const std::string& str, std::size_t pos = std::string::npos) const {
+    return sym_.str().rfind(str, pos);
+  }
+  std::string substr(std::size_t pos = 0, std::size_t len = std::string::npos) const {
+    return sym_.str().substr(pos, len);
+  }
+  void clear() { sym_ = Symbol{}; }
+
+  // Hidden friends, as for Symbol.
+  friend bool operator==(const InternedString& lhs, const InternedString& rhs) { return lhs.symbol() == rhs.symbol(); }
+  friend bool operator==(const InternedString& lhs, const std::string& rhs) { return lhs.str() == rhs; }
+  friend bool operator==(const std::string& lhs, const InternedString& rhs) { return lhs == rhs.str(); }
+  friend bool operator==(const InternedString& lhs, const char* rhs) { return lhs.str() == rhs; }
+  friend bool operator==(const char* lhs, const InternedString& rhs) { return lhs == rhs.str(); }
+
+  friend bool operator!=(const InternedString& lhs, const InternedString& rhs) { return !(lhs == rhs); }
+  friend bool operator!=(const InternedString& lhs, const std::string& rhs) { return !(lhs == rhs); }
+  friend bool operator!=(const std::string& lhs, const InternedString& rhs) { return !(lhs == rhs); }
+  friend bool operator!=(const InternedString& lhs, const char* rhs) { return !(lhs == rhs); }
+  friend bool operator!=(const char* lhs, const InternedString& rhs) { return !(lhs == rhs); }
+
+  friend bool operator<(const InternedString& lhs, const InternedString& rhs) { return lhs.symbol() < rhs.symbol(); }
+  friend bool operator<(const InternedString& lhs, const std::string& rhs) { return lhs.str() < rhs; }
+  friend bool operator<(const std::string& lhs, const InternedString& rhs) { return lhs < rhs.str(); }
+
+  friend std::string operator+(const InternedString& lhs, const std::string& rhs) { return lhs.str() + rhs; }
+  friend std::string operator+(const std::string& lhs, const InternedString& rhs) { return lhs + rhs.str(); }
+  friend std::string operator+(const InternedString& lhs, const char* rhs) { return lhs.str() + rhs; }
+  friend std::string operator+(const char* lhs, const InternedString& rhs) { return lhs + rhs.str(); }
+
+  friend std::ostream& operator<<(std::ostream& os, const InternedString& str) { return os << str.str(); }
+
+  friend std::string to_string(const InternedString& str) { return str.str(); }
+
+ private:
+  Symbol sym_;
+};
+
+}  // namespace vertexai
+
+namespace std {
+
+template <>
+struct hash<vertexai::Symbol> {
+  std::size_t operator()(const vertexai::Symbol& sym) const { return sym.hash(); }
+};
+
+template <>
+struct hash<vertexai::InternedString> {
+  std::size_t operator()(const vertexai::InternedString& str) const { return str.symbol().hash(); }
+};
+
+}  // namespace std
@@ -103,170 +103,184 @@ edsl::Tensor block(                      //
   }
 }
 
-std::vector<edsl::Tensor> weight_placeholders() {
+std::vector<edsl::Tensor> weight_placeholders(plaidml_datatype dtype) {
   return {
       // conv1
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {7, 7, 3, 64}),
+      edsl::Placeholder(dtype, {7, 7, 3, 64}),
 
       // block2a
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 64, 64}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {3, 3, 64, 64}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 64, 256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 64, 256}),
+      edsl::Placeholder(dtype, {1, 1, 64, 64}),
+      edsl::Placeholder(dtype, {3, 3, 64, 64}),
+      edsl::Placeholder(dtype, {1, 1, 64, 256}),
+      edsl::Placeholder(dtype, {1, 1, 64, 256}),
       // block2b
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 256, 64}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {3, 3, 64, 64}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 64, 256}),
+      edsl::Placeholder(dtype, {1, 1, 256, 64}),
+      edsl::Placeholder(dtype, {3, 3, 64, 64}),
+      edsl::Placeholder(dtype, {1, 1, 64, 256}),
       // block2c
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 256, 64}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {3, 3, 64, 64}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 64, 256}),
+      edsl::Placeholder(dtype, {1, 1, 256, 64}),
+      edsl::Placeholder(dtype, {3, 3, 64, 64}),
+      edsl::Placeholder(dtype, {1, 1, 64, 256}),
 
       // block3a
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 256, 128}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {3, 3, 128, 128}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 128, 512}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 256, 512}),
+      edsl::Placeholder(dtype, {1, 1, 256, 128}),
+      edsl::Placeholder(dtype, {3, 3, 128, 128}),
+      edsl::Placeholder(dtype, {1, 1, 128, 512}),
+      edsl::Placeholder(dtype, {1, 1, 256, 512}),
       // block3b
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 512, 128}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {3, 3, 128, 128}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 128, 512}),
+      edsl::Placeholder(dtype, {1, 1, 512, 128}),
+      edsl::Placeholder(dtype, {3, 3, 128, 128}),
+      edsl::Placeholder(dtype, {1, 1, 128, 512}),
       // block3c
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 512, 128}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {3, 3, 128, 128}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 128, 512}),
+      edsl::Placeholder(dtype, {1, 1, 512, 128}),
+      edsl::Placeholder(dtype, {3, 3, 128, 128}),
+      edsl::Placeholder(dtype, {1, 1, 128, 512}),
       // block3d
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 512, 128}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {3, 3, 128, 128}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 128, 512}),
+      edsl::Placeholder(dtype, {1, 1, 512, 128}),
+      edsl::Placeholder(dtype, {3, 3, 128, 128}),
+      edsl::Placeholder(dtype, {1, 1, 128, 512}),
 
       // block4a
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 512, 256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {3, 3, 256, 256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 256, 1024}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 512, 1024}),
+      edsl::Placeholder(dtype, {1, 1, 512, 256}),
+      edsl::Placeholder(dtype, {3, 3, 256, 256}),
+      edsl::Placeholder(dtype, {1, 1, 256, 1024}),
+      edsl::Placeholder(dtype, {1, 1, 512, 1024}),
       // block4b
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 1024, 256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {3, 3, 256, 256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 256, 1024}),
+      edsl::Placeholder(dtype, {1, 1, 1024, 256}),
+      edsl::Placeholder(dtype, {3, 3, 256, 256}),
+      edsl::Placeholder(dtype, {1, 1, 256, 1024}),
       // block4c
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 1024, 256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {3, 3, 256, 256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 256, 1024}),
+      edsl::Placeholder(dtype, {1, 1, 1024, 256}),
+      edsl::Placeholder(dtype, {3, 3, 256, 256}),
+      edsl::Placeholder(dtype, {1, 1, 256, 1024}),
       // block4d
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 1024, 256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {3, 3, 256, 256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 256, 1024}),
+      edsl::Placeholder(dtype, {1, 1, 1024, 256}),
+      edsl::Placeholder(dtype, {3, 3, 256, 256}),
+      edsl::Placeholder(dtype, {1, 1, 256, 1024}),
       // block4e
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 1024, 256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {3, 3, 256, 256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 256, 1024}),
+      edsl::Placeholder(dtype, {1, 1, 1024, 256}),
+      edsl::Placeholder(dtype, {3, 3, 256, 256}),
+      edsl::Placeholder(dtype, {1, 1, 256, 1024}),
       // block4f
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 1024, 256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {3, 3, 256, 256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 256, 1024}),
+      edsl::Placeholder(dtype, {1, 1, 1024, 256}),
+      edsl::Placeholder(dtype, {3, 3, 256, 256}),
+      edsl::Placeholder(dtype, {1, 1, 256, 1024}),
 
       // block5a
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 1024, 512}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {3, 3, 512, 512}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 512, 2048}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 1024, 2048}),
+      edsl::Placeholder(dtype, {1, 1, 1024, 512}),
+      edsl::Placeholder(dtype, {3, 3, 512, 512}),
+      edsl::Placeholder(dtype, {1, 1, 512, 2048}),
+      edsl::Placeholder(dtype, {1, 1, 1024, 2048}),
       // block5b
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 2048, 512}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {3, 3, 512, 512}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 512, 2048}),
+      edsl::Placeholder(dtype, {1, 1, 2048, 512}),
+      edsl::Placeholder(dtype, {3, 3, 512, 512}),
+      edsl::Placeholder(dtype, {1, 1, 512, 2048}),
       // block5c
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 2048, 512}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {3, 3, 512, 512}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1, 1, 512, 2048}),
+      edsl::Placeholder(dtype, {1, 1, 2048, 512}),
+      edsl::Placeholder(dtype, {3, 3, 512, 512}),
+      edsl::Placeholder(dtype, {1, 1, 512, 2048}),
 
       // dense
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {2048, 1000}),
+      edsl::Placeholder(dtype, {2048, 1000}),
   };
 }
 
-std::vector<edsl::Tensor> bias_placeholders() {
+std::vector<edsl::Tensor> bias_placeholders(plaidml_datatype dtype) {
   return {
       // conv1
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {64}),
+      edsl::Placeholder(dtype, {64}),
 
       // block2a
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {64}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {64}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {256}),
+      edsl::Placeholder(dtype, {64}),
+      edsl::Placeholder(dtype, {64}),
+      edsl::Placeholder(dtype, {256}),
+      edsl::Placeholder(dtype, {256}),
       // block2b
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {64}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {64}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {256}),
+      edsl::Placeholder(dtype, {64}),
+      edsl::Placeholder(dtype, {64}),
+      edsl::Placeholder(dtype, {256}),
       // block2c
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {64}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {64}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {256}),
+      edsl::Placeholder(dtype, {64}),
+      edsl::Placeholder(dtype, {64}),
+      edsl::Placeholder(dtype, {256}),
 
       // block3a
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {128}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {128}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {512}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {512}),
+      edsl::Placeholder(dtype, {128}),
+      edsl::Placeholder(dtype, {128}),
+      edsl::Placeholder(dtype, {512}),
+      edsl::Placeholder(dtype, {512}),
       // block3b
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {128}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {128}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {512}),
+      edsl::Placeholder(dtype, {128}),
+      edsl::Placeholder(dtype, {128}),
+      edsl::Placeholder(dtype, {512}),
       // block3c
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {128}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {128}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {512}),
+      edsl::Placeholder(dtype, {128}),
+      edsl::Placeholder(dtype, {128}),
+      edsl::Placeholder(dtype, {512}),
       // block3d
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {128}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {128}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {512}),
+      edsl::Placeholder(dtype, {128}),
+      edsl::Placeholder(dtype, {128}),
+      edsl::Placeholder(dtype, {512}),
 
       // block4a
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1024}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1024}),
+      edsl::Placeholder(dtype, {256}),
+      edsl::Placeholder(dtype, {256}),
+      edsl::Placeholder(dtype, {1024}),
+      edsl::Placeholder(dtype, {1024}),
       // block4b
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1024}),
+      edsl::Placeholder(dtype, {256}),
+      edsl::Placeholder(dtype, {256}),
+      edsl::Placeholder(dtype, {1024}),
       // block4c
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1024}),
+      edsl::Placeholder(dtype, {256}),
+      edsl::Placeholder(dtype, {256}),
+      edsl::Placeholder(dtype, {1024}),
       // block4d
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1024}),
+      edsl::Placeholder(dtype, {256}),
+      edsl::Placeholder(dtype, {256}),
+      edsl::Placeholder(dtype, {1024}),
       // block4e
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1024}),
+      edsl::Placeholder(dtype, {256}),
+      edsl::Placeholder(dtype, {256}),
+      edsl::Placeholder(dtype, {1024}),
       // block4f
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {256}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1024}),
+      edsl::Placeholder(dtype, {256}),
+      edsl::Placeholder(dtype, {256}),
+      edsl::Placeholder(dtype, {1024}),
 
       // block5a
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {512}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {512}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {2048}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {2048}),
+      edsl::Placeholder(dtype, {512}),
+      edsl::Placeholder(dtype, {512}),
+      edsl::Placeholder(dtype, {2048}),
+      edsl::Placeholder(dtype, {2048}),
       // block5b
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {512}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {512}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {2048}),
+      edsl::Placeholder(dtype, {512}),
+      edsl::Placeholder(dtype, {512}),
+      edsl::Placeholder(dtype, {2048}),
       // block5c
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {512}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {512}),
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {2048}),
+      edsl::Placeholder(dtype, {512}),
+      edsl::Placeholder(dtype, {512}),
+      edsl::Placeholder(dtype, {2048}),
 
       // dense
-      edsl::Placeholder(PLAIDML_DATA_FLOAT32, {1000}),
+      edsl::Placeholder(dtype, {1000}),
   };
 }
 
+// The int8 network is the same graph with int8 tensors throughout: the EDSL has no quantized convolution, so its
+// contractions accumulate in int8 and carry no requantization.  It measures the int8 code paths, not a calibrated
+// model.
+const char* dtype_label(plaidml_datatype dtype) {
+  switch (dtype) {
+    case PLAIDML_DATA_BFLOAT16:
+      return "bf16";
+    case PLAIDML_DATA_INT8:
+      return "int8";
+    default:
+      return "fp32";
+  }
+}
+
 }  // namespace
 
 struct resnet50 : public benchmark::Fixture {
@@ -382,21 +396,27 @@ struct resnet50 : public benchmark::Fixture {
     auto W_dense = W[53];
     auto B_dense = B[53];
     auto dense = op::dot(global_mean, W_dense) + B_dense;
+    if (dense.shape().dtype() == PLAIDML_DATA_INT8) {
+      // The classifier's logits are scored in floating point
+      dense = edsl::cast(dense, PLAIDML_DATA_FLOAT32);
+    }
     auto softmax = op::softmax(dense, 1);
     return edsl::Program("resnet50", {softmax});
   }
 
-  auto compile(int64_t batch_size = 1) {
-    auto I = edsl::Placeholder(PLAIDML_DATA_FLOAT32, {batch_size, 224, 224, 3});
-    auto W = weight_placeholders();
-    auto B = bias_placeholders();
+  auto compile(plaidml_datatype dtype = PLAIDML_DATA_FLOAT32, int64_t batch_size = 1) {
+    auto I = edsl::Placeholder(dtype, {batch_size, 224, 224, 3});
+    auto W = weight_placeholders(dtype);
+    auto B = bias_placeholders(dtype);
     auto program = build(batch_size, I, W, B);
     return exec::Binder(program).compile();
   }
 };
 
 BENCHMARK_DEFINE_F(resnet50, build)(benchmark::State& state) {  // NOLINT[runtime/references]
-  compile()->run();
+  auto dtype = static_cast<plaidml_datatype>(state.range(0));
+  state.SetLabel(dtype_label(dtype));
+  compile(dtype)->run();
 }
 
 BENCHMARK_DEFINE_F(resnet50, compile)(benchmark::State& state) {  // NOLINT[runtime/references]
@@ -406,18 +426,31 @@ BENCHMARK_DEFINE_F(resnet50, compile)(benchmark::State& state) {  // NOLINT[runt
 }
 
 BENCHMARK_DEFINE_F(resnet50, run)(benchmark::State& state) {  // NOLINT[runtime/references]
-  auto executable = compile();
+  // The argument selects the element type of the activations and weights.
+  auto dtype = static_cast<plaidml_datatype>(state.range(0));
+  state.SetLabel(dtype_label(dtype));
+  auto executable = compile(dtype);
   for (auto _ : state) {
     executable->run();
   }
   state.SetItemsProcessed(state.iterations());
 }
 
-BENCHMARK_REGISTER_F(resnet50, build)->Unit(benchmark::kMillisecond)->Iterations(1);
+BENCHMARK_REGISTER_F(resnet50, build)
+    ->Arg(PLAIDML_DATA_FLOAT32)
+    ->Arg(PLAIDML_DATA_BFLOAT16)
+    ->Arg(PLAIDML_DATA_INT8)
+    ->Unit(benchmark::kMillisecond)
+    ->Iterations(1);
 
 BENCHMARK_REGISTER_F(resnet50, compile)->Unit(benchmark::kMillisecond);
 
 // TODO: get HAL timer results, UseManualTime() instead of UseRealTime()
-BENCHMARK_REGISTER_F(resnet50, run)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_REGISTER_F(resnet50, run)
+    ->Arg(PLAIDML_DATA_FLOAT32)
+    ->Arg(PLAIDML_DATA_BFLOAT16)
+    ->Arg(PLAIDML_DATA_INT8)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
 
 }  // namespace networks::oplib
@@ -738,6 +738,21 @@ class _Library(plaidml.library.Library):
         self.plaidml_schedule_invocation.restype = ctypes.POINTER(_C_Invocation)
         self.plaidml_schedule_invocation.errcheck = self._check_err
 
+        # PLAIDML_API bool plaidml_poll_invocation(plaidml_invocation* invocation);
+        self.plaidml_poll_invocation = lib.plaidml_poll_invocation
+        self.plaidml_poll_invocation.argtypes = [
+            ctypes.POINTER(_C_Invocation)  # plaidml_invocation* invocation
+        ]
+        self.plaidml_poll_invocation.restype = ctypes.c_bool
+
+        # PLAIDML_API bool plaidml_wait_for_invocation(plaidml_invocation* invocation);
+        self.plaidml_wait_for_invocation = lib.plaidml_wait_for_invocation
+        self.plaidml_wait_for_invocation.argtypes = [
+            ctypes.POINTER(_C_Invocation)  # plaidml_invocation* invocation
+        ]
+        self.plaidml_wait_for_invocation.restype = ctypes.c_bool
+        self.plaidml_wait_for_invocation.errcheck = self._check_err
+
         # PLAIDML_API void plaidml_free_invocation(plaidml_invocation* invocation);
         self.plaidml_free_invocation = lib.plaidml_free_invocation
         self.plaidml_free_invocation.argtypes = [
@@ -1484,6 +1499,12 @@ class Invocation(object):
         self._as_parameter_ = _lib().plaidml_schedule_invocation(ctx, invoker)
         self._free = _lib().plaidml_free_invocation
 
+    def done(self):
+        return _lib().plaidml_poll_invocation(self)
+
+    def wait(self):
+        _lib().plaidml_wait_for_invocation(self)
+
     def __del__(self):
         if hasattr(self, '_free'):
             self._free(self)
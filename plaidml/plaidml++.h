@@ -735,6 +735,16 @@ class device {
     return r;
   }
 
+  // Wraps caller-owned memory, which must remain valid until release (if any) is invoked with arg.
+  buffer wrap(void* data, uint64_t size, void (*release)(void* arg) = nullptr, void* arg = nullptr) const {
+    buffer r;
+
+    r.ptr_ = std::shared_ptr<plaidml_buffer>(
+        plaidml_alloc_external_buffer(ctx_->get_ctx(), ptr_.get(), data, size, release, arg), plaidml_free_buffer);
+    vai_exception::check_and_throw(r.ptr_);
+    return r;
+  }
+
   base_tensor allocate(const base_shape& s) const { return base_tensor(s.get_context(), allocate(s.buffer_size()), s); }
 
   template <class T>
@@ -17,6 +17,7 @@
 #include <cstring>
 #include <exception>
 #include <fstream>
+#include <functional>
 #include <list>
 #include <map>
 #include <memory>
@@ -151,7 +152,8 @@ class Evaluator final {
   explicit Evaluator(plaidml_devconf* devconf)
       : platform_{devconf->platform},
         id_{devconf->device.dev_id()},
-        program_cache_{std::make_shared<tile::ProgramCache>(platform_, 500 /* TODO: Make this configurable */)} {}
+        program_cache_{std::make_shared<tile::ProgramCache>(platform_, 500 /* TODO: Make this configurable */,
+                                                            vertexai::env::Get("PLAIDML_BATCH_BUCKETS") == "1")} {}
 
   const std::shared_ptr<tile::Platform>& get_platform() const { return platform_; }
   const std::string& get_id() const { return id_; }
@@ -442,6 +444,34 @@ extern "C" plaidml_buffer* plaidml_alloc_buffer(vai_ctx* ctx, plaidml_device* de
   }
 }
 
+extern "C" plaidml_buffer* plaidml_alloc_external_buffer(vai_ctx* ctx, plaidml_device* device, void* data,
+                                                         uint64_t size, void (*release)(void* arg), void* arg) {
+  if (!device) {
+    IVLOG(1, "Called plaidml_alloc_external_buffer on invalid device; thus out of memory.");
+    vertexai::SetLastOOM();
+    return nullptr;
+  }
+
+  if (!ctx) {
+    vertexai::SetLastStatus(VAI_STATUS_CANCELLED, status_strings::kCancelled);
+    return nullptr;
+  }
+
+  try {
+    context::Activity activity{ctx->activity.ctx(), "vertexai::AllocExternalBuffer"};
+    std::function<void()> on_release;
+    if (release) {
+      on_release = [release, arg] { release(arg); };
+    }
+    auto buffer = device->evaluator->get_platform()->MakeExternalBuffer(
+        ctx->activity.ctx(), device->evaluator->get_id(), static_cast<char*>(data), size, std::move(on_release));
+    return new plaidml_buffer{std::move(activity), std::make_shared<BufferState>(buffer, device->evaluator)};
+  } catch (...) {
+    vertexai::SetLastException(std::current_exception());
+    return nullptr;
+  }
+}
+
 extern "C" void plaidml_free_buffer(plaidml_buffer* buffer) { delete buffer; }
 
 extern "C" plaidml_mapping* plaidml_map_buffer_current(plaidml_buffer* buffer,
@@ -1353,6 +1383,17 @@ struct plaidml_invoker {
       runinfo_cache{kRuninfoCacheSize};
 
   std::shared_ptr<RunInfo> runinfo;
+
+  // The program last scheduled by the invoker.  Runinfos are cached by shape, so an unchanged runinfo, device, set of
+  // consumed inputs, and set of constant buffers (which are compiled into the program) identify the same program;
+  // repeated invocations then skip building the program and looking it up in the device's program cache.
+  struct ProgramMemo {
+    std::shared_ptr<RunInfo> runinfo;
+    std::shared_ptr<Evaluator> evaluator;
+    std::set<std::string> consumed;
+    std::map<std::string, std::shared_ptr<tile::Buffer>> consts;
+    std::shared_ptr<tile::Program> program;
+  } program_memo;
 };
 
 namespace {
@@ -1563,13 +1604,95 @@ extern "C" bool plaidml_save_invoker(plaidml_invoker* invoker, const char* filen
 
 // plaidml_invocation
 //
-// Currently, the actual invocation structure is a placeholder; it
-// represents a particular invocation of a Plaid function, but it
-// doesn't have any useful data.  The intention is that it gives us a
-// place to stand to query information about the invocation, attach
-// callbacks, &c.
+// An invocation tracks the completion of one run of a Plaid function.  Its state is shared with the run's
+// continuation, so that the invocation may be freed before the run completes.
+
+namespace {
+
+class InvocationState final {
+ public:
+  // Records the outcome of the run, and invokes the callback if one has been set.
+  void Complete(std::exception_ptr error) noexcept {
+    void (*callback)(void* arg, bool ok);
+    void* arg;
+    {
+      std::lock_guard<std::mutex> lock{mu_};
+      done_ = true;
+      error_ = error;
+      callback = callback_;
+      arg = callback_arg_;
+    }
+    cv_.notify_all();
+    if (callback) {
+      Notify(callback, arg);
+    } else if (error) {
+      try {
+        std::rethrow_exception(error);
+      } catch (const std::exception& ex) {
+        LOG(ERROR) << ex.what();
+      } catch (...) {
+        LOG(ERROR) << "Unknown invocation failure";
+      }
+    }
+  }
+
+  // Sets the callback to invoke on completion, invoking it immediately if the run has already completed.
+  bool SetCallback(void (*callback)(void* arg, bool ok), void* arg) noexcept {
+    {
+      std::lock_guard<std::mutex> lock{mu_};
+      if (callback_) {
+        vertexai::SetLastStatus(VAI_STATUS_FAILED_PRECONDITION, "An invocation callback has already been set");
+        return false;
+      }
+      callback_ = callback;
+      callback_arg_ = arg;
+      if (!done_) {
+        return true;
+      }
+    }
+    Notify(callback, arg);
+    return true;
+  }
+
+  bool Poll() noexcept {
+    std::lock_guard<std::mutex> lock{mu_};
+    return done_;
+  }
+
+  bool Wait() noexcept {
+    std::unique_lock<std::mutex> lock{mu_};
+    cv_.wait(lock, [this] { return done_; });
+    if (error_) {
+      vertexai::SetLastException(error_);
+      return false;
+    }
+    return true;
+  }
 
-struct plaidml_invocation {};
+ private:
+  // Invokes the callback with the thread's status describing the outcome.
+  void Notify(void (*callback)(void* arg, bool ok), void* arg) noexcept {
+    if (error_) {
+      vertexai::SetLastException(error_);
+    } else {
+      vertexai::SetLastStatus(VAI_STATUS_OK, status_strings::kOk);
+    }
+    callback(arg, !error_);
+  }
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool done_ = false;
+  std::exception_ptr error_;
+  void (*callback_)(void* arg, bool ok) = nullptr;
+  void* callback_arg_ = nullptr;
+};
+
+}  // namespace
+
+struct plaidml_invocation {
+  std::shared_ptr<InvocationState> state;
+};
 
 namespace {
 
@@ -1597,7 +1720,7 @@ extern "C" plaidml_invocation* plaidml_schedule_invocation(vai_ctx* ctx, plaidml
   }
   context::Activity activity{ctx->activity.ctx(), "plaidml::invoker::ScheduleInvocation"};
   try {
-    auto invocation = std::make_unique<plaidml_invocation>();
+    auto invocation = std::make_unique<plaidml_invocation>(plaidml_invocation{std::make_shared<InvocationState>()});
     auto rundown = std::make_shared<context::Rundown>();
     rundown->TryEnterGate(activity.ctx().gate());
     BuildInvokerRunInfo(invoker, "invoker_program");
@@ -1612,68 +1735,85 @@ extern "C" plaidml_invocation* plaidml_schedule_invocation(vai_ctx* ctx, plaidml
     for (const auto& kv : out_buffers) {
       output_set.insert(kv.second.get());
     }
-
-    if (!evaluator) {
-      throw vertexai::error::FailedPrecondition{"Function has neither inputs nor outputs"};
-    }
-
-    tile::proto::Program prog;
-    prog.set_dev_id(evaluator->get_id());
-    prog.set_code(invoker->runinfo->code);
+    std::set<std::string> consumed;
     for (const auto& kv : invoker->runinfo->input_shapes) {
-      auto& input = (*prog.mutable_inputs())[kv.first];
-      *input.mutable_shape() = tile::IntoProto(kv.second);
       if (output_set.count(in_buffers[kv.first].get())) {
-        input.set_consumed(true);
+        consumed.insert(kv.first);
       }
     }
-    for (const auto& kv : invoker->runinfo->output_shapes) {
-      *(*prog.mutable_outputs())[kv.first].mutable_shape() = tile::IntoProto(kv.second);
+
+    if (!evaluator) {
+      throw vertexai::error::FailedPrecondition{"Function has neither inputs nor outputs"};
     }
 
-    size_t max_trials = 1;
-    auto env_trials = vertexai::env::Get("PLAIDML_KERNEL_TRIALS");
-    if (env_trials.length()) {
-      auto env_value = std::atoi(env_trials.c_str());
-      if (env_value) {
-        max_trials = env_value;
+    std::map<std::string, std::shared_ptr<tile::Buffer>> consts;
+    for (const auto& kvp : invoker->runinfo->input_shapes) {
+      if (kvp.second.is_const) {
+        consts.emplace(kvp.first, in_buffers[kvp.first]);
       }
     }
 
-    size_t max_trial_runs = 1;
-    auto env_runs = vertexai::env::Get("PLAIDML_KERNEL_TRIAL_RUNS");
-    if (env_runs.length()) {
-      auto env_value = std::atoi(env_runs.c_str());
-      if (env_value) {
-        max_trial_runs = env_value;
+    auto& memo = invoker->program_memo;
+    if (memo.runinfo != invoker->runinfo || memo.evaluator != evaluator || memo.consumed != consumed ||
+        memo.consts != consts) {
+      tile::proto::Program prog;
+      prog.set_dev_id(evaluator->get_id());
+      prog.set_code(invoker->runinfo->code);
+      for (const auto& kv : invoker->runinfo->input_shapes) {
+        auto& input = (*prog.mutable_inputs())[kv.first];
+        *input.mutable_shape() = tile::IntoProto(kv.second);
+        if (consumed.count(kv.first)) {
+          input.set_consumed(true);
+        }
+      }
+      for (const auto& kv : invoker->runinfo->output_shapes) {
+        *(*prog.mutable_outputs())[kv.first].mutable_shape() = tile::IntoProto(kv.second);
       }
-    }
 
-    auto* params = prog.mutable_tile_scanning_params();
-    params->set_max_trials(max_trials);
-    params->set_max_trial_runs(max_trial_runs);
+      size_t max_trials = 1;
+      auto env_trials = vertexai::env::Get("PLAIDML_KERNEL_TRIALS");
+      if (env_trials.length()) {
+        auto env_value = std::atoi(env_trials.c_str());
+        if (env_value) {
+          max_trials = env_value;
+        }
+      }
 
-    tile::ConstBufferManager const_bufs;
-    const_bufs.allocator = std::make_shared<PlatformAllocator>(*evaluator);
-    for (const auto& kvp : invoker->runinfo->input_shapes) {
-      if (kvp.second.is_const) {
-        const_bufs.buffers[kvp.first] = in_buffers[kvp.first];
+      size_t max_trial_runs = 1;
+      auto env_runs = vertexai::env::Get("PLAIDML_KERNEL_TRIAL_RUNS");
+      if (env_runs.length()) {
+        auto env_value = std::atoi(env_runs.c_str());
+        if (env_value) {
+          max_trial_runs = env_value;
+        }
       }
+
+      auto* params = prog.mutable_tile_scanning_params();
+      params->set_max_trials(max_trials);
+      params->set_max_trial_runs(max_trial_runs);
+
+      tile::ConstBufferManager const_bufs;
+      const_bufs.allocator = std::make_shared<PlatformAllocator>(*evaluator);
+      const_bufs.buffers = consts;
+      memo.program = evaluator->MakeProgram(activity.ctx(), prog, &const_bufs);
+      memo.runinfo = invoker->runinfo;
+      memo.evaluator = evaluator;
+      memo.consumed = std::move(consumed);
+      memo.consts = std::move(consts);
     }
-    auto program = evaluator->MakeProgram(activity.ctx(), prog, &const_bufs);
+    auto program = memo.program;
 
     // Run the program
     auto result = program->Run(activity.ctx(), in_buffers, out_buffers);
-    result.then(boost::launch::async,
-                [rundown = std::move(rundown), program = std::move(program)](decltype(result) fut) {
-                  try {
-                    fut.get();
-                  } catch (const std::exception& ex) {
-                    // TODO: We need a better way to notify users if the asynchronous results
-                    // of an invocation are valid, perhaps by allowing a callback to be specified.
-                    LOG(ERROR) << ex.what();
-                  }
-                });
+    result.then(tile::CompletionPool(), [rundown = std::move(rundown), program = std::move(program),
+                                         state = invocation->state](decltype(result) fut) {
+      try {
+        fut.get();
+        state->Complete(nullptr);
+      } catch (...) {
+        state->Complete(std::current_exception());
+      }
+    });
 
     return invocation.release();
   } catch (...) {
@@ -1682,6 +1822,31 @@ extern "C" plaidml_invocation* plaidml_schedule_invocation(vai_ctx* ctx, plaidml
   }
 }
 
+extern "C" bool plaidml_set_invocation_callback(plaidml_invocation* invocation,
+                                               void (*callback)(void* arg, bool ok), void* arg) {
+  if (!invocation || !callback) {
+    vertexai::SetLastOOM();
+    return false;
+  }
+  return invocation->state->SetCallback(callback, arg);
+}
+
+extern "C" bool plaidml_poll_invocation(plaidml_invocation* invocation) {
+  if (!invocation) {
+    vertexai::SetLastOOM();
+    return false;
+  }
+  return invocation->state->Poll();
+}
+
+extern "C" bool plaidml_wait_for_invocation(plaidml_invocation* invocation) {
+  if (!invocation) {
+    vertexai::SetLastOOM();
+    return false;
+  }
+  return invocation->state->Wait();
+}
+
 extern "C" void plaidml_free_invocation(plaidml_invocation* invocation) { delete invocation; }
 
 // plaidml_gradient
@@ -166,6 +166,17 @@ typedef struct plaidml_mapping plaidml_mapping;
 // NULL.
 PLAIDML_API plaidml_buffer* plaidml_alloc_buffer(vai_ctx* ctx, plaidml_device* device, uint64_t size);
 
+// Wraps caller-owned memory as a buffer, without copying it: programs read and
+// write the memory in place.  The memory must remain valid until the release
+// callback (if non-NULL) is invoked with the supplied argument, which happens
+// once the buffer and all uses of it are gone.
+//
+// Returns NULL if the device cannot use host memory directly, or if the memory
+// is not suitably aligned (16 bytes suffices); in that case the release
+// callback is never invoked.
+PLAIDML_API plaidml_buffer* plaidml_alloc_external_buffer(vai_ctx* ctx, plaidml_device* device, void* data,
+                                                          uint64_t size, void (*release)(void* arg), void* arg);
+
 // Frees a buffer.  After this call, the buffer should not be used for any
 // subsequent calls.  Freeing a NULL buffer is a no-op.
 PLAIDML_API void plaidml_free_buffer(plaidml_buffer* buffer);
@@ -537,15 +548,37 @@ typedef struct plaidml_invocation plaidml_invocation;
 // Note that this call may return before the computation described by
 // the function has actually completed; the computation is scheduled,
 // not complete.  Errors that occur asynchronously will be reported
-// when the buffers updated by running the function are remapped.
+// when the buffers updated by running the function are remapped, and
+// through the invocation itself (see below).
 //
 // Once this call returns, the invoker's inputs and outputs may be set
 // by the caller, and the invoker may be used for another run of the
 // invoker's function, even if the first run has not yet completed.
 PLAIDML_API plaidml_invocation* plaidml_schedule_invocation(vai_ctx* ctx, plaidml_invoker* invoker);
 
+// Sets a callback to be invoked once the invocation's computation has
+// completed.  The callback receives true if the computation succeeded;
+// otherwise, it receives false, and the thread's status describes the
+// failure.  If the computation has already completed, the callback is
+// invoked before this call returns; otherwise, it is invoked on a
+// thread shared by all invocations, and should return promptly.  The
+// callback is invoked exactly once, even if the invocation is freed
+// first.  An invocation may have at most one callback.
+PLAIDML_API bool plaidml_set_invocation_callback(plaidml_invocation* invocation,
+                                                 void (*callback)(void* arg, bool ok), void* arg);
+
+// Returns true iff the invocation's computation has completed, whether
+// or not it succeeded.
+PLAIDML_API bool plaidml_poll_invocation(plaidml_invocation* invocation);
+
+// Blocks until the invocation's computation has completed.  Returns
+// true if it succeeded; otherwise, returns false and sets the thread's
+// status to describe the failure.
+PLAIDML_API bool plaidml_wait_for_invocation(plaidml_invocation* invocation);
+
 // Frees an invocation.  After this call, the invocation should not be
 // used for any subsequent calls.  Freeing a NULL invocation is a no-op.
+// Freeing an invocation does not cancel its computation.
 PLAIDML_API void plaidml_free_invocation(plaidml_invocation* invocation);
 
 // A PlaidML gradient computes gradient data for a given scalar.
@@ -77,6 +77,14 @@ TEST(PlaidMLTest, Uints) {
 
   std::unique_ptr<plaidml_invocation> invocation(plaidml_schedule_invocation(ctx.get(), invoker.get()));
   EXPECT_THAT(vai_last_status(), IsVaiStatus(VAI_STATUS_OK));
+  EXPECT_TRUE(plaidml_wait_for_invocation(invocation.get()));
+  EXPECT_TRUE(plaidml_poll_invocation(invocation.get()));
+
+  // A callback set after completion is invoked immediately.
+  int calls = 0;
+  EXPECT_TRUE(plaidml_set_invocation_callback(
+      invocation.get(), [](void* arg, bool ok) { *static_cast<int*>(arg) += ok ? 1 : 100; }, &calls));
+  EXPECT_EQ(calls, 1);
 
   {
     std::unique_ptr<plaidml_mapping> map_c{plaidml_map_buffer_current(output_c.get(), nullptr, nullptr)};
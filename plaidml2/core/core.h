@@ -140,6 +140,13 @@ class Buffer {
             ffi::call<plaidml_buffer*>(plaidml_buffer_alloc, device.c_str(), shape.nbytes()))),
         shape_(shape) {}
 
+  // Wraps caller-owned memory, which must stay valid until release (if any) is called with arg.
+  Buffer(const std::string& device, const TensorShape& shape, void* data, void (*release)(void* arg) = nullptr,
+         void* arg = nullptr)
+      : ptr_(details::make_plaidml_buffer(ffi::call<plaidml_buffer*>(
+            plaidml_buffer_wrap, device.c_str(), static_cast<char*>(data), shape.nbytes(), release, arg))),
+        shape_(shape) {}
+
   explicit Buffer(plaidml_buffer* ptr, const TensorShape& shape)
       : ptr_(details::make_plaidml_buffer(ptr)), shape_(shape) {}
 
@@ -3,6 +3,7 @@
 #include "plaidml2/core/ffi.h"
 
 #include <cstdlib>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <utility>
@@ -327,6 +328,25 @@ plaidml_buffer* plaidml_buffer_alloc(  //
   });
 }
 
+plaidml_buffer* plaidml_buffer_wrap(  //
+    plaidml_error* err,               //
+    const char* device_id,            //
+    char* data,                       //
+    size_t size,                      //
+    void (*release)(void* arg),       //
+    void* arg) {
+  return ffi_wrap<plaidml_buffer*>(err, nullptr, [&] {
+    IVLOG(3, "plaidml_buffer_wrap");
+    auto ctx = GlobalContext::getContext();
+    std::function<void()> on_release;
+    if (release) {
+      on_release = [release, arg] { release(arg); };
+    }
+    auto buffer = GetPlatform()->MakeExternalBuffer(*ctx, device_id, data, size, on_release);
+    return new plaidml_buffer{buffer};
+  });
+}
+
 plaidml_view* plaidml_buffer_mmap_current(  //
     plaidml_error* err,                     //
     plaidml_buffer* buffer) {
@@ -199,6 +199,18 @@ plaidml_buffer* plaidml_buffer_alloc(  //
     const char* device_id,             //
     size_t size);
 
+// Wraps caller-owned memory as a buffer, without copying it; programs read and write the memory in place.  The
+// memory must stay valid until release (if non-NULL) is called with arg, once the buffer is no longer in use.  Only
+// devices which run directly against host memory support this, and the memory must be suitably aligned; on error,
+// release is never called.
+plaidml_buffer* plaidml_buffer_wrap(  //
+    plaidml_error* err,               //
+    const char* device_id,            //
+    char* data,                       //
+    size_t size,                      //
+    void (*release)(void* arg),       //
+    void* arg);
+
 plaidml_view* plaidml_buffer_mmap_current(  //
     plaidml_error* err,                     //
     plaidml_buffer* buffer);
@@ -32,6 +32,13 @@ using TensorDeriv = std::vector<Tensor> (*)(  //
     const Tensor& dY,                         //
     const std::vector<Tensor>& Xs);
 
+// A TensorDeriv parameterized by an integer known only when the graph is built, such as a reduction axis.
+using IndexedTensorDeriv = std::vector<Tensor> (*)(  //
+    int64_t arg,                                     //
+    const Tensor& Y,                                 //
+    const Tensor& dY,                                //
+    const std::vector<Tensor>& Xs);
+
 namespace details {
 
 struct Deleter {
@@ -795,18 +802,54 @@ inline plaidml_deriv ThunkTensorDeriv(TensorDeriv fn) {
   };
 }
 
-inline Tensor OverrideGrads(TensorDeriv fn, const std::vector<Tensor>& ins, const Tensor& out) {
-  auto thunk = ThunkTensorDeriv(fn);
+// The function is bound at compile time so that the user_ctx is free to carry the integer argument by value; nothing
+// has to outlive the graph.
+template <IndexedTensorDeriv fn>
+inline plaidml_deriv ThunkIndexedTensorDeriv() {
+  return [](void* user_ctx,          //
+            plaidml_expr* Y_expr,    //
+            plaidml_expr* dY_expr,   //
+            size_t nXs,              //
+            plaidml_expr** X_exprs,  //
+            plaidml_expr** dX_exprs) {
+    auto arg = static_cast<int64_t>(reinterpret_cast<intptr_t>(user_ctx));
+    Tensor Y(Y_expr);
+    Tensor dY(dY_expr);
+    std::vector<Tensor> Xs(nXs);
+    for (size_t i = 0; i < Xs.size(); i++) {
+      Xs[i] = Tensor(X_exprs[i]);
+    }
+    auto dXs = fn(arg, Y, dY, Xs);
+    for (size_t i = 0; i < Xs.size(); i++) {
+      dX_exprs[i] = ffi::call<plaidml_expr*>(plaidml_expr_clone, dXs[i].as_ptr());
+    }
+  };
+}
+
+namespace details {
+
+inline Tensor OverrideGrads(plaidml_deriv thunk, void* user_ctx, const std::vector<Tensor>& ins, const Tensor& out) {
   auto nins = ins.size();
   std::vector<plaidml_expr*> in_ptrs(nins);
   for (size_t i = 0; i < ins.size(); i++) {
     in_ptrs[i] = ins[i].as_ptr();
   }
-  auto ptr = ffi::call<plaidml_expr*>(plaidml_expr_grad_override, thunk, reinterpret_cast<void*>(fn), nins,
-                                      in_ptrs.data(), out.as_ptr());
+  auto ptr = ffi::call<plaidml_expr*>(plaidml_expr_grad_override, thunk, user_ctx, nins, in_ptrs.data(), out.as_ptr());
   return Tensor(ptr);
 }
 
+}  // namespace details
+
+inline Tensor OverrideGrads(TensorDeriv fn, const std::vector<Tensor>& ins, const Tensor& out) {
+  return details::OverrideGrads(ThunkTensorDeriv(fn), reinterpret_cast<void*>(fn), ins, out);
+}
+
+template <IndexedTensorDeriv fn>
+inline Tensor OverrideGrads(int64_t arg, const std::vector<Tensor>& ins, const Tensor& out) {
+  auto user_ctx = reinterpret_cast<void*>(static_cast<intptr_t>(arg));
+  return details::OverrideGrads(ThunkIndexedTensorDeriv<fn>(), user_ctx, ins, out);
+}
+
 Tensor Call(const std::string& fn, const std::vector<Tensor>& args);
 
 template <typename... Ts>
@@ -7,6 +7,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -34,6 +35,7 @@ using plaidml::core::GetPlatform;
 using plaidml::core::GlobalContext;
 using vertexai::context::Context;
 using vertexai::tile::Allocator;
+using vertexai::tile::BoundProgram;
 using vertexai::tile::Buffer;
 using vertexai::tile::BufferPtr;
 using vertexai::tile::ConstBufferManager;
@@ -123,6 +125,7 @@ struct plaidml_executable {
   BufferMap input_bufs;
   BufferMap output_bufs;
   std::shared_ptr<Program> program;
+  std::unique_ptr<BoundProgram> bound;
 #ifdef PLAIDML_MLIR
   std::unique_ptr<Executable> exec;
 #endif  // PLAIDML_MLIR
@@ -196,12 +199,7 @@ plaidml_executable* plaidml_compile(  //
       }
     }
 #ifdef PLAIDML_AST
-    ConstBufferManager const_bufs;
-    const_bufs.allocator = std::make_shared<PlatformAllocator>(device);
     auto exec = std::make_unique<plaidml_executable>();
-    auto stripe = vertexai::tile::lang::GenerateStripe(program->eval.runinfo);
-    Context ctx;
-    exec->program = GetPlatform()->MakeProgram(ctx, device, target, stripe, &const_bufs);
     std::unordered_map<ExprPtr, BufferPtr> input_bindings;
     for (size_t i = 0; i < ninputs; i++) {
       auto param_expr = std::dynamic_pointer_cast<ParamExpr>(inputs[i]->expr->expr);
@@ -232,6 +230,31 @@ plaidml_executable* plaidml_compile(  //
     for (const auto& kvp : program->eval.updates) {
       exec->output_bufs[kvp.first] = kvp.second->buffer;
     }
+    // With PLAIDML_CONST_PARAMS=1, parameters whose buffer was attached when the program was built, and which the
+    // program does not update, are compiled as constants, so that their contents are evaluated at compile time.  The
+    // caller must then leave those buffers unchanged for the executable's lifetime.
+    ConstBufferManager const_bufs;
+    const_bufs.allocator = std::make_shared<PlatformAllocator>(device);
+    auto runinfo = program->eval.runinfo;
+    if (vertexai::env::Get("PLAIDML_CONST_PARAMS") == "1") {
+      std::unordered_set<const ParamExpr*> updated;
+      for (const auto& kvp : program->eval.updates) {
+        updated.insert(kvp.second);
+      }
+      for (const auto& arg : program->eval.args) {
+        auto param_expr = std::dynamic_pointer_cast<ParamExpr>(arg.expr);
+        if (!arg.is_input || !param_expr || !param_expr->buffer || updated.count(param_expr.get()) ||
+            exec->input_bufs[arg.name] != param_expr->buffer) {
+          continue;
+        }
+        const_bufs.buffers.emplace(arg.name, param_expr->buffer);
+        runinfo.const_inputs.insert(arg.name);
+      }
+    }
+    auto stripe = vertexai::tile::lang::GenerateStripe(runinfo);
+    Context ctx;
+    exec->program = GetPlatform()->MakeProgram(ctx, device, target, stripe, &const_bufs);
+    exec->bound = exec->program->Bind(ctx, exec->input_bufs, exec->output_bufs);
     return exec.release();
 #endif
 #ifdef PLAIDML_MLIR
@@ -273,6 +296,7 @@ plaidml_executable* plaidml_compile(  //
         exec->output_bufs[name] = arg.buffer;
       }
     }
+    exec->bound = exec->program->Bind(*ctx, exec->input_bufs, exec->output_bufs);
 
     return exec.release();
 #endif
@@ -296,6 +320,10 @@ void plaidml_executable_run(  //
       exec->exec->invoke();
     } else {
 #endif  // PLAIDML_MLIR
+      if (exec->bound) {
+        exec->bound->Run().get();
+        return;
+      }
       auto ctx = GlobalContext::getContext();
       exec->program->Run(*ctx, exec->input_bufs, exec->output_bufs).get();
 #ifdef PLAIDML_MLIR
@@ -523,6 +523,24 @@ std::vector<int64_t>* extend_manual_padding(std::vector<int64_t>* pads, size_t r
   return pads;
 }
 
+// The derivative of softmax along the given axis
+std::vector<Tensor> softmax_deriv(int64_t axis, const Tensor& Y, const Tensor& DY, const std::vector<Tensor>& X) {
+  auto I = X[0];
+  auto ndims = I.shape().ndims();
+  std::vector<TensorDim> I_dims(ndims);
+  std::vector<TensorIndex> I_idxs(ndims);
+  I.bind_dims(I_dims);
+  std::vector<TensorDim> R_dims = I_dims;
+  std::vector<TensorIndex> R_idxs = I_idxs;
+  R_dims[axis] = TensorDim{1};
+  R_idxs[axis] = TensorIndex{0};
+
+  auto YdY = Y * DY;
+  auto T = TensorOutput(R_dims);
+  T(R_idxs) += YdY(I_idxs);
+  return std::vector<Tensor>{YdY - T * Y};
+}
+
 }  // namespace
 
 Value abs(const Value& value) {
@@ -2217,24 +2235,8 @@ Value softmax(const Value& value) {
   auto ndims = I.shape().ndims();
   auto axis = normalize_axis(raw_axis, ndims, "softmax");
 
-  // Ensure the axis is the last dimension, to make the derivative code happy
-  bool transposed = false;
-  std::vector<Value> pattern(ndims);  // Will be reused at the end to return to original order
-  if (axis != ndims - 1) {
-    transposed = true;
-    for (size_t i = 0; i < ndims; ++i) {
-      if (i == axis) {
-        pattern[i] = Value{ndims - 1};
-      } else if (i == ndims - 1) {
-        pattern[i] = Value{axis};
-      } else {
-        pattern[i] = Value{i};
-      }
-    }
-    I = transpose(make_tuple(args[0], Value{pattern})).as_tensor();
-    axis = ndims - 1;  // we've moved the softmax axis to be the last axis
-  }
-
+  // Reduce along the axis where it lies rather than transposing it to the end.  Every contraction and broadcast below
+  // then walks the same rows, which lets the fusion pass compute the whole softmax one row at a time.
   std::vector<TensorDim> I_dims(ndims);
   std::vector<TensorIndex> I_idxs(ndims);
   I.bind_dims(I_dims);
@@ -2249,30 +2251,7 @@ Value softmax(const Value& value) {
   auto N = TensorOutput(R_dims);
   N(R_idxs) += E(I_idxs);
   auto O = E / N;
-  TensorDeriv deriv = [](const Tensor& Y, const Tensor& DY, const std::vector<Tensor>& X) {  //
-    auto I = X[0];
-    auto ndims = I.shape().ndims();
-    std::vector<TensorDim> I_dims(ndims);
-    std::vector<TensorIndex> I_idxs(ndims);
-    I.bind_dims(I_dims);
-    std::vector<TensorDim> R_dims = I_dims;
-    std::vector<TensorIndex> R_idxs = I_idxs;
-    R_dims.back() = TensorDim{1};    // Softmax along last axis
-    R_idxs.back() = TensorIndex{0};  // Softmax along last axis
-
-    auto YdY = Y * DY;
-    auto T = TensorOutput(R_dims);
-    T(R_idxs) += YdY(I_idxs);
-    auto TB = TensorOutput(I_dims);
-    TB(I_idxs) += T(R_idxs);
-    return std::vector<Tensor>{YdY - TB * Y};
-  };
-  auto Overridden = OverrideGrads(deriv, std::vector<Tensor>{I}, O);
-  // If we reordered, return to original order
-  if (transposed) {
-    return transpose(make_tuple(Value{Overridden}, Value{pattern}));
-  }
-  return Value{Overridden};
+  return Value{OverrideGrads<softmax_deriv>(axis, std::vector<Tensor>{I}, O)};
 }
 
 Value spatial_padding(const Value& value) {
@@ -6,6 +6,7 @@
 #include "llvm/ADT/StringRef.h"
 
 #include "base/util/logging.h"
+#include "plaidml2/edsl/autodiff.h"
 #include "plaidml2/op/op.h"
 
 using ::testing::Eq;
@@ -1287,6 +1288,15 @@ module {
 #endif
 }
 
+TEST(Op, SoftmaxGradientAnyAxis) {
+  auto A = Placeholder(PLAIDML_DATA_FLOAT32, {2, 1, 1, 1, 1, 1, 1, 1, 1, 2}, "A");
+  for (auto axis : {0, 2, 9}) {
+    auto O = op::softmax(A, axis);
+    auto dA = Gradient({A}, O)[0];
+    EXPECT_THAT(dA.shape(), Eq(A.shape()));
+  }
+}
+
 TEST(Op, SpatialPadding) {
   auto A = Placeholder(PLAIDML_DATA_FLOAT32, {64, 4, 32, 32}, "A");
   auto X = op::spatial_padding(  //
@@ -5,6 +5,7 @@
 #include <unordered_map>
 #include <utility>
 
+#include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/TargetSelect.h"
 
@@ -207,9 +208,21 @@ Executable::Executable(StringRef entry, StringRef target, ModuleOp programModule
 
   assert(memRefTypes.size() == bufptrs.size() && "memRefTypes and bufptrs size mismatch");
 
+  // Optimize for the host so that LLVM's loop vectorizer can use the native
+  // vector width on the inner tile loops produced by the target pipeline.
+  auto tmBuilderOrError = llvm::orc::JITTargetMachineBuilder::detectHost();
+  if (!tmBuilderOrError) {
+    throw std::runtime_error("Failed to detect the host target machine");
+  }
+  auto tmOrError = tmBuilderOrError->createTargetMachine();
+  if (!tmOrError) {
+    throw std::runtime_error("Failed to create the host target machine");
+  }
+  auto targetMachine = std::move(*tmOrError);
+
   auto optPipeline = makeOptimizingTransformer(
-      /*optLevel=*/0, /*sizeLevel=*/0,
-      /*targetMachine=*/nullptr);
+      /*optLevel=*/3, /*sizeLevel=*/0,
+      /*targetMachine=*/targetMachine.get());
 
   if (VLOG_IS_ON(6)) {
     auto llvmModule = translateModuleToLLVMIR(*module);
@@ -110,8 +110,11 @@ struct AffineReduceOpConversion : public LoweringBase<pxa::AffineReduceOp> {
   explicit AffineReduceOpConversion(MLIRContext* ctx) : LoweringBase(ctx) {}
 
   void rewrite(pxa::AffineReduceOp op, ArrayRef<Value> operands, ConversionPatternRewriter& rewriter) const override {
-    auto source = rewriter.create<AffineLoadOp>(op.getLoc(), op.out(), op.map(), op.idxs());
-    auto reduce = createReduction(rewriter, op, source.getResult());
+    Value reduce = op.val();
+    if (op.agg() != AggregationKind::assign) {
+      auto source = rewriter.create<AffineLoadOp>(op.getLoc(), op.out(), op.map(), op.idxs());
+      reduce = createReduction(rewriter, op, source.getResult());
+    }
     rewriter.create<AffineStoreOp>(op.getLoc(), reduce, op.out(), op.map(), op.idxs());
     rewriter.eraseOp(op);
   }
@@ -119,7 +122,7 @@ struct AffineReduceOpConversion : public LoweringBase<pxa::AffineReduceOp> {
   Value createReduction(ConversionPatternRewriter& rewriter, pxa::AffineReduceOp op, Value source) const {
     switch (op.agg()) {
       case AggregationKind::assign:
-        return source;
+        return op.val();
       case AggregationKind::add: {
         if (source.getType().isa<FloatType>()) {
           return rewriter.create<mlir::AddFOp>(op.getLoc(), source, op.val());
@@ -0,0 +1,218 @@
+// Copyright 2020, Intel Corporation
+
+#include "pmlc/dialect/pxa/transforms/passes.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+
+#include "mlir/Dialect/AffineOps/AffineOps.h"
+#include "mlir/Dialect/StandardOps/Ops.h"
+#include "mlir/IR/AffineExpr.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/Pass/Pass.h"
+
+#include "base/util/logging.h"
+#include "base/util/stream_container.h"
+#include "pmlc/dialect/pxa/ir/ops.h"
+
+namespace pmlc::dialect::pxa {
+
+using mlir::AffineApplyOp;
+using mlir::AffineExpr;
+using mlir::AffineLoadOp;
+using mlir::AffineStoreOp;
+using mlir::OpBuilder;
+using mlir::SmallVector;
+
+namespace {
+
+// A memory access within the body of a parallel_for, expressed in terms of the loop's induction variables.
+struct Access {
+  AffineMap map;
+  std::vector<Value> operands;
+  MemRefType type;
+};
+
+std::vector<Access> collectAccesses(AffineParallelForOp op) {
+  std::vector<Access> accesses;
+  op.inner().walk([&](Operation* inner) {
+    if (auto load = llvm::dyn_cast<AffineLoadOp>(inner)) {
+      accesses.push_back(Access{load.getAffineMap(), {load.getMapOperands().begin(), load.getMapOperands().end()},
+                                load.getMemRefType()});
+    } else if (auto store = llvm::dyn_cast<AffineStoreOp>(inner)) {
+      accesses.push_back(Access{store.getAffineMap(), {store.getMapOperands().begin(), store.getMapOperands().end()},
+                                store.getMemRefType()});
+    } else if (auto reduce = llvm::dyn_cast<AffineReduceOp>(inner)) {
+      accesses.push_back(Access{reduce.map(), {reduce.idxs().begin(), reduce.idxs().end()},
+                                reduce.out().getType().cast<MemRefType>()});
+    }
+  });
+  return accesses;
+}
+
+// Estimates the number of bytes touched by a single tile of the iteration space.
+// Each access contributes the bounding box of the elements it can reach, which
+// overestimates for skewed accesses but is exact for the common strided cases.
+uint64_t computeFootprint(AffineParallelForOp op, const std::vector<Access>& accesses, ArrayRef<int64_t> tile) {
+  auto& body = op.inner().front();
+  uint64_t total = 0;
+  for (const auto& access : accesses) {
+    // Map each access operand back to the loop dimension it comes from (if any).
+    SmallVector<int, 8> argIdx;
+    for (auto operand : access.operands) {
+      int idx = -1;
+      for (unsigned i = 0; i < body.getNumArguments(); i++) {
+        if (operand == body.getArgument(i)) {
+          idx = i;
+          break;
+        }
+      }
+      argIdx.push_back(idx);
+    }
+    uint64_t elements = 1;
+    auto map = access.map;
+    for (unsigned r = 0; r < map.getNumResults(); r++) {
+      SmallVector<int64_t, 8> flat;
+      if (failed(getFlattenedAffineExpr(map.getResult(r), map.getNumDims(), map.getNumSymbols(), &flat))) {
+        // Non-linear access; assume it might touch anything along this dimension.
+        elements *= access.type.getShape()[r];
+        continue;
+      }
+      int64_t extent = 1;
+      for (unsigned d = 0; d < map.getNumDims(); d++) {
+        if (argIdx[d] >= 0) {
+          extent += std::abs(flat[d]) * (tile[argIdx[d]] - 1);
+        }
+      }
+      elements *= extent;
+    }
+    auto elemType = access.type.getElementType();
+    uint64_t elemBytes = std::max(1u, elemType.getIntOrFloatBitWidth() / 8);
+    total += elements * elemBytes;
+  }
+  return total;
+}
+
+// Returns the smallest divisor of `range` which is larger than `current`, or 0 if there is none.
+int64_t nextDivisor(int64_t range, int64_t current) {
+  for (int64_t candidate = current + 1; candidate <= range; candidate++) {
+    if (range % candidate == 0) {
+      return candidate;
+    }
+  }
+  return 0;
+}
+
+// Grows tile sizes round-robin, innermost dimension first, as long as the tile's
+// working set still fits in the cache budget. Only exact divisors are considered
+// since parallel_for has no way to express a partial trailing tile.
+SmallVector<int64_t, 8> chooseTileSizes(AffineParallelForOp op, ArrayRef<int64_t> ranges, uint64_t cacheSize) {
+  auto accesses = collectAccesses(op);
+  SmallVector<int64_t, 8> tile(ranges.size(), 1);
+  bool grew = true;
+  while (grew) {
+    grew = false;
+    for (size_t i = ranges.size(); i-- > 0;) {
+      auto next = nextDivisor(ranges[i], tile[i]);
+      if (!next) {
+        continue;
+      }
+      auto prev = tile[i];
+      tile[i] = next;
+      if (computeFootprint(op, accesses, tile) <= cacheSize) {
+        grew = true;
+      } else {
+        tile[i] = prev;
+      }
+    }
+  }
+  return tile;
+}
+
+// Splits `op` into an outer parallel_for over tiles and an inner parallel_for
+// within each tile; the inner induction variables are rebased onto the tile origin.
+void tileParallelFor(AffineParallelForOp op, ArrayRef<int64_t> ranges, ArrayRef<int64_t> tile) {
+  auto loc = op.getLoc();
+  OpBuilder builder(op);
+  SmallVector<int64_t, 8> outerRanges;
+  for (size_t i = 0; i < ranges.size(); i++) {
+    outerRanges.push_back(ranges[i] / tile[i]);
+  }
+  auto outer = builder.create<AffineParallelForOp>(loc, builder.getI64ArrayAttr(outerRanges), ArrayRef<Value>{});
+  auto outerBody = builder.createBlock(&outer.inner());
+  for (size_t i = 0; i < ranges.size(); i++) {
+    outerBody->addArgument(builder.getIndexType());
+  }
+  builder.create<AffineTerminatorOp>(loc);
+
+  op.getOperation()->moveBefore(outerBody->getTerminator());
+  op.setAttr("ranges", builder.getI64ArrayAttr(tile));
+
+  auto& innerBody = op.inner().front();
+  builder.setInsertionPointToStart(&innerBody);
+  auto ctx = op.getContext();
+  for (size_t i = 0; i < ranges.size(); i++) {
+    auto arg = innerBody.getArgument(i);
+    if (arg.use_empty()) {
+      continue;
+    }
+    AffineExpr expr = mlir::getAffineDimExpr(0, ctx) * tile[i] + mlir::getAffineDimExpr(1, ctx);
+    auto map = AffineMap::get(2, 0, {expr});
+    auto apply = builder.create<AffineApplyOp>(loc, map, ValueRange{outerBody->getArgument(i), arg});
+    for (auto& use : llvm::make_early_inc_range(arg.getUses())) {
+      if (use.getOwner() != apply.getOperation()) {
+        use.set(apply);
+      }
+    }
+  }
+}
+
+struct AutoTilePass : public mlir::FunctionPass<AutoTilePass> {
+  explicit AutoTilePass(unsigned cacheSize = kDefaultTileCacheSize) : cacheSize(cacheSize) {}
+
+  void runOnFunction() override {
+    // Only consider the outermost parallel_for of each nest, and collect first
+    // since tiling restructures the IR being walked.
+    std::vector<AffineParallelForOp> ops;
+    getFunction().walk([&](AffineParallelForOp op) {
+      if (!op.getParentOfType<AffineParallelForOp>()) {
+        ops.push_back(op);
+      }
+    });
+    for (auto op : ops) {
+      if (op.dynamic_ranges().size()) {
+        continue;
+      }
+      SmallVector<int64_t, 8> ranges;
+      for (auto attr : op.ranges().getValue()) {
+        ranges.push_back(attr.cast<IntegerAttr>().getInt());
+      }
+      auto tile = chooseTileSizes(op, ranges, cacheSize);
+      if (tile == ranges) {
+        // The whole iteration space already fits.
+        continue;
+      }
+      IVLOG(3, "pxa-autotile: ranges " << vertexai::StreamContainer(ranges)  //
+                                        << " -> tile " << vertexai::StreamContainer(tile));
+      tileParallelFor(op, ranges, tile);
+    }
+  }
+
+  unsigned cacheSize;
+};
+
+}  // namespace
+
+std::unique_ptr<mlir::OpPassBase<mlir::FuncOp>> createAutoTilePass(unsigned cacheSizeBytes) {
+  return std::make_unique<AutoTilePass>(cacheSizeBytes);
+}
+
+static mlir::PassRegistration<AutoTilePass> pass(  //
+    "pxa-autotile",                                //
+    "Tile pxa.parallel_for ops so that each tile's working set fits in cache");
+
+}  // namespace pmlc::dialect::pxa
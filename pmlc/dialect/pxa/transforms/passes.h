@@ -2,8 +2,19 @@
 
 #pragma once
 
+#include <memory>
+
+namespace mlir {
+class FuncOp;
+template <typename T>
+class OpPassBase;
+}  // namespace mlir
+
 namespace pmlc::dialect::pxa {
 
-//
+// The default working-set budget used when choosing tile sizes (sized for a per-core L2).
+constexpr unsigned kDefaultTileCacheSize = 256 * 1024;
+
+std::unique_ptr<mlir::OpPassBase<mlir::FuncOp>> createAutoTilePass(unsigned cacheSizeBytes = kDefaultTileCacheSize);
 
 }  // namespace pmlc::dialect::pxa
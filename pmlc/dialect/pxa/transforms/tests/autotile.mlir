@@ -0,0 +1,38 @@
+// RUN: pmlc-opt -pxa-autotile %s | FileCheck %s
+
+func @copy(%arg0: memref<1024x1024xf32>, %arg1: memref<1024x1024xf32>) {
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index):
+    %0 = affine.load %arg0[%i, %j] : memref<1024x1024xf32>
+    "pxa.reduce"(%0, %arg1, %i, %j) {agg = 0 : i64, map = (d0, d1) -> (d0, d1)} : (f32, memref<1024x1024xf32>, index, index) -> ()
+    "affine.terminator"() : () -> ()
+  }) {ranges = [1024, 1024]} : () -> ()
+  return
+}
+
+// CHECK-LABEL: func @copy
+// CHECK: pxa.parallel_for
+// CHECK: ^bb0(%[[I0:.*]]: index, %[[J0:.*]]: index):
+// CHECK:   pxa.parallel_for
+// CHECK:   ^bb0(%[[I1:.*]]: index, %[[J1:.*]]: index):
+// CHECK:     affine.apply #{{.*}}(%[[I0]], %[[I1]])
+// CHECK:     affine.apply #{{.*}}(%[[J0]], %[[J1]])
+// CHECK:     affine.load
+// CHECK:     pxa.reduce
+// CHECK:   ranges = [128, 256]
+// CHECK: ranges = [8, 4]
+
+func @small(%arg0: memref<16x16xf32>, %arg1: memref<16x16xf32>) {
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index):
+    %0 = affine.load %arg0[%i, %j] : memref<16x16xf32>
+    "pxa.reduce"(%0, %arg1, %i, %j) {agg = 0 : i64, map = (d0, d1) -> (d0, d1)} : (f32, memref<16x16xf32>, index, index) -> ()
+    "affine.terminator"() : () -> ()
+  }) {ranges = [16, 16]} : () -> ()
+  return
+}
+
+// CHECK-LABEL: func @small
+// CHECK: pxa.parallel_for
+// CHECK-NOT: pxa.parallel_for
+// CHECK: ranges = [16, 16]
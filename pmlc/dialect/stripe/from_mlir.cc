@@ -598,7 +598,15 @@ void StripeBuilder::visit(SpecialOp specialOp) {
     auto out_name = add_refinements(op->getBlock(), op->getOperand(i), stripe::RefDir::Out, "", true);
     stmt->outputs.emplace_back(out_name);
   }
-  stmt->name = util::getOpName(op->getName());
+  stmt->name = util::getOpName(op->getName()).str();
+  // Parameters such as a scan's axis travel as attributes.
+  for (const auto& [key, value] : op->getAttrs()) {
+    if (auto attr = value.dyn_cast<IntegerAttr>()) {
+      stmt->int_params[key.strref().str()] = attr.getInt();
+    } else if (auto attr = value.dyn_cast<StringAttr>()) {
+      stmt->str_params[key.strref().str()] = attr.getValue().str();
+    }
+  }
   cur_->stmts.push_back(stmt);
 }
 
@@ -608,7 +616,7 @@ void StripeBuilder::visit(util::GenericBuilder builder) {
   auto out_name = scalar_name(op);
   scalars_[op->getResult(0)] = out_name;
   auto intr = std::make_shared<stripe::Intrinsic>();
-  intr->name = util::getOpName(op->getName());
+  intr->name = util::getOpName(op->getName()).str();
   if (intr->name == "select") {
     intr->name = "cond";
   }
@@ -203,10 +203,10 @@ static void IntrinsicIntoMLIR(OpBuilder* builder, SymbolTable* locals, const str
     auto tensor = safe_at(locals->scalars, intrinsic.inputs[0]);
     auto op = builder->create<eltwise::CastOp>(builder->getUnknownLoc(), RankedTensorType::get({}, scalarType), tensor);
     locals->scalars.emplace(intrinsic.outputs[0], op.result());
-    op.setAttr("scalar_name", builder->getStringAttr(intrinsic.outputs[0]));
+    op.setAttr("scalar_name", builder->getStringAttr(intrinsic.outputs[0].str()));
     return;
   }
-  auto opName = eltwise::Dialect::getCanonicalOpName(intrinsic.name);
+  auto opName = eltwise::Dialect::getCanonicalOpName(intrinsic.name.str());
   auto abstractOp = mlir::AbstractOperation::lookup(opName, builder->getContext());
   if (!abstractOp) {
     throw std::runtime_error("Unknown intrinsic: " + intrinsic.name);
@@ -222,14 +222,20 @@ static void IntrinsicIntoMLIR(OpBuilder* builder, SymbolTable* locals, const str
   ScalarType scalarType = DataTypeIntoMLIR(builder->getContext(), intrinsic.type);
   auto op = genericBuilder->create(builder, builder->getUnknownLoc(), scalarType, operands);
   locals->scalars.emplace(intrinsic.outputs[0], op->getResult(0));
-  op->setAttr("scalar_name", builder->getStringAttr(intrinsic.outputs[0]));
+  op->setAttr("scalar_name", builder->getStringAttr(intrinsic.outputs[0].str()));
 }
 
 template <typename T>
 static void SpecialConvertImpl(OpBuilder* builder, SymbolTable* locals, const stripe::Special& special) {
   std::vector<Type> no_types;
   std::vector<Value> vals;
-  std::vector<NamedAttribute> no_attrs;
+  std::vector<NamedAttribute> attrs;
+  for (const auto& kvp : special.int_params) {
+    attrs.emplace_back(builder->getIdentifier(kvp.first), builder->getI64IntegerAttr(kvp.second));
+  }
+  for (const auto& kvp : special.str_params) {
+    attrs.emplace_back(builder->getIdentifier(kvp.first), builder->getStringAttr(kvp.second));
+  }
   for (size_t i = 0; i < special.outputs.size(); i++) {
     vals.push_back(safe_at(locals->refs, special.outputs[i]));
   }
@@ -237,7 +243,7 @@ static void SpecialConvertImpl(OpBuilder* builder, SymbolTable* locals, const st
     vals.push_back(safe_at(locals->refs, special.inputs[i]));
   }
   auto unk = builder->getUnknownLoc();
-  auto op = builder->create<T>(unk, no_types, vals, no_attrs);
+  auto op = builder->create<T>(unk, no_types, vals, attrs);
   if (special.outputs.size() != op.getNumOutputs()) {
     throw std::runtime_error(std::string("Special '") + special.name + "' has invalid number of inputs");
   }
@@ -255,6 +261,8 @@ static void SpecialIntoMLIR(OpBuilder* builder, SymbolTable* locals, const strip
     SpecialConvertImpl<GatherOp>(builder, locals, special);
   } else if (special.name == "scatter") {
     SpecialConvertImpl<ScatterOp>(builder, locals, special);
+  } else if (special.name == "scan") {
+    SpecialConvertImpl<ScanOp>(builder, locals, special);
   } else if (special.name == "shape") {
     SpecialConvertImpl<ShapeOp>(builder, locals, special);
   } else if (special.name == "zero") {
@@ -292,7 +300,7 @@ static void BlockIntoMLIR(OpBuilder* builder, const SymbolTable& outer, const st
       if (attrs.size() != 0) {
         any_attrs = true;
       }
-      idx_names.emplace_back(builder->getStringAttr(idx.name));
+      idx_names.emplace_back(builder->getStringAttr(idx.name.str()));
       idx_attrs.emplace_back(attrs);
     } else {
       // Handle the 'passthru' case by computing the appropriate affine and
@@ -386,7 +394,7 @@ static void BlockIntoMLIR(OpBuilder* builder, const SymbolTable& outer, const st
         if (attrs.size()) {
           op.setAttr(Dialect::getStripeAttrsName(), attrs);
         }
-        op.setAttr("scalar_name", builder->getStringAttr(load->into));
+        op.setAttr("scalar_name", builder->getStringAttr(load->into.str()));
         locals.scalars.emplace(load->into, op);
       } break;
       case stripe::StmtKind::LoadIndex: {
@@ -395,7 +403,7 @@ static void BlockIntoMLIR(OpBuilder* builder, const SymbolTable& outer, const st
         Type idx_base = ScalarType::get(builder->getContext(), DataType::INT32);
         Type idx_type = eltwise::getRankedTensorType(idx_base);
         auto op = builder->create<LoadIndexOp>(unknownLoc, idx_type, from);
-        op.setAttr("scalar_name", builder->getStringAttr(load_idx->into));
+        op.setAttr("scalar_name", builder->getStringAttr(load_idx->into.str()));
         locals.scalars.emplace(load_idx->into, op);
       } break;
       case stripe::StmtKind::Store: {
@@ -431,12 +439,12 @@ static void BlockIntoMLIR(OpBuilder* builder, const SymbolTable& outer, const st
           case stripe::ConstType::Integer:
             op = builder->create<eltwise::ScalarConstantOp>(
                 unknownLoc, ScalarType::get(builder->getContext(), DataType::INT32), cnst->iconst);
-            op.setAttr("scalar_name", builder->getStringAttr(cnst->name));
+            op.setAttr("scalar_name", builder->getStringAttr(cnst->name.str()));
             break;
           case stripe::ConstType::Float:
             op = builder->create<eltwise::ScalarConstantOp>(
                 unknownLoc, ScalarType::get(builder->getContext(), DataType::FLOAT32), cnst->fconst);
-            op.setAttr("scalar_name", builder->getStringAttr(cnst->name));
+            op.setAttr("scalar_name", builder->getStringAttr(cnst->name.str()));
             break;
         }
         locals.scalars.emplace(cnst->name, op);
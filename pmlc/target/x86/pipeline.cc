@@ -4,22 +4,38 @@
 #include "mlir/Conversion/StandardToLLVM/ConvertStandardToLLVMPass.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Pass/PassManager.h"
+#include "mlir/Pass/PassRegistry.h"
 #include "mlir/Transforms/Passes.h"
 
 #include "pmlc/compiler/registry.h"
 #include "pmlc/conversion/pxa_to_affine/pxa_to_affine.h"
+#include "pmlc/dialect/pxa/transforms/passes.h"
 
 using namespace mlir;  // NOLINT[build/namespaces]
 using pmlc::conversion::pxa_to_affine::createLowerPXAToAffinePass;
+using pmlc::dialect::pxa::createAutoTilePass;
 
 namespace pmlc::target::x86 {
 
-static compiler::TargetRegistration pipeline("llvm_cpu", [](OpPassManager* pm) {
-  // TODO: do optimizations here
+// Tiles each parallel_for and lowers it to affine loops with the loop-invariant
+// work hoisted out of the inner tile loops.
+static void addTilingPasses(OpPassManager& pm) {  // NOLINT[runtime/references]
+  // Split each parallel_for into cache-sized tiles; the inner tile loops are
+  // what the LLVM loop vectorizer sees once the module is JIT compiled.
+  pm.addNestedPass<FuncOp>(createAutoTilePass());
+  pm.addNestedPass<FuncOp>(createCanonicalizerPass());
 
-  pm->addPass(createLowerPXAToAffinePass());
-  pm->addNestedPass<FuncOp>(createCanonicalizerPass());
-  pm->addNestedPass<FuncOp>(createCSEPass());
+  pm.addPass(createLowerPXAToAffinePass());
+  pm.addNestedPass<FuncOp>(createCanonicalizerPass());
+  pm.addNestedPass<FuncOp>(createCSEPass());
+
+  // Hoist loads and index math that don't depend on the inner tile loops.
+  pm.addNestedPass<FuncOp>(createAffineLoopInvariantCodeMotionPass());
+  pm.addNestedPass<FuncOp>(createCanonicalizerPass());
+}
+
+static compiler::TargetRegistration pipeline("llvm_cpu", [](OpPassManager* pm) {
+  addTilingPasses(*pm);
 
   pm->addPass(createLowerAffinePass());
   pm->addNestedPass<FuncOp>(createCanonicalizerPass());
@@ -28,4 +44,9 @@ static compiler::TargetRegistration pipeline("llvm_cpu", [](OpPassManager* pm) {
   pm->addPass(createLowerToLLVMPass(true));
 });
 
+static PassPipelineRegistration<> tilingPipeline(  //
+    "x86-tile",                                    //
+    "Tile PXA and lower it to affine loops as the llvm_cpu target does",
+    addTilingPasses);
+
 }  // namespace pmlc::target::x86
@@ -0,0 +1,31 @@
+// RUN: pmlc-opt -x86-tile %s | FileCheck %s
+
+func @broadcast_add(%arg0: memref<1024x1024xf32>, %arg1: memref<1024xf32>, %arg2: memref<1024x1024xf32>) {
+  "pxa.parallel_for"() ( {
+  ^bb0(%i: index, %j: index):
+    %0 = affine.load %arg0[%i, %j] : memref<1024x1024xf32>
+    %1 = affine.load %arg1[%i] : memref<1024xf32>
+    %2 = addf %0, %1 : f32
+    "pxa.reduce"(%2, %arg2, %i, %j) {agg = 0 : i64, map = (d0, d1) -> (d0, d1)} : (f32, memref<1024x1024xf32>, index, index) -> ()
+    "affine.terminator"() : () -> ()
+  }) {ranges = [1024, 1024]} : () -> ()
+  return
+}
+
+// The iteration space is split into an outer band over tiles and an inner
+// band within each tile, all as plain affine loops.
+// CHECK-LABEL: func @broadcast_add
+// CHECK-NOT: pxa.
+// CHECK: affine.for %{{.*}} = 0 to {{[0-9]+}} {
+// CHECK-NEXT: affine.for %{{.*}} = 0 to {{[0-9]+}} {
+// CHECK-NEXT: affine.for %{{.*}} = 0 to {{[0-9]+}} {
+
+// The load of %arg1 does not depend on the innermost loop, so it is hoisted
+// out of it; what remains is a unit-stride loop over the last dimension of
+// each tile, which is the shape the LLVM loop vectorizer needs.
+// CHECK-NEXT: %[[B:.*]] = affine.load %arg1[
+// CHECK-NEXT: affine.for %[[J:.*]] = 0 to {{[0-9]+}} {
+// CHECK-NEXT: %[[A:.*]] = affine.load %arg0[{{.*}}%[[J]]]
+// CHECK-NEXT: %[[SUM:.*]] = addf %[[A]], %[[B]]
+// CHECK-NEXT: affine.store %[[SUM]], %arg2[{{.*}}%[[J]]]
+// CHECK-NOT: pxa.
@@ -0,0 +1,315 @@
+// Copyright 2020, Intel Corporation.
+
+#include "tile/base/batch_bucket.h"
+
+#include <cstring>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "base/util/logging.h"
+#include "tile/lang/parser.h"
+#include "tile/lang/type.h"
+#include "tile/proto/support.h"
+
+namespace vertexai {
+namespace tile {
+namespace {
+
+std::uint64_t NextPowerOfTwo(std::uint64_t n) {
+  std::uint64_t result = 1;
+  while (result < n) {
+    result <<= 1;
+  }
+  return result;
+}
+
+// Returns the index variable making up the polynomial, if it is exactly a single index.
+std::string SoleIndex(const math::Polynomial<math::Rational>& poly) {
+  const auto& terms = poly.getMap();
+  if (terms.size() != 1 || terms.begin()->first.empty() || terms.begin()->second != 1) {
+    return "";
+  }
+  return terms.begin()->first;
+}
+
+bool Mentions(const math::Polynomial<math::Rational>& poly, const std::string& idx) {
+  return poly.getMap().count(idx) != 0;
+}
+
+ShapeMap WithBatch(const ShapeMap& shapes, const std::map<std::string, std::uint64_t>& row_bytes,
+                   std::uint64_t batch) {
+  ShapeMap result = shapes;
+  for (auto& kvp : result) {
+    if (row_bytes.count(kvp.first)) {
+      kvp.second.dims[0].size = batch;
+    }
+  }
+  return result;
+}
+
+// Determines which program variables vary with the batch size, by comparing bindings at two different sizes.
+// Returns false if the batch size leaks into anything other than the outermost dimension of tensors.
+bool FindBatchVariables(const lang::Bindings& base, const lang::Bindings& probe, std::set<std::string>* vars) {
+  for (const auto& kvp : probe) {
+    auto it = base.find(kvp.first);
+    if (it == base.end()) {
+      return false;
+    }
+    const auto& lhs = it->second;
+    const auto& rhs = kvp.second;
+    if (lhs.tag != rhs.tag) {
+      return false;
+    }
+    if (lhs.tag != lang::Binding::TENSOR) {
+      if (!(lhs == rhs)) {
+        return false;
+      }
+      continue;
+    }
+    if (lhs.shape.dims.size() != rhs.shape.dims.size()) {
+      return false;
+    }
+    bool same = true;
+    for (size_t i = 0; i < lhs.shape.dims.size(); i++) {
+      if (lhs.shape.dims[i].size == rhs.shape.dims[i].size) {
+        continue;
+      }
+      if (i) {
+        return false;
+      }
+      same = false;
+    }
+    if (!same) {
+      vars->insert(kvp.first);
+    }
+  }
+  return true;
+}
+
+// Verifies that no operation combines values from different rows of the batch.
+bool RowsIndependent(const lang::Program& prog, const lang::Bindings& vars, const std::set<std::string>& batch_vars) {
+  auto rank = [&vars](const std::string& name) { return vars.at(name).shape.dims.size(); };
+  for (const auto& op : prog.ops) {
+    bool out_batch = batch_vars.count(op.output);
+    bool in_batch = false;
+    for (const auto& input : op.inputs) {
+      in_batch |= batch_vars.count(input) != 0;
+    }
+    switch (op.tag) {
+      case lang::Op::CONSTANT:
+        break;
+      case lang::Op::FUNCTION:
+        if (!in_batch) {
+          break;
+        }
+        if (!out_batch || op.f.is_special()) {
+          return false;
+        }
+        // Elementwise functions broadcast from the innermost dimension, so a batch input of a different rank
+        // would have its rows aligned with some other dimension of the output.  A reshape keeping the batch
+        // outermost preserves rows, since each row is contiguous.
+        if (op.f.fn != "reshape") {
+          for (const auto& input : op.inputs) {
+            if (batch_vars.count(input) && rank(input) != rank(op.output)) {
+              return false;
+            }
+          }
+        }
+        break;
+      case lang::Op::CONTRACTION: {
+        if (!out_batch) {
+          if (in_batch) {
+            return false;
+          }
+          break;
+        }
+        const auto& specs = op.c.specs;
+        auto idx = SoleIndex(specs[0].spec[0]);
+        if (idx.empty()) {
+          return false;
+        }
+        for (size_t i = 0; i < specs.size(); i++) {
+          bool spec_batch = i == 0 || batch_vars.count(specs[i].id);
+          for (size_t d = 0; d < specs[i].spec.size(); d++) {
+            if (spec_batch && d == 0) {
+              if (!(specs[i].spec[0] == specs[0].spec[0])) {
+                return false;
+              }
+            } else if (Mentions(specs[i].spec[d], idx)) {
+              return false;
+            }
+          }
+        }
+        for (const auto& constraint : op.c.constraints) {
+          if (Mentions(constraint.bound.poly, idx)) {
+            return false;
+          }
+        }
+      } break;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+bool ComputeBatchBucket(const proto::Program& program, const ConstBufferManager* const_bufs, BatchBucket* bucket,
+                        proto::Program* bucketed) {
+  auto inputs = FromProto(program.inputs());
+  auto outputs = FromProto(program.outputs());
+
+  // The batch size is taken from the outputs, all of which must agree and be dense along the batch dimension.
+  BatchBucket result;
+  for (const auto& kvp : outputs) {
+    const auto& shape = kvp.second;
+    if (shape.dims.empty() || (result.batch && shape.dims[0].size != result.batch)) {
+      return false;
+    }
+    result.batch = shape.dims[0].size;
+    if (shape.dims[0].stride * result.batch != shape.elem_size()) {
+      return false;
+    }
+    result.row_bytes[kvp.first] = shape.byte_size() / result.batch;
+  }
+  if (!result.batch) {
+    return false;
+  }
+  for (const auto& kvp : inputs) {
+    const auto& shape = kvp.second;
+    if ((const_bufs && const_bufs->buffers.count(kvp.first)) || shape.dims.empty() ||
+        shape.dims[0].size != result.batch) {
+      continue;
+    }
+    if (shape.dims[0].stride * result.batch != shape.elem_size()) {
+      return false;
+    }
+    result.row_bytes[kvp.first] = shape.byte_size() / result.batch;
+  }
+  result.bucket = NextPowerOfTwo(result.batch);
+
+  // Bind the program at two different batch sizes; whatever changes between the two carries the batch dimension.
+  auto probe_batch = result.bucket == result.batch ? 2 * result.bucket : result.bucket;
+  lang::Parser parser;
+  auto base_prog = parser.Parse(program.code());
+  auto probe_prog = base_prog;
+  lang::Bindings base_vars, probe_vars;
+  try {
+    base_vars = lang::BindProgram(&base_prog, inputs, outputs);
+    probe_vars = lang::BindProgram(&probe_prog, WithBatch(inputs, result.row_bytes, probe_batch),
+                                   WithBatch(outputs, result.row_bytes, probe_batch));
+  } catch (const std::exception& ex) {
+    IVLOG(2, "Not bucketing batch of " << program.id() << ": " << ex.what());
+    return false;
+  }
+  std::set<std::string> batch_vars;
+  if (!FindBatchVariables(base_vars, probe_vars, &batch_vars)) {
+    IVLOG(2, "Not bucketing batch of " << program.id() << ": batch size is used as a value");
+    return false;
+  }
+  for (const auto& kvp : result.row_bytes) {
+    if (!batch_vars.count(kvp.first)) {
+      return false;
+    }
+  }
+  if (!RowsIndependent(probe_prog, probe_vars, batch_vars)) {
+    IVLOG(2, "Not bucketing batch of " << program.id() << ": rows are not independent");
+    return false;
+  }
+
+  bucketed->CopyFrom(program);
+  for (auto& kvp : *bucketed->mutable_inputs()) {
+    if (result.row_bytes.count(kvp.first)) {
+      kvp.second.mutable_shape()->mutable_dims(0)->set_size(result.bucket);
+    }
+  }
+  for (auto& kvp : *bucketed->mutable_outputs()) {
+    kvp.second.mutable_shape()->mutable_dims(0)->set_size(result.bucket);
+  }
+  *bucket = std::move(result);
+  return true;
+}
+
+BatchPaddedProgram::BatchPaddedProgram(std::shared_ptr<Program> program, BatchBucket bucket,
+                                       std::shared_ptr<Platform> platform, std::string dev_id)
+    : program_{std::move(program)},
+      bucket_{std::move(bucket)},
+      platform_{std::move(platform)},
+      dev_id_{std::move(dev_id)} {}
+
+boost::future<void> BatchPaddedProgram::Run(const context::Context& ctx,
+                                            std::map<std::string, std::shared_ptr<Buffer>> inputs,
+                                            std::map<std::string, std::shared_ptr<Buffer>> outputs) {
+  // The batch inputs are padded once their current contents can be mapped, on the completion pool rather than the
+  // caller's thread; the program runs once they have all been padded.
+  std::vector<std::shared_ptr<Buffer>> sources;
+  std::vector<boost::future<std::unique_ptr<View>>> mapped;
+  // (padded buffer, bytes per row)
+  std::vector<std::pair<std::shared_ptr<Buffer>, std::uint64_t>> pads;
+  for (auto& kvp : inputs) {
+    auto it = bucket_.row_bytes.find(kvp.first);
+    if (it == bucket_.row_bytes.end()) {
+      continue;
+    }
+    auto padded = platform_->MakeBuffer(ctx, dev_id_, it->second * bucket_.bucket);
+    sources.emplace_back(kvp.second);
+    mapped.emplace_back(kvp.second->MapCurrent(ctx));
+    pads.emplace_back(padded, it->second);
+    kvp.second = std::move(padded);
+  }
+  auto ready = boost::when_all(mapped.begin(), mapped.end());
+  auto pads_done = ready
+                       .then(CompletionPool(),
+                             [ctx, batch = bucket_.batch, pads = std::move(pads)](decltype(ready) fut) {
+                               auto views = fut.get();
+                               for (size_t i = 0; i < pads.size(); i++) {
+                                 auto src = views[i].get();
+                                 auto row = pads[i].second;
+                                 auto real = row * batch;
+                                 auto dst = pads[i].first->MapDiscard(ctx);
+                                 std::memcpy(dst->data(), src->data(), real);
+                                 for (auto pos = real; pos < dst->size(); pos += row) {
+                                   std::memcpy(dst->data() + pos, src->data() + real - row, row);
+                                 }
+                                 dst->WriteBack(ctx);
+                               }
+                             })
+                       .share();
+  for (const auto& source : sources) {
+    if (!source->AddPendingRead(pads_done)) {
+      // Nothing would stop the caller overwriting this input before it has been copied.
+      pads_done.wait();
+    }
+  }
+
+  // (user buffer, padded buffer, bytes to copy back)
+  std::vector<std::tuple<std::shared_ptr<Buffer>, std::shared_ptr<Buffer>, std::uint64_t>> copies;
+  for (auto& kvp : outputs) {
+    auto row = bucket_.row_bytes.at(kvp.first);
+    auto padded = platform_->MakeBuffer(ctx, dev_id_, row * bucket_.bucket);
+    copies.emplace_back(kvp.second, padded, row * bucket_.batch);
+    kvp.second = std::move(padded);
+  }
+
+  auto result = pads_done
+                    .then(CompletionPool(),
+                          [ctx, program = program_, inputs = std::move(inputs),
+                           outputs = std::move(outputs)](boost::shared_future<void> fut) mutable {
+                            fut.get();
+                            return program->Run(ctx, std::move(inputs), std::move(outputs));
+                          })
+                    .unwrap();
+  return result.then(CompletionPool(), [ctx, copies = std::move(copies)](boost::future<void> fut) {
+    fut.get();
+    for (const auto& copy : copies) {
+      auto src = std::get<1>(copy)->MapCurrent(ctx).get();
+      auto dst = std::get<0>(copy)->MapDiscard(ctx);
+      std::memcpy(dst->data(), src->data(), std::get<2>(copy));
+      dst->WriteBack(ctx);
+    }
+  });
+}
+
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,61 @@
+// Copyright 2020, Intel Corporation.
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "base/context/context.h"
+#include "tile/base/buffer.h"
+#include "tile/base/platform.h"
+#include "tile/base/program.h"
+#include "tile/proto/tile.pb.h"
+
+namespace vertexai {
+namespace tile {
+
+// Describes how a program's outermost (batch) dimension is padded up to a bucket, so that a single compiled program
+// can serve every batch size within the bucket.
+struct BatchBucket {
+  std::uint64_t batch = 0;
+  std::uint64_t bucket = 0;
+  std::map<std::string, std::uint64_t> row_bytes;  // The size of one row of each batch input and output
+};
+
+// Determines whether the program can be compiled for a power-of-two batch bucket.  On success, the bucket is
+// described by *bucket and *bucketed is set to the program with its batch dimensions widened to the bucket size.
+//
+// A program is eligible only if its rows are provably independent: every output carries the batch dimension, and
+// no operation mixes values from different rows (e.g. a reduction over the batch, or a reshape folding the batch into
+// another dimension).  Constant inputs never carry the batch dimension.
+bool ComputeBatchBucket(const proto::Program& program, const ConstBufferManager* const_bufs, BatchBucket* bucket,
+                        proto::Program* bucketed);
+
+// Runs a program compiled for a batch bucket against tensors of the original batch size.
+//
+// Batch inputs are copied into bucket-sized buffers, with the padding rows replicating the last real row (so that
+// padding never introduces values the program would not otherwise see, e.g. zero divisors); batch outputs are
+// computed into bucket-sized buffers and their real rows copied back.
+class BatchPaddedProgram final : public Program {
+ public:
+  BatchPaddedProgram(std::shared_ptr<Program> program, BatchBucket bucket, std::shared_ptr<Platform> platform,
+                     std::string dev_id);
+
+  boost::future<void> Run(const context::Context& ctx,                             //
+                          std::map<std::string, std::shared_ptr<Buffer>> inputs,  //
+                          std::map<std::string, std::shared_ptr<Buffer>> outputs) final;
+
+  std::size_t MaxAvailableMemory() final { return program_->MaxAvailableMemory(); }
+
+  void Release() final { program_->Release(); }
+
+ private:
+  std::shared_ptr<Program> program_;
+  BatchBucket bucket_;
+  std::shared_ptr<Platform> platform_;
+  std::string dev_id_;
+};
+
+}  // namespace tile
+}  // namespace vertexai
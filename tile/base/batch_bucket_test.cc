@@ -0,0 +1,208 @@
+// Copyright 2020, Intel Corporation.
+
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tile/base/batch_bucket.h"
+#include "tile/base/platform.h"
+#include "tile/base/program_cache.h"
+#include "tile/proto/support.h"
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+using ::testing::Eq;
+using ::testing::IsFalse;
+using ::testing::IsTrue;
+using ::testing::Key;
+using ::testing::Ne;
+
+namespace vertexai {
+namespace tile {
+namespace {
+
+proto::Program MakeProgram(const std::string& code, const ShapeMap& inputs, const ShapeMap& outputs) {
+  proto::Program program;
+  program.set_code(code);
+  *program.mutable_inputs() = IntoProtoInput(inputs);
+  *program.mutable_outputs() = IntoProtoOutput(outputs);
+  return program;
+}
+
+TEST(BatchBucketTest, BucketsDense) {
+  auto program = MakeProgram(R"(
+    function (I[N, K], W[K, M], B[M]) -> (O) {
+      T[n, m : N, M] = +(I[n, k] * W[k, m]);
+      O = T + B;
+    })",
+                             {{"I", SimpleShape(DataType::FLOAT32, {5, 16})},
+                              {"W", SimpleShape(DataType::FLOAT32, {16, 8})},
+                              {"B", SimpleShape(DataType::FLOAT32, {8})}},
+                             {{"O", SimpleShape(DataType::FLOAT32, {5, 8})}});
+  BatchBucket bucket;
+  proto::Program bucketed;
+  EXPECT_THAT(ComputeBatchBucket(program, nullptr, &bucket, &bucketed), IsTrue());
+  EXPECT_THAT(bucket.batch, Eq(5));
+  EXPECT_THAT(bucket.bucket, Eq(8));
+  EXPECT_THAT(bucket.row_bytes, ElementsAre(Key("I"), Key("O")));
+  EXPECT_THAT(bucketed.inputs().at("I").shape().dims(0).size(), Eq(8));
+  EXPECT_THAT(bucketed.inputs().at("W").shape().dims(0).size(), Eq(16));
+  EXPECT_THAT(bucketed.outputs().at("O").shape().dims(0).size(), Eq(8));
+}
+
+TEST(BatchBucketTest, RejectsBatchReduction) {
+  auto program = MakeProgram(R"(
+    function (I[N, K]) -> (O) {
+      S[k : K] = +(I[n, k]);
+      O = I - S;
+    })",
+                             {{"I", SimpleShape(DataType::FLOAT32, {5, 16})}},
+                             {{"O", SimpleShape(DataType::FLOAT32, {5, 16})}});
+  BatchBucket bucket;
+  proto::Program bucketed;
+  EXPECT_THAT(ComputeBatchBucket(program, nullptr, &bucket, &bucketed), IsFalse());
+}
+
+TEST(BatchBucketTest, RejectsBatchAsValue) {
+  auto program = MakeProgram(R"(
+    function (I[N, K]) -> (O) {
+      O = I / N;
+    })",
+                             {{"I", SimpleShape(DataType::FLOAT32, {5, 16})}},
+                             {{"O", SimpleShape(DataType::FLOAT32, {5, 16})}});
+  BatchBucket bucket;
+  proto::Program bucketed;
+  EXPECT_THAT(ComputeBatchBucket(program, nullptr, &bucket, &bucketed), IsFalse());
+}
+
+// A buffer whose current contents only become mappable once the test releases them, and which records its readers.
+class DeferredBuffer final : public Buffer {
+ public:
+  explicit DeferredBuffer(std::vector<char> data) : data_{std::move(data)}, ready_{ready_promise_.get_future()} {}
+
+  void Release() { ready_promise_.set_value(); }
+
+  uint64_t size() const final { return data_.size(); }
+
+  boost::future<std::unique_ptr<View>> MapCurrent(const context::Context& ctx) final {
+    return ready_.then([this](boost::shared_future<void> fut) -> std::unique_ptr<View> {
+      fut.get();
+      return MapDiscard(context::Context{});
+    });
+  }
+
+  std::unique_ptr<View> MapDiscard(const context::Context& ctx) final {
+    return std::make_unique<DeferredView>(data_.data(), data_.size());
+  }
+
+  bool AddPendingRead(boost::shared_future<void> done) final {
+    readers.emplace_back(std::move(done));
+    return true;
+  }
+
+  std::vector<boost::shared_future<void>> readers;
+
+ private:
+  class DeferredView final : public View {
+   public:
+    DeferredView(char* data, std::size_t size) : View(data, size) {}
+    void WriteBack(const context::Context& ctx) final {}
+  };
+
+  std::vector<char> data_;
+  boost::promise<void> ready_promise_;
+  boost::shared_future<void> ready_;
+};
+
+class HostPlatform final : public Platform {
+ public:
+  std::shared_ptr<Buffer> MakeBuffer(const context::Context& ctx, const std::string& device,
+                                     std::uint64_t size) final {
+    return std::make_shared<SimpleBuffer>(size);
+  }
+  std::shared_ptr<Program> MakeProgram(const context::Context& ctx, const proto::Program& program,
+                                       ConstBufferManager* const_bufs) final {
+    return nullptr;
+  }
+  void ListDevices(const context::Context& ctx, const proto::ListDevicesRequest& request,
+                   proto::ListDevicesResponse* response) final {}
+  void RegisterCostModel(const lang::TileCostFunction& cost_fn) final {}
+  std::vector<std::string> ListDevices() final { return {}; }
+  std::shared_ptr<Program> MakeProgram(const context::Context& ctx, const std::string& device,
+                                       const std::string& target, const std::shared_ptr<stripe::Program>& program,
+                                       ConstBufferManager* const_bufs) final {
+    return nullptr;
+  }
+};
+
+// Computes O = I + 1, bytewise, and records the input it was run against.
+class IncrementProgram final : public Program {
+ public:
+  boost::future<void> Run(const context::Context& ctx, std::map<std::string, std::shared_ptr<Buffer>> inputs,
+                          std::map<std::string, std::shared_ptr<Buffer>> outputs) final {
+    auto in = inputs.at("I")->MapCurrent(ctx).get();
+    auto out = outputs.at("O")->MapDiscard(ctx);
+    seen.assign(in->begin(), in->end());
+    for (size_t i = 0; i < in->size(); i++) {
+      (*out)[i] = (*in)[i] + 1;
+    }
+    out->WriteBack(ctx);
+    return boost::make_ready_future();
+  }
+  std::size_t MaxAvailableMemory() final { return 0; }
+  void Release() final {}
+
+  std::vector<char> seen;
+};
+
+TEST(BatchPaddedProgramTest, PadsInputsWithoutBlockingTheCaller) {
+  BatchBucket bucket;
+  bucket.batch = 3;
+  bucket.bucket = 4;
+  bucket.row_bytes = {{"I", 2}, {"O", 2}};
+  auto inner = std::make_shared<IncrementProgram>();
+  BatchPaddedProgram program{inner, bucket, std::make_shared<HostPlatform>(), "dev"};
+
+  context::Context ctx;
+  auto input = std::make_shared<DeferredBuffer>(std::vector<char>{1, 2, 3, 4, 5, 6});
+  auto output = std::make_shared<SimpleBuffer>(6);
+  auto done = program.Run(ctx, {{"I", input}}, {{"O", output}});
+  ASSERT_THAT(input->readers.size(), Eq(1));
+  EXPECT_THAT(input->readers[0].is_ready(), IsFalse());
+  EXPECT_THAT(done.is_ready(), IsFalse());
+
+  input->Release();
+  done.get();
+  EXPECT_THAT(input->readers[0].is_ready(), IsTrue());
+  EXPECT_THAT(inner->seen, ElementsAreArray({1, 2, 3, 4, 5, 6, 5, 6}));
+  auto result = output->MapCurrent(ctx).get();
+  EXPECT_THAT(std::vector<char>(result->begin(), result->end()), ElementsAreArray({2, 3, 4, 5, 6, 7}));
+}
+
+TEST(ProgramCacheTest, SharesProgramsOnlyAcrossTheSameConstants) {
+  ProgramCache cache{std::make_shared<HostPlatform>(), 16};
+  context::Context ctx;
+  auto program = MakeProgram("function (W[N], X[N]) -> (Y) { Y = W + X; }",
+                             {{"W", SimpleShape(DataType::FLOAT32, {4})}, {"X", SimpleShape(DataType::FLOAT32, {4})}},
+                             {{"Y", SimpleShape(DataType::FLOAT32, {4})}});
+  auto id = [&](ConstBufferManager* const_bufs) { return std::get<0>(cache.GetProgram(ctx, "", program, const_bufs)); };
+
+  ConstBufferManager weights;
+  weights.buffers["W"] = std::make_shared<SimpleBuffer>(16);
+  ConstBufferManager same_weights;
+  same_weights.buffers["W"] = weights.buffers["W"];
+  ConstBufferManager other_weights;
+  other_weights.buffers["W"] = std::make_shared<SimpleBuffer>(16);
+
+  auto compiled = id(&weights);
+  EXPECT_THAT(id(&same_weights), Eq(compiled));
+  EXPECT_THAT(id(&other_weights), Ne(compiled));
+  EXPECT_THAT(id(nullptr), Ne(compiled));
+}
+
+}  // namespace
+}  // namespace tile
+}  // namespace vertexai
@@ -76,6 +76,11 @@ class Buffer {
   // existing contents.
   virtual std::unique_ptr<View> MapDiscard(const context::Context& ctx) = 0;
 
+  // Records that the host is still reading the buffer's current contents through a view, until done completes, so
+  // that later overwrites wait for it.  Returns false if the buffer doesn't track such readers, in which case the
+  // caller must finish reading before returning the buffer to its owner.
+  virtual bool AddPendingRead(boost::shared_future<void> done) { return false; }
+
   virtual BufferPtr Clone() { throw std::runtime_error("Not implemented"); }
 };
 
@@ -2,8 +2,10 @@
 
 #pragma once
 
+#include <functional>
 #include <list>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -31,6 +33,18 @@ class Platform {
       const std::string& device,               //
       std::uint64_t size) = 0;
 
+  // Wraps caller-owned host memory as a buffer on the target device, so that programs read and write it in place.
+  // The memory must remain valid until release is called, once the buffer, its views, and any runs using it are
+  // gone.  If the device cannot use the memory directly, this throws, and the memory remains the caller's.
+  virtual std::shared_ptr<Buffer> MakeExternalBuffer(  //
+      const context::Context& ctx,                     //
+      const std::string& device,                       //
+      char* data,                                      //
+      std::uint64_t size,                              //
+      std::function<void()> release) {
+    throw std::runtime_error("External buffers are not supported on device " + device);
+  }
+
   // Builds (pre-compiling if possible) a program for executing the supplied Program
   virtual std::shared_ptr<Program> MakeProgram(  //
       const context::Context& ctx,               //
@@ -0,0 +1,14 @@
+// Copyright 2020, Intel Corporation.
+
+#include "tile/base/program.h"
+
+namespace vertexai {
+namespace tile {
+
+boost::executors::basic_thread_pool& CompletionPool() {
+  static boost::executors::basic_thread_pool pool{2};
+  return pool;
+}
+
+}  // namespace tile
+}  // namespace vertexai
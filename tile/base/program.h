@@ -7,12 +7,24 @@
 #include <memory>
 #include <string>
 
+#include <boost/thread/executors/basic_thread_pool.hpp>
+
 #include "base/context/context.h"
 #include "tile/base/buffer.h"
 
 namespace vertexai {
 namespace tile {
 
+// BoundProgram is a Program with a fixed set of buffers, prepared for repeated runs.
+class BoundProgram {
+ public:
+  virtual ~BoundProgram() {}
+
+  // Runs the program against its bound buffers.  As with Program::Run, the run is complete once the returned future is
+  // resolved.
+  virtual boost::future<void> Run() = 0;
+};
+
 // Program represents a Tile program that's been compiled by a Platform.
 class Program {
  public:
@@ -29,6 +41,16 @@ class Program {
       std::map<std::string, std::shared_ptr<Buffer>> inputs,
       std::map<std::string, std::shared_ptr<Buffer>> outputs) = 0;
 
+  // Binds buffers for repeated runs, resolving everything that does not vary between runs up front.  Bound runs are
+  // ordered against other runs using the same buffers just as Program::Run's are.  Returns nullptr if the program does not support
+  // binding, in which case callers should use Run().
+  virtual std::unique_ptr<BoundProgram> Bind(                       //
+      const context::Context& ctx,                                  //
+      const std::map<std::string, std::shared_ptr<Buffer>>& inputs,  //
+      const std::map<std::string, std::shared_ptr<Buffer>>& outputs) {
+    return nullptr;
+  }
+
   // The maximum available memory
   virtual std::size_t MaxAvailableMemory() = 0;
 
@@ -36,5 +58,9 @@ class Program {
   virtual void Release() = 0;
 };
 
+// The pool on which program completions are handled.  A continuation only runs once its run has finished, so a
+// couple of threads keep up with any run rate, instead of each run holding a thread.
+boost::executors::basic_thread_pool& CompletionPool();
+
 }  // namespace tile
 }  // namespace vertexai
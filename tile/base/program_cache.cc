@@ -2,22 +2,45 @@
 
 #include "tile/base/program_cache.h"
 
+#include <cstring>
 #include <map>
-#include <sstream>
 
 #include "base/util/logging.h"
 
 namespace vertexai {
 namespace tile {
 
-ProgramCache::ProgramCache(std::shared_ptr<Platform> platform, std::size_t size_max)
-    : platform_{platform}, cache_{size_max} {}
+constexpr std::size_t ProgramCache::kNumShards;
+
+ProgramCache::ProgramCache(std::shared_ptr<Platform> platform, std::size_t size_max, bool bucket_batches)
+    : platform_{platform}, bucket_batches_{bucket_batches} {
+  // Each shard holds its share of the entries, rounded up; a zero size still disables caching entirely.
+  auto shard_max = (size_max + kNumShards - 1) / kNumShards;
+  for (std::size_t idx = 0; idx < kNumShards; ++idx) {
+    cache_.emplace_back(std::make_unique<LruCache<Key, std::shared_ptr<Entry>, KeyComp>>(shard_max));
+    buckets_.emplace_back(std::make_unique<LruCache<Key, std::shared_ptr<Bucketing>, KeyComp>>(shard_max));
+  }
+}
 
 std::tuple<std::string, std::shared_ptr<Program>> ProgramCache::GetProgram(const context::Context& ctx,
                                                                            const std::string& fallback_id,
                                                                            const tile::proto::Program& program,
                                                                            ConstBufferManager* const_bufs) {
-  auto entry = GetEntry(fallback_id, program);
+  if (bucket_batches_) {
+    auto bucketing = GetBucketing(program, const_bufs);
+    if (bucketing->eligible) {
+      const auto& bucket = bucketing->bucket;
+      auto entry = GetEntry(fallback_id, bucketing->program, const_bufs);
+      VLOG(3) << "Using compiled program " << entry->id() << " for user program " << program.id() << " (batch "
+              << bucket.batch << " in bucket " << bucket.bucket << ")";
+      auto compiled = entry->GetProgram(ctx, platform_.get(), const_bufs);
+      if (bucket.batch != bucket.bucket) {
+        compiled = std::make_shared<BatchPaddedProgram>(compiled, bucket, platform_, program.dev_id());
+      }
+      return std::make_tuple(entry->id(), compiled);
+    }
+  }
+  auto entry = GetEntry(fallback_id, program, const_bufs);
   VLOG(3) << "Using compiled program " << entry->id() << " for user program " << program.id();
   return std::make_tuple(entry->id(), entry->GetProgram(ctx, platform_.get(), const_bufs));
 }
@@ -25,57 +48,203 @@ std::tuple<std::string, std::shared_ptr<Program>> ProgramCache::GetProgram(const
 std::shared_ptr<lang::Program> ProgramCache::GetParsedProgram(const context::Context& ctx,
                                                               const std::string& fallback_id,
                                                               const tile::proto::Program& program) {
-  return GetEntry(fallback_id, program)->GetParsedProgram();
+  return GetEntry(fallback_id, program, nullptr)->GetParsedProgram();
 }
 
 namespace {
 
+// A streaming 128-bit hash: each 64-bit word is mixed into two lanes with independent constants (after
+// MurmurHash3), and the lanes are cross-mixed when the digest is taken.
+class Hasher {
+ public:
+  void Update(std::uint64_t word) {
+    lo_ ^= Rotl(word * kC1, 31) * kC2;
+    lo_ = Rotl(lo_, 27) * 5 + 0x52dce729;
+    hi_ ^= Rotl(word * kC2, 33) * kC1;
+    hi_ = Rotl(hi_, 31) * 5 + 0x38495ab5;
+    ++words_;
+  }
+
+  void Update(const std::string& str) {
+    Update(str.size());
+    auto bytes = str.data();
+    auto size = str.size();
+    for (; 8 <= size; bytes += 8, size -= 8) {
+      std::uint64_t word;
+      std::memcpy(&word, bytes, 8);
+      Update(word);
+    }
+    if (size) {
+      std::uint64_t word = 0;
+      std::memcpy(&word, bytes, size);
+      Update(word);
+    }
+  }
+
+  std::pair<std::uint64_t, std::uint64_t> Digest() const {
+    auto lo = lo_ ^ words_;
+    auto hi = hi_ ^ words_;
+    lo += hi;
+    hi += lo;
+    lo = Fmix(lo);
+    hi = Fmix(hi);
+    lo += hi;
+    hi += lo;
+    return std::make_pair(hi, lo);
+  }
+
+ private:
+  static constexpr std::uint64_t kC1 = 0x87c37b91114253d5ull;
+  static constexpr std::uint64_t kC2 = 0x4cf5ad432745937full;
+
+  static std::uint64_t Rotl(std::uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+  static std::uint64_t Fmix(std::uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ull;
+    k ^= k >> 33;
+    return k;
+  }
+
+  std::uint64_t lo_ = 0;
+  std::uint64_t hi_ = 0;
+  std::uint64_t words_ = 0;
+};
+
+// Hashes a map of tensors.  Map iteration order is unspecified, so each tensor is hashed on its own and the results
+// are summed, which needs no sorting.
 template <typename M>
-void SerializeShapemap(std::ostringstream* serialized, const M& m) {
-  std::map<std::string, const proto::TensorShape&> shapes;
+void HashShapemap(Hasher* hasher, const M& m) {
+  std::pair<std::uint64_t, std::uint64_t> sum{0, 0};
   for (const auto& t : m) {
-    shapes.emplace(t.first, t.second.shape());
+    Hasher entry;
+    entry.Update(t.first);
+    const auto& shape = t.second.shape();
+    entry.Update(static_cast<std::uint64_t>(shape.type()));
+    entry.Update(static_cast<std::uint64_t>(shape.dims_size()));
+    for (const auto& dim : shape.dims()) {
+      entry.Update(static_cast<std::uint64_t>(dim.size()));
+      entry.Update(static_cast<std::uint64_t>(dim.stride()));
+    }
+    auto digest = entry.Digest();
+    sum.first += digest.first;
+    sum.second += digest.second;
   }
-  for (const auto& t : shapes) {
-    (*serialized) << t.first.length() << ':';
-    (*serialized) << t.first;
-    (*serialized) << t.second.type() << ':';
-    for (const auto& dim : t.second.dims()) {
-      (*serialized) << dim.size() << '/' << dim.stride() << ':';
+  hasher->Update(m.size());
+  hasher->Update(sum.first);
+  hasher->Update(sum.second);
+}
+
+// Compares two maps of tensors on the fields which HashShapemap covers.
+template <typename M>
+bool ShapemapsEqual(const M& lhs, const M& rhs) {
+  if (lhs.size() != rhs.size()) {
+    return false;
+  }
+  for (const auto& t : lhs) {
+    auto it = rhs.find(t.first);
+    if (it == rhs.end()) {
+      return false;
+    }
+    const auto& a = t.second.shape();
+    const auto& b = it->second.shape();
+    if (a.type() != b.type() || a.dims_size() != b.dims_size()) {
+      return false;
+    }
+    for (int i = 0; i < a.dims_size(); ++i) {
+      if (a.dims(i).size() != b.dims(i).size() || a.dims(i).stride() != b.dims(i).stride()) {
+        return false;
+      }
     }
   }
+  return true;
+}
+
+std::map<std::string, BufferPtr> ConstBuffers(const ConstBufferManager* const_bufs) {
+  if (!const_bufs) {
+    return {};
+  }
+  return const_bufs->buffers;
 }
 
 }  // namespace
 
-std::shared_ptr<ProgramCache::Entry> ProgramCache::GetEntry(const std::string& fallback_id,
-                                                            const tile::proto::Program& program) {
-  std::ostringstream serialized;
+ProgramCache::Key ProgramCache::MakeKey(const tile::proto::Program& program, const ConstBufferManager* const_bufs) {
+  Hasher hasher;
 
-  // N.B. For cache lookup, we only serialize the parts of the program that
+  // N.B. For cache lookup, we only hash the parts of the program that
   // matter to the actual code generation.
-  serialized << program.code().length() << ':';
-  serialized << program.code();
+  hasher.Update(program.code());
+  HashShapemap(&hasher, program.inputs());
+  HashShapemap(&hasher, program.outputs());
+  if (const_bufs) {
+    // The buffers are keyed by name, so they are already in a canonical order.
+    hasher.Update(const_bufs->buffers.size());
+    for (const auto& kvp : const_bufs->buffers) {
+      hasher.Update(kvp.first);
+      hasher.Update(reinterpret_cast<std::uintptr_t>(kvp.second.get()));
+    }
+  }
 
-  SerializeShapemap(&serialized, program.inputs());
-  SerializeShapemap(&serialized, program.outputs());
+  return Key{program.dev_id(), hasher.Digest()};
+}
 
-  // The cache itself must be externally synchronized.
-  std::lock_guard<std::mutex> lock{mu_};
+ProgramCache::FullKey::FullKey(const tile::proto::Program& program, const ConstBufferManager* const_bufs)
+    : dev_id_{program.dev_id()},
+      code_{program.code()},
+      inputs_{program.inputs()},
+      outputs_{program.outputs()},
+      const_bufs_{ConstBuffers(const_bufs)} {}
 
-  return cache_.Lookup(Key{program.dev_id(), serialized.str()}, [&]() {
-    std::string cid = "c" + std::to_string(next_id_++);
-    if (program.id().size()) {
-      cid = cid + '_' + program.id();
-    } else if (fallback_id.size()) {
-      cid = cid + '_' + fallback_id;
-    }
-    VLOG(3) << "Compiling program as " << cid;
-    tile::proto::Program cprog;
-    cprog.CopyFrom(program);
-    cprog.set_id(cid);
-    return std::make_shared<ProgramCache::Entry>(cid, cprog);
+bool ProgramCache::FullKey::Matches(const tile::proto::Program& program, const ConstBufferManager* const_bufs) const {
+  return dev_id_ == program.dev_id() && code_ == program.code() && ShapemapsEqual(inputs_, program.inputs()) &&
+         ShapemapsEqual(outputs_, program.outputs()) && const_bufs_ == ConstBuffers(const_bufs);
+}
+
+std::shared_ptr<ProgramCache::Bucketing> ProgramCache::GetBucketing(const tile::proto::Program& program,
+                                                                    ConstBufferManager* const_bufs) {
+  auto key = MakeKey(program, const_bufs);
+  auto bucketing = buckets_[key.digest.second % kNumShards]->Lookup(
+      key, [&]() { return std::make_shared<Bucketing>(program, const_bufs); });
+  if (!bucketing->key.Matches(program, const_bufs)) {
+    LOG(WARNING) << "Program cache digest collision; bucketing " << program.id() << " without caching";
+    bucketing = std::make_shared<Bucketing>(program, const_bufs);
+  }
+  std::call_once(bucketing->compute_once, [&]() {
+    bucketing->eligible = ComputeBatchBucket(program, const_bufs, &bucketing->bucket, &bucketing->program);
   });
+  return bucketing;
+}
+
+std::shared_ptr<ProgramCache::Entry> ProgramCache::GetEntry(const std::string& fallback_id,
+                                                            const tile::proto::Program& program,
+                                                            const ConstBufferManager* const_bufs) {
+  auto key = MakeKey(program, const_bufs);
+  auto entry = cache_[key.digest.second % kNumShards]->Lookup(
+      key, [&]() { return MakeEntry(fallback_id, program, const_bufs); });
+  if (!entry->key().Matches(program, const_bufs)) {
+    LOG(WARNING) << "Program cache digest collision; compiling " << program.id() << " without caching";
+    entry = MakeEntry(fallback_id, program, const_bufs);
+  }
+  return entry;
+}
+
+std::shared_ptr<ProgramCache::Entry> ProgramCache::MakeEntry(const std::string& fallback_id,
+                                                             const tile::proto::Program& program,
+                                                             const ConstBufferManager* const_bufs) {
+  std::string cid = "c" + std::to_string(next_id_++);
+  if (program.id().size()) {
+    cid = cid + '_' + program.id();
+  } else if (fallback_id.size()) {
+    cid = cid + '_' + fallback_id;
+  }
+  VLOG(3) << "Compiling program as " << cid;
+  tile::proto::Program cprog;
+  cprog.CopyFrom(program);
+  cprog.set_id(cid);
+  return std::make_shared<ProgramCache::Entry>(cid, cprog, const_bufs);
 }
 
 std::shared_ptr<Program> ProgramCache::Entry::GetProgram(const context::Context& ctx, Platform* dev,
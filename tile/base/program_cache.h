@@ -2,13 +2,18 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 #include "base/context/context.h"
+#include "tile/base/batch_bucket.h"
 #include "tile/base/lru_cache.h"
 #include "tile/base/platform.h"
 #include "tile/base/program.h"
@@ -19,9 +24,18 @@ namespace vertexai {
 namespace tile {
 
 // ProgramCache implements an LRU Tile program cache.
+//
+// Programs are keyed by a 128-bit digest of the parts that matter to code generation (the code, the input and output
+// shapes, and the constant buffers compiled into the program), so a lookup hashes the program once rather than
+// serializing it.  Each entry also keeps those parts
+// in full, and a hit whose parts differ (a digest collision) is built afresh rather than served.  The cache is striped
+// by digest, so that concurrent lookups of different programs rarely contend.
+//
+// If bucket_batches is set, programs whose batch rows are independent are compiled once per power-of-two bucket of
+// their outermost dimension, and smaller batches are padded up to the bucket when run (see BatchPaddedProgram).
 class ProgramCache final {
  public:
-  ProgramCache(std::shared_ptr<Platform> platform, std::size_t size_max);
+  ProgramCache(std::shared_ptr<Platform> platform, std::size_t size_max, bool bucket_batches = false);
 
   // Gets the the requested program, looking it up in the cache and building it if necessary.
   // The fallback ID is used as the program ID if the program has no ID -- since GetProgram
@@ -41,46 +55,86 @@ class ProgramCache final {
  private:
   struct Key {
     std::string subdevice;
-    std::string ops;
+    std::pair<std::uint64_t, std::uint64_t> digest;
   };
 
   struct KeyComp {
     bool operator()(const Key& lhs, const Key& rhs) const {
-      if (lhs.subdevice < rhs.subdevice) {
-        return true;
-      }
-      if (rhs.subdevice < lhs.subdevice) {
-        return false;
-      }
-      return lhs.ops < rhs.ops;
+      return std::tie(lhs.digest, lhs.subdevice) < std::tie(rhs.digest, rhs.subdevice);
     }
   };
 
+  // The parts of a program which its key digests.
+  class FullKey {
+   public:
+    FullKey(const tile::proto::Program& program, const ConstBufferManager* const_bufs);
+
+    bool Matches(const tile::proto::Program& program, const ConstBufferManager* const_bufs) const;
+
+   private:
+    std::string dev_id_;
+    std::string code_;
+    google::protobuf::Map<std::string, tile::proto::ProgramInput> inputs_;
+    google::protobuf::Map<std::string, tile::proto::ProgramOutput> outputs_;
+    std::map<std::string, BufferPtr> const_bufs_;
+  };
+
   class Entry {
    public:
-    Entry(std::string id, tile::proto::Program proto) : id_{std::move(id)}, proto_{std::move(proto)} {}
+    Entry(std::string id, tile::proto::Program proto, const ConstBufferManager* const_bufs)
+        : id_{std::move(id)}, key_{proto, const_bufs}, proto_{std::move(proto)} {}
 
     const std::string& id() const { return id_; }
 
+    const FullKey& key() const { return key_; }
+
     std::shared_ptr<Program> GetProgram(const context::Context& ctx, Platform* dev, ConstBufferManager* const_bufs);
 
     std::shared_ptr<lang::Program> GetParsedProgram();
 
    private:
     std::string id_;
+    FullKey key_;
     std::once_flag compile_once_, parse_once_;
     tile::proto::Program proto_;
     std::shared_ptr<Program> compiled_;
     std::shared_ptr<lang::Program> parsed_;
   };
 
-  std::shared_ptr<Entry> GetEntry(const std::string& fallback_id, const tile::proto::Program& program);
+  // The outcome of ComputeBatchBucket for a particular program, memoized since it requires binding the program.
+  // The cache only holds the (empty) record, which is filled in once outside the cache lock.
+  struct Bucketing {
+    Bucketing(const tile::proto::Program& program, const ConstBufferManager* const_bufs) : key{program, const_bufs} {}
+
+    FullKey key;
+    std::once_flag compute_once;
+    bool eligible = false;
+    BatchBucket bucket;
+    tile::proto::Program program;
+  };
+
+  static constexpr std::size_t kNumShards = 16;
+
+  // Builds the cache key for a program.  If const_bufs is supplied, the constant inputs are part of the key: their
+  // names determine which inputs can carry the batch dimension, and the buffers themselves are compiled into the
+  // program (constant propagation may fold their contents into its code), so only callers passing the same constant
+  // buffers share a program.  Cached entries hold on to the buffers, so their addresses cannot be reused meanwhile.
+  static Key MakeKey(const tile::proto::Program& program, const ConstBufferManager* const_bufs);
+
+  std::shared_ptr<Entry> GetEntry(const std::string& fallback_id, const tile::proto::Program& program,
+                                  const ConstBufferManager* const_bufs);
+
+  std::shared_ptr<Entry> MakeEntry(const std::string& fallback_id, const tile::proto::Program& program,
+                                   const ConstBufferManager* const_bufs);
+
+  std::shared_ptr<Bucketing> GetBucketing(const tile::proto::Program& program, ConstBufferManager* const_bufs);
 
   std::shared_ptr<Platform> platform_;
+  bool bucket_batches_;
 
-  std::mutex mu_;
-  int next_id_ = 1;
-  LruCache<Key, std::shared_ptr<Entry>, KeyComp> cache_;
+  std::atomic<int> next_id_{1};
+  std::vector<std::unique_ptr<LruCache<Key, std::shared_ptr<Entry>, KeyComp>>> cache_;
+  std::vector<std::unique_ptr<LruCache<Key, std::shared_ptr<Bucketing>, KeyComp>>> buckets_;
 };
 
 }  // namespace tile
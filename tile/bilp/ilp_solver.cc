@@ -1,16 +1,120 @@
 #include "tile/bilp/ilp_solver.h"
 
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "base/util/parallel_for.h"
+#include "base/util/perf_counter.h"
+
 namespace vertexai {
 namespace tile {
 namespace bilp {
 
 using namespace math;  // NOLINT
 
-std::map<std::string, Rational> ILPSolver::reportSolution() const {
-  std::vector<Rational> sym_soln = getSymbolicSolution();
+namespace {
+
+PerfCounter ilp_cache_hits("ilp_cache_hits");
+PerfCounter ilp_cache_misses("ilp_cache_misses");
+
+// Objectives are solved in runs of this many, each warm-started from the last, and runs are solved concurrently.  The
+// runs depend only on the batch, not on how they are scheduled, so that results are reproducible.
+constexpr size_t kObjectivesPerRun = 4;
+
+// A warm-start tableau carries the Gomory cuts of the objectives before it; past this many, a run goes back to the
+// original tableau rather than let the tableau keep growing.
+constexpr size_t kMaxCarriedCuts = 16;
+
+// Cuts re-optimized by the dual simplex method need not converge; past this many, a problem is solved again cold, from
+// the tableau of the constraints as given, re-optimizing each cut from scratch.
+constexpr size_t kMaxDualCuts = 32;
+
+// The number of constraint sets whose solutions are remembered.
+constexpr size_t kMaxCachedConstraintSets = 1024;
+
+// A constraint set in canonical form: sorted, without duplicates.
+using ConstraintSet = std::vector<std::pair<Polynomial<Rational>, int64_t>>;
+
+ConstraintSet Canonicalize(const std::vector<SimpleConstraint>& constraints) {
+  ConstraintSet ret;
+  ret.reserve(constraints.size());
+  for (const auto& c : constraints) {
+    ret.emplace_back(c.poly, c.rhs);
+  }
+  std::sort(ret.begin(), ret.end());
+  ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+  return ret;
+}
+
+// The solutions found so far for a constraint set.
+struct CachedSolutions {
+  std::mutex mu;
+  bool empty_region = false;
+  std::map<Polynomial<Rational>, ILPResult> results;
+};
+
+class SolutionCache {
+ public:
+  std::shared_ptr<CachedSolutions> Lookup(const ConstraintSet& constraints) {
+    std::lock_guard<std::mutex> lock{mu_};
+    auto it = entries_.find(constraints);
+    if (it != entries_.end()) {
+      return it->second;
+    }
+    if (order_.size() == kMaxCachedConstraintSets) {
+      entries_.erase(order_.front());
+      order_.pop_front();
+    }
+    it = entries_.emplace(constraints, std::make_shared<CachedSolutions>()).first;
+    order_.push_back(constraints);
+    return it->second;
+  }
+
+ private:
+  std::mutex mu_;
+  std::map<ConstraintSet, std::shared_ptr<CachedSolutions>> entries_;
+  std::deque<ConstraintSet> order_;  // Oldest first, for eviction
+};
+
+SolutionCache& GetSolutionCache() {
+  static SolutionCache cache;
+  return cache;
+}
+
+// Replaces the objective row of a canonical form tableau
+void SetObjective(Tableau* tableau, const Polynomial<Rational>& obj) {
+  Matrix& mat = tableau->mat();
+  mat(0, 0) = 1;
+  for (size_t j = 1; j < mat.size2(); ++j) {
+    mat(0, j) = 0;
+  }
+  std::vector<std::string> var_names = tableau->varNames();
+  for (size_t i = 0; i < var_names.size(); ++i) {
+    const std::string& var = var_names[i];
+    if (var.substr(var.size() - 4, 4) == "_pos") {
+      mat(0, i + 1) = -obj[var.substr(1, var.size() - 5)];
+    } else if (var.substr(var.size() - 4, 4) == "_neg") {
+      mat(0, i + 1) = obj[var.substr(1, var.size() - 5)];
+    } else {
+      // Do nothing: We're on a slack variable or other artificially added variable
+    }
+  }
+  // Since objective was reset, need to price out to make canonical
+  tableau->priceOut();
+}
+
+}  // namespace
+
+std::map<std::string, Rational> ILPSolver::reportSolution(const SolveState& state,
+                                                          const std::vector<std::string>& var_names) {
+  const std::vector<Rational>& sym_soln = state.best_solution;
   std::map<std::string, Rational> soln;
   for (size_t i = 0; i < sym_soln.size(); ++i) {
-    std::string var = var_names_[i];
+    const std::string& var = var_names[i];
     if (var.substr(var.length() - 4, 4) == "_pos") {
       soln[var.substr(1, var.length() - 5)] += sym_soln[i];
     } else if (var.substr(var.length() - 4, 4) == "_neg") {
@@ -23,17 +127,87 @@ std::map<std::string, Rational> ILPSolver::reportSolution() const {
 std::map<Polynomial<Rational>, ILPResult> ILPSolver::batch_solve(const std::vector<RangeConstraint>& constraints,
                                                                  const std::vector<Polynomial<Rational>>& objectives) {
   // Solve a batch of ILP problems, all with the same constraints but different objectives
-  // A wrapper for the Tableau version
-  Tableau t = makeStandardFormTableau(constraints);
-  return batch_solve(&t, objectives);
+  std::vector<SimpleConstraint> simple_constraints;
+  for (const auto& c : constraints) {
+    simple_constraints.emplace_back(c.lowerBound());
+    simple_constraints.emplace_back(c.upperBound());
+  }
+  return batch_solve(simple_constraints, objectives);
 }
 
 std::map<Polynomial<Rational>, ILPResult> ILPSolver::batch_solve(const std::vector<SimpleConstraint>& constraints,
                                                                  const std::vector<Polynomial<Rational>>& objectives) {
   // Solve a batch of ILP problems, all with the same constraints but different objectives
-  // A wrapper for the Tableau version
-  Tableau t = makeStandardFormTableau(constraints);
-  return batch_solve(&t, objectives);
+  // The constraints are put in canonical order before building the tableau, so that the solutions found (which may
+  // differ among equally good optima) don't depend on whether they came from the cache
+  ConstraintSet canonical = Canonicalize(constraints);
+  auto cached = GetSolutionCache().Lookup(canonical);
+
+  std::map<Polynomial<Rational>, ILPResult> ret;
+  std::vector<Polynomial<Rational>> missing;
+  {
+    std::lock_guard<std::mutex> lock{cached->mu};
+    if (!cached->empty_region) {
+      for (const auto& obj : objectives) {
+        auto it = cached->results.find(obj);
+        if (it != cached->results.end()) {
+          ret.emplace(obj, it->second);
+        } else if (std::find(missing.begin(), missing.end(), obj) == missing.end()) {
+          missing.push_back(obj);
+        }
+      }
+    }
+    if (cached->empty_region || missing.empty()) {
+      ilp_cache_hits.inc();
+    } else {
+      ilp_cache_misses.inc();
+    }
+  }
+
+  bool empty_region = cached->empty_region;
+  std::vector<std::optional<ILPResult>> solved;
+  if (!empty_region && !missing.empty()) {
+    std::vector<SimpleConstraint> sorted;
+    for (const auto& c : canonical) {
+      sorted.emplace_back(c.first, c.second);
+    }
+    Tableau tableau = makeStandardFormTableau(sorted);
+    empty_region = !tableau.convertToCanonicalForm();
+    if (!empty_region) {
+      std::vector<size_t> unsettled;
+      solved = solve_objectives(tableau, missing, &unsettled);
+      if (!unsettled.empty()) {
+        Tableau given = makeStandardFormTableau(constraints);
+        given.convertToCanonicalForm();
+        solve_cold(given, missing, unsettled, &solved);
+      }
+    }
+    std::lock_guard<std::mutex> lock{cached->mu};
+    cached->empty_region = empty_region;
+    for (size_t i = 0; i < solved.size(); ++i) {
+      if (solved[i]) {
+        cached->results.emplace(missing[i], *solved[i]);
+      }
+    }
+  }
+
+  if (empty_region) {
+    IVLOG(3, "Feasible region empty");
+    if (throw_infeasible) {
+      throw std::runtime_error("Unable to run ILPSolver::batch_solve: Feasible region empty.");
+    }
+    return std::map<Polynomial<Rational>, ILPResult>{};
+  }
+  for (size_t i = 0; i < solved.size(); ++i) {
+    if (solved[i]) {
+      ret.emplace(missing[i], std::move(*solved[i]));
+    } else if (throw_infeasible) {
+      throw std::runtime_error("No feasible solution");
+    } else {
+      ret.emplace(missing[i], ILPResult());
+    }
+  }
+  return ret;
 }
 
 std::map<Polynomial<Rational>, ILPResult> ILPSolver::batch_solve(Tableau* tableau,
@@ -47,37 +221,85 @@ std::map<Polynomial<Rational>, ILPResult> ILPSolver::batch_solve(Tableau* tablea
     }
     return std::map<Polynomial<Rational>, ILPResult>{};
   }
-  var_names_ = tableau->varNames();
-  tableau->convertToCanonicalForm();
 
+  std::vector<size_t> unsettled;
+  std::vector<std::optional<ILPResult>> solved = solve_objectives(*tableau, objectives, &unsettled);
+  solve_cold(*tableau, objectives, unsettled, &solved);
   std::map<Polynomial<Rational>, ILPResult> ret;
-  for (const Polynomial<Rational>& obj : objectives) {
-    clean();
-    var_names_ = tableau->varNames();
-
-    // Copy tableau for manipulation specific to the objective
-    Tableau specific_t = *tableau;
-
-    // Set first row based on objective
-    specific_t.mat()(0, 0) = 1;
-    for (size_t i = 0; i < tableau->varNames().size(); ++i) {
-      std::string var = tableau->varNames()[i];
-      if (var.substr(var.size() - 4, 4) == "_pos") {
-        specific_t.mat()(0, i + 1) = -obj[var.substr(1, var.size() - 5)];
-      } else if (var.substr(var.size() - 4, 4) == "_neg") {
-        specific_t.mat()(0, i + 1) = obj[var.substr(1, var.size() - 5)];
-      } else {
-        // Do nothing: We're on a slack variable or other artificially added variable
-      }
+  for (size_t i = 0; i < objectives.size(); ++i) {
+    if (solved[i]) {
+      ret.emplace(objectives[i], std::move(*solved[i]));
+    } else if (throw_infeasible) {
+      throw std::runtime_error("No feasible solution");
+    } else {
+      ret.emplace(objectives[i], ILPResult());
     }
-
-    // Since objective was reset, need to price out to make canonical
-    specific_t.priceOut();
-    ret.emplace(std::piecewise_construct, std::make_tuple(obj), std::make_tuple(solve(specific_t, true)));
   }
   return ret;
 }
 
+std::vector<std::optional<ILPResult>> ILPSolver::solve_objectives(const Tableau& canonical,
+                                                                  const std::vector<Polynomial<Rational>>& objectives,
+                                                                  std::vector<size_t>* unsettled) {
+  std::vector<std::optional<ILPResult>> results(objectives.size());
+  size_t runs = (objectives.size() + kObjectivesPerRun - 1) / kObjectivesPerRun;
+  // Each run writes only its own objectives' results, and collects its unsettled objectives separately, so that they
+  // are reported in order.
+  std::vector<std::vector<size_t>> run_unsettled(runs);
+  ParallelFor(runs, std::max(1u, std::thread::hardware_concurrency()), [&](size_t run) {
+    size_t begin = run * kObjectivesPerRun;
+    solve_run(canonical, objectives, begin, std::min(begin + kObjectivesPerRun, objectives.size()), &results,
+              &run_unsettled[run]);
+  });
+  for (const auto& indices : run_unsettled) {
+    unsettled->insert(unsettled->end(), indices.begin(), indices.end());
+  }
+  return results;
+}
+
+void ILPSolver::solve_run(const Tableau& canonical, const std::vector<Polynomial<Rational>>& objectives, size_t begin,
+                          size_t end, std::vector<std::optional<ILPResult>>* results, std::vector<size_t>* unsettled) {
+  std::vector<std::string> var_names = canonical.varNames();
+  Tableau warm = canonical;
+  for (size_t i = begin; i < end; ++i) {
+    // The previous objective's final tableau is optimal for a problem with the same integer feasible region (its cuts
+    // remove only non-integral points), so it is a feasible basis from which to start on this objective
+    Tableau specific_t = warm;
+    SetObjective(&specific_t, objectives[i]);
+    SolveState state;
+    if (!solve_step(specific_t, &state, true)) {
+      IVLOG(4, "Dual simplex cuts did not converge for objective " << objectives[i]);
+      unsettled->push_back(i);
+      warm = canonical;
+      continue;
+    }
+    if (!state.feasible_found) {
+      warm = canonical;
+      continue;
+    }
+    (*results)[i] = ILPResult(state.best_objective, reportSolution(state, var_names));
+    if (specific_t.mat().size1() - canonical.mat().size1() <= kMaxCarriedCuts) {
+      warm = std::move(specific_t);
+    } else {
+      warm = canonical;
+    }
+  }
+}
+
+void ILPSolver::solve_cold(const Tableau& canonical, const std::vector<Polynomial<Rational>>& objectives,
+                           const std::vector<size_t>& indices, std::vector<std::optional<ILPResult>>* results) {
+  std::vector<std::string> var_names = canonical.varNames();
+  for (size_t i : indices) {
+    Tableau specific_t = canonical;
+    SetObjective(&specific_t, objectives[i]);
+    SolveState state;
+    solve_step(specific_t, &state, true, true);
+    if (state.feasible_found) {
+      (*results)[i] = ILPResult(state.best_objective, reportSolution(state, var_names));
+    }
+  }
+}
+
 ILPResult ILPSolver::solve(const std::vector<RangeConstraint>& constraints, const Polynomial<Rational> objective) {
   // A logging-enabled wrapper for make-Tableau-and-solve
   if (VLOG_IS_ON(3)) {
@@ -109,61 +331,73 @@ ILPResult ILPSolver::solve(const std::vector<SimpleConstraint>& constraints, con
 }
 
 ILPResult ILPSolver::solve(Tableau& tableau, bool already_canonical) {
-  clean();
-  var_names_ = tableau.varNames();
+  std::vector<std::string> var_names = tableau.varNames();
   IVLOG(5, "Starting ILPSolver with tableau " << tableau.mat().toString());
-  solve_step(tableau, already_canonical);
-  if (!feasible_found) {
+  SolveState state;
+  Tableau original = tableau;
+  if (!solve_step(tableau, &state, already_canonical)) {
+    IVLOG(4, "Dual simplex cuts did not converge; solving cold");
+    tableau = std::move(original);
+    state = SolveState();
+    solve_step(tableau, &state, already_canonical, true);
+  }
+  if (!state.feasible_found) {
     if (throw_infeasible)
       throw std::runtime_error("No feasible solution");
     else
       return ILPResult();
   }
-  return ILPResult(reportObjective(), reportSolution());
+  return ILPResult(state.best_objective, reportSolution(state, var_names));
 }
 
-void ILPSolver::solve_step(Tableau& tableau, bool already_canonical) {
+bool ILPSolver::solve_step(Tableau& tableau, SolveState* state, bool already_canonical, bool cold) {
   // Check feasible region exists for this subproblem
   if (!tableau.makeOptimal(already_canonical)) {
     // Feasible region empty (or unbounded), no solution from this branch
     IVLOG(5, "Feasible region empty; pruning branch");
-    return;
+    return true;
   }
 
-  // Check the LP Relaxation objective value
-  Rational obj_val = tableau.reportObjectiveValue();
-
-  // Check if this solution is integral
-  std::vector<Rational> soln = tableau.getSymbolicSolution();
-
-  // Find the greatest fractional part
-  Rational greatest_fractional = 0;
-  size_t greatest_fractional_row = 0;
-  for (size_t i = 1; i < tableau.mat().size1(); ++i) {
-    Rational frac = tableau.mat()(i, tableau.mat().size2() - 1) - Floor(tableau.mat()(i, tableau.mat().size2() - 1));
-    if (frac > greatest_fractional) {
-      greatest_fractional = frac;
-      greatest_fractional_row = i;
+  for (size_t cuts = 0;; ++cuts) {
+    // Check the LP Relaxation objective value
+    Rational obj_val = tableau.reportObjectiveValue();
+
+    // Check if this solution is integral
+    std::vector<Rational> soln = tableau.getSymbolicSolution();
+
+    // Find the row to cut on: the one with the greatest fractional part, or, when re-optimizing by the dual simplex
+    // method, the fractional row whose basic variable comes first, as the greatest fractional part can then stall,
+    // adding cuts indefinitely
+    RowToColLookup basic_vars = tableau.basicVars();
+    Rational cut_fractional = 0;
+    size_t cut_row = 0;
+    for (size_t i = 1; i < tableau.mat().size1(); ++i) {
+      Rational frac = tableau.mat()(i, tableau.mat().size2() - 1) - Floor(tableau.mat()(i, tableau.mat().size2() - 1));
+      if (frac > 0 && (cut_row == 0 || (cold ? frac > cut_fractional : basic_vars[i] < basic_vars[cut_row]))) {
+        cut_fractional = frac;
+        cut_row = i;
+      }
     }
-  }
 
-  if (greatest_fractional == 0) {
-    // This is an integer solution!
-    if (VLOG_IS_ON(3)) {
-      std::ostringstream msg;
-      msg << "Found new best integer solution!"
-          << "  objective: " << obj_val << "\n";
-      msg << "  Solution is:";
-      for (size_t i = 0; i < soln.size(); ++i) {
-        msg << "\n    " << tableau.varNames()[i] << ": " << soln[i];
+    if (cut_row == 0) {
+      // This is an integer solution!
+      if (VLOG_IS_ON(3)) {
+        std::ostringstream msg;
+        msg << "Found new best integer solution!"
+            << "  objective: " << obj_val << "\n";
+        msg << "  Solution is:";
+        for (size_t i = 0; i < soln.size(); ++i) {
+          msg << "\n    " << tableau.varNames()[i] << ": " << soln[i];
+        }
+        IVLOG(5, msg.str());
+        IVLOG(6, "  from tableau:" << tableau.mat().toString());
       }
-      IVLOG(5, msg.str());
-      IVLOG(6, "  from tableau:" << tableau.mat().toString());
+      state->feasible_found = true;
+      state->best_objective = obj_val;
+      state->best_solution = soln;
+      return true;
     }
-    feasible_found = true;
-    best_objective = obj_val;
-    best_solution = soln;
-  } else {
+
     // This is a non-integer solution; cut
     if (VLOG_IS_ON(5)) {
       std::ostringstream msg;
@@ -177,10 +411,30 @@ void ILPSolver::solve_step(Tableau& tableau, bool already_canonical) {
       IVLOG(6, "  from tableau:" << tableau.mat().toString());
     }
 
-    IVLOG(5, "Requesting Gomory cut at row " << greatest_fractional_row << " with value " << greatest_fractional);
-    Tableau with_cut = addGomoryCut(tableau, greatest_fractional_row);
-    IVLOG(6, "Adding Gomory cut yielded: " << with_cut.mat().toString());
-    solve_step(with_cut);
+    if (!cold && cuts == kMaxDualCuts) {
+      IVLOG(5, "Giving up on dual simplex cuts after " << cuts << " cuts");
+      return false;
+    }
+    IVLOG(5, "Requesting Gomory cut at row " << cut_row << " with value " << cut_fractional);
+    tableau = addGomoryCut(tableau, cut_row);
+    IVLOG(6, "Adding Gomory cut yielded: " << tableau.mat().toString());
+    bool feasible;
+    if (cold) {
+      // Canonicalization needs a nonnegative last column, so restate the cut with a surplus variable
+      size_t last_row = tableau.mat().size1() - 1;
+      for (size_t j = 0; j < tableau.mat().size2(); ++j) {
+        tableau.mat()(last_row, j) = -tableau.mat()(last_row, j);
+      }
+      feasible = tableau.makeOptimal();
+    } else {
+      // The cut leaves the objective row optimal but makes the cut row infeasible, which the dual simplex method
+      // repairs in a few pivots, rather than solving the cut problem from scratch
+      feasible = tableau.makeOptimalDual();
+    }
+    if (!feasible) {
+      IVLOG(5, "Feasible region empty; pruning branch");
+      return true;
+    }
   }
 }
 
@@ -193,12 +447,17 @@ Tableau ILPSolver::addGomoryCut(const Tableau& t, size_t row) {
       project(t.mat(), range(0, t.mat().size1()), range(t.mat().size2() - 1, t.mat().size2()));
   // Note: Assumes the uninitialized column was set to all 0s, which appears to
   // be an undocumented feature of ublas.
+  // The cut is sum(frac(a_j) * x_j) >= frac(b); it is stored negated, as
+  // -sum(frac(a_j) * x_j) + s = -frac(b), so that its slack s can be basic.
   for (size_t j = 0; j < t.mat().size2() - 1; ++j) {
-    ret.mat()(t.mat().size1(), j) = t.mat()(row, j) - Floor(t.mat()(row, j));
+    ret.mat()(t.mat().size1(), j) = Floor(t.mat()(row, j)) - t.mat()(row, j);
   }
-  ret.mat()(t.mat().size1(), t.mat().size2() - 1) = -1;
+  ret.mat()(t.mat().size1(), t.mat().size2() - 1) = 1;
   ret.mat()(t.mat().size1(), t.mat().size2()) =
-      t.mat()(row, t.mat().size2() - 1) - Floor(t.mat()(row, t.mat().size2() - 1));
+      Floor(t.mat()(row, t.mat().size2() - 1)) - t.mat()(row, t.mat().size2() - 1);
+  RowToColLookup basic_vars = t.basicVars();
+  basic_vars[t.mat().size1()] = t.mat().size2() - 1;
+  ret.setBasicVars(basic_vars);
   return ret;
 }
 
@@ -304,13 +563,6 @@ Tableau makeStandardFormTableau(const std::vector<RangeConstraint>& constraints,
   return makeStandardFormTableau(simple_constraints, objective);
 }
 
-void ILPSolver::clean() {
-  feasible_found = false;
-  best_objective = 0;
-  best_solution.clear();
-  var_names_.clear();
-}
-
 }  // namespace bilp
 }  // namespace tile
 }  // namespace vertexai
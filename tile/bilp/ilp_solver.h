@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <map>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -24,6 +25,11 @@ struct ILPResult {
       : obj_val{objective_val}, soln{solution} {};
 };
 
+// Solves integer linear programs by the simplex method with Gomory cuts.
+//
+// A solver carries no state between problems other than its settings.  The constraint-based batch_solve overloads
+// memoize their results by constraint set, so repeated batches over the same constraints (in any order) are answered
+// without re-solving.
 class ILPSolver {
  public:
   // Finds minimal value of objective subject to constraints (and subject to
@@ -49,30 +55,49 @@ class ILPSolver {
   FRIEND_TEST(BilpTest, SimpleOptimizeTest);
   FRIEND_TEST(BilpTest, OptimizeTest2D);
   FRIEND_TEST(BilpTest, TrivialILPTest);
-  bool feasible_found = false;
+
+  // The progress of solving a single problem
+  struct SolveState {
+    bool feasible_found = false;
+    math::Rational best_objective = 0;
+    std::vector<math::Rational> best_solution;  // In the tableau's varNames() order
+  };
+
   bool throw_infeasible = true;
-  math::Rational best_objective = 0;
-  std::vector<math::Rational> best_solution;
-  std::vector<std::string> var_names_;
 
   // Solves a tableau representing an ILP problem
   ILPResult solve(Tableau& tableau, bool already_canonical = false);  // NOLINT(runtime/references)
-  // Reports the minimized value of the objective for last solved problem
-  math::Rational reportObjective() const { return best_objective; }
-  // Reports the variable values minimizing the objective for last solved problem
-  std::map<std::string, math::Rational> reportSolution() const;
-  // Reports the variable values in var_names_ order for the last solved problem
-  std::vector<math::Rational> getSymbolicSolution() const { return best_solution; }
-
-  // Returns the solver to a neutral state to prepare to solve another problem
-  void clean();
+  // Solves each objective subject to the constraints of a canonical form tableau, solving runs of objectives
+  // concurrently. Entry i of the result is the solution for objectives[i], or empty if that problem is infeasible or
+  // its cuts did not converge, in which case i is added to unsettled.
+  static std::vector<std::optional<ILPResult>> solve_objectives(
+      const Tableau& canonical, const std::vector<math::Polynomial<math::Rational>>& objectives,
+      std::vector<size_t>* unsettled);
+  // Solves objectives [begin, end) in order, starting each from the final tableau of the one before
+  static void solve_run(const Tableau& canonical, const std::vector<math::Polynomial<math::Rational>>& objectives,
+                        size_t begin, size_t end, std::vector<std::optional<ILPResult>>* results,
+                        std::vector<size_t>* unsettled);
+  // Solves the objectives at the given indices without warm starts, re-optimizing each cut from scratch
+  static void solve_cold(const Tableau& canonical, const std::vector<math::Polynomial<math::Rational>>& objectives,
+                         const std::vector<size_t>& indices, std::vector<std::optional<ILPResult>>* results);
+  // Reports the variable values minimizing the objective of a solved problem
+  static std::map<std::string, math::Rational> reportSolution(const SolveState& state,
+                                                              const std::vector<std::string>& var_names);
+
   // Add an additional constraint that reduces the real feasible region but that
-  // leaves the integral feasible region unchanged
-  Tableau addGomoryCut(const Tableau& t, size_t row);
+  // leaves the integral feasible region unchanged. The cut's slack variable is
+  // made basic, so the result is dual feasible whenever t was optimal.
+  static Tableau addGomoryCut(const Tableau& t, size_t row);
 
-  // Perform one step of the solve algorithm (i.e. either find an integer feasible
-  // solution, or find a noninteger feasible solution, add a cut, and iterate)
-  void solve_step(Tableau& tableau, bool already_canonical = false);  // NOLINT(runtime/references)
+  // Run the solve algorithm: optimize the LP relaxation and, while its solution
+  // is not integral, add a cut and re-optimize. Leaves in tableau the last
+  // tableau optimized, including any cuts added. Cuts are re-optimized by the
+  // dual simplex method, unless cold, in which case each cut tableau is
+  // optimized from scratch. Returns false if the dual simplex cuts did not
+  // converge, in which case the problem should be solved again cold, from the
+  // tableau it started with.
+  static bool solve_step(Tableau& tableau, SolveState* state,  // NOLINT(runtime/references)
+                         bool already_canonical = false, bool cold = false);
 };
 
 // Transform constraints & objective to the tableau representing them
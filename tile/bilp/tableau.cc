@@ -178,6 +178,46 @@ bool Tableau::makeOptimal(bool already_canonical) {
   return makeOptimal(true);
 }
 
+bool Tableau::makeOptimalDual() {
+  size_t rhs_col = mat().size2() - 1;
+  while (true) {
+    // Select pivot row: the most infeasible basic variable
+    Rational min_rhs = 0;
+    size_t min_rhs_row = 0;  // 0 is not a valid row, so ok to start at this
+    for (size_t i = 1; i < mat().size1(); ++i) {
+      if (mat()(i, rhs_col) < min_rhs) {
+        min_rhs = mat()(i, rhs_col);
+        min_rhs_row = i;
+      }
+    }
+    if (min_rhs_row == 0) {
+      // Primal feasible, and dual feasibility is preserved by each pivot, so the Tableau is optimal
+      return true;
+    }
+
+    // Select pivot col: the ratio test keeps every objective coefficient nonpositive
+    Rational min_ratio = 0;    // Will separately initialize when first used
+    size_t min_ratio_col = 0;  // 0 is not a valid column, so ok to start at this
+    for (size_t j = 1; j < rhs_col; ++j) {
+      Rational entry = mat()(min_rhs_row, j);
+      if (entry < 0) {
+        Rational ratio = mat()(0, j) / entry;
+        if (min_ratio_col == 0 || ratio < min_ratio) {
+          min_ratio = ratio;
+          min_ratio_col = j;
+        }
+      }
+    }
+    if (min_ratio_col == 0) {
+      // The row can't be brought to a nonnegative value; the feasible region is empty
+      return false;
+    }
+
+    basic_vars_[min_rhs_row] = min_ratio_col;
+    mat().makePivotAt(min_rhs_row, min_ratio_col);
+  }
+}
+
 void Tableau::selectBasicVars() {
   // Makes basic_vars_ a map pointing from each row (other than 1st) to the basic var column for it
   basic_vars_ = RowToColLookup();  // Start from scratch
@@ -39,11 +39,17 @@ class Tableau {
 
   // Optimize Tableau via simplex algorithm
   bool makeOptimal(bool already_canonical = false);
+  // Re-optimize via the dual simplex algorithm a Tableau whose basis is dual feasible (i.e. no objective coefficient
+  // is positive) but whose last column may have gone negative, as after adding a cut to an optimal Tableau.  Returns
+  // false if the feasible region is empty.
+  bool makeOptimalDual();
   // Put Tableau in Canonical Form
   // (i.e. contains permuted identity submatrix, last column nonnegative except possibly objective)
   bool convertToCanonicalForm();
   // Find the columns that are basic variables in the current matrix
   void selectBasicVars();
+  // Use the given basic variables, e.g. those of the Tableau this one was derived from, without searching for them
+  void setBasicVars(const RowToColLookup& basic_vars) { basic_vars_ = basic_vars; }
   // Make objective == 0 at each basic variable via row ops
   void priceOut();
 
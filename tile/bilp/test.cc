@@ -1,6 +1,10 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <chrono>
+#include <random>
+
 #include "tile/bilp/ilp_solver.h"
 #include "tile/math/bignum.h"
 
@@ -178,6 +182,103 @@ TEST(BilpTest, Subdivision1D) {
   EXPECT_EQ(res[-Polynomial<Rational>("k_0")].obj_val, -2);
 }
 
+// Builds a feasible problem of the shape contraction lowering produces: every index has a range, and a few mixed
+// constraints (e.g. from strided or offset accesses) tie pairs of indices together.
+std::vector<RangeConstraint> MakeIndexConstraints(std::mt19937* rng, size_t num_idxs, size_t num_mixed) {
+  std::uniform_int_distribution<int> range(4, 32);
+  std::uniform_int_distribution<size_t> idx(0, num_idxs - 1);
+  std::uniform_int_distribution<int> coeff(1, 3);
+  auto var = [](size_t i) { return "i" + std::to_string(i); };
+  std::vector<RangeConstraint> constraints;
+  for (size_t i = 0; i < num_idxs; ++i) {
+    constraints.emplace_back(Polynomial<Rational>(var(i)), range(*rng));
+  }
+  for (size_t k = 0; k < num_mixed; ++k) {
+    size_t a = idx(*rng);
+    size_t b = (a + 1 + idx(*rng) % (num_idxs - 1)) % num_idxs;
+    Polynomial<Rational> poly = Polynomial<Rational>(var(a), coeff(*rng)) - Polynomial<Rational>(var(b), coeff(*rng));
+    // The origin always satisfies 0 <= poly + 16 < range + 16, so the problem is feasible
+    constraints.emplace_back(poly + 16, range(*rng) + 16);
+  }
+  return constraints;
+}
+
+std::vector<Polynomial<Rational>> MakeBoundObjectives(size_t num_idxs) {
+  std::vector<Polynomial<Rational>> objectives;
+  for (size_t i = 0; i < num_idxs; ++i) {
+    objectives.emplace_back("i" + std::to_string(i));
+    objectives.emplace_back("i" + std::to_string(i), -1);
+  }
+  return objectives;
+}
+
+TEST(BilpTest, BatchMatchesIndividualSolves) {
+  std::mt19937 rng{17};
+  for (size_t trial = 0; trial < 10; ++trial) {
+    std::vector<RangeConstraint> constraints = MakeIndexConstraints(&rng, 6, 3);
+    std::vector<Polynomial<Rational>> objectives = MakeBoundObjectives(6);
+    ILPSolver solver;
+    std::map<Polynomial<Rational>, ILPResult> batch = solver.batch_solve(constraints, objectives);
+    ASSERT_EQ(batch.size(), objectives.size());
+    for (const auto& obj : objectives) {
+      EXPECT_EQ(batch[obj].obj_val, solver.solve(constraints, obj).obj_val) << "objective " << obj;
+      EXPECT_EQ(batch[obj].obj_val, obj.eval(batch[obj].soln)) << "objective " << obj;
+    }
+
+    // The same constraints in another order are answered from the cache, with the same results
+    std::shuffle(constraints.begin(), constraints.end(), rng);
+    std::map<Polynomial<Rational>, ILPResult> again = solver.batch_solve(constraints, objectives);
+    for (const auto& obj : objectives) {
+      EXPECT_EQ(again[obj].obj_val, batch[obj].obj_val);
+      EXPECT_EQ(again[obj].soln, batch[obj].soln);
+    }
+  }
+}
+
+TEST(BilpTest, BatchTerminatesOnDegenerateCuts) {
+  // Warm-started cuts on these constraints once sent the dual simplex method into an endless cycle
+  std::vector<RangeConstraint> constraints;
+  Polynomial<Rational> x0("x0"), x1("x1"), x2("x2"), x3("x3"), x4("x4");
+  constraints.emplace_back(x0, 14);
+  constraints.emplace_back(x1, 12);
+  constraints.emplace_back(x2, 15);
+  constraints.emplace_back(x3, 18);
+  constraints.emplace_back(x4, 15);
+  constraints.emplace_back(3 * x0 + x1 - x2 + 2 * x3 + 3 * x4, 10);
+  constraints.emplace_back(6 + x0 + x1 - 3 * x2 - x3 - 2 * x4, 9);
+  constraints.emplace_back(-x0 + 3 * x1 + 2 * x2 - x3 - 2 * x4, 14);
+  std::vector<Polynomial<Rational>> objectives;
+  for (const auto& x : {x0, x1, x2, x3, x4}) {
+    objectives.push_back(x);
+    objectives.push_back(-x);
+  }
+  ILPSolver solver;
+  std::map<Polynomial<Rational>, ILPResult> batch = solver.batch_solve(constraints, objectives);
+  ASSERT_EQ(batch.size(), objectives.size());
+  for (const auto& obj : objectives) {
+    EXPECT_EQ(batch[obj].obj_val, solver.solve(constraints, obj).obj_val) << "objective " << obj;
+    EXPECT_EQ(batch[obj].obj_val, obj.eval(batch[obj].soln)) << "objective " << obj;
+  }
+}
+
+TEST(BilpTest, BatchSolveBenchmark) {
+  // Tracks the time to bound every index of a batch of problems; distinct constraints each time, so the solution
+  // cache does not apply.
+  std::mt19937 rng{42};
+  std::vector<std::vector<RangeConstraint>> problems;
+  for (size_t i = 0; i < 50; ++i) {
+    problems.push_back(MakeIndexConstraints(&rng, 8, 6));
+  }
+  std::vector<Polynomial<Rational>> objectives = MakeBoundObjectives(8);
+  ILPSolver solver;
+  auto start = std::chrono::steady_clock::now();
+  for (const auto& constraints : problems) {
+    EXPECT_EQ(solver.batch_solve(constraints, objectives).size(), objectives.size());
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  RecordProperty("batch_solve_usec", static_cast<int>(elapsed.count()));
+}
+
 TEST(MilpTest, RandomConstraintsTest) {
   const int varSize = 8;
   for (size_t test_count = 0; test_count < 20; ++test_count) {
@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "base/util/lookup.h"
+#include "base/util/parallel_for.h"
 #include "tile/stripe/stripe.h"
 
 namespace vertexai {
@@ -97,29 +98,48 @@ class AliasMap {
 // be instantiated.
 bool CheckOverlap(const std::vector<stripe::Extent>& a_extents, const std::vector<stripe::Extent>& b_extents);
 
+// Applies func to each block matching reqs.  With parallelism > 1, the subtrees of the first sibling blocks
+// reached are walked concurrently, so func must only touch the block it is given and that block's descendants.
 template <typename F>
 void RunOnBlocksRecurse(const AliasMap& map, stripe::Block* block, const stripe::Tags& reqs, const F& func,
-                        bool rec_func) {
+                        bool rec_func, size_t parallelism = 1) {
   bool run_func = block->has_tags(reqs) || reqs.count("all") > 0;
   if (run_func) {
     func(map, block);
   }
   if (!run_func || rec_func) {
+    if (parallelism > 1) {
+      std::vector<stripe::Block*> inners;
+      for (const auto& stmt : block->stmts) {
+        auto inner = stripe::Block::Downcast(stmt);
+        if (inner) {
+          inners.push_back(inner.get());
+        }
+      }
+      if (inners.size() > 1) {
+        ParallelFor(inners.size(), parallelism, [&](size_t i) {
+          AliasMap inner_map(map, inners[i]);
+          RunOnBlocksRecurse(inner_map, inners[i], reqs, func, rec_func);
+        });
+        return;
+      }
+    }
     for (auto& stmt : block->stmts) {
       auto inner = stripe::Block::Downcast(stmt);
       if (inner) {
         AliasMap inner_map(map, inner.get());
-        RunOnBlocksRecurse(inner_map, inner.get(), reqs, func, rec_func);
+        RunOnBlocksRecurse(inner_map, inner.get(), reqs, func, rec_func, parallelism);
       }
     }
   }
 }
 
 template <typename F>
-void RunOnBlocks(stripe::Block* root, const stripe::Tags& reqs, const F& func, bool rec_func = false) {
+void RunOnBlocks(stripe::Block* root, const stripe::Tags& reqs, const F& func, bool rec_func = false,
+                 size_t parallelism = 1) {
   AliasMap base;
   AliasMap root_map(base, root);
-  RunOnBlocksRecurse(root_map, root, reqs, func, rec_func);
+  RunOnBlocksRecurse(root_map, root, reqs, func, rec_func, parallelism);
 }
 
 std::ostream& operator<<(std::ostream& os, const AliasInfo& ai);
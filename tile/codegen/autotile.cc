@@ -414,77 +414,83 @@ std::optional<TileResult> PickBestTile(const Block& block, bool only_po2, bool o
 
 void AutotilePass::Apply(CompilerState* state) const {
   auto reqs = FromProto(options_.reqs());
-  RunOnBlocks(state->entry(), reqs, [this](const AliasMap& map, Block* block) {
-    if (block->has_any_tags(FromProto(options_.exclude()))) {
-      return;
-    }
-    ComputeDensityCostModel model(*block, options_);
-    auto result = PickBestTile(*block, options_.only_po2(), options_.only_even(), options_.only_multiple_of_32(),
-                               options_.fast(), model);
-    if (result) {
-      IVLOG(2, "Autotile> block: " << block->name << ", tile: " << result->tile << ", cost: " << result->cost);
-      const TileShape& tiling_shape = options_.flip() ? result->tile.counts() : result->tile.sizes();
-      if (ApplyTile(block, tiling_shape, false, false, options_.flip() || options_.interleave(),
-                    options_.location_idx_tag())) {
-        auto inner = block->SubBlock(0);
-        if (options_.copy_tags()) {
-          inner->set_attrs(*block);
-        }
-        if (options_.clear_outer()) {
-          block->clear_tags();
+  RunOnBlocks(
+      state->entry(), reqs,
+      [this](const AliasMap& map, Block* block) {
+        if (block->has_any_tags(FromProto(options_.exclude()))) {
+          return;
         }
-        block->add_tags(FromProto(options_.outer_set()));
-        inner->add_tags(FromProto(options_.inner_set()));
-        if (options_.clear_location()) {
-          block->location = Location{};
-        }
-      }
-    } else {
-      auto fail_inner_set = FromProto(options_.fail_inner_set());
-      auto fail_outer_set = FromProto(options_.fail_outer_set());
-      if (fail_inner_set.size() > 0 || fail_outer_set.size() > 0) {
-        TileShape tiling_shape;
-        for (const auto idx : block->idxs) {
-          if (idx.affine == Affine()) {
-            tiling_shape.push_back(idx.range);
+        ComputeDensityCostModel model(*block, options_);
+        auto result = PickBestTile(*block, options_.only_po2(), options_.only_even(), options_.only_multiple_of_32(),
+                                   options_.fast(), model);
+        if (result) {
+          IVLOG(2, "Autotile> block: " << block->name << ", tile: " << result->tile << ", cost: " << result->cost);
+          const TileShape& tiling_shape = options_.flip() ? result->tile.counts() : result->tile.sizes();
+          if (ApplyTile(block, tiling_shape, false, false, options_.flip() || options_.interleave(),
+                        options_.location_idx_tag())) {
+            auto inner = block->SubBlock(0);
+            if (options_.copy_tags()) {
+              inner->set_attrs(*block);
+            }
+            if (options_.clear_outer()) {
+              block->clear_tags();
+            }
+            block->add_tags(FromProto(options_.outer_set()));
+            inner->add_tags(FromProto(options_.inner_set()));
+            if (options_.clear_location()) {
+              block->location = Location{};
+            }
           }
+        } else {
+          auto fail_inner_set = FromProto(options_.fail_inner_set());
+          auto fail_outer_set = FromProto(options_.fail_outer_set());
+          if (fail_inner_set.size() > 0 || fail_outer_set.size() > 0) {
+            TileShape tiling_shape;
+            for (const auto idx : block->idxs) {
+              if (idx.affine == Affine()) {
+                tiling_shape.push_back(idx.range);
+              }
+            }
+            ApplyTile(block, tiling_shape, false, false, options_.flip(), options_.location_idx_tag());
+            auto inner = block->SubBlock(0);
+            inner->add_tags(FromProto(options_.fail_inner_set()));
+            block->add_tags(FromProto(options_.fail_outer_set()));
+          }
+          LOG(WARNING) << "Autotile> block: " << block->name << " was NOT split; unable to find a valid tiling";
         }
-        ApplyTile(block, tiling_shape, false, false, options_.flip(), options_.location_idx_tag());
-        auto inner = block->SubBlock(0);
-        inner->add_tags(FromProto(options_.fail_inner_set()));
-        block->add_tags(FromProto(options_.fail_outer_set()));
-      }
-      LOG(WARNING) << "Autotile> block: " << block->name << " was NOT split; unable to find a valid tiling";
-    }
-  });
+      },
+      false, state->parallelism);
 }
 
 void PartitionComputePass::Apply(CompilerState* state) const {
   auto reqs = FromProto(options_.reqs());
-  RunOnBlocks(state->entry(), reqs, [this](const AliasMap& map, Block* block) {
-    PartitionComputeCostModel model(*block, options_);
-    auto result = PickBestTile(*block, false, false, options_.only_multiple_of_32(), false, model);
-    if (result) {
-      IVLOG(2, "PartitionCompute> block: " << block->name                 //
-                                           << ", tile: " << result->tile  //
-                                           << ", cost: " << result->cost);
-      if (ApplyTile(block, result->tile.sizes(), false)) {
-        auto inner = block->SubBlock(0);
-        inner->set_attrs(*block);
-        block->clear_tags();
-        block->add_tags(FromProto(options_.set_tags()));
-        if (!options_.idx_tag().empty()) {
-          for (auto& idx : block->idxs) {
-            if (idx.range > 1) {
-              idx.set_tag(options_.idx_tag());
+  RunOnBlocks(
+      state->entry(), reqs,
+      [this](const AliasMap& map, Block* block) {
+        PartitionComputeCostModel model(*block, options_);
+        auto result = PickBestTile(*block, false, false, options_.only_multiple_of_32(), false, model);
+        if (result) {
+          IVLOG(2, "PartitionCompute> block: " << block->name                 //
+                                               << ", tile: " << result->tile  //
+                                               << ", cost: " << result->cost);
+          if (ApplyTile(block, result->tile.sizes(), false)) {
+            auto inner = block->SubBlock(0);
+            inner->set_attrs(*block);
+            block->clear_tags();
+            block->add_tags(FromProto(options_.set_tags()));
+            if (!options_.idx_tag().empty()) {
+              for (auto& idx : block->idxs) {
+                if (idx.range > 1) {
+                  idx.set_tag(options_.idx_tag());
+                }
+                // HACK: remove this somehow
+                idx.remove_tag("bank");
+              }
             }
-            // HACK: remove this somehow
-            idx.remove_tag("bank");
           }
         }
-      }
-    }
-  });
+      },
+      false, state->parallelism);
 }
 
 namespace {
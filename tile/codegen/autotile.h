@@ -12,6 +12,7 @@ namespace codegen {
 class AutotilePass final : public CompilePass {
  public:
   explicit AutotilePass(const proto::AutotilePass& options) : options_{options} {}
+  bool is_block_local() const final { return true; }
   void Apply(CompilerState* state) const final;
 
  private:
@@ -21,6 +22,7 @@ class AutotilePass final : public CompilePass {
 class PartitionComputePass final : public CompilePass {
  public:
   explicit PartitionComputePass(const proto::PartitionComputePass& options) : options_{options} {}
+  bool is_block_local() const final { return true; }
   void Apply(CompilerState* state) const final;
 
  private:
@@ -646,9 +646,12 @@ static void CacheBlock(const AliasMap& map, Block* block, const proto::CachePass
 
 void CachePass::Apply(CompilerState* state) const {
   auto reqs = FromProto(options_.reqs());
-  RunOnBlocks(state->entry(), reqs, [&](const AliasMap& map, Block* block) {  //
-    CacheBlock(map, block, options_);
-  });
+  RunOnBlocks(
+      state->entry(), reqs,
+      [&](const AliasMap& map, Block* block) {  //
+        CacheBlock(map, block, options_);
+      },
+      false, state->parallelism);
 }
 
 namespace {
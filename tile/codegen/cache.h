@@ -43,6 +43,7 @@ void ApplySimpleCache(const AliasMap& map,
 class CachePass final : public CompilePass {
  public:
   explicit CachePass(const proto::CachePass& options) : options_{options} {}
+  bool is_block_local() const final { return true; }
   void Apply(CompilerState* state) const final;
 
  private:
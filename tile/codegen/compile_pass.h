@@ -22,6 +22,8 @@ struct CompilerState {
   std::unique_ptr<MLIRState> mlir;
   std::shared_ptr<stripe::Program> prog;
   ConstBufferManager* const_bufs;
+  // How many threads the running pass may use; the driver only raises this for block-local passes.
+  size_t parallelism = 1;
 
   stripe::Block* entry() { return prog->entry.get(); }
 };
@@ -32,6 +34,9 @@ class CompilePass {
  public:
   virtual ~CompilePass() {}
   virtual bool is_stripe() const { return true; }
+  // A block-local pass only reads and rewrites the blocks it matches, their descendants, and the refinements
+  // they alias, never their parents or siblings.  The driver lets such passes walk sibling kernels concurrently.
+  virtual bool is_block_local() const { return false; }
   virtual void Apply(CompilerState* root) const = 0;
 };
 
@@ -17,6 +17,11 @@ namespace tile {
 namespace codegen {
 
 void ConstantPropagatePass::Apply(CompilerState* state) const {
+  if (state->const_bufs == nullptr || state->const_bufs->buffers.empty()) {
+    // No constants were supplied, so there's nothing to evaluate ahead of time
+    return;
+  }
+
   // Extract the primary blocks
   auto prog = state->entry();
   auto main = prog->SubBlock(0).get();
@@ -62,6 +67,19 @@ void ConstantPropagatePass::Apply(CompilerState* state) const {
       continue;
     }
 
+    // Tensors visible to the user must still be written by the program, even when their contents are constant
+    bool writes_user = false;
+    for (const auto& out : inner->ref_outs()) {
+      if (prog->ref_by_into(out->from)->has_tag("user")) {
+        writes_user = true;
+        break;
+      }
+    }
+    if (writes_user) {
+      stmt_it++;
+      continue;
+    }
+
     // Add block to constant propagation program + remove from the original
     cmain->stmts.push_back(inner);
     auto old_it = stmt_it;
@@ -96,7 +114,7 @@ void ConstantPropagatePass::Apply(CompilerState* state) const {
     }
   }
 
-  if (all_const.empty()) {
+  if (out_const.empty()) {
     // If there isn't any constant propagation work to be done, just bail
     return;
   }
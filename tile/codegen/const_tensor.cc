@@ -97,6 +97,12 @@ bool AnalyzeConstTensor(Block* block, Block* parent, std::string* tensor, Consta
   return true;
 }
 
+// Tensors visible to the user must still be written, even when their contents are constant
+bool IsUserTensor(const AliasMap& alias_map, const Block& inner, const std::string& tensor) {
+  const auto& info = alias_map.at(inner.ref_by_into(tensor)->from);
+  return info.base_ref && info.base_ref->has_tag("user");
+}
+
 void ConstTensor(const AliasMap& alias_map, Block* block, const proto::ConstTensorPass& options) {
   std::map<std::string, Constant> tensor_value;
   auto stmt_it = block->stmts.begin();
@@ -141,7 +147,7 @@ void ConstTensor(const AliasMap& alias_map, Block* block, const proto::ConstTens
     // Check if it is a constant tensor
     std::string tensor;
     Constant value("", static_cast<int64_t>(0));
-    if (AnalyzeConstTensor(inner.get(), block, &tensor, &value)) {
+    if (AnalyzeConstTensor(inner.get(), block, &tensor, &value) && !IsUserTensor(alias_map, *inner, tensor)) {
       tensor_value.emplace(tensor, value);
       auto old_it = stmt_it;
       ++stmt_it;
@@ -225,8 +225,8 @@ void LightCstrReduction(const AliasMap& alias_map, Block* block, const proto::Li
 
 static Polynomial<Rational> PolynomialIntToRational(const Polynomial<int64_t>& src) {
   Polynomial<Rational> dest;
-  const std::map<std::string, int64_t>& src_map = src.getMap();
-  std::map<std::string, Rational>& dest_map = dest.mutateMap();
+  const auto& src_map = src.getMap();
+  auto& dest_map = dest.mutateMap();
   for (const auto& element : src_map) {
     dest_map.emplace(element.first, Rational(element.second));
   }
@@ -363,7 +363,7 @@ void LightCstrReductionPass::Apply(CompilerState* state) const {
               [this](const AliasMap& alias_map, stripe::Block* block) {  //
                 LightCstrReduction(alias_map, block, options_);
               },
-              true);
+              true, state->parallelism);
 }
 
 void IlpCstrReductionPass::Apply(CompilerState* state) const {
@@ -372,7 +372,7 @@ void IlpCstrReductionPass::Apply(CompilerState* state) const {
               [this](const AliasMap& alias_map, stripe::Block* block) {  //
                 IlpCstrReduction(alias_map, block, options_);
               },
-              true);
+              true, state->parallelism);
 }
 
 namespace {
@@ -24,6 +24,7 @@ void IlpCstrReduction(const AliasMap& alias_map, stripe::Block* block,
 class LightCstrReductionPass final : public CompilePass {
  public:
   explicit LightCstrReductionPass(const proto::LightConstraintReductionPass& options) : options_{options} {}
+  bool is_block_local() const final { return true; }
   void Apply(CompilerState* state) const final;
 
  private:
@@ -36,6 +37,7 @@ void IlpCstrReduction(const AliasMap& alias_map, stripe::Block* block,
 class IlpCstrReductionPass final : public CompilePass {
  public:
   explicit IlpCstrReductionPass(const proto::IlpConstraintReductionPass& options) : options_{options} {}
+  bool is_block_local() const final { return true; }
   void Apply(CompilerState* state) const final;
 
  private:
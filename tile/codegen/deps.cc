@@ -237,9 +237,12 @@ void ComputeDepsForBlock(Block* block, const AliasMap& alias_map) {
 // Recomputes Statement dependencies within all matching Blocks.
 void ComputeDepsPass::Apply(CompilerState* state) const {
   auto reqs = stripe::FromProto(options_.reqs());
-  RunOnBlocks(state->entry(), reqs, [](const AliasMap& map, stripe::Block* block) {  //
-    ComputeDepsForBlock(block, map);
-  });
+  RunOnBlocks(
+      state->entry(), reqs,
+      [](const AliasMap& map, stripe::Block* block) {  //
+        ComputeDepsForBlock(block, map);
+      },
+      false, state->parallelism);
 }
 
 namespace {
@@ -43,6 +43,7 @@ void ComputeDepsForBlock(stripe::Block* block, const AliasMap& alias_map);
 class ComputeDepsPass final : public CompilePass {
  public:
   explicit ComputeDepsPass(const proto::ComputeDepsPass& options) : options_{options} {}
+  bool is_block_local() const final { return true; }
   void Apply(CompilerState* state) const final;
 
  private:
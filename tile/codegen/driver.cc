@@ -2,7 +2,9 @@
 
 #include "tile/codegen/driver.h"
 
+#include <algorithm>
 #include <memory>
+#include <thread>
 #include <unordered_map>
 
 #include <boost/format.hpp>
@@ -100,6 +102,7 @@ class ConfigsRegistry {
 }  // namespace
 
 void Optimize(CompilerState* state, const Passes& passes, const OptimizeOptions& options) {
+  size_t parallelism = options.parallelism ? options.parallelism : std::max(1u, std::thread::hardware_concurrency());
   size_t counter = 0;
   DumpProgram(*state->entry(), options, "initial", counter++);
   bool in_stripe = true;
@@ -118,7 +121,9 @@ void Optimize(CompilerState* state, const Passes& passes, const OptimizeOptions&
       ConvertIntoMLIR(state);
     }
     in_stripe = wants_stripe;
+    state->parallelism = compile_pass->is_block_local() ? parallelism : 1;
     compile_pass->Apply(state);
+    state->parallelism = 1;
     if (in_stripe) {
       DumpProgram(*state->entry(), options, pass.name(), counter);
     } else {
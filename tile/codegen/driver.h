@@ -19,6 +19,7 @@ struct OptimizeOptions {
   bool dump_passes_proto = false;
   bool dump_code = false;
   boost::filesystem::path dbg_dir;
+  size_t parallelism = 0;  // Threads for block-local passes; 0 uses every core
 };
 
 using Passes = google::protobuf::RepeatedPtrField<proto::Pass>;
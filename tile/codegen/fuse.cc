@@ -90,13 +90,16 @@ static Affine TranslateAffine(const Affine& src, const AliasMap& map, std::map<s
 }
 
 std::optional<FusionPlan> ComputeFusionPlan(const AliasMap& scope, const Block& a, const Block& b,
-                                            const std::string& buf_name) {
+                                            const std::string& buf_name, bool reduce_broadcast) {
   IVLOG(3, "ComputeFusionPlan for " << buf_name << " between " << a.name << " and " << b.name);
   FusionPlan plan;
   plan.tile_a = TileShape(a.idxs.size(), 1);
   plan.a_interleave = false;
   plan.tile_b = TileShape(b.idxs.size(), 1);
   plan.b_interleave = false;
+  plan.reduce_broadcast = false;
+  // Indexes of b which walk a whole dimension of the buffer that a writes in each iteration
+  std::set<std::string> whole_b;
   // This is quite hueristic right now, but still beats our prior implementation
   auto it_a = a.ref_by_from(buf_name, false);
   if (it_a == a.refs.end()) {
@@ -112,12 +115,24 @@ std::optional<FusionPlan> ComputeFusionPlan(const AliasMap& scope, const Block&
   for (size_t i = 0; i < it_a->access.size(); i++) {
     const Affine& poly_a = it_a->access[i];
     const Affine& poly_b = it_b->access[i];
-    if (a.exterior_shape(it_a->into()).dims[i].size == 1) {
+    auto dim_size = a.exterior_shape(it_a->into()).dims[i].size;
+    if (dim_size == 1) {
+      plan.reduce_broadcast = true;
       continue;
     }
     if (poly_a == 0 && poly_b == 0) {
       continue;
     }
+    if (reduce_broadcast && poly_a == 0 && it_a->interior_shape.dims[i].size == dim_size &&  //
+        poly_b.getMap().size() == 1 && poly_b.constant() == 0) {
+      const auto& term = *poly_b.getMap().begin();
+      auto idx = b.idx_by_name(term.first);
+      if (term.second == 1 && idx && idx->range == dim_size && idx->affine == Affine()) {
+        whole_b.insert(term.first);
+        plan.reduce_broadcast = true;
+        continue;
+      }
+    }
     if (poly_a.getMap().size() != 1 || poly_a.getMap().begin()->first.empty()) {
       IVLOG(3, "ComputeFusionPlan: complex access in a: " << poly_a.toString());
       return std::nullopt;
@@ -159,13 +174,28 @@ std::optional<FusionPlan> ComputeFusionPlan(const AliasMap& scope, const Block&
     plan.remap_a.emplace(idx_a, idx_a);
     plan.remap_b.emplace(idx_b, idx_a);
   }
+  for (const auto& name : whole_b) {
+    if (plan.remap_b.count(name)) {
+      IVLOG(3, "ComputeFusionPlan: whole dimension index also maps another dimension: " << name);
+      return std::nullopt;
+    }
+  }
   // Process the index that are not in the ref access
+  bool inner_idxs = false;
   for (size_t i = 0; i < b.idxs.size(); ++i) {
     const auto& idx = b.idxs[i];
     if (plan.remap_b.find(idx.name) == plan.remap_b.end()) {
       plan.tile_b[i] = idx.range;
+      inner_idxs = inner_idxs || idx.range > 1;
     }
   }
+  for (const auto& idx : a.idxs) {
+    if (plan.remap_a.find(idx.name) == plan.remap_a.end()) {
+      inner_idxs = inner_idxs || idx.range > 1;
+    }
+  }
+  // A size one dimension only reduces or broadcasts if some index is left to walk inside the fused block
+  plan.reduce_broadcast = plan.reduce_broadcast && inner_idxs;
 
   // Translate the constraints
   if (TranslatedContraints(scope, plan.remap_a, a) != TranslatedContraints(scope, plan.remap_b, b)) {
@@ -296,7 +326,7 @@ std::shared_ptr<Block> FusionRefactor(const stripe::Block& orig,
       if (idx.affine != Affine()) {
         IVLOG(3, "Affine idx: " << idx.name);
         outer->idxs.push_back(idx);
-        inner->idxs.emplace_back(Index{idx.name, 1, idx.name});
+        inner->idxs.emplace_back(Index{idx.name, 1, idx.name.str()});
       } else {
         IVLOG(3, "New idx: " << idx.name);
         inner->idxs.push_back(idx);
@@ -566,11 +596,16 @@ void FusionInner(const AliasMap& scope, Block* block, TagFusionStrategy* strateg
       }
       IVLOG(3, "Fuse on = " << fuse_on);
       // Compute a fusion plan for the two blocks, if fails, give up
-      auto plan = ComputeFusionPlan(scope, *block1, *block2, fuse_on);
+      bool reduce_broadcast = strategy->Options().reduce_broadcast();
+      auto plan = ComputeFusionPlan(scope, *block1, *block2, fuse_on, reduce_broadcast);
       if (!plan) {
         IVLOG(3, "Fusion plan failed");
         break;
       }
+      if (reduce_broadcast && !plan->reduce_broadcast) {
+        IVLOG(3, "Fusion plan neither reduces nor broadcasts");
+        break;
+      }
       // Now call the strategy to see if we should fuse
       if (!strategy->AttemptFuse(*block, *block1, *block2)) {
         IVLOG(3, "Fusion denied by strategy");
@@ -578,6 +613,10 @@ void FusionInner(const AliasMap& scope, Block* block, TagFusionStrategy* strateg
       }
       // Do the appropriate refactors
       auto refactor1 = FusionRefactor(*block1, plan->remap_a, plan->tile_a, plan->a_interleave);
+      if (reduce_broadcast && refactor1->idxs_product() < strategy->Options().min_outer_size()) {
+        IVLOG(3, "Fused block has too few outer iterations: " << refactor1->idxs_product());
+        break;
+      }
       auto inner1 = refactor1->SubBlock(0, true);
       auto refactor2 = FusionRefactor(*block2, plan->remap_b, plan->tile_b, plan->b_interleave,
                                       (refactor1->idxs_product() > 1) || (inner1 == nullptr));
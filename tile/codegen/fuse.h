@@ -23,11 +23,14 @@ struct FusionPlan {
   TileShape tile_b;
   bool b_interleave;
   std::map<std::string, std::string> remap_b;
+  // Whether the shared buffer is reduced or broadcast along some dimension
+  bool reduce_broadcast;
 };
 
-// Given a shared buffer between two blocks, compute a possible fusion
+// Given a shared buffer between two blocks, compute a possible fusion.  With reduce_broadcast, b may read whole
+// dimensions of the buffer which a writes in a single iteration.
 std::optional<FusionPlan> ComputeFusionPlan(const AliasMap& scope, const stripe::Block& a, const stripe::Block& b,
-                                            const std::string& buf_name);
+                                            const std::string& buf_name, bool reduce_broadcast = false);
 
 // A transform that flattens trivial indexes.  TODO: move to a utility header
 void FlattenTrivial(stripe::Block* block);
@@ -92,7 +92,7 @@ void IdxOrderPass::Apply(CompilerState* state) const {
               [](const AliasMap& alias_map, stripe::Block* block) {  //
                 ReorderIndex(block, true, false);
               },
-              true);
+              true, state->parallelism);
 }
 
 namespace {
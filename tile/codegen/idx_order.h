@@ -23,6 +23,7 @@ void ReorderIndex(stripe::Block* block, bool global_only, bool apply_inner);
 class IdxOrderPass final : public CompilePass {
  public:
   explicit IdxOrderPass(const proto::IdxOrderPass& options) : options_{options} {}
+  bool is_block_local() const final { return true; }
   void Apply(CompilerState* state) const final;
 
  private:
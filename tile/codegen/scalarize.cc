@@ -111,9 +111,12 @@ void Scalarize(Block* block, bool recursive) {
 
 void ScalarizePass::Apply(CompilerState* state) const {
   auto reqs = stripe::FromProto(options_.reqs());
-  RunOnBlocks(state->entry(), reqs, [](const AliasMap& map, stripe::Block* block) {  //
-    Scalarize(block, true);
-  });
+  RunOnBlocks(
+      state->entry(), reqs,
+      [](const AliasMap& map, stripe::Block* block) {  //
+        Scalarize(block, true);
+      },
+      false, state->parallelism);
 }
 
 namespace {
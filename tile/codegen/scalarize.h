@@ -15,6 +15,7 @@ void Scalarize(stripe::Block* block, bool recursive = false);
 class ScalarizePass final : public CompilePass {
  public:
   explicit ScalarizePass(const proto::ScalarizePass& options) : options_{options} {}
+  bool is_block_local() const final { return true; }
   void Apply(CompilerState* state) const final;
 
  private:
@@ -0,0 +1,240 @@
+// Copyright 2019, Intel Corporation
+
+#include "tile/codegen/scan.h"
+
+#include <algorithm>
+#include <memory>
+#include <set>
+#include <string>
+
+#include "base/util/any_factory_map.h"
+#include "tile/stripe/stripe.h"
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+
+using namespace stripe;  // NOLINT
+
+namespace {
+
+struct ScanInfo {
+  std::string src;
+  std::string dst;
+  std::string agg_op;
+  size_t axis;
+  bool reverse;
+};
+
+int64_t FloorDiv(int64_t num, int64_t den) { return num >= 0 ? num / den : -((-num + den - 1) / den); }
+
+int64_t CeilDiv(int64_t num, int64_t den) { return -FloorDiv(-num, den); }
+
+// Checks that the block only moves the element it loads from src into dst.
+bool IsCopy(const Block& block, const std::string& src, const std::string& dst) {
+  std::string scalar;
+  for (const auto& stmt : block.stmts) {
+    switch (stmt->kind()) {
+      case StmtKind::Load: {
+        auto load = Load::Downcast(stmt);
+        if (!scalar.empty() || load->from != src) {
+          return false;
+        }
+        scalar = load->into;
+      } break;
+      case StmtKind::Intrinsic: {
+        auto intrinsic = Intrinsic::Downcast(stmt);
+        if (intrinsic->name != "assign" || intrinsic->inputs.size() != 1 || intrinsic->inputs[0] != scalar) {
+          return false;
+        }
+        scalar = intrinsic->outputs[0];
+      } break;
+      case StmtKind::Store: {
+        auto store = Store::Downcast(stmt);
+        if (store->from != scalar || store->into != dst || stmt != block.stmts.back()) {
+          return false;
+        }
+        return true;
+      }
+      default:
+        return false;
+    }
+  }
+  return false;
+}
+
+bool AnalyzeScan(const Block& parent, const Block& block, ScanInfo* info) {
+  static const std::set<std::string> agg_ops{"add", "mul", "max", "min"};
+  if (!block.has_tag("contraction") || block.refs.size() != 2 || block.constraints.empty()) {
+    return false;
+  }
+  const Refinement* src = nullptr;
+  const Refinement* dst = nullptr;
+  for (const auto& ref : block.refs) {
+    if (ref.dir == RefDir::In) {
+      src = &ref;
+    } else if (IsWriteDir(ref.dir)) {
+      dst = &ref;
+    }
+  }
+  if (!src || !dst || !agg_ops.count(dst->agg_op) || !IsCopy(block, src->into(), dst->into())) {
+    return false;
+  }
+  auto src_outer = parent.ref_by_into(src->from, false);
+  auto dst_outer = parent.ref_by_into(dst->from, false);
+  if (src_outer == parent.refs.end() || dst_outer == parent.refs.end()) {
+    return false;
+  }
+  const auto& src_dims = src_outer->interior_shape.dims;
+  const auto& dst_dims = dst_outer->interior_shape.dims;
+  size_t ndims = dst_dims.size();
+  if (src_dims.size() != ndims || src->access.size() != ndims || dst->access.size() != ndims) {
+    return false;
+  }
+
+  // Each output dimension is covered by its own index, unless it is a unit dimension.
+  std::set<std::string> out_idxs;
+  for (size_t i = 0; i < ndims; ++i) {
+    if (src_dims[i].size != dst_dims[i].size) {
+      return false;
+    }
+    const auto& terms = dst->access[i].getMap();
+    if (terms.empty() && dst_dims[i].size == 1) {
+      continue;
+    }
+    if (terms.size() != 1 || terms.begin()->first.empty() || terms.begin()->second != 1) {
+      return false;
+    }
+    auto idx = block.idx_by_name(terms.begin()->first);
+    if (!idx || idx->range != dst_dims[i].size || !(idx->affine == Affine()) || !out_idxs.insert(idx->name).second) {
+      return false;
+    }
+  }
+
+  // Exactly one further index, the cumulator, walks along the input.
+  const Index* cumulator = nullptr;
+  for (const auto& idx : block.idxs) {
+    if (out_idxs.count(idx.name)) {
+      continue;
+    }
+    if (cumulator || !(idx.affine == Affine())) {
+      return false;
+    }
+    cumulator = &idx;
+  }
+  if (!cumulator) {
+    return false;
+  }
+
+  // The input is addressed as the output is, except along the scanned axis.
+  size_t axis = ndims;
+  for (size_t i = 0; i < ndims; ++i) {
+    if (!(src->access[i] == dst->access[i])) {
+      if (axis != ndims) {
+        return false;
+      }
+      axis = i;
+    }
+  }
+  if (axis == ndims || dst->access[axis].getMap().empty()) {
+    return false;
+  }
+  std::string pos = dst->access[axis].getMap().begin()->first;
+  std::string cum = cumulator->name;
+  const auto& src_access = src->access[axis];
+  for (const auto& kvp : src_access.getMap()) {
+    if (!kvp.first.empty() && kvp.first != pos && kvp.first != cum) {
+      return false;
+    }
+  }
+  int64_t slope = src_access.get(pos);
+  int64_t step = src_access.get(cum);
+  if ((slope != 0 && slope != 1) || (step != 1 && step != -1)) {
+    return false;
+  }
+  for (const auto& constraint : block.constraints) {
+    for (const auto& kvp : constraint.getMap()) {
+      if (!kvp.first.empty() && kvp.first != pos && kvp.first != cum) {
+        return false;
+      }
+    }
+  }
+
+  // For every position along the axis, the constraints leave the cumulator an interval, and so the input an interval
+  // of elements.  A prefix scan reads every element up to the position; a suffix scan, every element from it.
+  int64_t size = dst_dims[axis].size;
+  bool prefix = true;
+  bool suffix = true;
+  for (int64_t p = 0; p < size; ++p) {
+    int64_t lo = 0;
+    int64_t hi = cumulator->range - 1;
+    for (const auto& constraint : block.constraints) {
+      int64_t rest = constraint.get(pos) * p + constraint.constant();
+      int64_t coeff = constraint.get(cum);
+      if (coeff > 0) {
+        lo = std::max(lo, CeilDiv(-rest, coeff));
+      } else if (coeff < 0) {
+        hi = std::min(hi, FloorDiv(rest, -coeff));
+      } else if (rest < 0) {
+        return false;
+      }
+    }
+    if (lo > hi) {
+      return false;
+    }
+    int64_t base = slope * p + src_access.constant();
+    int64_t first = base + std::min(step * lo, step * hi);
+    int64_t last = base + std::max(step * lo, step * hi);
+    prefix = prefix && first == 0 && last == p;
+    suffix = suffix && first == p && last == size - 1;
+  }
+  if (!prefix && !suffix) {
+    return false;
+  }
+
+  info->src = src->from;
+  info->dst = dst->from;
+  info->agg_op = dst->agg_op;
+  info->axis = axis;
+  info->reverse = !prefix;
+  return true;
+}
+
+}  // namespace
+
+void Scan(Block* block) {
+  for (auto& stmt : block->stmts) {
+    auto inner = Block::Downcast(stmt);
+    ScanInfo info;
+    if (!inner || !AnalyzeScan(*block, *inner, &info)) {
+      continue;
+    }
+    IVLOG(2, "Scan: replacing " << inner->name << " with a scan of " << info.src << " along axis " << info.axis);
+    auto scan = std::make_shared<Special>();
+    scan->name = "scan";
+    scan->inputs = {info.src};
+    scan->outputs = {info.dst};
+    scan->int_params["axis"] = info.axis;
+    scan->int_params["reverse"] = info.reverse;
+    scan->str_params["agg_op"] = info.agg_op;
+    scan->deps = inner->deps;
+    stmt = scan;
+  }
+}
+
+void ScanPass::Apply(CompilerState* state) const {
+  auto reqs = stripe::FromProto(options_.reqs());
+  RunOnBlocks(state->entry(), reqs, [](const AliasMap& alias_map, stripe::Block* block) {  //
+    Scan(block);
+  });
+}
+
+namespace {
+[[gnu::unused]] char reg = []() -> char {
+  CompilePassFactory<ScanPass, proto::ScanPass>::Register();
+  return 0;
+}();
+}  // namespace
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
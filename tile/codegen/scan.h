@@ -0,0 +1,30 @@
+// Copyright 2019, Intel Corporation
+
+#pragma once
+
+#include "tile/codegen/alias.h"
+#include "tile/codegen/codegen.pb.h"
+#include "tile/codegen/compile_pass.h"
+#include "tile/stripe/stripe.h"
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+
+// Replaces each child of the block which computes a running aggregate along one axis of its input, as
+//   O[..., a, ...] = agg(I[..., a - k, ...]), a - k >= 0
+// does for cumsum, with a "scan" special.  The contraction does quadratic work along the axis; the special, linear.
+void Scan(stripe::Block* block);
+
+class ScanPass final : public CompilePass {
+ public:
+  explicit ScanPass(const proto::ScanPass& options) : options_{options} {}
+  void Apply(CompilerState* state) const final;
+
+ private:
+  proto::ScanPass options_;
+};
+
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
@@ -467,7 +467,7 @@ class StatementBinder final {
   StatementBinder() {}
 
   // Construct a StatementBinder for a non-Block.
-  explicit StatementBinder(std::vector<std::pair<std::string*, RefInfo*>> updates)
+  explicit StatementBinder(std::vector<std::pair<InternedString*, RefInfo*>> updates)
       : non_block_updates_{std::move(updates)} {}
 
   // Construct a StatementBinder for a Block.
@@ -511,7 +511,7 @@ class StatementBinder final {
   }
 
  private:
-  std::vector<std::pair<std::string*, RefInfo*>> non_block_updates_;
+  std::vector<std::pair<InternedString*, RefInfo*>> non_block_updates_;
   std::vector<std::pair<stripe::Refinement*, RefInfo*>> block_updates_;
   stripe::Block* block_ = nullptr;
   const stripe::Location* mem_loc_ = nullptr;
@@ -535,13 +535,13 @@ class IOGatherer final : private stripe::MutableStmtVisitor {
   void Visit(stripe::Load* load) final {
     auto* ri = FindDirectRefInfo(load->from);
     ios_.emplace_back(ri, stripe::RefDir::In);
-    binder_ = StatementBinder{std::vector<std::pair<std::string*, RefInfo*>>{{&load->from, ri}}};
+    binder_ = StatementBinder{std::vector<std::pair<InternedString*, RefInfo*>>{{&load->from, ri}}};
   }
 
   void Visit(stripe::Store* store) final {
     auto* ri = FindDirectRefInfo(store->into);
     ios_.emplace_back(ri, stripe::RefDir::Out);
-    binder_ = StatementBinder{std::vector<std::pair<std::string*, RefInfo*>>{{&store->into, ri}}};
+    binder_ = StatementBinder{std::vector<std::pair<InternedString*, RefInfo*>>{{&store->into, ri}}};
   }
 
   void Visit(stripe::LoadIndex* load_index) final {}
@@ -550,7 +550,7 @@ class IOGatherer final : private stripe::MutableStmtVisitor {
 
   void Visit(stripe::Special* special) final {
     // TODO: Handle the case where a special accesses a single tensor multiple times.
-    std::vector<std::pair<std::string*, RefInfo*>> updates;
+    std::vector<std::pair<InternedString*, RefInfo*>> updates;
     std::unordered_map<RefInfo*, stripe::RefDir> accesses;
     for (auto nit = special->inputs.begin(); nit != special->inputs.end(); ++nit) {
       auto* ri = FindDirectRefInfo(*nit);
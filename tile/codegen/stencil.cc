@@ -4,11 +4,14 @@
 
 #include <map>
 #include <utility>
+#include <vector>
 
 #include "base/util/logging.h"
 #include "base/util/lookup.h"
+#include "base/util/parallel_for.h"
 #include "base/util/stream_container.h"
 #include "base/util/throw.h"
+#include "tile/codegen/alias.h"
 #include "tile/codegen/tile.h"
 #include "tile/math/util.h"
 #include "tile/stripe/stripe.h"
@@ -256,11 +259,19 @@ void ApplyRefTags(Block* block, const StencilMatch& match, const StencilPassOpti
   }
 }
 
-void StencilPassRecurse(Block* block, const StencilPassOptions& options) {
+void StencilPassRecurse(Block* block, const StencilPassOptions& options, size_t parallelism) {
+  std::vector<Block*> inners;
   for (auto stmt : block->stmts) {
     auto inner = Block::Downcast(stmt);
     if (inner) {
-      StencilPassRecurse(inner.get(), options);
+      inners.push_back(inner.get());
+    }
+  }
+  if (parallelism > 1 && inners.size() > 1) {
+    ParallelFor(inners.size(), parallelism, [&](size_t i) { StencilPassRecurse(inners[i], options, 1); });
+  } else {
+    for (auto* inner : inners) {
+      StencilPassRecurse(inner, options, parallelism);
     }
   }
   if (block->has_tags(options.reqs)) {
@@ -306,7 +317,7 @@ void StencilPass::Apply(CompilerState* state) const {
   sopts.is_strict_dims = options_.is_strict_dims();
   sopts.copy_tags = options_.copy_tags();
 
-  StencilPassRecurse(state->entry(), sopts);
+  StencilPassRecurse(state->entry(), sopts, state->parallelism);
 }
 
 std::ostream& operator<<(std::ostream& os, const StencilIndexMatch& idx) {
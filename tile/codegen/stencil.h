@@ -38,6 +38,7 @@ std::optional<StencilMatch> FindBestStencil(const std::vector<proto::Stencil>& s
 class StencilPass final : public CompilePass {
  public:
   explicit StencilPass(const proto::StencilPass& options) : options_{options} {}
+  bool is_block_local() const final { return true; }
   void Apply(CompilerState* state) const final;
 
  private:
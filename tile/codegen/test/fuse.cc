@@ -4,6 +4,7 @@
 
 #include "base/util/stream_container.h"
 #include "testing/matchers.h"
+#include "tile/codegen/aggrinit.h"
 #include "tile/codegen/cache.h"
 #include "tile/codegen/fuse.h"
 #include "tile/codegen/localize.h"
@@ -17,6 +18,7 @@
 
 using ::testing::ContainerEq;
 using ::testing::Eq;
+using ::testing::IsNull;
 using ::testing::LinesEq;
 
 namespace vertexai {
@@ -324,6 +326,113 @@ TEST(Codegen, FuseAuto) {
   IVLOG(2, "After>\n" << *program->entry);
 }
 
+static std::shared_ptr<Program> GenerateSoftmax() {
+  lang::RunInfo runinfo;
+  runinfo.program_name = "softmax";
+  runinfo.code = R"***(
+    function (I[X, Y]) -> (O) {
+      M[0, y : 1, Y] = >(I[x, y]);
+      E = exp(I - M);
+      N[0, y : 1, Y] = +(E[x, y]);
+      O = E / N;
+    }
+  )***";
+  runinfo.input_shapes.emplace("I", SimpleShape(DataType::FLOAT32, {16, 32}));
+  runinfo.output_shapes.emplace("O", SimpleShape(DataType::FLOAT32, {16, 32}));
+  return GenerateStripe(runinfo);
+}
+
+static void FuseReduceBroadcast(const AliasMap& main_map, Block* main, uint64_t min_outer_size = 0) {
+  proto::FusionPass options;
+  options.set_reduce_broadcast(true);
+  options.set_min_outer_size(min_outer_size);
+  TagFusionStrategy strategy(options);
+  FusionInner(main_map, main, &strategy);
+}
+
+TEST(Codegen, FuseReduceBroadcast) {
+  auto program = GenerateSoftmax();
+  auto main = program->entry->SubBlock(0);
+
+  IVLOG(2, "Before>\n" << *program->entry);
+
+  AliasMap base;
+  AliasMap prog_map(base, program->entry.get());
+  AliasMap main_map(prog_map, main.get());
+  FuseReduceBroadcast(main_map, main.get());
+
+  IVLOG(2, "After>\n" << *program->entry);
+
+  // The reductions along x and everything which broadcasts them back share one walk over y
+  ASSERT_THAT(main->stmts.size(), Eq(1));
+  auto fused = main->SubBlock(0);
+  ASSERT_THAT(fused->idxs.size(), Eq(1));
+  EXPECT_THAT(fused->idxs[0].range, Eq(32));
+}
+
+TEST(Codegen, FuseReduceBroadcastNeedsOuterIterations) {
+  auto program = GenerateSoftmax();
+  auto main = program->entry->SubBlock(0);
+  auto stmts = main->stmts.size();
+
+  AliasMap base;
+  AliasMap prog_map(base, program->entry.get());
+  AliasMap main_map(prog_map, main.get());
+  // The fused block would only walk Y = 32 rows
+  FuseReduceBroadcast(main_map, main.get(), 64);
+
+  EXPECT_THAT(main->stmts.size(), Eq(stmts));
+}
+
+TEST(Codegen, FuseReduceBroadcastInitializesLocals) {
+  auto program = GenerateSoftmax();
+  auto main = program->entry->SubBlock(0);
+  CompilerState state(program);
+
+  AliasMap base;
+  AliasMap prog_map(base, program->entry.get());
+  AliasMap main_map(prog_map, main.get());
+  FuseReduceBroadcast(main_map, main.get());
+  LocalizeBlockPass(main_map, main.get());
+  AggregationBlockOutputInitializationPass(proto::AggregationBlockOutputInitializationPass{}).Apply(&state);
+
+  IVLOG(2, "After>\n" << *program->entry);
+
+  ASSERT_THAT(main->stmts.size(), Eq(1));
+  auto fused = main->SubBlock(0);
+
+  // Localizing shrinks the reduction outputs to a single element per row, so they must be reinitialized by every
+  // iteration of the fused block, ahead of the inner block which reduces into them.
+  std::map<std::string, std::string> expected_inits = {{"M", "agg_init_max"}, {"N", "agg_init_add"}};
+  for (const auto& kvp : expected_inits) {
+    auto it = fused->ref_by_into(kvp.first);
+    ASSERT_THAT(it->dir, Eq(RefDir::None));
+    EXPECT_THAT(it->interior_shape.elem_size(), Eq(1));
+
+    bool initialized = false;
+    bool reduced = false;
+    for (const auto& stmt : fused->stmts) {
+      auto special = Special::Downcast(stmt);
+      if (special && special->outputs == std::vector<InternedString>{kvp.first}) {
+        EXPECT_THAT(special->name, Eq(kvp.second));
+        EXPECT_FALSE(reduced) << kvp.first << " is initialized after it is reduced into";
+        initialized = true;
+      }
+      auto inner = Block::Downcast(stmt);
+      if (inner && !reduced) {
+        for (const auto* ref : inner->ref_outs(true)) {
+          reduced = reduced || ref->from == kvp.first;
+        }
+      }
+    }
+    EXPECT_TRUE(initialized) << kvp.first << " is never initialized";
+    EXPECT_TRUE(reduced);
+  }
+  for (const auto& stmt : main->stmts) {
+    EXPECT_THAT(Special::Downcast(stmt), IsNull());
+  }
+}
+
 }  // namespace test
 }  // namespace codegen
 }  // namespace tile
@@ -0,0 +1,118 @@
+// Copyright 2019, Intel Corporation
+
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "base/proto/proto.h"
+#include "tile/codegen/alias.h"
+#include "tile/codegen/codegen.pb.h"
+#include "tile/codegen/driver.h"
+#include "tile/lang/gen_stripe.h"
+#include "tile/lang/runinfo.h"
+#include "tile/stripe/stripe.h"
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+namespace test {
+
+using ::testing::Eq;
+using ::testing::Ne;
+
+static proto::Stage GenerateStage() {
+  auto cfg_tmpl = R"(
+    passes: [
+      {
+        name: "autotile"
+        pass: {
+          [type.vertex.ai/vertexai.tile.codegen.proto.AutotilePass] {
+            reqs: ["kernel"]
+            outer_set: ["tiled"]
+            inner_set: ["inner"]
+            only_po2: true
+            fast: true
+            max_output_size: 64
+          }
+        }
+      }, {
+        name: "scalarize"
+        pass: {
+          [type.vertex.ai/vertexai.tile.codegen.proto.ScalarizePass] {
+            reqs: ["main"]
+          }
+        }
+      }, {
+        name: "compute_deps"
+        pass: {
+          [type.vertex.ai/vertexai.tile.codegen.proto.ComputeDepsPass] {
+            reqs: ["all"]
+          }
+        }
+      }
+    ]
+  )";
+  return ParseProtoText<proto::Stage>(cfg_tmpl);
+}
+
+static std::string Compile(size_t parallelism) {
+  lang::RunInfo runinfo;
+  runinfo.program_name = "parallel_kernels";
+  runinfo.code = R"***(
+    function (A[M, K], B[K, N], C[M, K], D[K, N]) -> (X, Y, Z) {
+      AB[m, n: M, N] = +(A[m, k] * B[k, n]);
+      CD[m, n: M, N] = +(C[m, k] * D[k, n]);
+      X = AB + CD;
+      Y = AB * CD;
+      Z[m: M] = >(AB[m, n]);
+    }
+  )***";
+  auto a = SimpleShape(DataType::FLOAT32, {16, 32});
+  auto b = SimpleShape(DataType::FLOAT32, {32, 16});
+  runinfo.input_shapes.emplace("A", a);
+  runinfo.input_shapes.emplace("B", b);
+  runinfo.input_shapes.emplace("C", a);
+  runinfo.input_shapes.emplace("D", b);
+  runinfo.output_shapes.emplace("X", SimpleShape(DataType::FLOAT32, {16, 16}));
+  runinfo.output_shapes.emplace("Y", SimpleShape(DataType::FLOAT32, {16, 16}));
+  runinfo.output_shapes.emplace("Z", SimpleShape(DataType::FLOAT32, {16}));
+  auto program = GenerateStripe(runinfo);
+
+  OptimizeOptions options;
+  options.parallelism = parallelism;
+  CompilerState state(program);
+  Optimize(&state, GenerateStage().passes(), options);
+  return to_string(*program->entry);
+}
+
+TEST(ParallelPassTest, MatchesSerialOutput) {
+  auto serial = Compile(1);
+  EXPECT_THAT(serial.find("tiled"), Ne(std::string::npos));
+  EXPECT_THAT(Compile(4), Eq(serial));
+}
+
+TEST(ParallelPassTest, ParallelForRethrowsFirstFailure) {
+  std::vector<std::atomic<int>> runs(16);
+  auto task = [&](size_t i) {
+    runs[i]++;
+    if (i == 3 || i == 11) {
+      throw std::runtime_error(std::to_string(i));
+    }
+  };
+  try {
+    ParallelFor(runs.size(), 4, task);
+    FAIL() << "Expected ParallelFor to throw";
+  } catch (const std::runtime_error& err) {
+    EXPECT_THAT(std::string{err.what()}, Eq("3"));
+  }
+  for (const auto& count : runs) {
+    EXPECT_THAT(count.load(), Eq(1));
+  }
+}
+
+}  // namespace test
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
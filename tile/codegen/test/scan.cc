@@ -0,0 +1,93 @@
+// Copyright 2019, Intel Corporation
+
+#include <gmock/gmock.h>
+
+#include "tile/codegen/scan.h"
+#include "tile/lang/gen_stripe.h"
+#include "tile/lang/runinfo.h"
+#include "tile/stripe/stripe.h"
+
+namespace vertexai {
+namespace tile {
+namespace codegen {
+namespace test {
+
+using ::testing::Eq;
+using ::testing::IsNull;
+using ::testing::NotNull;
+
+static std::shared_ptr<stripe::Block> Generate(const std::string& code) {
+  lang::RunInfo runinfo;
+  runinfo.program_name = "scan";
+  runinfo.code = code;
+  runinfo.input_shapes.emplace("I", SimpleShape(DataType::FLOAT32, {4, 8}));
+  runinfo.output_shapes.emplace("O", SimpleShape(DataType::FLOAT32, {4, 8}));
+  auto program = GenerateStripe(runinfo);
+  auto main = program->entry->SubBlock(0);
+  Scan(main.get());
+  return main;
+}
+
+static std::shared_ptr<stripe::Special> FindScan(const stripe::Block& block) {
+  for (const auto& stmt : block.stmts) {
+    auto special = stripe::Special::Downcast(stmt);
+    if (special && special->name == "scan") {
+      return special;
+    }
+  }
+  return nullptr;
+}
+
+TEST(ScanTest, Prefix) {
+  auto main = Generate(R"***(
+    function (I[M, N]) -> (O) {
+      O[m, n: M, N] = +(I[m, n - k]), k < N;
+    }
+  )***");
+  auto scan = FindScan(*main);
+  ASSERT_THAT(scan, NotNull());
+  EXPECT_THAT(scan->inputs, Eq(std::vector<InternedString>{"I"}));
+  EXPECT_THAT(scan->outputs, Eq(std::vector<InternedString>{"O"}));
+  EXPECT_THAT(scan->int_params.at("axis"), Eq(1));
+  EXPECT_THAT(scan->int_params.at("reverse"), Eq(0));
+  EXPECT_THAT(scan->str_params.at("agg_op"), Eq("add"));
+}
+
+TEST(ScanTest, PrefixByConstraint) {
+  auto main = Generate(R"***(
+    function (I[M, N]) -> (O) {
+      O[m, n: M, N] = *(I[k, n]), m - k < M;
+    }
+  )***");
+  auto scan = FindScan(*main);
+  ASSERT_THAT(scan, NotNull());
+  EXPECT_THAT(scan->int_params.at("axis"), Eq(0));
+  EXPECT_THAT(scan->int_params.at("reverse"), Eq(0));
+  EXPECT_THAT(scan->str_params.at("agg_op"), Eq("mul"));
+}
+
+TEST(ScanTest, Suffix) {
+  auto main = Generate(R"***(
+    function (I[M, N]) -> (O) {
+      O[m, n: M, N] = +(I[m, n + k]), k < N;
+    }
+  )***");
+  auto scan = FindScan(*main);
+  ASSERT_THAT(scan, NotNull());
+  EXPECT_THAT(scan->int_params.at("axis"), Eq(1));
+  EXPECT_THAT(scan->int_params.at("reverse"), Eq(1));
+}
+
+TEST(ScanTest, IgnoresWindows) {
+  auto main = Generate(R"***(
+    function (I[M, N]) -> (O) {
+      O[m, n: M, N] = +(I[m, n - k]), k < 2;
+    }
+  )***");
+  EXPECT_THAT(FindScan(*main), IsNull());
+}
+
+}  // namespace test
+}  // namespace codegen
+}  // namespace tile
+}  // namespace vertexai
@@ -517,7 +517,7 @@ class StripeGenerator {
 
     auto stmt = std::make_shared<Special>();
     stmt->name = op.f.fn;
-    stmt->inputs = op.inputs;
+    stmt->inputs.assign(op.inputs.begin(), op.inputs.end());
     stmt->outputs = {op.output};
     main->stmts.push_back(stmt);
   }
@@ -618,7 +618,7 @@ class StripeGenerator {
   void ProcessReshape(Block* main, const Op& op) {
     auto stmt = std::make_shared<Special>();
     stmt->name = op.f.fn;
-    stmt->inputs = std::vector<std::string>{op.inputs[0]};
+    stmt->inputs = {op.inputs[0]};
     stmt->outputs = {op.output};
     main->stmts.push_back(stmt);
   }
@@ -650,8 +650,8 @@ class StripeGenerator {
                     const std::vector<std::string>& outputs) {
     auto stmt = std::make_shared<Intrinsic>();
     stmt->name = name;
-    stmt->inputs = inputs;
-    stmt->outputs = outputs;
+    stmt->inputs.assign(inputs.begin(), inputs.end());
+    stmt->outputs.assign(outputs.begin(), outputs.end());
     stmt->type = type;
     block->stmts.push_back(stmt);
   }
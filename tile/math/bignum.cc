@@ -1,13 +1,227 @@
 
 #include "tile/math/bignum.h"
 
+#include <stdexcept>
+
 #include <boost/math/common_factor_rt.hpp>
 
 namespace vertexai {
 namespace tile {
 namespace math {
 
+namespace {
+
+bool AddOverflows(std::int64_t a, std::int64_t b, std::int64_t* r) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_add_overflow(a, b, r);
+#else
+  if ((b > 0 && a > std::numeric_limits<std::int64_t>::max() - b) ||
+      (b < 0 && a < std::numeric_limits<std::int64_t>::min() - b)) {
+    return true;
+  }
+  *r = a + b;
+  return false;
+#endif
+}
+
+bool SubOverflows(std::int64_t a, std::int64_t b, std::int64_t* r) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_sub_overflow(a, b, r);
+#else
+  if ((b < 0 && a > std::numeric_limits<std::int64_t>::max() + b) ||
+      (b > 0 && a < std::numeric_limits<std::int64_t>::min() + b)) {
+    return true;
+  }
+  *r = a - b;
+  return false;
+#endif
+}
+
+bool MulOverflows(std::int64_t a, std::int64_t b, std::int64_t* r) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_mul_overflow(a, b, r);
+#else
+  if (a && b) {
+    auto limit_max = std::numeric_limits<std::int64_t>::max();
+    auto limit_min = std::numeric_limits<std::int64_t>::min();
+    if ((a == -1 && b == limit_min) || (b == -1 && a == limit_min)) {
+      return true;
+    }
+    if (a > 0 ? (b > 0 ? a > limit_max / b : b < limit_min / a) : (b > 0 ? a < limit_min / b : a < limit_max / b)) {
+      return true;
+    }
+  }
+  *r = a * b;
+  return false;
+#endif
+}
+
+// The greatest common divisor of |a| and |b|, as long as one of them is nonzero and neither is INT64_MIN.
+std::int64_t SmallGCD(std::int64_t a, std::int64_t b) {
+  a = a < 0 ? -a : a;
+  b = b < 0 ? -b : b;
+  while (b) {
+    auto t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+constexpr std::int64_t kSmallMin = std::numeric_limits<std::int64_t>::min();
+
+}  // namespace
+
+Rational::Rational(const Integer& num, const Integer& den) {
+  if (den == 0) {
+    throw std::overflow_error("Division by zero.");
+  }
+  Assign(BigRational(num, den));
+}
+
+void Rational::Assign(const BigRational& value) {
+  const auto& num = boost::multiprecision::numerator(value);
+  const auto& den = boost::multiprecision::denominator(value);
+  // INT64_MIN is excluded from the inline range, so that negating an inline value never overflows.
+  if (kSmallMin < num && num <= std::numeric_limits<std::int64_t>::max() &&
+      den <= std::numeric_limits<std::int64_t>::max()) {
+    num_ = static_cast<std::int64_t>(num);
+    den_ = static_cast<std::int64_t>(den);
+    big_.reset();
+  } else {
+    big_ = std::make_shared<const BigRational>(value);
+  }
+}
+
+void Rational::AssignSmall(std::int64_t num, std::int64_t den) {
+  if (num == kSmallMin || den == kSmallMin) {
+    Assign(BigRational(Integer(num), Integer(den)));
+    return;
+  }
+  if (den < 0) {
+    num = -num;
+    den = -den;
+  }
+  auto g = SmallGCD(num, den);
+  num_ = num / g;
+  den_ = den / g;
+  big_.reset();
+}
+
+std::string Rational::str() const {
+  if (big_) {
+    return big_->str();
+  }
+  if (den_ == 1) {
+    return std::to_string(num_);
+  }
+  return std::to_string(num_) + "/" + std::to_string(den_);
+}
+
+Rational& Rational::operator+=(const Rational& rhs) {
+  if (!big_ && !rhs.big_) {
+    // a/b + c/d = (a*(d/g) + c*(b/g)) / (b/g*d), where g = gcd(b, d).
+    auto g = SmallGCD(den_, rhs.den_);
+    std::int64_t lhs_num, rhs_num, num, den;
+    if (!MulOverflows(num_, rhs.den_ / g, &lhs_num) && !MulOverflows(rhs.num_, den_ / g, &rhs_num) &&
+        !AddOverflows(lhs_num, rhs_num, &num) && !MulOverflows(den_ / g, rhs.den_, &den)) {
+      AssignSmall(num, den);
+      return *this;
+    }
+  }
+  Assign(big() + rhs.big());
+  return *this;
+}
+
+Rational& Rational::operator-=(const Rational& rhs) {
+  if (!big_ && !rhs.big_) {
+    auto g = SmallGCD(den_, rhs.den_);
+    std::int64_t lhs_num, rhs_num, num, den;
+    if (!MulOverflows(num_, rhs.den_ / g, &lhs_num) && !MulOverflows(rhs.num_, den_ / g, &rhs_num) &&
+        !SubOverflows(lhs_num, rhs_num, &num) && !MulOverflows(den_ / g, rhs.den_, &den)) {
+      AssignSmall(num, den);
+      return *this;
+    }
+  }
+  Assign(big() - rhs.big());
+  return *this;
+}
+
+Rational& Rational::operator*=(const Rational& rhs) {
+  if (!big_ && !rhs.big_) {
+    if (num_ == 0 || rhs.num_ == 0) {
+      num_ = 0;
+      den_ = 1;
+      return *this;
+    }
+    // Cancel across the two fractions first, so that the products are already in lowest terms.
+    auto g1 = SmallGCD(num_, rhs.den_);
+    auto g2 = SmallGCD(rhs.num_, den_);
+    std::int64_t num, den;
+    if (!MulOverflows(num_ / g1, rhs.num_ / g2, &num) && !MulOverflows(den_ / g2, rhs.den_ / g1, &den) &&
+        num != kSmallMin) {
+      num_ = num;
+      den_ = den;
+      return *this;
+    }
+  }
+  Assign(big() * rhs.big());
+  return *this;
+}
+
+Rational& Rational::operator/=(const Rational& rhs) {
+  if (rhs == 0) {
+    throw std::overflow_error("Division by zero.");
+  }
+  if (!rhs.big_) {
+    // Multiply by the reciprocal, which is itself inline since INT64_MIN is never an inline numerator.
+    Rational reciprocal;
+    reciprocal.num_ = rhs.num_ < 0 ? -rhs.den_ : rhs.den_;
+    reciprocal.den_ = rhs.num_ < 0 ? -rhs.num_ : rhs.num_;
+    return *this *= reciprocal;
+  }
+  Assign(big() / rhs.big());
+  return *this;
+}
+
+Rational Rational::operator-() const {
+  Rational result{*this};
+  if (big_) {
+    result.Assign(-*big_);
+  } else {
+    result.num_ = -num_;
+  }
+  return result;
+}
+
+int Rational::Compare(const Rational& lhs, const Rational& rhs) {
+  if (!lhs.big_ && !rhs.big_) {
+    if (lhs.den_ == rhs.den_) {
+      return lhs.num_ < rhs.num_ ? -1 : (rhs.num_ < lhs.num_ ? 1 : 0);
+    }
+    std::int64_t a, b;
+    if (!MulOverflows(lhs.num_, rhs.den_, &a) && !MulOverflows(rhs.num_, lhs.den_, &b)) {
+      return a < b ? -1 : (b < a ? 1 : 0);
+    }
+  }
+  return lhs.big().compare(rhs.big());
+}
+
+Integer numerator(const Rational& x) {
+  return x.is_small() ? Integer(x.small_numerator()) : Integer(boost::multiprecision::numerator(x.big()));
+}
+
+Integer denominator(const Rational& x) {
+  return x.is_small() ? Integer(x.small_denominator()) : Integer(boost::multiprecision::denominator(x.big()));
+}
+
 Integer Floor(const Rational& x) {
+  if (x.is_small()) {
+    auto num = x.small_numerator();
+    auto den = x.small_denominator();
+    auto quot = num / den;
+    return Integer(num % den < 0 ? quot - 1 : quot);
+  }
   if (x < 0) {
     return (numerator(x) - denominator(x) + 1) / denominator(x);
   } else {
@@ -15,7 +229,15 @@ Integer Floor(const Rational& x) {
   }
 }
 
-Integer Ceil(const Rational& x) { return Floor(Rational(numerator(x) - 1, denominator(x))) + 1; }
+Integer Ceil(const Rational& x) {
+  if (x.is_small()) {
+    auto num = x.small_numerator();
+    auto den = x.small_denominator();
+    auto quot = num / den;
+    return Integer(num % den > 0 ? quot + 1 : quot);
+  }
+  return Floor(Rational(numerator(x) - 1, denominator(x))) + 1;
+}
 
 int ToInteger(const Rational& x) {
   if (Floor(x) != Ceil(x)) {
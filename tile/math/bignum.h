@@ -1,6 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <ostream>
 #include <string>
+#include <type_traits>
 
 #include <boost/multiprecision/cpp_int.hpp>
 
@@ -11,7 +17,119 @@ namespace math {
 typedef boost::multiprecision::cpp_int_backend<> IntegerBackend;
 typedef boost::multiprecision::rational_adaptor<IntegerBackend> RationalBackend;
 typedef boost::multiprecision::number<IntegerBackend, boost::multiprecision::et_off> Integer;
-typedef boost::multiprecision::number<RationalBackend, boost::multiprecision::et_off> Rational;
+typedef boost::multiprecision::number<RationalBackend, boost::multiprecision::et_off> BigRational;
+
+// An exact rational number.
+//
+// Nearly every rational the compiler works with has a numerator and denominator that fit in 64 bits, so those are
+// held inline and operated on directly, with each operation checked for overflow; only a result that does not fit is
+// promoted to an arbitrary-precision BigRational.  Values are kept canonical -- in lowest terms with a positive
+// denominator, and inline whenever they fit -- so that equal values always have equal representations.
+class Rational {
+ public:
+  Rational() {}
+
+  template <typename I, typename = typename std::enable_if<std::is_integral<I>::value>::type>
+  Rational(I value) {  // NOLINT(runtime/explicit)
+    // INT64_MIN is never held inline, so that negating an inline value cannot overflow.
+    if (std::is_signed<I>::value ? static_cast<std::int64_t>(value) == std::numeric_limits<std::int64_t>::min()
+                                 : static_cast<std::uint64_t>(value) > std::numeric_limits<std::int64_t>::max()) {
+      Assign(BigRational(value));
+    } else {
+      num_ = static_cast<std::int64_t>(value);
+    }
+  }
+
+  Rational(const Integer& value) { Assign(BigRational(value)); }  // NOLINT(runtime/explicit)
+
+  Rational(const BigRational& value) { Assign(value); }  // NOLINT(runtime/explicit)
+
+  template <typename I, typename J,
+            typename = typename std::enable_if<std::is_integral<I>::value && std::is_integral<J>::value>::type>
+  Rational(I num, J den) : Rational(Rational(num) / Rational(den)) {}
+
+  Rational(const Integer& num, const Integer& den);
+
+  bool is_small() const { return !big_; }
+
+  // The numerator and denominator of an inline value; only valid if is_small().
+  std::int64_t small_numerator() const { return num_; }
+  std::int64_t small_denominator() const { return den_; }
+
+  BigRational big() const { return big_ ? *big_ : BigRational(Integer(num_), Integer(den_)); }
+
+  std::string str() const;
+
+  template <typename T>
+  T convert_to() const {
+    return static_cast<T>(*this);
+  }
+
+  template <typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+  explicit operator T() const {
+    if (big_) {
+      return big_->convert_to<T>();
+    }
+    if (std::is_floating_point<T>::value) {
+      // Dividing exactly represented operands rounds the quotient correctly; otherwise converting each operand would
+      // round twice, so the exact ratio is converted instead.
+      constexpr std::int64_t exact = std::int64_t{1} << std::min(std::numeric_limits<T>::digits, 62);
+      if (-exact <= num_ && num_ <= exact && den_ <= exact) {
+        return static_cast<T>(num_) / static_cast<T>(den_);
+      }
+      return big().convert_to<T>();
+    }
+    if (std::is_same<T, bool>::value) {
+      return static_cast<T>(num_ != 0);
+    }
+    // Integral conversions truncate towards zero, as for BigRational.
+    return static_cast<T>(num_ / den_);
+  }
+
+  Rational& operator+=(const Rational& rhs);
+  Rational& operator-=(const Rational& rhs);
+  Rational& operator*=(const Rational& rhs);
+  Rational& operator/=(const Rational& rhs);
+
+  Rational operator-() const;
+  Rational operator+() const { return *this; }
+
+  friend Rational operator+(Rational lhs, const Rational& rhs) { return lhs += rhs; }
+  friend Rational operator-(Rational lhs, const Rational& rhs) { return lhs -= rhs; }
+  friend Rational operator*(Rational lhs, const Rational& rhs) { return lhs *= rhs; }
+  friend Rational operator/(Rational lhs, const Rational& rhs) { return lhs /= rhs; }
+
+  friend bool operator==(const Rational& lhs, const Rational& rhs) {
+    if (!lhs.big_ && !rhs.big_) {
+      return lhs.num_ == rhs.num_ && lhs.den_ == rhs.den_;
+    }
+    return lhs.big_ && rhs.big_ && *lhs.big_ == *rhs.big_;
+  }
+  friend bool operator!=(const Rational& lhs, const Rational& rhs) { return !(lhs == rhs); }
+  friend bool operator<(const Rational& lhs, const Rational& rhs) { return Compare(lhs, rhs) < 0; }
+  friend bool operator>(const Rational& lhs, const Rational& rhs) { return Compare(rhs, lhs) < 0; }
+  friend bool operator<=(const Rational& lhs, const Rational& rhs) { return Compare(rhs, lhs) >= 0; }
+  friend bool operator>=(const Rational& lhs, const Rational& rhs) { return Compare(lhs, rhs) >= 0; }
+
+  friend std::ostream& operator<<(std::ostream& os, const Rational& x) { return os << x.str(); }
+
+ private:
+  // Returns a negative value, zero, or a positive value as lhs is less than, equal to, or greater than rhs.
+  static int Compare(const Rational& lhs, const Rational& rhs);
+
+  // Sets the value, demoting it to the inline representation if it fits.
+  void Assign(const BigRational& value);
+
+  // Sets the value to num/den (den > 0), reducing it to lowest terms.
+  void AssignSmall(std::int64_t num, std::int64_t den);
+
+  std::int64_t num_ = 0;
+  std::int64_t den_ = 1;
+  std::shared_ptr<const BigRational> big_;  // Set iff the value does not fit inline; shared, since never mutated.
+};
+
+Integer numerator(const Rational& x);
+Integer denominator(const Rational& x);
 
 inline std::string to_string(const Integer& x) { return x.str(); }
 inline std::string to_string(const Rational& x) { return x.str(); }
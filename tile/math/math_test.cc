@@ -29,6 +29,41 @@ TEST_CASE("Floor", "[lattice]") {
   REQUIRE(Floor(Rational(-4, 3)) == -2);
 }
 
+TEST_CASE("RationalOverflow", "[lattice]") {
+  // Results that overflow 64 bits are promoted, and demoted again once they fit.
+  Rational big = INT64_MAX;
+  big += 1;
+  REQUIRE(!big.is_small());
+  REQUIRE(big.str() == "9223372036854775808");
+  REQUIRE(big > INT64_MAX);
+  big -= 2;
+  REQUIRE(big.is_small());
+  REQUIRE(big == INT64_MAX - 1);
+
+  Rational product = Rational(INT64_MAX, 3) * Rational(INT64_MAX, 5);
+  REQUIRE(!product.is_small());
+  REQUIRE(product / Rational(INT64_MAX, 15) == INT64_MAX);
+  REQUIRE((product / Rational(INT64_MAX, 15)).is_small());
+
+  Rational tiny = Rational(1, INT64_MAX) - Rational(1, INT64_MAX - 1);
+  REQUIRE(tiny < 0);
+  REQUIRE(Floor(tiny) == -1);
+  REQUIRE(Ceil(tiny) == 0);
+  REQUIRE(-Rational(INT64_MIN) == Rational(Integer(INT64_MAX) + 1));
+  REQUIRE(denominator(Rational(6, -4)) == 2);
+  REQUIRE(numerator(Rational(6, -4)) == -3);
+}
+
+TEST_CASE("RationalToDouble", "[lattice]") {
+  // Conversions round the exact ratio once, even when the numerator or denominator is not exactly a double.
+  REQUIRE(static_cast<double>(Rational(1, 3)) == 1.0 / 3);
+  REQUIRE(static_cast<float>(Rational(1, 3)) == 1.0f / 3);
+  REQUIRE(static_cast<double>(Rational(INT64_C(1152921504606847009), 3)) == 384307168202282368.0);
+  REQUIRE(static_cast<double>(Rational(-INT64_C(1152921504606847009), 3)) == -384307168202282368.0);
+  REQUIRE(static_cast<float>(Rational(16777217, 3)) == 5592405.5f);
+  REQUIRE(static_cast<double>(Rational(3, INT64_MAX)) == 3.0 / 9223372036854775807.0);
+}
+
 TEST_CASE("Reduce", "[lattice]") {
   REQUIRE(Reduce(5, 3) == 2);
   REQUIRE(Reduce(7, 3) == 1);
@@ -118,6 +153,27 @@ TEST_CASE("Basic Polynomial<Rational> evaluation", "[poly]") {
   REQUIRE(r.eval({{"a0", 5}, {"a1", 9}}) == 33);
 }
 
+TEST_CASE("Polynomial terms", "[poly]") {
+  // Terms stay in name order however they are added, and copies share the interned names.
+  Polynomial<Rational> p = 3 * Polynomial<Rational>("j") + Polynomial<Rational>("i") - 2;
+  Polynomial<Rational> q = p;
+  std::vector<std::string> names;
+  for (const auto& kvp : p.getMap()) {
+    names.push_back(kvp.first);
+  }
+  REQUIRE((names == std::vector<std::string>{"", "i", "j"}));
+  REQUIRE(&q.getMap().at("j") != &p.getMap().at("j"));
+  REQUIRE(&std::next(q.getMap().begin())->first.str() == &std::next(p.getMap().begin())->first.str());
+
+  q.mutateMap().erase("i");
+  q.mutateMap()["k"] = 5;
+  REQUIRE(p["i"] == 1);
+  REQUIRE(q.getMap().count("i") == 0);
+  REQUIRE(q == 3 * Polynomial<Rational>("j") + 5 * Polynomial<Rational>("k") - 2);
+  REQUIRE(p < q - 5 * Polynomial<Rational>("k"));
+  REQUIRE((p - p).getMap().empty());
+}
+
 TEST_CASE("IntersectParallelConstraintPair", "[poly]") {
   Polynomial<Rational> i("i"), j("j");
   RangeConstraint c1{2 * i + j + 1, 8};
@@ -88,7 +88,11 @@ template <typename T>
 Polynomial<T>::Polynomial() {}
 
 template <typename T>
-Polynomial<T>::Polynomial(const T& c) : Polynomial<T>("", c) {}
+Polynomial<T>::Polynomial(const T& c) {
+  if (c) {
+    map_[InternedString()] = c;
+  }
+}
 
 template <typename T>
 Polynomial<T>::Polynomial(const std::string& i, const T& c) {
@@ -135,12 +139,12 @@ T Polynomial<T>::operator[](const std::string& var) const {
 }
 
 template <typename T>
-const std::map<std::string, T>& Polynomial<T>::getMap() const {
+const Terms<T>& Polynomial<T>::getMap() const {
   return map_;
 }
 
 template <typename T>
-std::map<std::string, T>& Polynomial<T>::mutateMap() {
+Terms<T>& Polynomial<T>::mutateMap() {
   return map_;
 }
 
@@ -203,7 +207,7 @@ void Polynomial<T>::setConstant(T value) {
   if (value == T(0)) {
     map_.erase("");
   } else {
-    map_[""] = value;
+    map_[InternedString()] = value;
   }
 }
 
@@ -299,7 +303,7 @@ T Polynomial<T>::get(const std::string& name) const {
 
 int64_t abs_value(int64_t value) { return std::llabs(value); }
 
-Rational abs_value(Rational value) { return abs(value); }
+Rational abs_value(Rational value) { return Abs(value); }
 
 template <typename T>
 std::string Polynomial<T>::toString() const {
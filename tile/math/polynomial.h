@@ -1,21 +1,115 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <map>
 #include <set>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include <boost/container/small_vector.hpp>
 #include <boost/operators.hpp>
 
 #include "base/util/logging.h"
+#include "base/util/symbol.h"
 #include "tile/math/bignum.h"
 
 namespace vertexai {
 namespace tile {
 namespace math {
 
+// The terms of a Polynomial: the coefficient of each variable, with the constant term as the coefficient of the empty
+// variable.
+//
+// Polynomials rarely have more than a few terms, so the terms are kept inline in a vector sorted by variable name, and
+// the names are interned so that copying a polynomial copies no strings.  The interface is the part of std::map's that
+// polynomials' users need, except that, as for a vector, inserting or erasing a term invalidates iterators.
+template <typename T>
+class Terms {
+ public:
+  using key_type = InternedString;
+  using mapped_type = T;
+  using value_type = std::pair<InternedString, T>;
+
+ private:
+  using Vector = boost::container::small_vector<value_type, 4>;
+
+ public:
+  using iterator = typename Vector::iterator;
+  using const_iterator = typename Vector::const_iterator;
+
+  iterator begin() { return terms_.begin(); }
+  iterator end() { return terms_.end(); }
+  const_iterator begin() const { return terms_.begin(); }
+  const_iterator end() const { return terms_.end(); }
+
+  std::size_t size() const { return terms_.size(); }
+  bool empty() const { return terms_.empty(); }
+  void clear() { terms_.clear(); }
+  void swap(Terms& rhs) { terms_.swap(rhs.terms_); }
+
+  // Lookups compare names as strings, so they never need to intern the name.
+  iterator find(const std::string& name) {
+    auto it = lower_bound(name);
+    return it != terms_.end() && it->first.str() == name ? it : terms_.end();
+  }
+  const_iterator find(const std::string& name) const { return const_cast<Terms*>(this)->find(name); }
+  std::size_t count(const std::string& name) const { return find(name) != terms_.end(); }
+
+  T& at(const std::string& name) {
+    auto it = find(name);
+    if (it == terms_.end()) {
+      throw std::out_of_range("No term for " + name);
+    }
+    return it->second;
+  }
+  const T& at(const std::string& name) const { return const_cast<Terms*>(this)->at(name); }
+
+  // Insertions intern the name only when adding a term for it.
+  T& operator[](const InternedString& name) { return emplace(name, T()).first->second; }
+  T& operator[](const std::string& name) { return emplace(name, T()).first->second; }
+  T& operator[](const char* name) { return emplace(name, T()).first->second; }
+
+  std::pair<iterator, bool> emplace(const InternedString& name, T value) { return add(name, std::move(value)); }
+  std::pair<iterator, bool> emplace(const std::string& name, T value) { return add(name, std::move(value)); }
+  std::pair<iterator, bool> emplace(const char* name, T value) { return add(std::string(name), std::move(value)); }
+  std::pair<iterator, bool> insert(const value_type& term) { return add(term.first, term.second); }
+
+  iterator erase(const_iterator pos) { return terms_.erase(pos); }
+  std::size_t erase(const std::string& name) {
+    auto it = find(name);
+    if (it == terms_.end()) {
+      return 0;
+    }
+    terms_.erase(it);
+    return 1;
+  }
+
+  bool operator==(const Terms& rhs) const { return terms_ == rhs.terms_; }
+  bool operator!=(const Terms& rhs) const { return terms_ != rhs.terms_; }
+  bool operator<(const Terms& rhs) const { return terms_ < rhs.terms_; }
+
+ private:
+  iterator lower_bound(const std::string& name) {
+    return std::lower_bound(terms_.begin(), terms_.end(), name,
+                            [](const value_type& term, const std::string& name) { return term.first.str() < name; });
+  }
+
+  template <typename Name>
+  std::pair<iterator, bool> add(const Name& name, T value) {
+    const std::string& str = name;
+    auto it = lower_bound(str);
+    if (it != terms_.end() && it->first.str() == str) {
+      return std::make_pair(it, false);
+    }
+    return std::make_pair(terms_.emplace(it, InternedString(name), std::move(value)), true);
+  }
+
+  Vector terms_;
+};
+
 // A linear Polynomial<Rational> of Rational coefficients
 template <typename T>
 class Polynomial : boost::additive<Polynomial<T>>,
@@ -32,8 +126,8 @@ class Polynomial : boost::additive<Polynomial<T>>,
   Polynomial(const std::string& i, const T& c = 1);  // Monomial  // NOLINT
   // clang-format on
   T operator[](const std::string& var) const;      // Quick coefficent access
-  const std::map<std::string, T>& getMap() const;  // Get inner map
-  std::map<std::string, T>& mutateMap();           // Get inner map for editing
+  const Terms<T>& getMap() const;                  // Get inner map
+  Terms<T>& mutateMap();                           // Get inner map for editing
   bool operator==(const Polynomial& rhs) const;    // Equality
   bool operator<(const Polynomial& rhs) const;     // Lexigraphical order
   Polynomial& operator+=(const Polynomial& rhs);   // Addition
@@ -67,7 +161,7 @@ class Polynomial : boost::additive<Polynomial<T>>,
  private:
   // Map from index -> coefficient
   // Constant offset is a coefficent of empty string
-  std::map<std::string, T> map_;
+  Terms<T> map_;
 };
 
 extern template class Polynomial<Rational>;
@@ -232,9 +232,9 @@ void SemtreeEmitter::Visit(const stripe::Special& spec) {
   lang::Op op;
   op.tag = lang::Op::FUNCTION;
   op.f.fn = spec.name;
-  op.inputs = spec.inputs;
+  op.inputs = spec.buffer_reads();
   if (spec.outputs.size() > 1) {
-    op.f.params = spec.outputs;
+    op.f.params = spec.buffer_writes();
   } else {
     op.output = spec.outputs[0];
   }
@@ -0,0 +1,210 @@
+// Copyright 2020, Intel Corporation.
+
+#include "tile/platform/local_machine/cpu_buffer.h"
+
+#ifdef _WIN32
+#include <malloc.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+#include "base/util/env.h"
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+namespace {
+
+#ifdef MAP_HUGETLB
+constexpr std::size_t kHugePageSize = 2 << 20;
+
+// Explicit huge pages come from a pool the administrator reserves up front, so they are only requested on demand.
+bool UseHugeTLB() {
+  static bool use = env::Get("PLAIDML_CPU_HUGETLB") == "1";
+  return use;
+}
+#endif
+
+// Allocates size bytes of CpuBuffer::kAlignment-aligned memory, setting *release to the function freeing it.  Sets
+// *zeroed if the system guarantees the memory reads as zero.
+char* Allocate(std::uint64_t size, std::function<void()>* release, bool* zeroed) {
+  *zeroed = !size;
+  if (!size) {
+    return nullptr;
+  }
+  if (CpuBuffer::kMapThreshold <= size) {
+    // Fresh system pages are zero-filled by the kernel as they are first touched, so nothing is touched here.
+    *zeroed = true;
+#ifdef _WIN32
+    void* ptr = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!ptr) {
+      throw std::bad_alloc();
+    }
+    *release = [ptr] { VirtualFree(ptr, 0, MEM_RELEASE); };
+#else
+    void* ptr = MAP_FAILED;
+    std::size_t length = size;
+#ifdef MAP_HUGETLB
+    if (UseHugeTLB()) {
+      length = (size + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+      ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif
+    if (ptr == MAP_FAILED) {
+      // Either explicit huge pages were not requested or the pool is exhausted; ask for transparent ones instead.
+      length = size;
+      ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (ptr == MAP_FAILED) {
+        throw std::bad_alloc();
+      }
+#ifdef MADV_HUGEPAGE
+      madvise(ptr, length, MADV_HUGEPAGE);
+#endif
+    }
+    *release = [ptr, length] { munmap(ptr, length); };
+#endif
+    return static_cast<char*>(ptr);
+  }
+#ifdef _WIN32
+  void* ptr = _aligned_malloc(size, CpuBuffer::kAlignment);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  *release = [ptr] { _aligned_free(ptr); };
+#else
+  void* ptr = nullptr;
+  if (posix_memalign(&ptr, CpuBuffer::kAlignment, size)) {
+    throw std::bad_alloc();
+  }
+  *release = [ptr] { std::free(ptr); };
+#endif
+  return static_cast<char*>(ptr);
+}
+
+class CpuView final : public View {
+ public:
+  CpuView(std::shared_ptr<CpuBuffer> buffer, char* data, std::size_t size)
+      : View(data, size), buffer_{std::move(buffer)} {}
+
+  void WriteBack(const context::Context& ctx) final {}
+
+ private:
+  std::shared_ptr<CpuBuffer> buffer_;  // Keeps the memory alive while the view is in use
+};
+
+}  // namespace
+
+constexpr std::size_t CpuBuffer::kMinAlignment;
+constexpr std::size_t CpuBuffer::kAlignment;
+constexpr std::size_t CpuBuffer::kMapThreshold;
+
+CpuBuffer::CpuBuffer(std::uint64_t size) : size_{size} { data_ = Allocate(size, &release_, &defined_); }
+
+CpuBuffer::CpuBuffer(char* data, std::uint64_t size, std::function<void()> release)
+    : defined_{true}, data_{data}, size_{size}, release_{std::move(release)} {}
+
+CpuBuffer::~CpuBuffer() {
+  if (release_) {
+    release_();
+  }
+}
+
+boost::shared_future<void> CpuBuffer::pending() {
+  std::lock_guard<std::mutex> lock{mu_};
+  return pending_;
+}
+
+void CpuBuffer::SetPendingWrite(boost::shared_future<void> done) {
+  std::lock_guard<std::mutex> lock{mu_};
+  // The writer waited for every earlier access, so its completion now implies theirs.
+  pending_ = std::move(done);
+  readers_.clear();
+  defined_ = true;
+}
+
+bool CpuBuffer::AddPendingRead(boost::shared_future<void> done) {
+  std::lock_guard<std::mutex> lock{mu_};
+  readers_.erase(std::remove_if(readers_.begin(), readers_.end(),
+                                [](const boost::shared_future<void>& reader) { return reader.is_ready(); }),
+                 readers_.end());
+  readers_.emplace_back(std::move(done));
+  return true;
+}
+
+std::vector<boost::shared_future<void>> CpuBuffer::PendingAccesses() {
+  std::lock_guard<std::mutex> lock{mu_};
+  std::vector<boost::shared_future<void>> accesses;
+  if (pending_.valid() && !pending_.is_ready()) {
+    accesses.emplace_back(pending_);
+  }
+  for (const auto& reader : readers_) {
+    if (!reader.is_ready()) {
+      accesses.emplace_back(reader);
+    }
+  }
+  return accesses;
+}
+
+void CpuBuffer::Define() {
+  std::lock_guard<std::mutex> lock{mu_};
+  if (!defined_) {
+    std::fill(data_, data_ + size_, '\0');
+    defined_ = true;
+  }
+}
+
+boost::future<std::unique_ptr<View>> CpuBuffer::MapCurrent(const context::Context& ctx) {
+  auto self = shared_from_this();
+  auto done = pending();
+  if (!done.valid() || done.is_ready()) {
+    Define();
+    std::unique_ptr<View> view = std::make_unique<CpuView>(self, data_, size_);
+    return boost::make_ready_future(std::move(view));
+  }
+  return done.then([self](boost::shared_future<void> fut) {
+    fut.get();
+    std::unique_ptr<View> view = std::make_unique<CpuView>(self, self->data_, self->size_);
+    return view;
+  });
+}
+
+std::unique_ptr<View> CpuBuffer::MapDiscard(const context::Context& ctx) {
+  // The contents are being discarded, so a failed access does not matter; only its completion does.
+  for (const auto& access : PendingAccesses()) {
+    access.wait();
+  }
+  return MapForWrite();
+}
+
+std::unique_ptr<View> CpuBuffer::MapForWrite() {
+  // Programs need not write every element of their outputs, and callers may read back what they did not write, so
+  // even discarded contents are zeroed the first time.
+  Define();
+  return std::make_unique<CpuView>(shared_from_this(), data_, size_);
+}
+
+BufferPtr CpuBuffer::Clone() {
+  auto done = pending();
+  if (done.valid()) {
+    done.wait();
+  }
+  // Clones always own their memory, even when this buffer wraps the caller's.  Contents nothing has written yet need
+  // no copy: the clone will be zeroed on demand just as this buffer would be.
+  auto clone = std::make_shared<CpuBuffer>(size_);
+  std::lock_guard<std::mutex> lock{mu_};
+  if (defined_) {
+    std::copy(data_, data_ + size_, clone->data_);
+    clone->defined_ = true;
+  }
+  return clone;
+}
+
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
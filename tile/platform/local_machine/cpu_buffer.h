@@ -0,0 +1,91 @@
+// Copyright 2020, Intel Corporation.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "tile/base/buffer.h"
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+
+// A host memory buffer for the CPU device.
+//
+// CPU programs run asynchronously, so the buffer tracks the run (if any) that is writing it, and the runs still reading
+// it: maps of the current contents are chained on the writer's completion, so callers always observe completed
+// results, while discarding maps and later writers also wait for the readers, so nothing is overwritten mid-read.
+//
+// The memory is either owned by the buffer, or supplied by the caller (see Platform::MakeExternalBuffer), in which
+// case programs read and write it in place.
+//
+// Owned memory is cache-line aligned, and is never touched at allocation: large buffers are mapped directly from the
+// system (backed by huge pages where available), so that each page is faulted in by whichever thread first writes it,
+// typically the one computing on it, and read as zero until written.  Smaller owned memory comes from the heap, and is
+// zeroed when it is first mapped, however it is mapped, so that every buffer starts out zeroed.
+class CpuBuffer final : public tile::Buffer, public std::enable_shared_from_this<CpuBuffer> {
+ public:
+  // The alignment of the memory of every buffer the CPU device allocates, on which generated code may rely; caller
+  // memory must be at least as aligned.
+  static constexpr std::size_t kMinAlignment = 16;
+
+  // The alignment of owned memory: a cache line, so that no vector load or store straddles one.
+  static constexpr std::size_t kAlignment = 64;
+
+  // Owned buffers at least this large are mapped directly from the system rather than the heap.
+  static constexpr std::size_t kMapThreshold = 2 << 20;
+
+  explicit CpuBuffer(std::uint64_t size);
+
+  // Wraps caller-owned memory, calling release (if supplied) once the buffer is destroyed.
+  CpuBuffer(char* data, std::uint64_t size, std::function<void()> release);
+
+  ~CpuBuffer();
+
+  std::uint64_t size() const final { return size_; }
+
+  boost::future<std::unique_ptr<View>> MapCurrent(const context::Context& ctx) final;
+
+  std::unique_ptr<View> MapDiscard(const context::Context& ctx) final;
+
+  BufferPtr Clone() final;
+
+  // Records that the buffer is being written by a run that completes with the supplied future.  The run must already
+  // have waited for PendingAccesses().
+  void SetPendingWrite(boost::shared_future<void> done);
+
+  // Records that the buffer is being read by a run that completes with the supplied future.
+  bool AddPendingRead(boost::shared_future<void> done) final;
+
+  // Returns the completions of the runs still writing or reading the buffer, all of which must finish before it may be
+  // overwritten.
+  std::vector<boost::shared_future<void>> PendingAccesses();
+
+  // Maps the buffer for a run which will overwrite it, and which has already waited for PendingAccesses().
+  std::unique_ptr<View> MapForWrite();
+
+  // The buffer's memory, which stays at the same address for the buffer's lifetime.  Its contents may only be accessed
+  // through a view, or by a run ordered by the pending accesses above.
+  char* data() const { return data_; }
+
+ private:
+  boost::shared_future<void> pending();
+
+  // Marks the contents as defined, zeroing them first if nothing has written them yet.
+  void Define();
+
+  std::mutex mu_;
+  boost::shared_future<void> pending_;
+  std::vector<boost::shared_future<void>> readers_;
+  bool defined_;
+  char* data_;
+  std::uint64_t size_;
+  std::function<void()> release_;
+};
+
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
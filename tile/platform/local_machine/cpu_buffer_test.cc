@@ -0,0 +1,146 @@
+// Copyright 2020, Intel Corporation.
+
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "tile/platform/local_machine/cpu_buffer.h"
+#include "tile/platform/local_machine/platform.h"
+
+using ::testing::Eq;
+using ::testing::IsEmpty;
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+namespace {
+
+TEST(CpuBufferTest, PendingAccessesTrackReaders) {
+  auto buffer = std::make_shared<CpuBuffer>(64);
+  EXPECT_THAT(buffer->PendingAccesses(), IsEmpty());
+
+  boost::promise<void> read1;
+  boost::promise<void> read2;
+  buffer->AddPendingRead(read1.get_future().share());
+  buffer->AddPendingRead(read2.get_future().share());
+  EXPECT_THAT(buffer->PendingAccesses().size(), Eq(2));
+
+  read1.set_value();
+  EXPECT_THAT(buffer->PendingAccesses().size(), Eq(1));
+
+  // A writer waits for every earlier access, so it supersedes the readers.
+  boost::promise<void> write;
+  buffer->SetPendingWrite(write.get_future().share());
+  EXPECT_THAT(buffer->PendingAccesses().size(), Eq(1));
+  read2.set_value();
+  write.set_value();
+  EXPECT_THAT(buffer->PendingAccesses(), IsEmpty());
+}
+
+TEST(CpuBufferTest, MapDiscardWaitsForReaders) {
+  context::Context ctx;
+  auto buffer = std::make_shared<CpuBuffer>(64);
+  boost::promise<void> read;
+  buffer->AddPendingRead(read.get_future().share());
+
+  auto discard = std::async(std::launch::async, [&] { return buffer->MapDiscard(ctx); });
+  EXPECT_THAT(discard.wait_for(std::chrono::milliseconds(50)), Eq(std::future_status::timeout));
+  read.set_value();
+  EXPECT_THAT(discard.get()->size(), Eq(64));
+}
+
+TEST(CpuBufferTest, FreshBuffersReadAsZero) {
+  context::Context ctx;
+  // Leave some dirty memory on the heap for the buffers below to reuse.
+  for (int i = 0; i < 4; ++i) {
+    auto dirty = std::make_shared<CpuBuffer>(256);
+    auto view = dirty->MapDiscard(ctx);
+    std::memset(view->data(), 'x', view->size());
+  }
+  std::string zeros(256, '\0');
+  auto discarded = std::make_shared<CpuBuffer>(256)->MapDiscard(ctx);
+  EXPECT_THAT(std::string(discarded->data(), discarded->size()), Eq(zeros));
+  auto written = std::make_shared<CpuBuffer>(256)->MapForWrite();
+  EXPECT_THAT(std::string(written->data(), written->size()), Eq(zeros));
+}
+
+TEST(CpuBufferTest, ExternalReleaseFollowsLastViewAndRun) {
+  context::Context ctx;
+  alignas(CpuBuffer::kAlignment) char data[64] = {};
+  int releases = 0;
+  auto buffer = std::make_shared<CpuBuffer>(data, sizeof(data), [&releases] { ++releases; });
+  auto view = buffer->MapCurrent(ctx).get();
+  EXPECT_THAT(view->data(), Eq(data));
+
+  // A run holds the buffers it uses until it completes, and then lets them go, just as CpuProgram::Run does.
+  auto held = std::make_shared<std::shared_ptr<CpuBuffer>>(buffer);
+  boost::promise<void> start;
+  auto run = start.get_future()
+                 .then([held](boost::future<void> fut) {
+                   auto used = std::move(*held);
+                   fut.get();
+                 })
+                 .share();
+  buffer->SetPendingWrite(run);
+
+  buffer.reset();
+  EXPECT_THAT(releases, Eq(0));
+  view.reset();
+  EXPECT_THAT(releases, Eq(0));
+  start.set_value();
+  run.wait();
+  EXPECT_THAT(releases, Eq(1));
+}
+
+TEST(CpuBufferTest, ExternalCloneCopies) {
+  context::Context ctx;
+  alignas(CpuBuffer::kAlignment) char data[64];
+  std::memset(data, 'a', sizeof(data));
+  int releases = 0;
+  auto buffer = std::make_shared<CpuBuffer>(data, sizeof(data), [&releases] { ++releases; });
+
+  auto clone = buffer->Clone();
+  auto clone_view = clone->MapCurrent(ctx).get();
+  EXPECT_NE(clone_view->data(), data);
+  EXPECT_THAT(clone_view->data()[0], Eq('a'));
+
+  // The two no longer share memory in either direction.
+  data[0] = 'b';
+  EXPECT_THAT(clone_view->data()[0], Eq('a'));
+  clone_view->data()[1] = 'c';
+  EXPECT_THAT(data[1], Eq('a'));
+
+  // Only the wrapped buffer releases the caller's memory.
+  clone_view.reset();
+  clone.reset();
+  EXPECT_THAT(releases, Eq(0));
+  buffer.reset();
+  EXPECT_THAT(releases, Eq(1));
+}
+
+TEST(CpuBufferTest, ExternalRejectsUnusableMemory) {
+  context::Context ctx;
+  Platform platform;
+  alignas(CpuBuffer::kAlignment) char data[128] = {};
+  int releases = 0;
+  auto release = [&releases] { ++releases; };
+
+  EXPECT_THROW(platform.MakeExternalBuffer(ctx, "llvm_cpu.0", data + 1, 64, release), std::runtime_error);
+  EXPECT_THROW(platform.MakeExternalBuffer(ctx, "llvm_cpu.0", nullptr, 64, release), std::runtime_error);
+  EXPECT_THROW(platform.MakeExternalBuffer(ctx, "opencl_cpu.0", data, 64, release), std::runtime_error);
+  // The memory remains the caller's when the request fails.
+  EXPECT_THAT(releases, Eq(0));
+
+  platform.MakeExternalBuffer(ctx, "llvm_cpu.0", data, 64, release).reset();
+  EXPECT_THAT(releases, Eq(1));
+}
+
+}  // namespace
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
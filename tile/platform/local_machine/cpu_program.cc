@@ -2,11 +2,28 @@
 
 #include "tile/platform/local_machine/cpu_program.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+#include <boost/thread/executors/basic_thread_pool.hpp>
 
 #include "base/util/env.h"
 #include "tile/codegen/driver.h"
 #include "tile/lang/gen_stripe.h"
+#include "tile/platform/local_machine/cpu_buffer.h"
+#include "tile/stripe/stripe.pb.h"
 #include "tile/targets/cpu/jit.h"
 #include "tile/targets/targets.h"
 
@@ -14,31 +31,51 @@ namespace vertexai {
 namespace tile {
 namespace local_machine {
 
+namespace {
+
+std::string SerializeDeterministic(const google::protobuf::Message& msg) {
+  std::string bytes;
+  google::protobuf::io::StringOutputStream raw{&bytes};
+  google::protobuf::io::CodedOutputStream coded{&raw};
+  coded.SetSerializationDeterministic(true);
+  msg.SerializeToCodedStream(&coded);
+  return bytes;
+}
+
+// The pool on which CPU programs execute.  Kernels are themselves parallelized internally, so a small number of
+// dispatch threads suffices to keep several programs in flight.
+boost::executors::basic_thread_pool& Dispatcher() {
+  static boost::executors::basic_thread_pool pool{[] {
+    auto env_inflight = env::Get("PLAIDML_CPU_MAX_INFLIGHT");
+    if (env_inflight.size()) {
+      return std::max(1, std::atoi(env_inflight.c_str()));
+    }
+    return static_cast<int>(std::max(2u, std::thread::hardware_concurrency() / 4));
+  }()};
+  return pool;
+}
+
+// Adds a program's constant buffers to the inputs of a run.  Callers may pass a constant themselves, as long as it is
+// the same buffer the program was compiled with.
+void AddConstants(const std::map<std::string, std::shared_ptr<tile::Buffer>>& const_bufs,
+                  std::map<std::string, std::shared_ptr<tile::Buffer>>* inputs) {
+  for (const auto& kvp : const_bufs) {
+    auto it = inputs->emplace(kvp.first, kvp.second).first;
+    if (it->second != kvp.second) {
+      throw std::runtime_error("Input \"" + kvp.first + "\" is bound to a different buffer than the constant compiled "
+                               "into the program");
+    }
+  }
+}
+
+}  // namespace
+
 CpuProgram::CpuProgram(            //
     const std::string& target,     //
     const lang::RunInfo& runinfo,  //
     ConstBufferManager* const_bufs)
     : executable_{new targets::cpu::Native} {
-  auto stripe = GenerateStripe(runinfo);
-  auto out_dir = boost::filesystem::path(env::Get("PLAIDML_STRIPE_OUTPUT"));
-  codegen::OptimizeOptions options = {
-      !out_dir.empty(),    // dump_passes
-      false,               // dump_passes_proto
-      false,               // dump_code
-      out_dir / "passes",  // dbg_dir
-  };
-  const auto& cfgs = targets::GetConfigs();
-  const auto& cfg = cfgs.configs().at(target);
-  const auto& stage = cfg.stages().at("default");
-  codegen::CompilerState state(stripe);
-  state.const_bufs = const_bufs;
-  codegen::Optimize(&state, stage.passes(), options);
-  targets::cpu::Config config;
-  if (!env::Get("PLAIDML_CPU_PROFILE").empty()) {
-    config.profile_block_execution = true;
-    source_ = stripe->entry;
-  }
-  executable_->compile(*stripe->entry, config);
+  Compile(target, GenerateStripe(runinfo), const_bufs);
 }
 
 CpuProgram::CpuProgram(                              //
@@ -46,6 +83,13 @@ CpuProgram::CpuProgram(                              //
     const std::shared_ptr<stripe::Program>& stripe,  //
     ConstBufferManager* const_bufs)
     : executable_{new targets::cpu::Native} {
+  Compile(target, stripe, const_bufs);
+}
+
+void CpuProgram::Compile(                            //
+    const std::string& target,                       //
+    const std::shared_ptr<stripe::Program>& stripe,  //
+    ConstBufferManager* const_bufs) {
   auto out_dir = boost::filesystem::path(env::Get("PLAIDML_STRIPE_OUTPUT"));
   codegen::OptimizeOptions options = {
       !out_dir.empty(),    // dump_passes
@@ -56,15 +100,75 @@ CpuProgram::CpuProgram(                              //
   const auto& cfgs = targets::GetConfigs();
   const auto& cfg = cfgs.configs().at(target);
   const auto& stage = cfg.stages().at("default");
-  codegen::CompilerState state(stripe);
-  state.const_bufs = const_bufs;
-  codegen::Optimize(&state, stage.passes(), options);
   targets::cpu::Config config;
   if (!env::Get("PLAIDML_CPU_PROFILE").empty()) {
     config.profile_block_execution = true;
+  }
+
+  // Consult the on-disk object cache before running any codegen passes; the key
+  // covers everything that affects the generated code, including the contents
+  // of the constants, so a hit can skip both the Stripe pass pipeline and LLVM.
+  // Constant propagation materializes new constant buffers while the passes
+  // run, so their contents are stored with the object code and restored on a
+  // hit.
+  auto cache = targets::cpu::ObjectCache::FromEnv();
+  if (!targets::cpu::ObjectCache::IsCacheable(config) || options.dump_passes ||
+      (const_bufs && !const_bufs->allocator)) {
+    cache.reset();
+  }
+  std::string key;
+  std::set<std::string> supplied;
+  if (cache) {
+    context::Context ctx;
+    std::vector<std::unique_ptr<tile::View>> views;
+    std::vector<targets::cpu::ConstantBytes> constants;
+    if (const_bufs) {
+      for (const auto& kvp : const_bufs->buffers) {
+        views.emplace_back(kvp.second->MapCurrent(ctx).get());
+        constants.emplace_back(targets::cpu::ConstantBytes{kvp.first, views.back()->data(), views.back()->size()});
+        supplied.emplace(kvp.first);
+      }
+    }
+    key = targets::cpu::ObjectCache::ComputeKey(SerializeDeterministic(stripe::IntoProto(*stripe)),
+                                                SerializeDeterministic(stage), constants);
+    std::map<std::string, std::string> derived;
+    if (executable_->load(*cache, key, &derived)) {
+      if (const_bufs) {
+        for (const auto& kvp : derived) {
+          auto buffer = const_bufs->allocator->allocate(kvp.second.size());
+          auto view = buffer->MapDiscard(ctx);
+          std::memcpy(view->data(), kvp.second.data(), kvp.second.size());
+          view->WriteBack(ctx);
+          const_bufs->buffers[kvp.first] = buffer;
+        }
+        const_bufs_ = const_bufs->buffers;
+      }
+      IVLOG(1, "Peak arena size: " << executable_->arena_size());
+      return;
+    }
+  }
+
+  codegen::CompilerState state(stripe);
+  state.const_bufs = const_bufs;
+  codegen::Optimize(&state, stage.passes(), options);
+  if (const_bufs) {
+    const_bufs_ = const_bufs->buffers;
+  }
+  if (config.profile_block_execution) {
     source_ = CloneBlock(*stripe->entry);
   }
   executable_->compile(*(source_ ? source_ : stripe->entry), config);
+  IVLOG(1, "Peak arena size: " << executable_->arena_size());
+  if (cache) {
+    std::map<std::string, std::string> derived;
+    context::Context ctx;
+    for (const auto& kvp : const_bufs_) {
+      if (!supplied.count(kvp.first)) {
+        derived.emplace(kvp.first, kvp.second->MapCurrent(ctx).get()->str());
+      }
+    }
+    executable_->store(*cache, key, derived);
+  }
 }
 
 CpuProgram::~CpuProgram() {}
@@ -73,37 +177,188 @@ boost::future<void> CpuProgram::Run(  //
     const context::Context& ctx,      //
     std::map<std::string, std::shared_ptr<tile::Buffer>> inputs,
     std::map<std::string, std::shared_ptr<tile::Buffer>> outputs) {
-  std::map<std::string, void*> buffers;
-  // map in the input buffers, preserving contents
+  AddConstants(const_bufs_, &inputs);
+  // Chain execution on the input buffers' readiness, rather than blocking the caller until they can be mapped.
+  std::vector<std::string> names;
+  std::vector<boost::future<std::unique_ptr<tile::View>>> mapped;
   for (auto& kvp : inputs) {
     IVLOG(2, "Input: " << kvp.first);
-    auto view = kvp.second->MapCurrent(ctx).get();
-    buffers.emplace(kvp.first, view->data());
+    names.emplace_back(kvp.first);
+    mapped.emplace_back(kvp.second->MapCurrent(ctx));
   }
-  // map in output buffers, discarding contents
-  for (auto& kvp : outputs) {
+  // Outputs are overwritten, so the run also waits for every earlier run still reading or writing one.  The outputs
+  // which are not also inputs are mapped, discarding their contents, once that wait is over.
+  std::vector<boost::shared_future<void>> accesses;
+  auto discards = std::make_shared<std::map<std::string, std::shared_ptr<tile::Buffer>>>();
+  for (const auto& kvp : outputs) {
     IVLOG(2, "Output: " << kvp.first);
+    if (auto cpu_buffer = std::dynamic_pointer_cast<CpuBuffer>(kvp.second)) {
+      auto pending = cpu_buffer->PendingAccesses();
+      accesses.insert(accesses.end(), pending.begin(), pending.end());
+    }
     // don't overwrite the buffer if it's already been mapped in
-    if (buffers.find(kvp.first) == buffers.end()) {
-      auto view = kvp.second->MapDiscard(ctx);
-      buffers.emplace(kvp.first, view->data());
+    if (inputs.find(kvp.first) == inputs.end()) {
+      discards->emplace(kvp.first, kvp.second);
     }
   }
-  executable_->run(buffers);
-  std::string profile_var = env::Get("PLAIDML_CPU_PROFILE");
-  if (!profile_var.empty()) {
-    // copy profile measurements into the saved stripe block
-    executable_->set_perf_attrs(source_.get());
-    // generate a unique file name for this run
-    static unsigned run_counter;
-    std::string suffix = "00000" + std::to_string(run_counter++);
-    suffix = suffix.substr(suffix.size() - 6);
-    auto path = boost::filesystem::path(profile_var + "." + suffix);
-    // dump annotated stripe block contents to disk
-    std::ofstream fout(path.string());
-    fout << *source_ << std::endl;
+  auto ready = boost::when_all(boost::when_all(mapped.begin(), mapped.end()),  //
+                               boost::when_all(accesses.begin(), accesses.end()));
+  auto done = ready
+                  .then(Dispatcher(),
+                        [self = shared_from_this(), ctx, names = std::move(names), discards](decltype(ready) fut) {
+                          // The continuation outlives the run, and the buffers record the run's completion, so the
+                          // buffers are taken out of it here rather than held in a cycle with it.
+                          std::map<std::string, std::shared_ptr<tile::Buffer>> outputs;
+                          outputs.swap(*discards);
+                          std::map<std::string, void*> buffers;
+                          std::vector<std::unique_ptr<tile::View>> input_views;
+                          auto results = std::get<0>(fut.get()).get();
+                          for (size_t i = 0; i < names.size(); i++) {
+                            input_views.emplace_back(results[i].get());
+                            buffers.emplace(names[i], input_views.back()->data());
+                          }
+                          std::map<std::string, std::unique_ptr<tile::View>> output_views;
+                          for (const auto& kvp : outputs) {
+                            auto cpu_buffer = std::dynamic_pointer_cast<CpuBuffer>(kvp.second);
+                            auto view = cpu_buffer ? cpu_buffer->MapForWrite() : kvp.second->MapDiscard(ctx);
+                            buffers.emplace(kvp.first, view->data());
+                            output_views.emplace(kvp.first, std::move(view));
+                          }
+                          auto args = self->executable_->arguments(buffers);
+                          self->Execute(args.data());
+                          for (const auto& kvp : output_views) {
+                            kvp.second->WriteBack(ctx);
+                          }
+                        })
+                  .share();
+  for (const auto& kvp : inputs) {
+    if (auto cpu_buffer = std::dynamic_pointer_cast<CpuBuffer>(kvp.second)) {
+      cpu_buffer->AddPendingRead(done);
+    }
+  }
+  for (const auto& kvp : outputs) {
+    if (auto cpu_buffer = std::dynamic_pointer_cast<CpuBuffer>(kvp.second)) {
+      cpu_buffer->SetPendingWrite(done);
+    }
+  }
+  return done.then([](boost::shared_future<void> fut) { fut.get(); });
+}
+
+// A bound run resolves the executable's argument slots once, from the addresses of the buffers, which never move.  Each
+// run is otherwise ordered against the buffers' other accesses just as CpuProgram::Run is.
+class CpuProgram::Bound final : public BoundProgram {
+ public:
+  Bound(std::shared_ptr<CpuProgram> program, const context::Context& ctx,
+        std::vector<std::shared_ptr<CpuBuffer>> inputs, std::vector<std::shared_ptr<CpuBuffer>> outputs,
+        std::vector<std::shared_ptr<CpuBuffer>> discards, std::vector<void*> args)
+      : program_{std::move(program)},
+        ctx_{ctx},
+        inputs_{std::move(inputs)},
+        outputs_{std::move(outputs)},
+        discards_{std::move(discards)},
+        args_{std::move(args)} {}
+
+  boost::future<void> Run() final {
+    std::vector<boost::future<std::unique_ptr<tile::View>>> mapped;
+    for (const auto& buffer : inputs_) {
+      mapped.emplace_back(buffer->MapCurrent(ctx_));
+    }
+    std::vector<boost::shared_future<void>> accesses;
+    for (const auto& buffer : outputs_) {
+      auto pending = buffer->PendingAccesses();
+      accesses.insert(accesses.end(), pending.begin(), pending.end());
+    }
+    auto discards = std::make_shared<std::vector<std::shared_ptr<CpuBuffer>>>(discards_);
+    auto ready = boost::when_all(boost::when_all(mapped.begin(), mapped.end()),  //
+                                 boost::when_all(accesses.begin(), accesses.end()));
+    auto done = ready
+                    .then(Dispatcher(),
+                          [program = program_, args = args_, discards](decltype(ready) fut) mutable {
+                            // As in CpuProgram::Run, the buffers are taken out of the continuation, which they
+                            // record as their pending write.
+                            std::vector<std::shared_ptr<CpuBuffer>> outputs;
+                            outputs.swap(*discards);
+                            std::vector<std::unique_ptr<tile::View>> views;
+                            for (auto& view : std::get<0>(fut.get()).get()) {
+                              views.emplace_back(view.get());
+                            }
+                            for (const auto& buffer : outputs) {
+                              views.emplace_back(buffer->MapForWrite());
+                            }
+                            program->Execute(args.data());
+                          })
+                    .share();
+    for (const auto& buffer : inputs_) {
+      buffer->AddPendingRead(done);
+    }
+    for (const auto& buffer : outputs_) {
+      buffer->SetPendingWrite(done);
+    }
+    return done.then([](boost::shared_future<void> fut) { fut.get(); });
   }
-  return boost::make_ready_future();
+
+ private:
+  std::shared_ptr<CpuProgram> program_;
+  context::Context ctx_;
+  std::vector<std::shared_ptr<CpuBuffer>> inputs_;
+  std::vector<std::shared_ptr<CpuBuffer>> outputs_;
+  std::vector<std::shared_ptr<CpuBuffer>> discards_;  // The outputs which are not also inputs
+  std::vector<void*> args_;
+};
+
+std::unique_ptr<BoundProgram> CpuProgram::Bind(                          //
+    const context::Context& ctx,                                         //
+    const std::map<std::string, std::shared_ptr<tile::Buffer>>& inputs,  //
+    const std::map<std::string, std::shared_ptr<tile::Buffer>>& outputs) {
+  auto all_inputs = inputs;
+  AddConstants(const_bufs_, &all_inputs);
+  // Only CPU buffers can be addressed without mapping them; anything else runs through Run().
+  std::map<std::string, void*> buffers;
+  std::vector<std::shared_ptr<CpuBuffer>> bound_inputs;
+  for (const auto& kvp : all_inputs) {
+    auto cpu_buffer = std::dynamic_pointer_cast<CpuBuffer>(kvp.second);
+    if (!cpu_buffer) {
+      return nullptr;
+    }
+    buffers.emplace(kvp.first, cpu_buffer->data());
+    bound_inputs.emplace_back(std::move(cpu_buffer));
+  }
+  std::vector<std::shared_ptr<CpuBuffer>> bound_outputs;
+  std::vector<std::shared_ptr<CpuBuffer>> discards;
+  for (const auto& kvp : outputs) {
+    auto cpu_buffer = std::dynamic_pointer_cast<CpuBuffer>(kvp.second);
+    if (!cpu_buffer) {
+      return nullptr;
+    }
+    if (buffers.emplace(kvp.first, cpu_buffer->data()).second) {
+      discards.emplace_back(cpu_buffer);
+    }
+    bound_outputs.emplace_back(std::move(cpu_buffer));
+  }
+  auto args = executable_->arguments(buffers);
+  return std::make_unique<Bound>(shared_from_this(), ctx, std::move(bound_inputs), std::move(bound_outputs),
+                                 std::move(discards), std::move(args));
+}
+
+void CpuProgram::Execute(void** args) {
+  // The source block is only retained when profiling.
+  if (!source_) {
+    executable_->run(args);
+    return;
+  }
+  std::string profile_var = env::Get("PLAIDML_CPU_PROFILE");
+  std::lock_guard<std::mutex> lock{profile_mu_};
+  executable_->run(args);
+  // copy profile measurements into the saved stripe block
+  executable_->set_perf_attrs(source_.get());
+  // generate a unique file name for this run
+  static std::atomic<unsigned> run_counter{0};
+  std::string suffix = "00000" + std::to_string(run_counter++);
+  suffix = suffix.substr(suffix.size() - 6);
+  auto path = boost::filesystem::path(profile_var + "." + suffix);
+  // dump annotated stripe block contents to disk
+  std::ofstream fout(path.string());
+  fout << *source_ << std::endl;
 }
 
 void CpuProgram::Release() {}
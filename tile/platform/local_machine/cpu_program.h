@@ -4,6 +4,7 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 
 #include "tile/base/program.h"
@@ -23,7 +24,12 @@ class Native;
 
 namespace local_machine {
 
-class CpuProgram final : public tile::Program {
+// CpuProgram runs JIT-compiled Stripe programs on the host.
+//
+// Runs are asynchronous: each one waits for its inputs to become available and then executes on a shared dispatch
+// pool, so several runs (of the same or different programs) may be in flight at once.  The pool's size is controlled
+// by PLAIDML_CPU_MAX_INFLIGHT.
+class CpuProgram final : public tile::Program, public std::enable_shared_from_this<CpuProgram> {
  public:
   CpuProgram(                        //
       const std::string& target,     //
@@ -42,6 +48,11 @@ class CpuProgram final : public tile::Program {
       std::map<std::string, std::shared_ptr<tile::Buffer>> inputs,
       std::map<std::string, std::shared_ptr<tile::Buffer>> outputs) final;
 
+  std::unique_ptr<BoundProgram> Bind(                                      //
+      const context::Context& ctx,                                         //
+      const std::map<std::string, std::shared_ptr<tile::Buffer>>& inputs,  //
+      const std::map<std::string, std::shared_ptr<tile::Buffer>>& outputs) final;
+
   // The maximum available memory
   std::size_t MaxAvailableMemory() final;
 
@@ -49,8 +60,19 @@ class CpuProgram final : public tile::Program {
   void Release() final;
 
  private:
+  void Compile(                                        //
+      const std::string& target,                       //
+      const std::shared_ptr<stripe::Program>& stripe,  //
+      ConstBufferManager* const_bufs);
+
+  class Bound;
+
+  void Execute(void** args);
+
   std::unique_ptr<tile::targets::cpu::Native> executable_;
+  std::map<std::string, std::shared_ptr<tile::Buffer>> const_bufs_;  // Bound as inputs on every run
   std::shared_ptr<stripe::Block> source_;
+  std::mutex profile_mu_;  // Serializes runs while profiling, since measurements accumulate in the executable
 };
 
 }  // namespace local_machine
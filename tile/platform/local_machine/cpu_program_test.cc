@@ -0,0 +1,210 @@
+// Copyright 2020, Intel Corporation.
+
+#include <gmock/gmock.h>
+
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "base/util/env.h"
+#include "tile/platform/local_machine/cpu_buffer.h"
+#include "tile/platform/local_machine/cpu_program.h"
+
+using ::testing::ContainerEq;
+using ::testing::Eq;
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+namespace {
+
+// Y = 2 * W + X, where the first step only depends on W, and so is evaluated at compile time when W is constant.
+constexpr char kCode[] = "function (W[N], X[N]) -> (Y) { T = 2 * W; Y = T + X; }";
+constexpr size_t kSize = 4;
+
+class CpuAllocator final : public Allocator {
+ public:
+  BufferPtr allocate(size_t size) final { return std::make_shared<CpuBuffer>(size); }
+};
+
+std::shared_ptr<Buffer> MakeBuffer(const std::vector<float>& values) {
+  context::Context ctx;
+  auto buffer = std::make_shared<CpuBuffer>(values.size() * sizeof(float));
+  auto view = buffer->MapDiscard(ctx);
+  std::memcpy(view->data(), values.data(), view->size());
+  return buffer;
+}
+
+std::vector<float> Contents(const std::shared_ptr<Buffer>& buffer) {
+  context::Context ctx;
+  auto view = buffer->MapCurrent(ctx).get();
+  std::vector<float> values(view->size() / sizeof(float));
+  std::memcpy(values.data(), view->data(), view->size());
+  return values;
+}
+
+lang::RunInfo MakeRunInfo(bool const_weights) {
+  lang::RunInfo runinfo;
+  runinfo.program_name = "const_program";
+  runinfo.code = kCode;
+  auto weights = SimpleShape(DataType::FLOAT32, {kSize});
+  weights.is_const = const_weights;
+  runinfo.input_shapes.emplace("W", weights);
+  runinfo.input_shapes.emplace("X", SimpleShape(DataType::FLOAT32, {kSize}));
+  runinfo.output_shapes.emplace("Y", SimpleShape(DataType::FLOAT32, {kSize}));
+  return runinfo;
+}
+
+class CpuProgramTest : public ::testing::Test {
+ protected:
+  CpuProgramTest() {
+    const_bufs_.allocator = std::make_shared<CpuAllocator>();
+    const_bufs_.buffers["W"] = W_;
+  }
+
+  context::Context ctx_;
+  std::shared_ptr<Buffer> W_ = MakeBuffer({1, 2, 3, 4});
+  std::shared_ptr<Buffer> X_ = MakeBuffer({10, 20, 30, 40});
+  std::vector<float> expected_{12, 24, 36, 48};
+  ConstBufferManager const_bufs_;
+};
+
+TEST_F(CpuProgramTest, RunWithoutConstants) {
+  auto program = std::make_shared<CpuProgram>("llvm_cpu", MakeRunInfo(false), nullptr);
+  auto Y = MakeBuffer(std::vector<float>(kSize));
+  program->Run(ctx_, {{"W", W_}, {"X", X_}}, {{"Y", Y}}).get();
+  EXPECT_THAT(Contents(Y), ContainerEq(expected_));
+}
+
+TEST_F(CpuProgramTest, RunBindsConstants) {
+  auto program = std::make_shared<CpuProgram>("llvm_cpu", MakeRunInfo(true), &const_bufs_);
+  // The constant is bound by the program itself, so the caller may leave it out...
+  auto Y = MakeBuffer(std::vector<float>(kSize));
+  program->Run(ctx_, {{"X", X_}}, {{"Y", Y}}).get();
+  EXPECT_THAT(Contents(Y), ContainerEq(expected_));
+
+  // ...or pass the same buffer again...
+  auto Y2 = MakeBuffer(std::vector<float>(kSize));
+  program->Run(ctx_, {{"W", W_}, {"X", X_}}, {{"Y", Y2}}).get();
+  EXPECT_THAT(Contents(Y2), ContainerEq(expected_));
+
+  // ...but not a different one, which the compiled program would silently ignore.
+  auto other = MakeBuffer({5, 6, 7, 8});
+  EXPECT_THROW(program->Run(ctx_, {{"W", other}, {"X", X_}}, {{"Y", Y}}), std::runtime_error);
+}
+
+TEST_F(CpuProgramTest, BindBindsConstants) {
+  auto program = std::make_shared<CpuProgram>("llvm_cpu", MakeRunInfo(true), &const_bufs_);
+  auto Y = MakeBuffer(std::vector<float>(kSize));
+  auto bound = program->Bind(ctx_, {{"X", X_}}, {{"Y", Y}});
+  ASSERT_TRUE(bound);
+  bound->Run();
+  bound.reset();
+  // The run outlives the binding, and mapping its output waits for it.
+  EXPECT_THAT(Contents(Y), ContainerEq(expected_));
+
+  auto other = MakeBuffer({5, 6, 7, 8});
+  EXPECT_THROW(program->Bind(ctx_, {{"W", other}, {"X", X_}}, {{"Y", Y}}), std::runtime_error);
+}
+
+TEST_F(CpuProgramTest, BoundRunsAreOrderedWithRuns) {
+  auto program = std::make_shared<CpuProgram>("llvm_cpu", MakeRunInfo(false), nullptr);
+  auto Y = MakeBuffer(std::vector<float>(kSize));
+  auto Z = MakeBuffer(std::vector<float>(kSize));
+  // Z = 2 * W + Y, bound before Y has been computed.
+  auto bound = program->Bind(ctx_, {{"W", W_}, {"X", Y}}, {{"Y", Z}});
+  ASSERT_TRUE(bound);
+
+  // Neither run is waited for: the bound run must wait for the run writing its input, and a later run overwriting
+  // that input must wait for the bound run to have read it.
+  program->Run(ctx_, {{"W", W_}, {"X", X_}}, {{"Y", Y}});
+  auto bound_done = bound->Run();
+  program->Run(ctx_, {{"W", W_}, {"X", W_}}, {{"Y", Y}});
+  bound_done.get();
+  EXPECT_THAT(Contents(Z), ContainerEq(std::vector<float>{14, 28, 42, 56}));
+  EXPECT_THAT(Contents(Y), ContainerEq(std::vector<float>{3, 6, 9, 12}));
+
+  // Binding doesn't keep the buffers mapped, or tie them to the binding, between runs.
+  bound.reset();
+  EXPECT_THAT(Contents(Z), ContainerEq(std::vector<float>{14, 28, 42, 56}));
+}
+
+TEST_F(CpuProgramTest, RunReleasesExternalBuffers) {
+  auto program = std::make_shared<CpuProgram>("llvm_cpu", MakeRunInfo(false), nullptr);
+  alignas(CpuBuffer::kAlignment) float w[kSize] = {1, 2, 3, 4};
+  alignas(CpuBuffer::kAlignment) float x[kSize] = {10, 20, 30, 40};
+  alignas(CpuBuffer::kAlignment) float y[kSize] = {};
+  int releases = 0;
+  auto wrap = [&](float* data) {
+    // Nothing may be released before the run has written its output.
+    return std::make_shared<CpuBuffer>(reinterpret_cast<char*>(data), sizeof(w), [&] {
+      EXPECT_THAT(y[0], Eq(expected_[0]));
+      ++releases;
+    });
+  };
+
+  auto W = wrap(w);
+  auto X = wrap(x);
+  auto Y = wrap(y);
+  auto done = program->Run(ctx_, {{"W", W}, {"X", X}}, {{"Y", Y}});
+  // The run keeps the buffers it uses until it completes.
+  W.reset();
+  X.reset();
+  Y.reset();
+  done.get();
+  EXPECT_THAT(releases, Eq(3));
+  EXPECT_THAT(std::vector<float>(y, y + kSize), ContainerEq(expected_));
+}
+
+TEST_F(CpuProgramTest, ObjectCacheKeysConstantsByContents) {
+  auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  env::Set("PLAIDML_CPU_CACHE_DIR", dir.string());
+  auto entries = [&dir] {
+    if (!boost::filesystem::exists(dir)) {
+      return 0l;
+    }
+    return std::distance(boost::filesystem::directory_iterator(dir), boost::filesystem::directory_iterator());
+  };
+  auto run = [&](const std::shared_ptr<CpuProgram>& program) {
+    auto Y = MakeBuffer(std::vector<float>(kSize));
+    program->Run(ctx_, {{"X", X_}}, {{"Y", Y}}).get();
+    return Contents(Y);
+  };
+
+  auto compiled = std::make_shared<CpuProgram>("llvm_cpu", MakeRunInfo(true), &const_bufs_);
+  EXPECT_THAT(entries(), Eq(1));
+  EXPECT_THAT(run(compiled), ContainerEq(expected_));
+
+  // The same contents in another buffer hit the cache, which restores the constant that propagation derived from W.
+  ConstBufferManager same;
+  same.allocator = std::make_shared<CpuAllocator>();
+  same.buffers["W"] = MakeBuffer({1, 2, 3, 4});
+  auto loaded = std::make_shared<CpuProgram>("llvm_cpu", MakeRunInfo(true), &same);
+  EXPECT_THAT(entries(), Eq(1));
+  EXPECT_THAT(same.buffers.size(), Eq(const_bufs_.buffers.size()));
+  EXPECT_THAT(run(loaded), ContainerEq(expected_));
+
+  // Different contents compile afresh.
+  ConstBufferManager other;
+  other.allocator = std::make_shared<CpuAllocator>();
+  other.buffers["W"] = MakeBuffer({5, 6, 7, 8});
+  auto recompiled = std::make_shared<CpuProgram>("llvm_cpu", MakeRunInfo(true), &other);
+  EXPECT_THAT(entries(), Eq(2));
+  EXPECT_THAT(run(recompiled), ContainerEq(std::vector<float>{20, 32, 44, 56}));
+
+  auto without_consts = std::make_shared<CpuProgram>("llvm_cpu", MakeRunInfo(false), nullptr);
+  EXPECT_THAT(entries(), Eq(3));
+
+  env::Set("PLAIDML_CPU_CACHE_DIR", "");
+  boost::filesystem::remove_all(dir);
+}
+
+}  // namespace
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
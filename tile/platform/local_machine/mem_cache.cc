@@ -2,26 +2,127 @@
 
 #include "tile/platform/local_machine/mem_cache.h"
 
+#include <iterator>
 #include <utility>
 
+#include "base/util/perf_counter.h"
+
 namespace vertexai {
 namespace tile {
 namespace local_machine {
+namespace {
+
+PerfCounter mem_cache_hits("mem_cache_hits");
+PerfCounter mem_cache_misses("mem_cache_misses");
+PerfCounter mem_cache_bytes_held("mem_cache_bytes_held");
+PerfCounter mem_cache_evictions("mem_cache_evictions");
+
+// A cached buffer may be used for a request up to this many times smaller than itself; beyond that, the device memory
+// is better spent on a fresh allocation.
+constexpr std::size_t kMaxSlack = 2;
+
+std::size_t Octave(std::size_t size) {
+  std::size_t octave = 0;
+  while (size >>= 1) {
+    octave++;
+  }
+  return octave;
+}
+
+}  // namespace
+
+constexpr std::size_t MemCache::kSubClasses;
+constexpr std::size_t MemCache::kMinClassSize;
+constexpr std::size_t MemCache::kNumShards;
+
+MemCache::MemCache(std::uint64_t high_water_mark) : high_water_mark_{high_water_mark} {}
+
+std::size_t MemCache::SizeClass(std::size_t size) {
+  if (size <= kMinClassSize) {
+    return kMinClassSize;
+  }
+  std::size_t step = (std::size_t{1} << Octave(size)) / kSubClasses;
+  return (size + step - 1) / step * step;
+}
+
+MemCache::Shard* MemCache::ShardFor(std::size_t capacity) { return &shards_[Octave(capacity) % kNumShards]; }
 
-std::shared_ptr<hal::Buffer> MemCache::TryAlloc(std::size_t size) {
-  std::lock_guard<std::mutex> lock{mu_};
-  auto& l = mem_[size];
-  if (l.size()) {
-    std::shared_ptr<hal::Buffer> result{std::move(l.top())};
-    l.pop();
+std::shared_ptr<hal::Buffer> MemCache::TryAlloc(std::size_t size, std::size_t* capacity) {
+  auto wanted = SizeClass(size);
+  // A best fit lies either in the request's own octave or the next one up.
+  for (auto candidate : {wanted, std::size_t{1} << (Octave(wanted) + 1)}) {
+    auto shard = ShardFor(candidate);
+    std::lock_guard<std::mutex> lock{shard->mu};
+    auto it = shard->mem.lower_bound(wanted);
+    if (it == shard->mem.end() || kMaxSlack * wanted < it->first) {
+      continue;
+    }
+    *capacity = it->first;
+    std::shared_ptr<hal::Buffer> result{std::move(it->second)};
+    shard->mem.erase(it);
+    bytes_held_ -= *capacity;
+    mem_cache_bytes_held.add(-static_cast<int64_t>(*capacity));
+    mem_cache_hits.inc();
     return result;
   }
+  mem_cache_misses.inc();
   return std::shared_ptr<hal::Buffer>{};
 }
 
-void MemCache::Free(std::size_t size, std::shared_ptr<hal::Buffer> mem) {
-  std::lock_guard<std::mutex> lock{mu_};
-  mem_[size].push(std::move(mem));
+void MemCache::Free(std::size_t capacity, std::shared_ptr<hal::Buffer> mem) {
+  if (!mem) {
+    return;
+  }
+  if (high_water_mark_ < capacity) {
+    // Never worth holding; let it go straight back to the device.
+    mem_cache_evictions.inc();
+    return;
+  }
+  // Account for the buffer before publishing it, so that a concurrent TryAlloc never drives bytes_held_ negative.
+  bytes_held_ += capacity;
+  mem_cache_bytes_held.add(capacity);
+  {
+    auto shard = ShardFor(capacity);
+    std::lock_guard<std::mutex> lock{shard->mu};
+    shard->mem.emplace(capacity, std::move(mem));
+  }
+  if (high_water_mark_ < bytes_held_) {
+    Trim(high_water_mark_);
+  }
+}
+
+void MemCache::Trim(std::uint64_t target) {
+  // Release the largest idle buffers first: they free the most memory per eviction, and small buffers are the ones
+  // most likely to be requested again.
+  while (target < bytes_held_) {
+    Shard* largest = nullptr;
+    std::size_t largest_size = 0;
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock{shard.mu};
+      if (!shard.mem.empty() && largest_size < shard.mem.rbegin()->first) {
+        largest = &shard;
+        largest_size = shard.mem.rbegin()->first;
+      }
+    }
+    if (!largest) {
+      return;
+    }
+    std::shared_ptr<hal::Buffer> victim;
+    {
+      std::lock_guard<std::mutex> lock{largest->mu};
+      if (largest->mem.empty()) {
+        continue;
+      }
+      auto it = std::prev(largest->mem.end());
+      largest_size = it->first;
+      victim = std::move(it->second);
+      largest->mem.erase(it);
+    }
+    bytes_held_ -= largest_size;
+    mem_cache_bytes_held.add(-static_cast<int64_t>(largest_size));
+    mem_cache_evictions.inc();
+    // The victim is released outside the shard lock, since returning memory to the device may be slow.
+  }
 }
 
 }  // namespace local_machine
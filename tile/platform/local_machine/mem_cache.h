@@ -2,11 +2,12 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <mutex>
-#include <stack>
-#include <unordered_map>
 
 #include "tile/base/hal.h"
 
@@ -15,14 +16,50 @@ namespace tile {
 namespace local_machine {
 
 // Caches device memory allocations.
+//
+// Requests are rounded up to a size class (a power of two, split into kSubClasses evenly-spaced steps), so that
+// buffers released by one program can be reused by requests of nearby sizes from any other program on the same
+// device.  Lookups are best-fit within a bounded amount of slack.  Idle buffers are released, largest first, whenever
+// the bytes held by the cache exceed its high-water mark.
 class MemCache {
  public:
-  std::shared_ptr<hal::Buffer> TryAlloc(std::size_t size);
-  void Free(std::size_t size, std::shared_ptr<hal::Buffer>);
+  static constexpr std::size_t kSubClasses = 4;
+  static constexpr std::size_t kMinClassSize = 256;
+
+  // A cache holding no more than high_water_mark idle bytes.
+  explicit MemCache(std::uint64_t high_water_mark = UINT64_MAX);
+
+  // Returns the size class for a request of the given size; buffers should be allocated at this size so that they
+  // can later satisfy any request in the class.
+  static std::size_t SizeClass(std::size_t size);
+
+  // Returns a cached buffer of at least the requested size, or nullptr.  On success, *capacity is set to the size of
+  // the returned buffer, which must be passed back to Free.
+  std::shared_ptr<hal::Buffer> TryAlloc(std::size_t size, std::size_t* capacity);
+
+  // Returns a buffer of the given capacity to the cache.
+  void Free(std::size_t capacity, std::shared_ptr<hal::Buffer> mem);
+
+  // Releases idle buffers until no more than target bytes are held.
+  void Trim(std::uint64_t target);
+
+  std::uint64_t bytes_held() const { return bytes_held_; }
+  std::uint64_t high_water_mark() const { return high_water_mark_; }
 
  private:
-  std::mutex mu_;
-  std::unordered_map<std::size_t, std::stack<std::shared_ptr<hal::Buffer>>> mem_;
+  // Each shard holds the idle buffers of a set of octaves, so that requests of unrelated sizes do not contend.
+  struct Shard {
+    std::mutex mu;
+    std::multimap<std::size_t, std::shared_ptr<hal::Buffer>> mem;
+  };
+
+  static constexpr std::size_t kNumShards = 8;
+
+  Shard* ShardFor(std::size_t capacity);
+
+  std::uint64_t high_water_mark_;
+  std::atomic<std::uint64_t> bytes_held_{0};
+  std::array<Shard, kNumShards> shards_;
 };
 
 }  // namespace local_machine
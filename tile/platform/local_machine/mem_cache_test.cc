@@ -0,0 +1,85 @@
+// Copyright 2020, Intel Corporation.
+
+#include <gmock/gmock.h>
+
+#include <memory>
+#include <vector>
+
+#include "tile/platform/local_machine/mem_cache.h"
+
+using ::testing::Eq;
+using ::testing::IsNull;
+using ::testing::Not;
+
+namespace vertexai {
+namespace tile {
+namespace local_machine {
+namespace {
+
+class FakeBuffer final : public hal::Buffer {
+ public:
+  boost::future<void*> MapCurrent(const std::vector<std::shared_ptr<hal::Event>>& deps) final {
+    throw std::logic_error{"unimplemented"};
+  }
+  boost::future<void*> MapDiscard(const std::vector<std::shared_ptr<hal::Event>>& deps) final {
+    throw std::logic_error{"unimplemented"};
+  }
+  std::shared_ptr<hal::Event> Unmap(const context::Context& ctx) final { throw std::logic_error{"unimplemented"}; }
+};
+
+TEST(MemCacheTest, SizeClasses) {
+  EXPECT_THAT(MemCache::SizeClass(1), Eq(256));
+  EXPECT_THAT(MemCache::SizeClass(256), Eq(256));
+  EXPECT_THAT(MemCache::SizeClass(257), Eq(320));
+  EXPECT_THAT(MemCache::SizeClass(1024), Eq(1024));
+  EXPECT_THAT(MemCache::SizeClass(1025), Eq(1280));
+  EXPECT_THAT(MemCache::SizeClass(1700), Eq(1792));
+  EXPECT_THAT(MemCache::SizeClass(1793), Eq(2048));
+}
+
+TEST(MemCacheTest, ReusesNearbySizes) {
+  MemCache cache;
+  std::size_t capacity = 0;
+  EXPECT_THAT(cache.TryAlloc(1000, &capacity), IsNull());
+
+  auto buffer = std::make_shared<FakeBuffer>();
+  cache.Free(MemCache::SizeClass(1000), buffer);
+  EXPECT_THAT(cache.bytes_held(), Eq(1024));
+
+  // A request from a different class is satisfied by the best available fit.
+  EXPECT_THAT(cache.TryAlloc(700, &capacity), Eq(buffer));
+  EXPECT_THAT(capacity, Eq(1024));
+  EXPECT_THAT(cache.bytes_held(), Eq(0));
+}
+
+TEST(MemCacheTest, BoundsSlack) {
+  MemCache cache;
+  cache.Free(4096, std::make_shared<FakeBuffer>());
+  std::size_t capacity = 0;
+  EXPECT_THAT(cache.TryAlloc(1000, &capacity), IsNull());
+  EXPECT_THAT(cache.TryAlloc(3000, &capacity), Not(IsNull()));
+  EXPECT_THAT(capacity, Eq(4096));
+}
+
+TEST(MemCacheTest, TrimsLargestFirst) {
+  MemCache cache{4096};
+  auto small = std::make_shared<FakeBuffer>();
+  cache.Free(1024, small);
+  cache.Free(2048, std::make_shared<FakeBuffer>());
+  cache.Free(2048, std::make_shared<FakeBuffer>());
+  EXPECT_THAT(cache.bytes_held(), Eq(3072));
+
+  // Buffers larger than the high-water mark are never held.
+  cache.Free(8192, std::make_shared<FakeBuffer>());
+  EXPECT_THAT(cache.bytes_held(), Eq(3072));
+
+  cache.Trim(1024);
+  EXPECT_THAT(cache.bytes_held(), Eq(1024));
+  std::size_t capacity = 0;
+  EXPECT_THAT(cache.TryAlloc(1024, &capacity), Eq(small));
+}
+
+}  // namespace
+}  // namespace local_machine
+}  // namespace tile
+}  // namespace vertexai
@@ -5,12 +5,18 @@
 #include <google/protobuf/util/json_util.h>
 
 #include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
 #include <memory>
+#include <string>
 #include <utility>
 
 #include <boost/process/environment.hpp>
 
 #include "base/util/compat.h"
+#include "base/util/env.h"
 #include "base/util/error.h"
 #include "base/util/factory.h"
 #include "base/util/logging.h"
@@ -20,6 +26,7 @@
 #include "tile/lang/parser.h"
 #include "tile/platform/local_machine/block_placer.h"
 #include "tile/platform/local_machine/buffer.h"
+#include "tile/platform/local_machine/cpu_buffer.h"
 #include "tile/platform/local_machine/cpu_program.h"
 #include "tile/platform/local_machine/direct_mem_strategy.h"
 #include "tile/platform/local_machine/fifo_scheduler.h"
@@ -36,11 +43,32 @@ namespace {
 
 const char* kCpuDevice = "llvm_cpu.0";
 
+// Builds the device's temporary memory pool.  By default the pool may hold idle buffers up to the same fraction of
+// device memory that the scheduler plans for; PLAIDML_MEM_CACHE_LIMIT overrides this with an explicit byte count.
+// A limit that isn't a plain decimal byte count is ignored with a warning.
+std::shared_ptr<MemCache> MakeTmpMemCache(hal::Memory* source) {
+  auto limit = env::Get("PLAIDML_MEM_CACHE_LIMIT");
+  if (limit.size()) {
+    // strtoull skips leading whitespace and accepts a sign, so require the value to start with a digit.
+    if (std::isdigit(static_cast<unsigned char>(limit[0]))) {
+      char* end = nullptr;
+      errno = 0;
+      auto bytes = std::strtoull(limit.c_str(), &end, 10);
+      if (errno == 0 && *end == '\0') {
+        return std::make_shared<MemCache>(bytes);
+      }
+    }
+    LOG(WARNING) << "Ignoring invalid PLAIDML_MEM_CACHE_LIMIT \"" << limit << "\"; expected a byte count";
+  }
+  return std::make_shared<MemCache>(std::llround(std::floor(source->size_goal() * kGoalMemPercentage)));
+}
+
 void GetMemStrategy(const std::shared_ptr<DevInfo>& devinfo, Platform::PlatformDev* pd) {
   if (devinfo->dev->executor() && devinfo->dev->executor()->shared_memory()) {
     IVLOG(2, "Using shared memory for data transfer");
     pd->mem_strategy = std::make_shared<DirectMemStrategy>(devinfo, devinfo->dev->executor()->shared_memory());
     pd->tmp_mem_source = devinfo->dev->executor()->shared_memory();
+    pd->tmp_mem_cache = MakeTmpMemCache(pd->tmp_mem_source);
     return;
   }
 
@@ -48,12 +76,14 @@ void GetMemStrategy(const std::shared_ptr<DevInfo>& devinfo, Platform::PlatformD
     IVLOG(2, "Using device memory and direct memory strategy");
     pd->mem_strategy = std::make_shared<DirectMemStrategy>(devinfo, devinfo->dev->executor()->device_memory());
     pd->tmp_mem_source = devinfo->dev->executor()->device_memory();
+    pd->tmp_mem_cache = MakeTmpMemCache(pd->tmp_mem_source);
     return;
   }
 
   IVLOG(2, "Using host memory for data transfer");
   pd->mem_strategy = std::make_shared<DirectMemStrategy>(devinfo, devinfo->devset->host_memory());
   pd->tmp_mem_source = devinfo->devset->host_memory();
+  pd->tmp_mem_cache = MakeTmpMemCache(pd->tmp_mem_source);
 }
 
 bool MatchConfig(const proto::Platform& config, const hal::proto::HardwareInfo& info,
@@ -214,12 +244,29 @@ void Platform::RegisterCostModel(const lang::TileCostFunction& cost_fn) { tile_o
 std::shared_ptr<tile::Buffer> Platform::MakeBuffer(const context::Context& ctx, const std::string& device_id,
                                                    std::uint64_t size) {
   if (device_id == kCpuDevice) {
-    return std::make_shared<SimpleBuffer>(size);
+    return std::make_shared<CpuBuffer>(size);
   }
   auto& platform_dev = LookupDevice(device_id);
   return std::make_shared<Buffer>(platform_dev.devinfo, platform_dev.mem_strategy, size);
 }
 
+std::shared_ptr<tile::Buffer> Platform::MakeExternalBuffer(const context::Context& ctx, const std::string& device_id,
+                                                           char* data, std::uint64_t size,
+                                                           std::function<void()> release) {
+  // Only the CPU device runs programs directly against host memory; every other device would need a copy anyway.
+  if (device_id != kCpuDevice) {
+    throw std::runtime_error("External buffers are not supported on device " + device_id);
+  }
+  if (!data && size) {
+    throw std::runtime_error("External buffer memory must not be null");
+  }
+  if (reinterpret_cast<std::uintptr_t>(data) % CpuBuffer::kMinAlignment) {
+    throw std::runtime_error("External buffer memory must be aligned to " + std::to_string(CpuBuffer::kMinAlignment) +
+                             " bytes");
+  }
+  return std::make_shared<CpuBuffer>(data, size, std::move(release));
+}
+
 std::shared_ptr<tile::Program> Platform::MakeProgram(  //
     const context::Context& ctx,                       //
     const tile::proto::Program& program,               //
@@ -234,7 +281,8 @@ std::shared_ptr<tile::Program> Platform::MakeProgram(  //
     return std::make_shared<CpuProgram>("llvm_cpu", runinfo, const_bufs);
   }
   const auto& platform_dev = LookupDevice(program.dev_id());
-  auto tmp_strategy = std::make_shared<TmpMemStrategy>(platform_dev.devinfo, platform_dev.tmp_mem_source);
+  auto tmp_strategy = std::make_shared<TmpMemStrategy>(platform_dev.devinfo, platform_dev.tmp_mem_source,  //
+                                                       platform_dev.tmp_mem_cache);
   return std::make_shared<Program>(  //
       ctx,                           //
       program,                       //
@@ -257,7 +305,8 @@ std::shared_ptr<tile::Program> Platform::MakeProgram(  //
     return std::make_shared<CpuProgram>(target, program, const_bufs);
   }
   const auto& platform_dev = LookupDevice(device);
-  auto tmp_strategy = std::make_shared<TmpMemStrategy>(platform_dev.devinfo, platform_dev.tmp_mem_source);
+  auto tmp_strategy = std::make_shared<TmpMemStrategy>(platform_dev.devinfo, platform_dev.tmp_mem_source,  //
+                                                       platform_dev.tmp_mem_cache);
   return std::make_shared<Program>(  //
       ctx,                           //
       program,                       //
@@ -12,6 +12,7 @@
 #include "tile/base/platform.h"
 #include "tile/platform/local_machine/devinfo.h"
 #include "tile/platform/local_machine/local_machine.pb.h"
+#include "tile/platform/local_machine/mem_cache.h"
 #include "tile/platform/local_machine/mem_strategy.h"
 #include "tile/platform/local_machine/scheduler.h"
 
@@ -30,6 +31,7 @@ class Platform : public tile::Platform {
     std::shared_ptr<DevInfo> devinfo;
     std::shared_ptr<MemStrategy> mem_strategy;
     hal::Memory* tmp_mem_source;
+    std::shared_ptr<MemCache> tmp_mem_cache;  // Shared by all programs running on the device
     std::shared_ptr<Scheduler> scheduler;
   };
 
@@ -43,6 +45,13 @@ class Platform : public tile::Platform {
       const std::string& device,             //
       std::uint64_t size) final;
 
+  std::shared_ptr<tile::Buffer> MakeExternalBuffer(  //
+      const context::Context& ctx,                   //
+      const std::string& device,                     //
+      char* data,                                    //
+      std::uint64_t size,                            //
+      std::function<void()> release) final;
+
   std::shared_ptr<tile::Program> MakeProgram(  //
       const context::Context& ctx,             //
       const tile::proto::Program& program,     //
@@ -13,7 +13,8 @@ namespace {
 // A MemChunk implementation that frees its underlying memory to a MemCache when the chunk is deleted.
 class TmpMemChunk final : public MemChunk {
  public:
-  TmpMemChunk(std::uint64_t size, const std::shared_ptr<MemCache>& mem_cache, std::shared_ptr<hal::Buffer> hal_buffer);
+  TmpMemChunk(std::uint64_t size, std::size_t capacity, const std::shared_ptr<MemCache>& mem_cache,
+              std::shared_ptr<hal::Buffer> hal_buffer);
   virtual ~TmpMemChunk();
 
   std::uint64_t size() const final;
@@ -24,16 +25,17 @@ class TmpMemChunk final : public MemChunk {
 
  private:
   std::uint64_t size_;
+  std::size_t capacity_;
   std::shared_ptr<MemCache> mem_cache_;
   std::shared_ptr<hal::Buffer> hal_buffer_;
   std::shared_ptr<MemDeps> deps_;
 };
 
-TmpMemChunk::TmpMemChunk(std::uint64_t size, const std::shared_ptr<MemCache>& mem_cache,
+TmpMemChunk::TmpMemChunk(std::uint64_t size, std::size_t capacity, const std::shared_ptr<MemCache>& mem_cache,
                          std::shared_ptr<hal::Buffer> hal_buffer)
-    : size_{size}, mem_cache_{mem_cache}, hal_buffer_{hal_buffer}, deps_{std::make_shared<MemDeps>()} {}
+    : size_{size}, capacity_{capacity}, mem_cache_{mem_cache}, hal_buffer_{hal_buffer}, deps_{std::make_shared<MemDeps>()} {}
 
-TmpMemChunk::~TmpMemChunk() { mem_cache_->Free(size_, std::move(hal_buffer_)); }
+TmpMemChunk::~TmpMemChunk() { mem_cache_->Free(capacity_, std::move(hal_buffer_)); }
 
 std::uint64_t TmpMemChunk::size() const { return size_; }
 
@@ -51,20 +53,26 @@ std::shared_ptr<hal::Buffer> TmpMemChunk::hal_buffer() { return hal_buffer_; }
 
 }  // namespace
 
-TmpMemStrategy::TmpMemStrategy(const std::shared_ptr<DevInfo>& devinfo, hal::Memory* source)
-    : devinfo_{devinfo}, source_{source}, cache_{std::make_shared<MemCache>()} {
+TmpMemStrategy::TmpMemStrategy(const std::shared_ptr<DevInfo>& devinfo, hal::Memory* source,
+                               std::shared_ptr<MemCache> cache)
+    : devinfo_{devinfo}, source_{source}, cache_{std::move(cache)} {
   if (!source_) {
     throw std::logic_error{"The temporary memory management strategy requires memory"};
   }
+  if (!cache_) {
+    cache_ = std::make_shared<MemCache>();
+  }
 }
 
 std::shared_ptr<MemChunk> TmpMemStrategy::MakeChunk(const context::Context& ctx, std::uint64_t size) const {
-  auto hal_buffer = cache_->TryAlloc(size);
+  std::size_t capacity = 0;
+  auto hal_buffer = cache_->TryAlloc(size, &capacity);
   if (!hal_buffer) {
-    auto buffer = source_->MakeBuffer(size, hal::BufferAccessMask::DEVICE_RW);
-    hal_buffer = buffer;
+    // Allocate the whole size class, so that the buffer can be reused by any request in it.
+    capacity = MemCache::SizeClass(size);
+    hal_buffer = source_->MakeBuffer(capacity, hal::BufferAccessMask::DEVICE_RW);
   }
-  return std::make_shared<TmpMemChunk>(size, cache_, std::move(hal_buffer));
+  return std::make_shared<TmpMemChunk>(size, capacity, cache_, std::move(hal_buffer));
 }
 
 }  // namespace local_machine
@@ -2,9 +2,11 @@
 
 #pragma once
 
-#include <map>
+#include <algorithm>
 #include <string>
+#include <utility>
 #include <variant>
+#include <vector>
 
 #include "tile/stripe/stripe.h"
 
@@ -44,8 +46,44 @@ inline std::ostream& operator<<(std::ostream& os, const AttrValue& value) {
   return os;
 }
 
+// A Taggable's attributes, shared between copies of the Taggable until one of them is modified.  Attributes are kept
+// sorted by name; there are rarely more than a handful, so a lookup is a short scan.  Lookups by Symbol compare
+// pointers; lookups by string compare strings, but don't need to take the intern table's lock to intern the name.
 struct Taggable::Impl {
-  std::map<std::string, AttrValue> attrs;
+  std::vector<std::pair<Symbol, AttrValue>> attrs;
+
+  const AttrValue* find(const Symbol& name) const {
+    for (const auto& attr : attrs) {
+      if (attr.first == name) {
+        return &attr.second;
+      }
+    }
+    return nullptr;
+  }
+
+  const AttrValue* find(const std::string& name) const {
+    for (const auto& attr : attrs) {
+      if (attr.first.str() == name) {
+        return &attr.second;
+      }
+    }
+    return nullptr;
+  }
+
+  // Adds an attribute, unless one of the same name is already present.
+  void emplace(const Symbol& name, AttrValue value) {
+    if (find(name)) {
+      return;
+    }
+    auto it = std::upper_bound(attrs.begin(), attrs.end(), name,
+                               [](const Symbol& lhs, const auto& rhs) { return lhs < rhs.first; });
+    attrs.emplace(it, name, std::move(value));
+  }
+
+  void erase(const Symbol& name) {
+    attrs.erase(std::remove_if(attrs.begin(), attrs.end(), [&](const auto& attr) { return attr.first == name; }),
+                attrs.end());
+  }
 };
 
 struct Accessor {
@@ -31,7 +31,7 @@ const char* Intrinsic::ADD = "add";
 const char* Intrinsic::EQ = "cmp_eq";
 const char* Intrinsic::COND = "cond";
 
-const Taggable::Impl* Accessor::impl(const Taggable& taggable) { return taggable.impl_.get(); }
+const Taggable::Impl* Accessor::impl(const Taggable& taggable) { return &taggable.impl(); }
 
 namespace {
 
@@ -240,47 +240,96 @@ class CodecRegistry {
   std::unordered_map<std::string, Codec::Factory> registry_;
 };
 
+// The value that a lookup of a missing attribute yields; std::get on it throws, as for an attribute of the wrong type.
+const AttrValue& MissingAttr(const AttrValue* value) {
+  static const AttrValue missing;
+  return value ? *value : missing;
+}
+
 }  // namespace
 
-Taggable::Taggable() : impl_(new Impl()) {}
+Taggable::Taggable() {}
 
 Taggable::~Taggable() = default;
 
-Taggable::Taggable(const Taggable& rhs) { set_attrs(rhs); }
+Taggable::Taggable(const Taggable& rhs) : impl_(rhs.impl_) {
+  if (impl_) {
+    rhs.owned_.store(false, std::memory_order_relaxed);
+  }
+}
 
 Taggable& Taggable::operator=(const Taggable& rhs) {
   set_attrs(rhs);
   return *this;
 }
 
-void Taggable::set_tag(const std::string& tag) { impl_->attrs.emplace(tag, Void{}); }
+const Taggable::Impl& Taggable::impl() const {
+  static const Impl empty;
+  return impl_ ? *impl_ : empty;
+}
+
+Taggable::Impl* Taggable::mutable_impl() {
+  // Whether the attributes are shared is decided by owned_ rather than by the use count, which other threads may be
+  // changing by copying or releasing other owners of the same attributes.
+  if (!impl_) {
+    impl_ = std::make_shared<Impl>();
+  } else if (!owned_.load(std::memory_order_relaxed)) {
+    impl_ = std::make_shared<Impl>(*impl_);
+  }
+  owned_.store(true, std::memory_order_relaxed);
+  return impl_.get();
+}
+
+void Taggable::set_tag(const std::string& tag) {
+  if (!impl().find(tag)) {
+    mutable_impl()->emplace(Symbol{tag}, Void{});
+  }
+}
+
+void Taggable::set_tag(const Symbol& tag) {
+  if (!impl().find(tag)) {
+    mutable_impl()->emplace(tag, Void{});
+  }
+}
 
 void Taggable::add_tags(const Tags& to_add) {
   for (const auto& tag : to_add) {
-    impl_->attrs.emplace(tag, Void{});
+    set_tag(tag);
   }
 }
 
-void Taggable::clear_tags() { impl_->attrs.clear(); }
+void Taggable::clear_tags() { impl_.reset(); }
 
-void Taggable::remove_tag(const std::string& tag) { impl_->attrs.erase(tag); }
+void Taggable::remove_tag(const std::string& tag) {
+  if (impl().find(tag)) {
+    remove_tag(Symbol{tag});
+  }
+}
+
+void Taggable::remove_tag(const Symbol& tag) {
+  if (impl().find(tag)) {
+    mutable_impl()->erase(tag);
+  }
+}
 
 void Taggable::remove_tags(const Tags& to_remove) {
   for (const auto& tag : to_remove) {
-    impl_->attrs.erase(tag);
+    remove_tag(tag);
   }
 }
 
 void Taggable::set_tags(const Tags& tags) {
-  impl_->attrs.clear();
+  clear_tags();
   add_tags(tags);
 }
 
-bool Taggable::has_tag(const std::string& tag) const { return impl_->attrs.count(tag); }
+bool Taggable::has_tag(const std::string& tag) const { return impl().find(tag) != nullptr; }
+
+bool Taggable::has_tag(const Symbol& tag) const { return impl().find(tag) != nullptr; }
 
 bool Taggable::has_tags(const Tags& to_find) const {
   for (const auto& tag : to_find) {
-    if (impl_->attrs.count(tag) == 0) {
+    if (!has_tag(tag)) {
       return false;
     }
   }
@@ -288,8 +337,11 @@ bool Taggable::has_tags(const Tags& to_find) const {
 }
 
 bool Taggable::has_any_tags(const Tags& to_find) const {
+  if (impl().attrs.empty()) {
+    return false;
+  }
   for (const auto& tag : to_find) {
-    if (impl_->attrs.count(tag) == 1) {
+    if (has_tag(tag)) {
       return true;
     }
   }
@@ -308,46 +360,80 @@ class TagVisitorVisitor {
   void operator()(const google::protobuf::Any& v) const { inner->Visit(name, v); }
 };
 
-bool Taggable::any_tags() const { return !impl_->attrs.empty(); }
+bool Taggable::any_tags() const { return !impl().attrs.empty(); }
 
 void Taggable::visit_tags(TagVisitor* visitor) const {
   TagVisitorVisitor outer;
   outer.inner = visitor;
-  for (const auto& kvp : impl_->attrs) {
-    outer.name = kvp.first;
+  for (const auto& kvp : impl().attrs) {
+    outer.name = kvp.first.str();
     std::visit(outer, kvp.second);
   }
 }
 
-void Taggable::set_attr(const std::string& name) { impl_->attrs.emplace(name, Void{}); }
+void Taggable::set_attr(const std::string& name) { set_tag(name); }
 
-void Taggable::set_attr(const std::string& name, bool value) { impl_->attrs.emplace(name, value); }
+// An attribute that is already present keeps its value, so it is looked up before the attributes are unshared.
+void Taggable::set_attr(const std::string& name, bool value) {
+  if (!impl().find(name)) {
+    mutable_impl()->emplace(Symbol{name}, value);
+  }
+}
 
-void Taggable::set_attr(const std::string& name, int64_t value) { impl_->attrs.emplace(name, value); }
+void Taggable::set_attr(const std::string& name, int64_t value) {
+  if (!impl().find(name)) {
+    mutable_impl()->emplace(Symbol{name}, value);
+  }
+}
+
+void Taggable::set_attr(const std::string& name, double value) {
+  if (!impl().find(name)) {
+    mutable_impl()->emplace(Symbol{name}, value);
+  }
+}
 
-void Taggable::set_attr(const std::string& name, double value) { impl_->attrs.emplace(name, value); }
+void Taggable::set_attr(const std::string& name, const std::string& value) {
+  if (!impl().find(name)) {
+    mutable_impl()->emplace(Symbol{name}, value);
+  }
+}
 
-void Taggable::set_attr(const std::string& name, const std::string& value) { impl_->attrs.emplace(name, value); }
+void Taggable::set_attr(const std::string& name, const Any& value) {
+  if (!impl().find(name)) {
+    mutable_impl()->emplace(Symbol{name}, value);
+  }
+}
 
-void Taggable::set_attr(const std::string& name, const Any& value) { impl_->attrs.emplace(name, value); }
+bool Taggable::has_attr(const std::string& name) const { return impl().find(name) != nullptr; }
 
-bool Taggable::has_attr(const std::string& name) const { return impl_->attrs.count(name); }
+bool Taggable::has_attr(const Symbol& name) const { return impl().find(name) != nullptr; }
 
 void Taggable::set_attrs(const Taggable& rhs) {
-  if (this != &rhs) {
-    impl_.reset(new Impl(*rhs.impl_));
+  if (this == &rhs) {
+    return;
+  }
+  impl_ = rhs.impl_;
+  owned_.store(false, std::memory_order_relaxed);
+  if (impl_) {
+    rhs.owned_.store(false, std::memory_order_relaxed);
   }
 }
 
-bool Taggable::get_attr_bool(const std::string& name) const { return std::get<bool>(impl_->attrs[name]); }
+bool Taggable::get_attr_bool(const std::string& name) const { return std::get<bool>(MissingAttr(impl().find(name))); }
 
-int64_t Taggable::get_attr_int(const std::string& name) const { return std::get<int64_t>(impl_->attrs[name]); }
+int64_t Taggable::get_attr_int(const std::string& name) const {
+  return std::get<int64_t>(MissingAttr(impl().find(name)));
+}
 
-double Taggable::get_attr_float(const std::string& name) const { return std::get<double>(impl_->attrs[name]); }
+double Taggable::get_attr_float(const std::string& name) const {
+  return std::get<double>(MissingAttr(impl().find(name)));
+}
 
-std::string Taggable::get_attr_str(const std::string& name) const { return std::get<std::string>(impl_->attrs[name]); }
+std::string Taggable::get_attr_str(const std::string& name) const {
+  return std::get<std::string>(MissingAttr(impl().find(name)));
+}
 
-Any Taggable::get_attr_any(const std::string& name) const { return std::get<Any>(impl_->attrs[name]); }
+Any Taggable::get_attr_any(const std::string& name) const { return std::get<Any>(MissingAttr(impl().find(name))); }
 
 bool Taggable::get_attr_bool(const std::string& name, bool def) const {
   return has_attr(name) ? get_attr_bool(name) : def;
@@ -818,7 +904,7 @@ Location RealizeLocation(const Location& loc, const Block& block) {
           auto tag = name_coeff.first.substr(1);
           for (const auto& idx : block.idxs) {
             if (idx.has_tag(tag)) {
-              tag_map[name_coeff.first] = idx.name;
+              tag_map[name_coeff.first] = idx.name.str();
               break;
             }
           }
@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <list>
 #include <map>
@@ -12,6 +13,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "base/util/symbol.h"
 #include "tile/base/shape.h"
 #include "tile/math/polynomial.h"
 #include "tile/stripe/stripe.pb.h"
@@ -96,7 +98,7 @@ class Taggable {
   Taggable();
 
  public:
-  // Copy constructor
+  // Copy constructor; the copy shares the attributes until either is modified
   Taggable(const Taggable& rhs);
 
   // Copy assignment
@@ -105,13 +107,16 @@ class Taggable {
   ~Taggable();
 
   void set_tag(const std::string& tag);
+  void set_tag(const Symbol& tag);
   void set_tags(const Tags& tags);
   void add_tags(const Tags& to_add);
   void clear_tags();
   void remove_tag(const std::string& tag);
+  void remove_tag(const Symbol& tag);
   void remove_tags(const Tags& tags);
 
   bool has_tag(const std::string& tag) const;
+  bool has_tag(const Symbol& tag) const;
   bool has_tags(const Tags& to_find) const;
   bool has_any_tags(const Tags& to_find) const;
 
@@ -127,6 +132,7 @@ class Taggable {
   void set_attrs(const Taggable& rhs);
 
   bool has_attr(const std::string& name) const;
+  bool has_attr(const Symbol& name) const;
   bool get_attr_bool(const std::string& name) const;
   int64_t get_attr_int(const std::string& name) const;
   double get_attr_float(const std::string& name) const;
@@ -140,7 +146,15 @@ class Taggable {
 
  private:
   struct Impl;
-  std::unique_ptr<Impl> impl_;
+
+  const Impl& impl() const;
+  // Returns the attributes for modification, first unsharing them from any copies.
+  Impl* mutable_impl();
+
+  std::shared_ptr<Impl> impl_;  // Shared by copies until modified; null if there are no attributes
+  // Whether impl_ was created or copied by this object and never handed to a copy, so it may be modified in place.
+  // Copying clears it on both sides; it is atomic because concurrent copies of one object are allowed.
+  mutable std::atomic<bool> owned_{false};
 };
 
 class Codec {
@@ -182,7 +196,7 @@ struct Index : Taggable {
       : name(name),  //
         range(range),
         affine(affine) {}
-  std::string name;
+  InternedString name;
   uint64_t range;
   Affine affine;
 };
@@ -253,20 +267,21 @@ struct Refinement : Taggable {
 
   Refinement WithInto(const std::string& into) const {
     Refinement result = *this;
-    result.into_ = into;
+    result.into_ = Symbol{into};
     return result;
   }
 
   static Refinement FromInto(const std::string& into) {
     Refinement result;
-    result.into_ = into;
+    result.into_ = Symbol{into};
     return result;
   }
 
-  const std::string& into() const { return into_; }
+  const std::string& into() const { return into_.str(); }
+  const Symbol& into_symbol() const { return into_; }
 
   RefDir dir = RefDir::None;
-  std::string from;
+  InternedString from;
   std::vector<Affine> access;
   TensorShape interior_shape;
   std::string agg_op;
@@ -286,7 +301,7 @@ struct Refinement : Taggable {
   Refinement& mut() const { return const_cast<Refinement&>(*this); }
 
  private:
-  std::string into_;
+  Symbol into_;  // Interned, so that copying a refinement doesn't copy its name
 };
 
 }  // namespace stripe
@@ -303,7 +318,15 @@ struct less<::vertexai::tile::stripe::Refinement> {
   using is_transparent = void;  // Allows string comparators
   const bool operator()(const ::vertexai::tile::stripe::Refinement& lhs,
                         const ::vertexai::tile::stripe::Refinement& rhs) const {
-    return std::less<std::string>{}(lhs.into(), rhs.into());
+    return lhs.into_symbol() < rhs.into_symbol();
+  }
+  const bool operator()(const ::vertexai::tile::stripe::Refinement& lhs,
+                        const ::vertexai::Symbol& rhs) const {
+    return lhs.into_symbol() < rhs;
+  }
+  const bool operator()(const ::vertexai::Symbol& lhs,
+                        const ::vertexai::tile::stripe::Refinement& rhs) const {
+    return lhs < rhs.into_symbol();
   }
   const bool operator()(const ::vertexai::tile::stripe::Refinement& lhs, const std::string& rhs) const {
     return std::less<std::string>{}(lhs.into(), rhs);
@@ -335,8 +358,8 @@ struct Load : Statement {
   void Accept(MutableStmtVisitor* v) { v->Visit(this); }
   Load* Accept(RewriteStmtVisitor* v) { return v->Visit(*this); }
 
-  std::string from;
-  std::string into;
+  InternedString from;
+  InternedString into;
 };
 
 struct Store : Statement {
@@ -349,8 +372,8 @@ struct Store : Statement {
   void Accept(MutableStmtVisitor* v) { v->Visit(this); }
   Store* Accept(RewriteStmtVisitor* v) { return v->Visit(*this); }
 
-  std::string from;
-  std::string into;
+  InternedString from;
+  InternedString into;
 };
 
 struct LoadIndex : Statement {
@@ -363,22 +386,22 @@ struct LoadIndex : Statement {
   LoadIndex* Accept(RewriteStmtVisitor* v) { return v->Visit(*this); }
 
   Affine from;
-  std::string into;
+  InternedString into;
 };
 
 struct Intrinsic : Statement {
   static std::shared_ptr<Intrinsic> Downcast(const std::shared_ptr<Statement>& stmt);
   StmtKind kind() const { return StmtKind::Intrinsic; }
-  std::vector<std::string> scalar_uses() const { return inputs; }
-  std::vector<std::string> scalar_defs() const { return outputs; }
+  std::vector<std::string> scalar_uses() const { return {inputs.begin(), inputs.end()}; }
+  std::vector<std::string> scalar_defs() const { return {outputs.begin(), outputs.end()}; }
   void Accept(ConstStmtVisitor* v) const { v->Visit(*this); }
   void Accept(MutableStmtVisitor* v) { v->Visit(this); }
   Intrinsic* Accept(RewriteStmtVisitor* v) { return v->Visit(*this); }
 
-  std::string name;
+  InternedString name;
   DataType type = DataType::FLOAT32;
-  std::vector<std::string> inputs;
-  std::vector<std::string> outputs;
+  std::vector<InternedString> inputs;
+  std::vector<InternedString> outputs;
 
   static const char* ASSIGN;
   static const char* SUM;
@@ -395,15 +418,15 @@ struct Intrinsic : Statement {
 struct Special : Statement {
   static std::shared_ptr<Special> Downcast(const std::shared_ptr<Statement>& stmt);
   StmtKind kind() const { return StmtKind::Special; }
-  std::vector<std::string> buffer_reads() const { return inputs; }
-  std::vector<std::string> buffer_writes() const { return outputs; }
+  std::vector<std::string> buffer_reads() const { return {inputs.begin(), inputs.end()}; }
+  std::vector<std::string> buffer_writes() const { return {outputs.begin(), outputs.end()}; }
   void Accept(ConstStmtVisitor* v) const { v->Visit(*this); }
   void Accept(MutableStmtVisitor* v) { v->Visit(this); }
   Special* Accept(RewriteStmtVisitor* v) { return v->Visit(*this); }
 
-  std::string name;
-  std::vector<std::string> inputs;
-  std::vector<std::string> outputs;
+  InternedString name;
+  std::vector<InternedString> inputs;
+  std::vector<InternedString> outputs;
   std::map<std::string, int64_t> int_params;
   std::map<std::string, std::string> str_params;
 };
@@ -423,7 +446,7 @@ struct Constant : Statement {
   void Accept(MutableStmtVisitor* v) { v->Visit(this); }
   Constant* Accept(RewriteStmtVisitor* v) { return v->Visit(*this); }
 
-  std::string name;
+  InternedString name;
   ConstType type;
   int64_t iconst;
   double fconst;
@@ -580,6 +603,7 @@ proto::Block IntoProto(const Block& block);
 proto::Program IntoProto(const Program& program);
 
 std::shared_ptr<Block> CloneBlock(const Block& orig, int depth = -1);
+
 const Block* FindBlockByTag(const Block& block, const std::string& tag);
 void FindBlocksByTag(std::vector<const Block*>* into, const Block& block, const std::string& tag);
 const Index* FindIndexByTag(const Block& block, const std::string& tag);
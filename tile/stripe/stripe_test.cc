@@ -3,6 +3,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <thread>
+
 #include "tile/stripe/stripe.h"
 
 using ::testing::Combine;
@@ -93,6 +95,133 @@ TEST_P(StripeLocThrowTest, ParserThrows) {
 INSTANTIATE_TEST_CASE_P(InvalidPatterns, StripeLocThrowTest,
                         Values("foo[1, *  ]qux/bar", "foo[1, florp ]/bar", "foo[1, 2* ]/bar"));
 
+TEST(StripeSymbolTest, InternsBySpelling) {
+  Symbol a{"alpha"};
+  EXPECT_THAT(a, Eq(Symbol{std::string("alpha")}));
+  EXPECT_THAT(&a.str(), Eq(&Symbol{"alpha"}.str()));
+  EXPECT_THAT(a, Ne(Symbol{"beta"}));
+  EXPECT_TRUE(a < Symbol{"beta"});
+  EXPECT_FALSE(Symbol{"beta"} < a);
+  EXPECT_FALSE(a < a);
+  EXPECT_TRUE(Symbol{}.empty());
+  EXPECT_THAT(Symbol{}, Eq(Symbol{""}));
+}
+
+TEST(StripeSymbolTest, RefinementNamesAreInterned) {
+  Block block;
+  block.refs.emplace(Refinement::FromInto("zeta"));
+  block.refs.emplace(Refinement::FromInto("alpha"));
+  auto copy = block;
+  EXPECT_THAT(&copy.ref_by_into("alpha")->into(), Eq(&block.ref_by_into("alpha")->into()));
+  EXPECT_THAT(block.ref_by_into("zeta")->WithInto("alpha").into_symbol(), Eq(Symbol{"alpha"}));
+
+  // Refinements still iterate in name order
+  EXPECT_THAT(block.refs.begin()->into(), Eq("alpha"));
+  EXPECT_THAT(block.refs.count(Symbol{"zeta"}), Eq(1));
+}
+
+TEST(StripeSymbolTest, IndexAndSourceNamesAreInterned) {
+  Block block;
+  block.idxs.emplace_back("i", 4);
+  block.refs.emplace(RefDir::In, "A", "a", std::vector<Affine>{}, TensorShape{});
+  auto copy = block;
+  EXPECT_THAT(&copy.idxs[0].name.str(), Eq(&block.idxs[0].name.str()));
+  EXPECT_THAT(&copy.ref_by_into("a")->from.str(), Eq(&block.ref_by_into("a")->from.str()));
+
+  // They still read and write as strings
+  const std::string& name = block.idxs[0].name;
+  EXPECT_THAT(name, Eq("i"));
+  EXPECT_THAT(block.idxs[0].name + "_outer", Eq("i_outer"));
+  EXPECT_TRUE(block.idx_by_name("i"));
+  block.ref_by_into("a")->mut().from = std::string("B");
+  EXPECT_THAT(block.ref_by_into("a")->from, Eq("B"));
+  EXPECT_THAT(copy.ref_by_into("a")->from, Eq("A"));
+  block.ref_by_into("a")->mut().from.clear();
+  EXPECT_TRUE(block.ref_by_into("a")->from.empty());
+}
+
+TEST(StripeSymbolTest, StatementNamesAreInterned) {
+  Load load{"A", "$a"};
+  Load copy = load;
+  EXPECT_THAT(&copy.from.str(), Eq(&load.from.str()));
+  EXPECT_THAT(&copy.into.str(), Eq(&load.into.str()));
+
+  Intrinsic intrinsic;
+  intrinsic.name = Intrinsic::MUL;
+  intrinsic.inputs = {"$a", "$b"};
+  intrinsic.outputs = {"$c"};
+  EXPECT_THAT(&intrinsic.inputs[0].str(), Eq(&load.into.str()));
+  EXPECT_THAT(intrinsic.name, Eq("mul"));
+  EXPECT_THAT(intrinsic.scalar_uses(), Eq(std::vector<std::string>{"$a", "$b"}));
+  EXPECT_THAT(intrinsic.scalar_defs(), Eq(std::vector<std::string>{"$c"}));
+}
+
+TEST(StripeTaggableTest, CopiesShareAttributesUntilModified) {
+  Index orig{"i", 4};
+  orig.set_tag("b");
+  orig.set_attr("a", int64_t{3});
+  Index copy = orig;
+  copy.set_tag("c");
+  copy.remove_tag("b");
+  EXPECT_TRUE(orig.has_tag("b"));
+  EXPECT_FALSE(orig.has_tag("c"));
+  EXPECT_FALSE(copy.has_tag("b"));
+  EXPECT_TRUE(copy.has_tag(Symbol{"c"}));
+  EXPECT_THAT(copy.get_attr_int("a"), Eq(3));
+  copy.set_attr("a", int64_t{4});
+  EXPECT_THAT(copy.get_attr_int("a"), Eq(3));
+
+  // Attributes are visited in name order, however they were added
+  struct Names : TagVisitor {
+    void Visit(const std::string& name) final { names.push_back(name); }
+    void Visit(const std::string& name, bool value) final { names.push_back(name); }
+    void Visit(const std::string& name, int64_t value) final { names.push_back(name); }
+    void Visit(const std::string& name, double value) final { names.push_back(name); }
+    void Visit(const std::string& name, const std::string& value) final { names.push_back(name); }
+    void Visit(const std::string& name, const google::protobuf::Any& value) final { names.push_back(name); }
+    std::vector<std::string> names;
+  } visitor;
+  orig.visit_tags(&visitor);
+  EXPECT_THAT(visitor.names, Eq(std::vector<std::string>{"a", "b"}));
+
+  orig.clear_tags();
+  EXPECT_FALSE(orig.any_tags());
+  EXPECT_TRUE(copy.any_tags());
+  EXPECT_THROW(orig.get_attr_int("a"), std::bad_variant_access);
+}
+
+TEST(StripeTaggableTest, SharedSubtreesModifyIndependently) {
+  Block outer;
+  for (size_t i = 0; i < 2; ++i) {
+    auto inner = std::make_shared<Block>();
+    inner->set_tag("kernel");
+    inner->idxs.emplace_back("i", 4);
+    inner->idxs.back().set_attr("stride", int64_t{1});
+    outer.stmts.push_back(inner);
+  }
+  auto clone = CloneBlock(outer);
+
+  std::vector<std::thread> threads;
+  for (const auto& stmt : clone->stmts) {
+    auto inner = Block::Downcast(stmt);
+    threads.emplace_back([inner] {
+      inner->set_tag("modified");
+      inner->idxs.front().set_attr("stride", int64_t{2});
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& stmt : outer.stmts) {
+    auto inner = Block::Downcast(stmt);
+    EXPECT_FALSE(inner->has_tag("modified"));
+    EXPECT_THAT(inner->idxs.front().get_attr_int("stride"), Eq(1));
+  }
+  for (const auto& stmt : clone->stmts) {
+    EXPECT_TRUE(stmt->has_tag("modified"));
+  }
+}
+
 }  // namespace
 }  // namespace stripe
 }  // namespace tile
@@ -5,10 +5,12 @@
 #include <llvm/Bitcode/BitcodeWriter.h>
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
 #include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Intrinsics.h>
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Verifier.h>
 #include <llvm/Support/DynamicLibrary.h>
+#include <llvm/Support/Host.h>
 #include <llvm/Support/TargetRegistry.h>
 #include <llvm/Support/ToolOutputFile.h>
 #include <llvm/Transforms/IPO/PassManagerBuilder.h>
@@ -16,7 +18,11 @@
 
 #include <algorithm>
 #include <deque>
+#include <functional>
+#include <map>
 #include <memory>
+#include <set>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -26,6 +32,7 @@
 #include "tile/stripe/stripe.h"
 #include "tile/targets/cpu/executable.h"
 #include "tile/targets/cpu/link_names.h"
+#include "tile/targets/cpu/vmath.h"
 
 namespace vertexai {
 namespace tile {
@@ -39,6 +46,76 @@ class Error : public std::runtime_error {
   using std::runtime_error::runtime_error;
 };
 
+namespace {
+
+// bfloat16 has no LLVM type: it is stored as i16 and computed on as float32.
+DataType ComputeType(DataType type) { return type == DataType::BFLOAT16 ? DataType::FLOAT32 : type; }
+
+// Returns elem_type, or a vector of it with as many lanes as shape has.
+llvm::Type* SameShape(llvm::Type* shape, llvm::Type* elem_type) {
+  if (auto vec_type = llvm::dyn_cast<llvm::VectorType>(shape)) {
+    return llvm::VectorType::get(elem_type, vec_type->getNumElements());
+  }
+  return elem_type;
+}
+
+// The width in bytes of the widest vector registers the host CPU supports.
+size_t HostVectorBytes() {
+  static size_t bytes = []() -> size_t {
+    llvm::StringMap<bool> features;
+    if (!llvm::sys::getHostCPUFeatures(features)) {
+      return 16;
+    }
+    if (features.lookup("avx512f")) {
+      return 64;
+    }
+    if (features.lookup("avx")) {
+      return 32;
+    }
+    return 16;
+  }();
+  return bytes;
+}
+
+// Estimates the number of statements executed by a single iteration of a block.
+uint64_t EstimateIterationWork(const stripe::Block& block) {
+  uint64_t work = 0;
+  for (const auto& stmt : block.stmts) {
+    if (auto inner = stripe::Block::Downcast(stmt)) {
+      work += inner->idxs_product() * EstimateIterationWork(*inner);
+    } else {
+      work += 1;
+    }
+  }
+  return std::max<uint64_t>(work, 1);
+}
+
+// Constraints anywhere under a block make the cost of its iterations uneven.
+bool HasUnevenIterations(const stripe::Block& block) {
+  if (!block.constraints.empty()) {
+    return true;
+  }
+  for (const auto& stmt : block.stmts) {
+    if (auto inner = stripe::Block::Downcast(stmt)) {
+      if (HasUnevenIterations(*inner)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// Arena slots are aligned to a cache line, so that no two temporaries share one.
+constexpr uint64_t kArenaAlignment = 64;
+
+uint64_t AlignArena(uint64_t offset) { return (offset + kArenaAlignment - 1) / kArenaAlignment * kArenaAlignment; }
+
+// Local buffers up to this size which the arena planner could not place (because every thread of an enclosing
+// parallel block needs its own) live on the stack instead of the heap.  Kernel scratch copies are bounded by it too.
+constexpr uint64_t kMaxStackBuffer = 16 * 1024;
+
+}  // namespace
+
 Compiler::Compiler(llvm::LLVMContext* context, const Config& config)
     : context_(*context), builder_{context_}, config_{config}, arenaSize_(0) {
   static std::once_flag init_once;
@@ -64,7 +141,9 @@ ProgramModule Compiler::CompileProgram(const stripe::Block& program) {
   module_->setDataLayout(machine->createDataLayout());
   module_->setTargetTriple(targetTriple);
 
-  GenerateArena(program);
+  PlanArena(program);
+  xsmm_kernels_ = std::make_shared<std::vector<XSMMKernel>>();
+  parallel_blocks_ = std::make_shared<uint64_t>(0);
   llvm::Function* main = CompileBlock(program);
   ret.externals = external_funcptrs_;
   // Generate a stub function we can invoke from the outside, passing buffers
@@ -103,6 +182,9 @@ ProgramModule Compiler::CompileProgram(const stripe::Block& program) {
       ret.parameters.push_back(ref.into());
     }
   }
+  ret.arena_size = arenaSize_;
+  ret.xsmm_kernels = *xsmm_kernels_;
+  ret.parallel_blocks = *parallel_blocks_;
   module_ = nullptr;
   assert(ret.module);
   return ret;
@@ -141,15 +223,16 @@ void Compiler::GenerateInvoker(const stripe::Block& program, llvm::Function* mai
   // argument value in order, then load the value.
   std::vector<llvm::Value*> args;
   std::vector<llvm::Value*> allocs;
+  llvm::Value* pool = nullptr;
   {
     if (arenaSize_) {
       IVLOG(1, "Arena size: " << arenaSize_);
-      // allocate the arena on the heap. This way static initialization order is never an issue.
-      auto buffer = Malloc(arenaSize_);
-      auto arena_gval = module_->getNamedGlobal(arena_name_);
-      auto arenatype = llvm::ArrayType::get(builder_.getInt8Ty(), 1)->getPointerTo();
-      builder_.CreateStore(builder_.CreateBitCast(buffer, arenatype), arena_gval);
-      allocs.push_back(buffer);
+      // Take an arena from the executable's pool for the duration of this invocation, so that concurrent invocations
+      // never share one and repeated invocations never return to the system allocator.
+      pool = builder_.CreateLoad(module_->getNamedGlobal(arena_pool_name_));
+      arena_ = builder_.CreateCall(ArenaAcquireFunction(), {pool, IndexConst(arenaSize_)}, "arena");
+    } else {
+      arena_ = llvm::ConstantPointerNull::get(builder_.getInt8PtrTy());
     }
     unsigned i = 0;
     for (auto& ref : program.refs) {
@@ -162,9 +245,15 @@ void Compiler::GenerateInvoker(const stripe::Block& program, llvm::Function* mai
         llvm::Type* eltype = CType(ref.interior_shape.type)->getPointerTo();
         args.push_back(builder_.CreateBitCast(elval, eltype));
       } else if (ref.has_tag("tmp")) {
-        // Allocate a temporary buffer for this refinement
-        auto buffer = Malloc(ref.interior_shape.byte_size());
-        allocs.push_back(buffer);
+        // Temporary buffers live in the arena; they are only allocated separately when the planner has not seen them.
+        llvm::Value* buffer = nullptr;
+        auto it = arena_offsets_->find(&ref);
+        if (it != arena_offsets_->end()) {
+          buffer = ArenaBuffer(it->second);
+        } else {
+          buffer = Malloc(ref.interior_shape.byte_size());
+          allocs.push_back(buffer);
+        }
         llvm::Type* buftype = CType(ref.interior_shape.type)->getPointerTo();
         args.push_back(builder_.CreateBitCast(buffer, buftype));
       } else {
@@ -178,6 +267,8 @@ void Compiler::GenerateInvoker(const stripe::Block& program, llvm::Function* mai
   for (unsigned i = 0; i < program.idxs.size(); ++i) {
     args.push_back(IndexConst(0));
   }
+  // The arena base address is the final parameter of every directly-invoked block function.
+  args.push_back(arena_);
   // Having built the argument list, we'll call the actual kernel using the
   // parameter signature it expects.
   builder_.CreateCall(main, args, "");
@@ -185,6 +276,9 @@ void Compiler::GenerateInvoker(const stripe::Block& program, llvm::Function* mai
   for (auto ptr : allocs) {
     Free(ptr);
   }
+  if (pool) {
+    builder_.CreateCall(ArenaReleaseFunction(), {pool, arena_}, "");
+  }
   builder_.CreateRetVoid();
 }
 
@@ -211,12 +305,89 @@ uint64_t Compiler::MeasureArena(const stripe::Block& block) {
   return extent;
 }
 
-void Compiler::GenerateArena(const stripe::Block& block) {
-  arenaSize_ = MeasureArena(block);
-  auto arenatype = llvm::ArrayType::get(builder_.getInt8Ty(), 1)->getPointerTo();
-  module_->getOrInsertGlobal(arena_name_, arenatype);
-  auto gval = module_->getNamedGlobal(arena_name_);
-  gval->setInitializer(llvm::Constant::getNullValue(arenatype));
+void Compiler::PlanArena(const stripe::Block& program) {
+  // Refinements which have been placed keep the offsets the placer assigned them at the start of the arena.  Every
+  // other temporary which is allocated at most once at a time is packed after them, sharing space with any temporary
+  // whose lifetime does not overlap its own.
+  std::vector<ArenaAllocation> allocs;
+  for (const auto& ref : program.refs) {
+    if (ref.has_tag("tmp")) {
+      allocs.push_back(ArenaAllocation{&ref, ref.interior_shape.byte_size(), 0, UINT64_MAX});
+    }
+  }
+  uint64_t clock = 0;
+  CollectArenaAllocations(program, false, &clock, &allocs);
+
+  // Place the largest allocations first, each at the lowest offset which does not collide with an already-placed
+  // allocation of overlapping lifetime.
+  std::stable_sort(allocs.begin(), allocs.end(),
+                   [](const ArenaAllocation& a, const ArenaAllocation& b) { return a.size > b.size; });
+  arenaSize_ = MeasureArena(program);
+  uint64_t base = AlignArena(arenaSize_);
+  auto offsets = std::make_shared<std::map<const stripe::Refinement*, uint64_t>>();
+  for (size_t i = 0; i < allocs.size(); ++i) {
+    auto& alloc = allocs[i];
+    std::vector<std::pair<uint64_t, uint64_t>> busy;
+    for (size_t j = 0; j < i; ++j) {
+      const auto& other = allocs[j];
+      if (alloc.first <= other.last && other.first <= alloc.last) {
+        busy.emplace_back(other.offset, other.offset + other.size);
+      }
+    }
+    std::sort(busy.begin(), busy.end());
+    alloc.offset = base;
+    for (const auto& range : busy) {
+      if (alloc.offset + alloc.size <= range.first) {
+        break;
+      }
+      alloc.offset = std::max(alloc.offset, AlignArena(range.second));
+    }
+    arenaSize_ = std::max(arenaSize_, alloc.offset + alloc.size);
+    offsets->emplace(alloc.ref, alloc.offset);
+  }
+  arena_offsets_ = offsets;
+
+  // Each executable owns a pool of arenas, whose address it stores here once the module has been loaded.
+  auto pooltype = builder_.getInt8PtrTy();
+  module_->getOrInsertGlobal(arena_pool_name_, pooltype);
+  auto gval = module_->getNamedGlobal(arena_pool_name_);
+  gval->setInitializer(llvm::Constant::getNullValue(pooltype));
+}
+
+void Compiler::CollectArenaAllocations(const stripe::Block& block, bool parallel, uint64_t* clock,
+                                       std::vector<ArenaAllocation>* allocs) {
+  // Each nested block is assigned the span of clock ticks covering its own visit and those of its descendants; its
+  // local refinements live for exactly that span.
+  for (const auto& stmt : block.stmts) {
+    auto inner = stripe::Block::Downcast(stmt);
+    if (!inner) {
+      continue;
+    }
+    auto first = (*clock)++;
+    CollectArenaAllocations(*inner, parallel || getCompileFor(*inner) == THREADED_BLOCK, clock, allocs);
+    auto last = (*clock)++;
+    if (parallel) {
+      // Every concurrent iteration of an enclosing threaded block needs its own copy.
+      continue;
+    }
+    for (const auto& ref : inner->refs) {
+      if (ref.dir == stripe::RefDir::None && ref.from.empty() && !ref.has_tag("placed")) {
+        allocs->push_back(ArenaAllocation{&ref, ref.interior_shape.byte_size(), first, last});
+      }
+    }
+  }
+}
+
+llvm::Value* Compiler::ArenaBuffer(uint64_t offset) { return builder_.CreateGEP(arena_, IndexConst(offset)); }
+
+llvm::Value* Compiler::StackBuffer(uint64_t size) {
+  // The slot is allocated in the entry block, so that every iteration of the enclosing loops reuses it rather than
+  // growing the stack, and LLVM is free to promote it to registers.
+  auto function = builder_.GetInsertBlock()->getParent();
+  llvm::IRBuilder<> entry(&function->getEntryBlock(), function->getEntryBlock().begin());
+  auto slot = entry.CreateAlloca(llvm::ArrayType::get(builder_.getInt8Ty(), size), nullptr, "stack_buffer");
+  slot->setAlignment(llvm::MaybeAlign(kArenaAlignment));
+  return builder_.CreateBitCast(slot, builder_.getInt8PtrTy());
 }
 
 llvm::Function* Compiler::CompileXSMMBlock(const stripe::Block& block, const XSMMDispatch xsmmDispatch,
@@ -257,90 +428,18 @@ llvm::Function* Compiler::CompileXSMMBlock(const stripe::Block& block, const XSM
       ai->setName(param_name);
       assert(nullptr == buffers_[param_name].base);
       buffers_[param_name].base = &(*ai);
-    } else {
+    } else if (idx < block.refs.size() + block.idxs.size()) {
       idx -= block.refs.size();
       std::string param_name = block.idxs[idx].name;
       ai->setName(param_name);
       assert(nullptr == indexes_[param_name].init);
       indexes_[param_name].init = &(*ai);
+    } else {
+      ai->setName("arena");
+      arena_ = &(*ai);
     }
   }
   auto i32t = builder_.getInt32Ty();
-  llvm::Value* lda = builder_.CreateAlloca(i32t);
-  llvm::Value* ldb = builder_.CreateAlloca(i32t);
-  llvm::Value* ldc = builder_.CreateAlloca(i32t);
-
-  llvm::Value* alpha = nullptr;
-  llvm::Value* beta = nullptr;
-  llvm::Value* one = nullptr;
-  llvm::Type* alphaPtrType = nullptr;
-  llvm::Type* betaPtrType = nullptr;
-  llvm::Type* aPtrType = nullptr;
-  llvm::Type* bPtrType = nullptr;
-  llvm::Type* cPtrType = nullptr;
-  std::string functionName("Invalid");
-  switch (xsmmDispatch) {
-    case XSMMDispatch::SMM:
-      one = llvm::ConstantFP::get(builder_.getFloatTy(), 1.0);
-      alpha = builder_.CreateAlloca(builder_.getFloatTy());
-      beta = builder_.CreateAlloca(builder_.getFloatTy());
-      alphaPtrType = betaPtrType = aPtrType = bPtrType = cPtrType = llvm::Type::getFloatPtrTy(context_);
-      functionName = "libxsmm_smmdispatch";
-      break;
-
-    case XSMMDispatch::DMM:
-      one = llvm::ConstantFP::get(builder_.getDoubleTy(), 1.0L);
-      alpha = builder_.CreateAlloca(builder_.getDoubleTy());
-      beta = builder_.CreateAlloca(builder_.getDoubleTy());
-      alphaPtrType = betaPtrType = aPtrType = bPtrType = cPtrType = llvm::Type::getDoublePtrTy(context_);
-      functionName = "libxsmm_dmmdispatch";
-      break;
-
-    case XSMMDispatch::WIMM:
-      one = llvm::ConstantInt::get(builder_.getInt8Ty(), 1);
-      alpha = builder_.CreateAlloca(builder_.getInt8Ty());
-      beta = builder_.CreateAlloca(builder_.getInt8Ty());
-      alphaPtrType = betaPtrType = aPtrType = bPtrType = llvm::Type::getInt8PtrTy(context_);
-      cPtrType = llvm::Type::getInt32PtrTy(context_);
-      functionName = "libxsmm_wimmdispatch";
-      break;
-
-      // TODO: Handle the bfloat16 dispatch function when support for bfloat16 is added to Stripe.
-
-    default:
-      throw std::runtime_error("Unsupported DataType for XSMM.");
-  }
-
-  builder_.CreateStore(one, alpha);
-  builder_.CreateStore(one, beta);
-
-  builder_.CreateStore(llvm::ConstantInt::get(i32t, xsmmCallData.lda_a_value), lda);
-  builder_.CreateStore(llvm::ConstantInt::get(i32t, xsmmCallData.lda_b_value), ldb);
-  builder_.CreateStore(llvm::ConstantInt::get(i32t, xsmmCallData.lda_c_value), ldc);
-  llvm::Value* nptr = llvm::ConstantPointerNull::get(llvm::Type::getInt32PtrTy(context_));
-  llvm::Value* dispatch = XSMMDispatchFunction(alphaPtrType, betaPtrType, aPtrType, bPtrType, cPtrType, functionName);
-
-  std::vector<llvm::Value*> args1 = {llvm::ConstantInt::get(i32t, FindIndexByTag(block, "stencil_m")->range),
-                                     llvm::ConstantInt::get(i32t, FindIndexByTag(block, "stencil_n")->range),
-                                     llvm::ConstantInt::get(i32t, FindIndexByTag(block, "stencil_k")->range),
-                                     lda,
-                                     ldb,
-                                     ldc,
-                                     alpha,
-                                     beta,
-                                     nptr,
-                                     nptr};
-  llvm::Value* func = builder_.CreateCall(dispatch, args1);
-
-  std::vector<llvm::Type*> param_types{
-      func->getType(),                                     // ptr of function to call
-      buffers_[xsmmCallData.in1->into()].base->getType(),  // a
-      buffers_[xsmmCallData.in0->into()].base->getType(),  // b
-      buffers_[xsmmCallData.out0->into()].base->getType()  // c
-  };
-  llvm::FunctionType* rftype = llvm::FunctionType::get(builder_.getVoidTy(), param_types, false);
-  llvm::FunctionType* xsmmCallHelperType = llvm::FunctionType::get(builder_.getVoidTy(), param_types, false);
-  auto xmmCallFunc = module_->getOrInsertFunction("XSMMRTCaller", xsmmCallHelperType).getCallee();
 
 #define CREATE_OFFSET_STMTS(name)                                                          \
   llvm::Value* arg_##name;                                                                 \
@@ -354,12 +453,243 @@ llvm::Function* Compiler::CompileXSMMBlock(const stripe::Block& block, const XSM
   CREATE_OFFSET_STMTS(in1);
   CREATE_OFFSET_STMTS(out0);
 
-  std::vector<llvm::Value*> args2 = {func, arg_in1, arg_in0, arg_out0};
-  builder_.CreateCall(rftype, xmmCallFunc, args2);
+  std::vector<llvm::Type*> param_types{
+      arg_in1->getType(),  // a
+      arg_in0->getType(),  // b
+      arg_out0->getType()  // c
+  };
+  llvm::FunctionType* rftype = llvm::FunctionType::get(builder_.getVoidTy(), param_types, false);
+  auto xsmmKernel = GetXSMMKernel(block, xsmmDispatch, xsmmCallData);
+  llvm::Value* packed_heap = nullptr;
+  if (xsmmDispatch == XSMMDispatch::BSMM || xsmmDispatch == XSMMDispatch::BMMM) {
+    arg_in1 = PackVNNI(arg_in1, xsmmKernel, xsmmCallData.lda_a_value, &packed_heap);
+  }
+  auto kernel = XSMMKernelFunction(xsmmKernel, rftype);
+  std::vector<llvm::Value*> args = {arg_in1, arg_in0, arg_out0};
+  builder_.CreateCall(rftype, kernel, args);
+  if (packed_heap) {
+    Free(packed_heap);
+  }
   builder_.CreateRetVoid();
   return function;
 }
 
+bool Compiler::XSMMNest(const stripe::Block& block, std::set<std::string>* batch_idxs) {
+  // A block whose only statement is an XSMM block calls the kernel directly from its own loops.  Every iteration
+  // accumulates into the output, so the iterations which share an output tile may be folded into a single
+  // batch-reduce call.
+  if (block.stmts.size() != 1 || !block.constraints.empty() || block.idxs_product() < 2) {
+    return false;
+  }
+  auto inner = stripe::Block::Downcast(block.stmts.front());
+  if (!inner || getCompileFor(*inner) != XSMM_BLOCK || !inner->constraints.empty()) {
+    return false;
+  }
+  auto xsmmDispatch = GetXSMMDispatch(*inner);
+  XSMMCallData xsmmCallData;
+  if (xsmmDispatch == XSMMDispatch::NONE || !GetXSMMCallData(&xsmmCallData, *inner)) {
+    return false;
+  }
+  for (const auto& ref : inner->refs) {
+    if (ref.dir == stripe::RefDir::None && ref.from.empty()) {
+      return false;
+    }
+  }
+  // libxsmm only provides batch-reduce kernels for single precision.
+  if (xsmmDispatch == XSMMDispatch::SMM) {
+    const auto* out = xsmmCallData.out0;
+    auto access = block.ref_by_into(out->from.empty() ? out->into() : out->from.str())->FlatAccess();
+    for (const auto& idx : block.idxs) {
+      if (1 < idx.range && access.get(idx.name) == 0) {
+        batch_idxs->insert(idx.name);
+      }
+    }
+  }
+  auto kernel = GetXSMMKernel(*inner, xsmmDispatch, xsmmCallData);
+  kernel.prefetch = batch_idxs->empty();
+  kernel.batch_reduce = !batch_idxs->empty();
+  if (!DispatchXSMMKernel(kernel)) {
+    batch_idxs->clear();
+    return false;
+  }
+  return true;
+}
+
+void Compiler::CompileXSMMNest(const stripe::Block& block, const std::set<std::string>& batch_idxs) {
+  // Emits the body of an XSMM nest (see XSMMNest), within the loops over every index not in batch_idxs.
+  const auto& inner = *stripe::Block::Downcast(block.stmts.front());
+  auto xsmmDispatch = GetXSMMDispatch(inner);
+  XSMMCallData xsmmCallData;
+  GetXSMMCallData(&xsmmCallData, inner);
+  auto kernel = GetXSMMKernel(inner, xsmmDispatch, xsmmCallData);
+  // The operands of the inner block's kernel call for the current iteration, as CompileXSMMBlock computes them.
+  auto source = [&](const stripe::Refinement* ref) -> const Buffer& {
+    return buffers_[ref->from.empty() ? ref->into() : ref->from.str()];
+  };
+  auto operand = [&](const stripe::Refinement* ref, int32_t offset) {
+    return builder_.CreateGEP(ElementPtr(source(ref)), IndexConst(offset));
+  };
+
+  if (batch_idxs.empty()) {
+    // Each call prefetches the operands of the next iteration of the innermost loop; past the end of the loop, the
+    // addresses are only ever prefetched, never accessed.
+    std::string next;
+    for (const auto& idx : block.idxs) {
+      if (1 < idx.range) {
+        next = idx.name;
+      }
+    }
+    std::vector<std::pair<const stripe::Refinement*, int32_t>> operands{
+        {xsmmCallData.in1, xsmmCallData.offset_in1},  // a
+        {xsmmCallData.in0, xsmmCallData.offset_in0},  // b
+        {xsmmCallData.out0, xsmmCallData.offset_out0}  // c
+    };
+    std::vector<llvm::Value*> args;
+    for (const auto& op : operands) {
+      args.push_back(operand(op.first, op.second));
+    }
+    kernel.prefetch = true;
+    for (size_t i = 0; i < operands.size(); ++i) {
+      auto stride = source(operands[i].first).refinement->FlatAccess().get(next);
+      args.push_back(builder_.CreateGEP(args[i], IndexConst(stride)));
+    }
+    llvm::Value* packed_heap = nullptr;
+    if (xsmmDispatch == XSMMDispatch::BSMM || xsmmDispatch == XSMMDispatch::BMMM) {
+      // Only the current a is packed; the next one is prefetched where it lies.
+      args[0] = PackVNNI(args[0], kernel, xsmmCallData.lda_a_value, &packed_heap);
+    }
+    std::vector<llvm::Type*> param_types;
+    for (auto arg : args) {
+      param_types.push_back(arg->getType());
+    }
+    auto rftype = llvm::FunctionType::get(builder_.getVoidTy(), param_types, false);
+    builder_.CreateCall(rftype, XSMMKernelFunction(kernel, rftype), args);
+    if (packed_heap) {
+      Free(packed_heap);
+    }
+    return;
+  }
+
+  // Gather the a and b operands of every iteration of the batch indexes into arrays, then accumulate all of their
+  // products into the output tile with one call.
+  kernel.batch_reduce = true;
+  uint64_t count = 1;
+  for (const auto& idx : block.idxs) {
+    if (batch_idxs.count(idx.name)) {
+      count *= idx.range;
+    }
+  }
+  auto function = builder_.GetInsertBlock()->getParent();
+  llvm::IRBuilder<> entry(&function->getEntryBlock(), function->getEntryBlock().begin());
+  auto a_type = source(xsmmCallData.in1).base->getType();
+  auto b_type = source(xsmmCallData.in0).base->getType();
+  llvm::Value* a_ptrs = entry.CreateAlloca(a_type, IndexConst(count), "a_ptrs");
+  llvm::Value* b_ptrs = entry.CreateAlloca(b_type, IndexConst(count), "b_ptrs");
+  llvm::Value* slot = IndexVariable("slot");
+  llvm::Value* count_ptr = entry.CreateAlloca(builder_.getInt64Ty(), nullptr, "count");
+  builder_.CreateStore(IndexConst(0), slot);
+  std::vector<Loop> loops;
+  loops.reserve(batch_idxs.size());
+  for (const auto& idx : block.idxs) {
+    if (batch_idxs.count(idx.name)) {
+      llvm::Value* variable = indexes_[idx.name].variable;
+      llvm::Value* init = indexes_[idx.name].init;
+      loops.emplace_back();
+      CreateLoop(&loops.back(), idx.name);
+      EnterLoop(&loops.back(), variable, init, builder_.CreateAdd(init, IndexConst(idx.range)));
+    }
+  }
+  llvm::Value* n = builder_.CreateLoad(slot);
+  builder_.CreateStore(operand(xsmmCallData.in1, xsmmCallData.offset_in1), builder_.CreateGEP(a_ptrs, n));
+  builder_.CreateStore(operand(xsmmCallData.in0, xsmmCallData.offset_in0), builder_.CreateGEP(b_ptrs, n));
+  builder_.CreateStore(builder_.CreateAdd(n, IndexConst(1)), slot);
+  size_t loop = loops.size();
+  for (auto it = block.idxs.rbegin(); it != block.idxs.rend(); ++it) {
+    if (batch_idxs.count(it->name)) {
+      LeaveLoop(&loops[--loop], indexes_[it->name].variable);
+    }
+  }
+  builder_.CreateStore(builder_.getInt64(count), count_ptr);
+  // The output does not depend on the batch indexes, so their final values are irrelevant here.
+  llvm::Value* c = operand(xsmmCallData.out0, xsmmCallData.offset_out0);
+  std::vector<llvm::Type*> param_types{a_ptrs->getType(), b_ptrs->getType(), c->getType(), count_ptr->getType()};
+  auto rftype = llvm::FunctionType::get(builder_.getVoidTy(), param_types, false);
+  builder_.CreateCall(rftype, XSMMKernelFunction(kernel, rftype), {a_ptrs, b_ptrs, c, count_ptr});
+}
+
+XSMMKernel Compiler::GetXSMMKernel(const stripe::Block& block, const XSMMDispatch xsmmDispatch,
+                                   const XSMMCallData& xsmmCallData) {
+  XSMMKernel kernel;
+  kernel.dispatch = xsmmDispatch;
+  kernel.m = FindIndexByTag(block, "stencil_m")->range;
+  auto n_idx = FindIndexByTag(block, "stencil_n");
+  kernel.n = n_idx ? n_idx->range : 1;
+  kernel.k = FindIndexByTag(block, "stencil_k")->range;
+  kernel.lda = xsmmCallData.lda_a_value;
+  kernel.ldb = xsmmCallData.lda_b_value;
+  kernel.ldc = xsmmCallData.lda_c_value;
+  if (xsmmDispatch == XSMMDispatch::BSMM || xsmmDispatch == XSMMDispatch::BMMM) {
+    // The kernel reads A from the packed copy PackVNNI makes.
+    kernel.lda = kernel.m;
+  }
+  return kernel;
+}
+
+llvm::Value* Compiler::PackVNNI(llvm::Value* a, const XSMMKernel& kernel, int32_t lda, llvm::Value** heap) {
+  // libxsmm's bfloat16 kernels read the m x k A operand with each pair of consecutive k elements adjacent: element
+  // (i, p) lives at ((p / 2) * m + i) * 2 + p % 2. k is even (see GetXSMMDispatch). The copy sits in this function's
+  // frame when it fits there; a larger one is allocated for the call, which is small next to the kernel's m x n x k
+  // multiply-adds.
+  uint64_t size = kernel.m * kernel.k * 2;
+  llvm::Value* buffer;
+  if (size <= kMaxStackBuffer) {
+    buffer = StackBuffer(size);
+  } else {
+    buffer = Malloc(size);
+    *heap = buffer;
+  }
+  llvm::Value* packed = builder_.CreateBitCast(buffer, a->getType());
+  auto function = builder_.GetInsertBlock()->getParent();
+  llvm::IRBuilder<> entry(&function->getEntryBlock(), function->getEntryBlock().begin());
+  llvm::Value* pair_var = IndexVariable("vnni_pair");
+  llvm::Value* row_var = IndexVariable("vnni_row");
+  Loop pair_loop;
+  CreateLoop(&pair_loop, "vnni_pair");
+  EnterLoop(&pair_loop, pair_var, IndexConst(0), IndexConst(kernel.k / 2));
+  Loop row_loop;
+  CreateLoop(&row_loop, "vnni_row");
+  EnterLoop(&row_loop, row_var, IndexConst(0), IndexConst(kernel.m));
+  llvm::Value* pair = builder_.CreateLoad(pair_var);
+  llvm::Value* row = builder_.CreateLoad(row_var);
+  llvm::Value* src = builder_.CreateAdd(builder_.CreateMul(pair, IndexConst(2 * lda)), row);
+  llvm::Value* dst = builder_.CreateMul(builder_.CreateAdd(builder_.CreateMul(pair, IndexConst(kernel.m)), row),
+                                        IndexConst(2));
+  builder_.CreateStore(builder_.CreateLoad(builder_.CreateGEP(a, src)), builder_.CreateGEP(packed, dst));
+  builder_.CreateStore(builder_.CreateLoad(builder_.CreateGEP(a, builder_.CreateAdd(src, IndexConst(lda)))),
+                       builder_.CreateGEP(packed, builder_.CreateAdd(dst, IndexConst(1))));
+  LeaveLoop(&row_loop, row_var);
+  LeaveLoop(&pair_loop, pair_var);
+  return packed;
+}
+
+llvm::Value* Compiler::XSMMKernelFunction(const XSMMKernel& kernel, llvm::FunctionType* type) {
+  // Look the kernel up in the executable's table, assigning it a slot if it is new to the program.
+  auto& kernels = *xsmm_kernels_;
+  size_t slot = std::find(kernels.begin(), kernels.end(), kernel) - kernels.begin();
+  if (slot == kernels.size()) {
+    kernels.push_back(kernel);
+  }
+  auto tabletype = builder_.getInt8PtrTy()->getPointerTo();
+  module_->getOrInsertGlobal(xsmm_kernels_name_, tabletype);
+  auto gval = module_->getNamedGlobal(xsmm_kernels_name_);
+  if (!gval->hasInitializer()) {
+    gval->setInitializer(llvm::Constant::getNullValue(tabletype));
+  }
+  llvm::Value* table = builder_.CreateLoad(gval);
+  llvm::Value* func = builder_.CreateLoad(builder_.CreateConstGEP1_64(table, slot));
+  return builder_.CreateBitCast(func, type->getPointerTo());
+}
+
 // Gets the leading dimensions and the buffers for an XSMM call if available.
 // @returns true if the XSMM call is applicable, otherwise false.
 bool Compiler::GetXSMMCallData(XSMMCallData* xsmmCallData, const stripe::Block& block) {
@@ -440,7 +770,7 @@ const XSMMDispatch Compiler::GetXSMMDispatch(const stripe::Block& block) {
       firstIteration = false;
       if (dataType == DataType::FLOAT32) {
         xsmmDispatch = XSMMDispatch::SMM;
-      } else if (dataType == DataType::FLOAT32) {
+      } else if (dataType == DataType::FLOAT64) {
         xsmmDispatch = XSMMDispatch::DMM;
       } else {
         break;
@@ -478,7 +808,16 @@ const XSMMDispatch Compiler::GetXSMMDispatch(const stripe::Block& block) {
         xsmmDispatch = XSMMDispatch::WIMM;
       }
 
-      // TODO: Handle bfloat16 when support added to Stripe.
+      // BSMM, BMMM, as long as the A operand can be packed for them (see PackVNNI)
+      auto m_idx = FindIndexByTag(block, "stencil_m");
+      auto k_idx = FindIndexByTag(block, "stencil_k");
+      if (in0 == DataType::BFLOAT16 && in1 == DataType::BFLOAT16 && m_idx && k_idx && k_idx->range % 2 == 0) {
+        if (out == DataType::FLOAT32) {
+          xsmmDispatch = XSMMDispatch::BSMM;
+        } else if (out == DataType::BFLOAT16) {
+          xsmmDispatch = XSMMDispatch::BMMM;
+        }
+      }
     }
   }
 
@@ -521,6 +860,8 @@ llvm::Function* Compiler::CompileThreadedBlock(const stripe::Block& block) {
     std::string refName = it->into();
     buffers_[refName].base = builder_.CreateBitCast(refPtr, buftype);
   }
+  // The arena base address follows the refinements.
+  arena_ = builder_.CreateLoad(builder_.CreateConstGEP1_32(refsArray, block.refs.size()), "arena");
   // Second parameter points to an array of index init values.
   llvm::Value* initsArray = function->getArg(1);
   for (unsigned i = 0; i < block.idxs.size(); ++i) {
@@ -535,6 +876,18 @@ llvm::Function* Compiler::CompileThreadedBlock(const stripe::Block& block) {
   // Fourth parameter is the composite index range end.
   // We will use these to replace the init & limit values for index 0.
 
+  // Decompose the range begin into a digit per index, once; the first index
+  // varies fastest. Each iteration then advances the digits with a carry chain
+  // rather than paying a divide and remainder per index per iteration.
+  std::vector<llvm::Value*> digits(block.idxs.size());
+  llvm::Value* cur = function->getArg(2);
+  for (size_t i = 0; i < block.idxs.size(); ++i) {
+    const auto& idx = block.idxs[i];
+    digits[i] = builder_.CreateAlloca(IndexType(), nullptr, "digit_" + idx.name);
+    builder_.CreateStore(builder_.CreateURem(cur, IndexConst(idx.range)), digits[i]);
+    cur = builder_.CreateUDiv(cur, IndexConst(idx.range));
+  }
+
   // Construct the joint index loop
   Loop joint_loop;
   llvm::Value* joint_idx = builder_.CreateAlloca(IndexType());
@@ -542,11 +895,9 @@ llvm::Function* Compiler::CompileThreadedBlock(const stripe::Block& block) {
   EnterLoop(&joint_loop, joint_idx, function->getArg(2), function->getArg(3));
 
   // Extract into specific index values
-  llvm::Value* cur = builder_.CreateLoad(joint_idx);
-  for (auto& idx : block.idxs) {
-    auto low_part = builder_.CreateURem(cur, IndexConst(idx.range));
-    auto with_init = builder_.CreateAdd(low_part, indexes_[idx.name].init);
-    cur = builder_.CreateUDiv(cur, IndexConst(idx.range));
+  for (size_t i = 0; i < block.idxs.size(); ++i) {
+    const auto& idx = block.idxs[i];
+    auto with_init = builder_.CreateAdd(builder_.CreateLoad(digits[i]), indexes_[idx.name].init);
     builder_.CreateStore(with_init, indexes_[idx.name].variable);
   }
 
@@ -554,6 +905,10 @@ llvm::Function* Compiler::CompileThreadedBlock(const stripe::Block& block) {
   // to execute the block body for this iteration
   llvm::Value* go = builder_.getTrue();
   for (auto& constraint : block.constraints) {
+    if (lanes && constraint.get(block.idxs.back().name)) {
+      // Checked lane by lane within the vector loop (see LaneMask).
+      continue;
+    }
     llvm::Value* gateval = Eval(constraint);
     llvm::Value* check = builder_.CreateICmpSGE(gateval, IndexConst(0));
     go = builder_.CreateAnd(check, go);
@@ -565,7 +920,6 @@ llvm::Function* Compiler::CompileThreadedBlock(const stripe::Block& block) {
 
   // process each statement in the block body, generating code to modify the
   // parameter buffer contents
-  std::shared_ptr<stripe::Block> pBlock = std::make_shared<stripe::Block>(block);
   for (const auto& stmt : block.stmts) {
     stmt->Accept(this);
   }
@@ -574,7 +928,24 @@ llvm::Function* Compiler::CompileThreadedBlock(const stripe::Block& block) {
   builder_.CreateBr(block_done);
   builder_.SetInsertPoint(block_done);
 
-  // increment each index, from innermost to outermost, then jump back to test
+  // advance the digits: bump the fastest index, carrying into the next one
+  // whenever an index wraps around to zero
+  auto advanced = llvm::BasicBlock::Create(context_, "advanced", function);
+  for (size_t i = 0; i < block.idxs.size(); ++i) {
+    llvm::Value* next = builder_.CreateAdd(builder_.CreateLoad(digits[i]), IndexConst(1));
+    llvm::Value* wrap = builder_.CreateICmpEQ(next, IndexConst(block.idxs[i].range));
+    builder_.CreateStore(builder_.CreateSelect(wrap, IndexConst(0), next), digits[i]);
+    if (i + 1 < block.idxs.size()) {
+      auto carry = llvm::BasicBlock::Create(context_, "carry_" + block.idxs[i + 1].name, function);
+      builder_.CreateCondBr(wrap, carry, advanced);
+      builder_.SetInsertPoint(carry);
+    } else {
+      builder_.CreateBr(advanced);
+    }
+  }
+  builder_.SetInsertPoint(advanced);
+
+  // increment the joint index, then jump back to test
   LeaveLoop(&joint_loop, joint_idx);
 
   builder_.CreateRetVoid();
@@ -588,7 +959,10 @@ llvm::Function* Compiler::CompileBlock(const stripe::Block& block) {
     const XSMMDispatch xsmmDispatch = GetXSMMDispatch(block);
     XSMMCallData xsmmCallData;
     auto data = GetXSMMCallData(&xsmmCallData, block);
-    if (xsmmDispatch != XSMMDispatch::NONE && data) {
+    // libxsmm may be unable to generate the kernel on this machine (e.g. bfloat16 without AVX-512), in which case the
+    // block is compiled as a loop nest like any other.
+    if (xsmmDispatch != XSMMDispatch::NONE && data &&
+        DispatchXSMMKernel(GetXSMMKernel(block, xsmmDispatch, xsmmCallData))) {
       return CompileXSMMBlock(block, xsmmDispatch, xsmmCallData);
     }
   } else if (compileFor == THREADED_BLOCK) {
@@ -618,6 +992,7 @@ llvm::Function* Compiler::CompileBlock(const stripe::Block& block) {
   // This block will be invoked through a direct function call.
   // First, a parameter for each refinement, containing the base address.
   // Then, a parameter for each index, containing the initial value.
+  // Finally, the base address of the arena.
   for (auto ai = function->arg_begin(); ai != function->arg_end(); ++ai) {
     unsigned idx = ai->getArgNo();
     if (idx < block.refs.size()) {
@@ -627,19 +1002,22 @@ llvm::Function* Compiler::CompileBlock(const stripe::Block& block) {
       ai->setName(param_name);
       assert(nullptr == buffers_[param_name].base);
       buffers_[param_name].base = &(*ai);
-    } else {
+    } else if (idx < block.refs.size() + block.idxs.size()) {
       idx -= block.refs.size();
       std::string param_name = block.idxs[idx].name;
       ai->setName(param_name);
       assert(nullptr == indexes_[param_name].init);
       indexes_[param_name].init = &(*ai);
+    } else {
+      ai->setName("arena");
+      arena_ = &(*ai);
     }
   }
 
   // allocate storage for each loop index
   for (auto& idx : block.idxs) {
     llvm::Value* variable = builder_.CreateAlloca(IndexType());
-    variable->setName(idx.name);
+    variable->setName(idx.name.str());
     assert(nullptr == indexes_[idx.name].variable);
     indexes_[idx.name].variable = variable;
   }
@@ -653,20 +1031,36 @@ llvm::Function* Compiler::CompileBlock(const stripe::Block& block) {
   }
 
   // generate the basic blocks for each nested loop's evaluation stages
-  // initialize each loop index and generate the termination check
-  std::vector<Loop> loops(block.idxs.size());
+  // initialize each loop index and generate the termination check; when the
+  // block can be vectorized, the innermost loop is emitted with the body, as
+  // are the loops over the batch indexes of an XSMM nest
+  size_t lanes = VectorLanes(block);
+  std::set<std::string> batch_idxs;
+  bool xsmm_nest = !lanes && XSMMNest(block, &batch_idxs);
+  std::vector<size_t> looped;
   for (size_t i = 0; i < block.idxs.size(); ++i) {
+    if (!(lanes && i + 1 == block.idxs.size()) && !batch_idxs.count(block.idxs[i].name)) {
+      looped.push_back(i);
+    }
+  }
+  std::vector<Loop> loops(looped.size());
+  for (size_t j = 0; j < looped.size(); ++j) {
+    size_t i = looped[j];
     std::string name = block.idxs[i].name;
     llvm::Value* variable = indexes_[name].variable;
     llvm::Value* init = indexes_[name].init;
-    CreateLoop(&loops[i], name);
-    EnterLoop(&loops[i], variable, init, limits[i]);
+    CreateLoop(&loops[j], name);
+    EnterLoop(&loops[j], variable, init, limits[i]);
   }
 
   // check the constraints against the current index values and decide whether
   // to execute the block body for this iteration
   llvm::Value* go = builder_.getTrue();
   for (auto& constraint : block.constraints) {
+    if (lanes && constraint.get(block.idxs.back().name)) {
+      // Checked lane by lane within the vector loop (see LaneMask).
+      continue;
+    }
     llvm::Value* gateval = Eval(constraint);
     llvm::Value* check = builder_.CreateICmpSGE(gateval, IndexConst(0));
     go = builder_.CreateAnd(check, go);
@@ -680,9 +1074,14 @@ llvm::Function* Compiler::CompileBlock(const stripe::Block& block) {
 
   // process each statement in the block body, generating code to modify the
   // parameter buffer contents
-  std::shared_ptr<stripe::Block> pBlock = std::make_shared<stripe::Block>(block);
-  for (const auto& stmt : block.stmts) {
-    stmt->Accept(this);
+  if (lanes) {
+    VectorLoop(block, lanes);
+  } else if (xsmm_nest) {
+    CompileXSMMNest(block, batch_idxs);
+  } else {
+    for (const auto& stmt : block.stmts) {
+      stmt->Accept(this);
+    }
   }
 
   ProfileLoopLeave(block);
@@ -692,15 +1091,228 @@ llvm::Function* Compiler::CompileBlock(const stripe::Block& block) {
   builder_.SetInsertPoint(block_done);
 
   // increment each index, from innermost to outermost, then jump back to test
-  for (size_t i = block.idxs.size(); i-- > 0;) {
-    llvm::Value* variable = indexes_[block.idxs[i].name].variable;
-    LeaveLoop(&loops[i], variable);
+  for (size_t j = looped.size(); j-- > 0;) {
+    llvm::Value* variable = indexes_[block.idxs[looped[j]].name].variable;
+    LeaveLoop(&loops[j], variable);
   }
 
   builder_.CreateRetVoid();
   return function;
 }
 
+size_t Compiler::VectorLanes(const stripe::Block& block) {
+  // A block is vectorized along its innermost index when every lane of a vector would execute the block's statements
+  // independently: its statements are elementwise, every store is contiguous along the index, and every load is
+  // either contiguous along the index or the same for all lanes.
+  static const std::set<std::string> math_funcs{"abs",   "acos", "acosh", "asin",  "asinh", "atan", "atanh",
+                                                 "ceil",  "cos",  "cosh",  "exp",   "floor", "log",  "pow",
+                                                 "round", "sin",  "sinh",  "sqrt",  "tan",   "tanh"};
+  if (block.idxs.empty()) {
+    return 0;
+  }
+  const auto& idx = block.idxs.back();
+  if (!(idx.affine == stripe::Affine())) {
+    return 0;
+  }
+  auto vectorizable_type = [](DataType type) { return type != DataType::FLOAT16; };
+  auto stride = [&](const std::string& name) {
+    const auto& ref = *block.ref_by_into(name);
+    return vectorizable_type(ref.interior_shape.type) ? ref.FlatAccess().get(idx.name) : -1;
+  };
+  // A load must not read a buffer the block also stores to, whether through the same refinement or another view of
+  // the same base buffer.
+  std::set<const stripe::Refinement*> stored;
+  for (const auto& stmt : block.stmts) {
+    if (auto store = stripe::Store::Downcast(stmt)) {
+      stored.insert(BaseRef(store->into));
+    }
+  }
+  for (const auto& stmt : block.stmts) {
+    switch (stmt->kind()) {
+      case stripe::StmtKind::Load: {
+        auto load = stripe::Load::Downcast(stmt);
+        auto step = stride(load->from);
+        if (stored.count(BaseRef(load->from)) || (step != 0 && step != 1)) {
+          return 0;
+        }
+      } break;
+      case stripe::StmtKind::Store:
+        if (stride(stripe::Store::Downcast(stmt)->into) != 1) {
+          return 0;
+        }
+        break;
+      case stripe::StmtKind::Constant:
+      case stripe::StmtKind::LoadIndex:
+        break;
+      case stripe::StmtKind::Intrinsic: {
+        auto intrinsic = stripe::Intrinsic::Downcast(stmt);
+        if (config_.externals.count(intrinsic->name) || !vectorizable_type(intrinsic->type)) {
+          return 0;
+        }
+        if (math_funcs.count(intrinsic->name) && !is_float(intrinsic->type)) {
+          return 0;
+        }
+      } break;
+      default:
+        return 0;
+    }
+  }
+  // Size the vectors so that the widest element the block loads, stores or computes on fills a register.
+  size_t elem_bytes = 1;
+  for (const auto& ref : block.refs) {
+    elem_bytes = std::max(elem_bytes, byte_width(ComputeType(ref.interior_shape.type)));
+  }
+  for (const auto& stmt : block.stmts) {
+    if (auto intrinsic = stripe::Intrinsic::Downcast(stmt)) {
+      elem_bytes = std::max(elem_bytes, byte_width(ComputeType(intrinsic->type)));
+    }
+  }
+  size_t vector_bytes = config_.vector_bytes ? config_.vector_bytes : HostVectorBytes();
+  size_t lanes = vector_bytes / elem_bytes;
+  if (lanes < 2 || idx.range < lanes) {
+    return 0;
+  }
+  return lanes;
+}
+
+void Compiler::VectorLoop(const stripe::Block& block, size_t lanes) {
+  // Each iteration of the innermost index's loop covers a full vector of lanes; a remainder too short to fill one is
+  // covered by a single final iteration whose loads and stores are masked.
+  const auto& idx = block.idxs.back();
+  llvm::Value* variable = indexes_[idx.name].variable;
+  llvm::Value* init = indexes_[idx.name].init;
+  size_t full = idx.range / lanes * lanes;
+  lanes_ = lanes;
+  vector_idx_ = idx.name;
+  Loop loop;
+  CreateLoop(&loop, idx.name);
+  EnterLoop(&loop, variable, init, builder_.CreateAdd(init, IndexConst(full)));
+  mask_ = LaneMask(block, nullptr);
+  for (const auto& stmt : block.stmts) {
+    stmt->Accept(this);
+  }
+  mask_ = nullptr;
+  LeaveLoop(&loop, variable, lanes);
+  // On leaving the loop, the index has advanced to exactly init + full.
+  size_t remainder = idx.range - full;
+  if (remainder) {
+    std::vector<llvm::Constant*> active;
+    for (size_t i = 0; i < lanes; ++i) {
+      active.push_back(builder_.getInt1(i < remainder));
+    }
+    mask_ = LaneMask(block, llvm::ConstantVector::get(active));
+    for (const auto& stmt : block.stmts) {
+      stmt->Accept(this);
+    }
+    mask_ = nullptr;
+  }
+  lanes_ = 0;
+  vector_idx_.clear();
+}
+
+llvm::Value* Compiler::LaneMask(const stripe::Block& block, llvm::Value* active) {
+  // Combines the lanes active in this iteration of the vector loop with each constraint on the vector index, which
+  // lane i sees advanced by i steps of the index.  Null when every lane is active.
+  llvm::Value* mask = active;
+  for (const auto& constraint : block.constraints) {
+    auto step = constraint.get(vector_idx_);
+    if (!step) {
+      continue;
+    }
+    std::vector<llvm::Constant*> offsets;
+    for (size_t i = 0; i < lanes_; ++i) {
+      offsets.push_back(llvm::ConstantInt::get(IndexType(), i * step));
+    }
+    auto lane_vals = builder_.CreateAdd(builder_.CreateVectorSplat(lanes_, Eval(constraint)),  //
+                                        llvm::ConstantVector::get(offsets));
+    auto check = builder_.CreateICmpSGE(lane_vals, llvm::ConstantInt::get(lane_vals->getType(), 0));
+    mask = mask ? builder_.CreateAnd(mask, check) : check;
+  }
+  return mask;
+}
+
+llvm::Value* Compiler::VectorLoad(llvm::Value* element) {
+  // Loads the lanes starting at the given element.  Booleans are bytes in memory but bits in a vector, so they are
+  // loaded as bytes and narrowed.
+  auto elem_type = element->getType()->getPointerElementType();
+  bool boolean = elem_type->isIntegerTy(1);
+  if (boolean) {
+    elem_type = builder_.getInt8Ty();
+  }
+  auto vec_type = llvm::VectorType::get(elem_type, lanes_);
+  auto ptr = builder_.CreateBitCast(element, vec_type->getPointerTo());
+  auto align = module_->getDataLayout().getABITypeAlignment(elem_type);
+  llvm::Value* value = nullptr;
+  if (!mask_) {
+    value = builder_.CreateAlignedLoad(ptr, llvm::MaybeAlign(align));
+  } else {
+    // Inactive lanes read as one rather than undef, so that arithmetic on them (integer division in particular)
+    // cannot trap.
+    auto func = llvm::Intrinsic::getDeclaration(module_, llvm::Intrinsic::masked_load, {vec_type, ptr->getType()});
+    auto passthru = elem_type->isFloatingPointTy() ? llvm::ConstantFP::get(vec_type, 1.0)  //
+                                                   : llvm::ConstantInt::get(vec_type, 1);
+    value = builder_.CreateCall(func, {ptr, builder_.getInt32(align), mask_, passthru});
+  }
+  if (boolean) {
+    value = builder_.CreateTrunc(value, llvm::VectorType::get(builder_.getInt1Ty(), lanes_));
+  }
+  return value;
+}
+
+llvm::Value* Compiler::VectorGather(llvm::Value* element) {
+  // Loads the same element into every lane, reading it only if some lane is active: under a constraint, the element
+  // may lie outside its buffer for iterations the scalar loop would skip.
+  auto elem_type = element->getType()->getPointerElementType();
+  bool boolean = elem_type->isIntegerTy(1);
+  if (boolean) {
+    elem_type = builder_.getInt8Ty();
+    element = builder_.CreateBitCast(element, elem_type->getPointerTo());
+  }
+  auto vec_type = llvm::VectorType::get(elem_type, lanes_);
+  auto ptrs = builder_.CreateVectorSplat(lanes_, element);
+  auto align = module_->getDataLayout().getABITypeAlignment(elem_type);
+  auto func = llvm::Intrinsic::getDeclaration(module_, llvm::Intrinsic::masked_gather, {vec_type, ptrs->getType()});
+  auto passthru = elem_type->isFloatingPointTy() ? llvm::ConstantFP::get(vec_type, 1.0)  //
+                                                 : llvm::ConstantInt::get(vec_type, 1);
+  llvm::Value* value = builder_.CreateCall(func, {ptrs, builder_.getInt32(align), mask_, passthru});
+  if (boolean) {
+    value = builder_.CreateTrunc(value, llvm::VectorType::get(builder_.getInt1Ty(), lanes_));
+  }
+  return value;
+}
+
+void Compiler::VectorStore(llvm::Value* value, llvm::Value* element) {
+  // Stores the lanes starting at the given element, widening booleans to the bytes they occupy in memory.
+  auto elem_type = element->getType()->getPointerElementType();
+  if (elem_type->isIntegerTy(1)) {
+    elem_type = builder_.getInt8Ty();
+    value = builder_.CreateZExt(value, llvm::VectorType::get(elem_type, lanes_));
+  }
+  auto ptr = builder_.CreateBitCast(element, value->getType()->getPointerTo());
+  auto align = module_->getDataLayout().getABITypeAlignment(elem_type);
+  if (!mask_) {
+    builder_.CreateAlignedStore(value, ptr, llvm::MaybeAlign(align));
+    return;
+  }
+  auto func =
+      llvm::Intrinsic::getDeclaration(module_, llvm::Intrinsic::masked_store, {value->getType(), ptr->getType()});
+  builder_.CreateCall(func, {value, ptr, builder_.getInt32(align), mask_});
+}
+
+llvm::Value* Compiler::SafeDivisor(llvm::Value* divisor) {
+  // In the masked remainder of a vector loop, inactive lanes may hold values the scalar loop would never compute;
+  // they divide by one instead.
+  if (!mask_ || !divisor->getType()->isVectorTy()) {
+    return divisor;
+  }
+  return builder_.CreateSelect(mask_, divisor, llvm::ConstantInt::get(divisor->getType(), 1));
+}
+
+const stripe::Refinement* Compiler::BaseRef(const std::string& name) {
+  auto it = bases_.find(name);
+  return it == bases_.end() ? buffers_[name].refinement : it->second;
+}
+
 void Compiler::Visit(const stripe::Load& load) {
   // op->from is the name of a source buffer
   // op->into is the name of a destination scalar
@@ -709,8 +1321,24 @@ void Compiler::Visit(const stripe::Load& load) {
   // Load the value from that address and use it to redefine the
   // destination scalar.
   llvm::Value* element = ElementPtr(from);
-  llvm::Value* value = builder_.CreateLoad(element, load.into);
-  scalars_[load.into] = Scalar{value, from.refinement->interior_shape.type};
+  llvm::Value* value = nullptr;
+  if (!lanes_) {
+    value = builder_.CreateLoad(element, load.into.str());
+  } else if (from.refinement->FlatAccess().get(vector_idx_)) {
+    value = VectorLoad(element);
+    value->setName(load.into.str());
+  } else if (mask_) {
+    value = VectorGather(element);
+    value->setName(load.into.str());
+  } else {
+    // Every lane reads the same element.
+    value = builder_.CreateVectorSplat(lanes_, builder_.CreateLoad(element), load.into);
+  }
+  DataType type = from.refinement->interior_shape.type;
+  if (type == DataType::BFLOAT16) {
+    value = BF16ToFloat(value);
+  }
+  scalars_[load.into] = Scalar{value, ComputeType(type)};
 }
 
 void Compiler::Visit(const stripe::Store& store) {
@@ -723,80 +1351,106 @@ void Compiler::Visit(const stripe::Store& store) {
   // use GEP to compute the destination element address
   // use the specified aggregation to store the value
   Buffer into = buffers_[store.into];
+  bool bf16 = into.refinement->interior_shape.type == DataType::BFLOAT16;
   Scalar from = Cast(scalars_[store.from], into.refinement->interior_shape.type);
   llvm::Value* value = from.value;
   llvm::Value* element = ElementPtr(into);
   std::string agg_op = into.refinement->agg_op;
+  if (!agg_op.empty() && "assign" != agg_op) {
+    llvm::Value* prev = lanes_ ? VectorLoad(element) : builder_.CreateLoad(element);
+    value = Aggregate(agg_op, from.type, bf16 ? BF16ToFloat(prev) : prev, value);
+  }
+  if (bf16) {
+    value = FloatToBF16(value);
+  }
+  if (lanes_) {
+    VectorStore(value, element);
+  } else {
+    builder_.CreateStore(value, element);
+  }
+}
+
+llvm::Value* Compiler::Aggregate(const std::string& agg_op, DataType type, llvm::Value* prev, llvm::Value* value) {
+  // Combines a new value into the previous value of an element, as the agg_op (add, mul, max, min) specifies.
   if ("add" == agg_op) {
-    llvm::Value* prev = builder_.CreateLoad(element);
-    if (is_float(from.type)) {
-      value = builder_.CreateFAdd(value, prev);
-    } else if (is_int(from.type) || is_uint(from.type)) {
-      value = builder_.CreateAdd(value, prev);
-    } else {
-      throw Error("Invalid addition type: " + to_string(from.type));
+    if (is_float(type)) {
+      return builder_.CreateFAdd(value, prev);
+    } else if (is_int(type) || is_uint(type)) {
+      return builder_.CreateAdd(value, prev);
     }
+    throw Error("Invalid addition type: " + to_string(type));
   } else if ("mul" == agg_op) {
-    llvm::Value* prev = builder_.CreateLoad(element);
-    if (is_float(from.type)) {
-      value = builder_.CreateFMul(value, prev);
-    } else if (is_int(from.type) || is_uint(from.type)) {
-      value = builder_.CreateMul(value, prev);
-    } else {
-      throw Error("Invalid multiplication type: " + to_string(from.type));
+    if (is_float(type)) {
+      return builder_.CreateFMul(value, prev);
+    } else if (is_int(type) || is_uint(type)) {
+      return builder_.CreateMul(value, prev);
     }
+    throw Error("Invalid multiplication type: " + to_string(type));
   } else if ("max" == agg_op) {
-    llvm::Value* prev = builder_.CreateLoad(element);
     llvm::Value* flag = nullptr;
-    if (is_float(from.type)) {
+    if (is_float(type)) {
       flag = builder_.CreateFCmpUGT(prev, value);
-    } else if (is_int(from.type)) {
+    } else if (is_int(type)) {
       flag = builder_.CreateICmpSGT(prev, value);
-    } else if (is_uint(from.type)) {
+    } else if (is_uint(type)) {
       flag = builder_.CreateICmpUGT(prev, value);
     }
-    value = builder_.CreateSelect(flag, prev, value);
+    return builder_.CreateSelect(flag, prev, value);
   } else if ("min" == agg_op) {
-    llvm::Value* prev = builder_.CreateLoad(element);
     llvm::Value* flag = nullptr;
-    if (is_float(from.type)) {
+    if (is_float(type)) {
       flag = builder_.CreateFCmpULT(prev, value);
-    } else if (is_int(from.type)) {
+    } else if (is_int(type)) {
       flag = builder_.CreateICmpSLT(prev, value);
-    } else if (is_uint(from.type)) {
+    } else if (is_uint(type)) {
       flag = builder_.CreateICmpULT(prev, value);
     }
-    value = builder_.CreateSelect(flag, prev, value);
-  } else if ("assign" == agg_op) {
-    // fall through to assignment
-  } else if (!agg_op.empty()) {
-    throw Error("Unimplemented agg_op: " + to_string(agg_op));
+    return builder_.CreateSelect(flag, prev, value);
   }
-  builder_.CreateStore(value, element);
+  throw Error("Unimplemented agg_op: " + to_string(agg_op));
 }
 
 void Compiler::Visit(const stripe::LoadIndex& load_index) {
   // op->from is an affine
   // op->into is the name of a destination scalar
   llvm::Value* rval = Eval(load_index.from);
-  rval->setName(load_index.into);
+  if (lanes_) {
+    // Each lane sees its own value of the vector index.
+    rval = builder_.CreateVectorSplat(lanes_, rval);
+    auto step = load_index.from.get(vector_idx_);
+    if (step) {
+      std::vector<llvm::Constant*> offsets;
+      for (size_t i = 0; i < lanes_; ++i) {
+        offsets.push_back(llvm::ConstantInt::get(IndexType(), i * step));
+      }
+      rval = builder_.CreateAdd(rval, llvm::ConstantVector::get(offsets));
+    }
+  }
+  rval->setName(load_index.into.str());
   scalars_[load_index.into] = Scalar{rval, DataType::INT64};
 }
 
 void Compiler::Visit(const stripe::Constant& constant) {
-  // store a constant integer or float value into a scalar
+  // store a constant integer or float value into a scalar; within a vector
+  // loop, the constant is splatted across every lane
   switch (constant.type) {
     case stripe::ConstType::Integer: {
       auto ty = builder_.getInt64Ty();
-      auto value = llvm::ConstantInt::get(ty, constant.iconst);
+      llvm::Value* value = llvm::ConstantInt::get(ty, constant.iconst);
+      if (lanes_) {
+        value = builder_.CreateVectorSplat(lanes_, value);
+      }
       scalars_[constant.name] = Scalar{value, DataType::INT64};
-      value->setName(constant.name);
+      value->setName(constant.name.str());
     } break;
     case stripe::ConstType::Float: {
       auto ty = builder_.getDoubleTy();
-      auto value = llvm::ConstantFP::get(ty, constant.fconst);
+      llvm::Value* value = llvm::ConstantFP::get(ty, constant.fconst);
+      if (lanes_) {
+        value = builder_.CreateVectorSplat(lanes_, value);
+      }
       scalars_[constant.name] = Scalar{value, DataType::FLOAT64};
-      value->setName(constant.name);
+      value->setName(constant.name.str());
     } break;
   }
 }
@@ -817,6 +1471,7 @@ void Compiler::Visit(const stripe::Special& special) {
       {"agg_init_max", &Compiler::AggInitMax},  //
       {"scatter", &Compiler::Scatter},          //
       {"gather", &Compiler::Gather},            //
+      {"scan", &Compiler::Scan},                //
   };
   auto it = handlers.find(special.name);
   if (it == handlers.end()) {
@@ -907,6 +1562,14 @@ void Compiler::Visit(const stripe::Intrinsic& intrinsic) {
 void Compiler::Visit(const stripe::Block& block) {
   // Compile a nested block as a function in the same module
   Compiler nested(&context_, module_, config_);
+  nested.arena_offsets_ = arena_offsets_;
+  nested.xsmm_kernels_ = xsmm_kernels_;
+  nested.parallel_blocks_ = parallel_blocks_;
+  for (const auto& ref : block.refs) {
+    if (ref.dir != stripe::RefDir::None || !ref.from.empty()) {
+      nested.bases_[ref.into()] = BaseRef(ref.from.empty() ? ref.into() : ref.from.str());
+    }
+  }
   auto function = nested.CompileBlock(block);
   for (auto& fptr_iter : nested.external_funcptrs_) {
     external_funcptrs_.emplace(fptr_iter);
@@ -924,13 +1587,16 @@ void Compiler::Visit(const stripe::Block& block) {
     // When a refinement is neither in nor out, and it has no "from"
     // name, it represents a local allocation.
     if (ref.dir == stripe::RefDir::None && ref.from.empty()) {
+      auto it = arena_offsets_->find(&ref);
       if (ref.has_tag("placed")) {
-        auto arena = module_->getNamedGlobal(arena_name_);
-        auto baseArenaAddress = builder_.CreateLoad(arena);
-        std::vector<llvm::Value*> idxList{IndexConst(ref.offset)};
-        buffer = builder_.CreateGEP(baseArenaAddress, idxList);
+        buffer = ArenaBuffer(ref.offset);
+      } else if (it != arena_offsets_->end()) {
+        buffer = ArenaBuffer(it->second);
+      } else if (ref.interior_shape.byte_size() <= kMaxStackBuffer) {
+        // Small per-thread buffers take a slot in this function's frame.
+        buffer = StackBuffer(ref.interior_shape.byte_size());
       } else {
-        // Allocate new storage for the buffer.
+        // The buffer is allocated concurrently by each thread; allocate new storage for it.
         buffer = Malloc(ref.interior_shape.byte_size());
         allocs.push_back(buffer);
       }
@@ -940,7 +1606,7 @@ void Compiler::Visit(const stripe::Block& block) {
       // Pass in the current element address from the source buffer.
       // If a "from" name is specified, use that buffer; if not, that means
       // that both blocks use the same name, so use "into".
-      std::string name = ref.from.empty() ? ref.into() : ref.from;
+      std::string name = ref.from.empty() ? ref.into() : ref.from.str();
       buffer = ElementPtr(buffers_[name]);
     }
     refs.push_back(buffer);
@@ -956,9 +1622,9 @@ void Compiler::Visit(const stripe::Block& block) {
   // Assemble the argument list and invoke the function.
   if (getCompileFor(block) == THREADED_BLOCK) {
     assert(!block.has_tag("xsmm"));
-    // Combine the bufs into an array; pass it as the first parameter.
+    // Combine the bufs, followed by the arena, into an array; pass it as the first parameter.
     auto int8PtrType = builder_.getInt8Ty()->getPointerTo();
-    auto int8PtrArrayType = llvm::ArrayType::get(int8PtrType, refs.size());
+    auto int8PtrArrayType = llvm::ArrayType::get(int8PtrType, refs.size() + 1);
     llvm::Value* bufsArg = builder_.CreateAlloca(int8PtrArrayType);
     bufsArg = builder_.CreateBitCast(bufsArg, int8PtrType->getPointerTo());
     for (size_t i = 0; i < refs.size(); ++i) {
@@ -966,6 +1632,7 @@ void Compiler::Visit(const stripe::Block& block) {
       llvm::Value* elementPtr = builder_.CreateConstGEP1_32(bufsArg, i);
       builder_.CreateStore(castRef, elementPtr);
     }
+    builder_.CreateStore(arena_, builder_.CreateConstGEP1_32(bufsArg, refs.size()));
     // Combine the idx inits into an array; pass it as the second parameter.
     auto indexArrayType = llvm::ArrayType::get(IndexType(), idxs.size());
     llvm::Value* initsArg = builder_.CreateAlloca(indexArrayType);
@@ -979,7 +1646,11 @@ void Compiler::Visit(const stripe::Block& block) {
       for (auto& idx : block.idxs) {
         total_range *= idx.range;
       }
-      ParallelFor(bufsArg, initsArg, total_range, function);
+      // Size chunks so that each one does a meaningful amount of work; the
+      // runtime will shrink the grain further if that leaves threads idle.
+      size_t grain = std::max<uint64_t>(1, kParallelChunkWork / EstimateIterationWork(block));
+      auto schedule = HasUnevenIterations(block) ? ParallelSchedule::Dynamic : ParallelSchedule::Static;
+      ParallelFor(bufsArg, initsArg, total_range, grain, schedule, function);
     } else {
       // There is no point in using ParallelFor to invoke a block which has no
       // indexes, since there is no way to divide the work among threads.
@@ -987,10 +1658,11 @@ void Compiler::Visit(const stripe::Block& block) {
       builder_.CreateCall(function, {bufsArg, initsArg, zero, zero});
     }
   } else {
-    // Argument list consists of the refinements, followed by the index inits.
+    // Argument list consists of the refinements, followed by the index inits and the arena.
     std::vector<llvm::Value*> args;
     args.insert(args.end(), refs.begin(), refs.end());
     args.insert(args.end(), idxs.begin(), idxs.end());
+    args.push_back(arena_);
     // Invoke the function. It does not return a value.
     builder_.CreateCall(function, args, "");
   }
@@ -1145,9 +1817,9 @@ void Compiler::Divide(const stripe::Intrinsic& div) {
   if (is_float(div.type)) {
     ret = builder_.CreateFDiv(lhs.value, rhs.value);
   } else if (is_int(div.type)) {
-    ret = builder_.CreateSDiv(lhs.value, rhs.value);
+    ret = builder_.CreateSDiv(lhs.value, SafeDivisor(rhs.value));
   } else if (is_uint(div.type)) {
-    ret = builder_.CreateUDiv(lhs.value, rhs.value);
+    ret = builder_.CreateUDiv(lhs.value, SafeDivisor(rhs.value));
   } else {
     throw Error("Invalid division type: " + to_string(div.type));
   }
@@ -1163,9 +1835,9 @@ void Compiler::Mod(const stripe::Intrinsic& mod) {
   // Output type is operation type
   llvm::Value* ret = nullptr;
   if (is_int(mod.type)) {
-    ret = builder_.CreateSRem(lhs.value, rhs.value);
+    ret = builder_.CreateSRem(lhs.value, SafeDivisor(rhs.value));
   } else if (is_uint(mod.type)) {
-    ret = builder_.CreateURem(lhs.value, rhs.value);
+    ret = builder_.CreateURem(lhs.value, SafeDivisor(rhs.value));
   } else {
     throw Error("Invalid modulo type: " + to_string(mod.type));
   }
@@ -1362,9 +2034,12 @@ void Compiler::BitLeft(const stripe::Intrinsic& stmt) {
 void Compiler::AsFloat(const stripe::Intrinsic& stmt) {
   assert(2 == stmt.inputs.size());
   Scalar inStmt2 = scalars_[stmt.inputs[1]];
-  int bits = llvm::cast<llvm::ConstantInt>(*inStmt2.value).getValue().getLimitedValue();
+  int bits = llvm::cast<llvm::Constant>(inStmt2.value)->getUniqueInteger().getLimitedValue();
   DataType type = DataType::INVALID;
   switch (bits) {
+    case 16:
+      type = DataType::FLOAT16;
+      break;
     case 32:
       type = DataType::FLOAT32;
       break;
@@ -1372,7 +2047,6 @@ void Compiler::AsFloat(const stripe::Intrinsic& stmt) {
       type = DataType::FLOAT64;
       break;
     default:
-      // TODO: Add bfloat16 when added to Stripe.
       std::ostringstream oss;
       oss << "Invalid bit count for as_float for CPU jit - " << bits;
       throw std::runtime_error(oss.str());
@@ -1381,13 +2055,13 @@ void Compiler::AsFloat(const stripe::Intrinsic& stmt) {
   Scalar ret = Cast(scalars_[stmt.inputs[0]], type);
   assert(1 == stmt.outputs.size());
   scalars_[stmt.outputs[0]] = ret;
-  ret.value->setName(stmt.outputs[0]);
+  ret.value->setName(stmt.outputs[0].str());
 }
 
 void Compiler::AsInt(const stripe::Intrinsic& stmt) {
   assert(2 == stmt.inputs.size());
   Scalar inStmt2 = scalars_[stmt.inputs[1]];
-  int bits = llvm::cast<llvm::ConstantInt>(*inStmt2.value).getValue().getLimitedValue();
+  int bits = llvm::cast<llvm::Constant>(inStmt2.value)->getUniqueInteger().getLimitedValue();
   DataType type = DataType::INVALID;
   switch (bits) {
     case 8:
@@ -1411,13 +2085,13 @@ void Compiler::AsInt(const stripe::Intrinsic& stmt) {
   Scalar ret = Cast(scalars_[stmt.inputs[0]], type);
   assert(1 == stmt.outputs.size());
   scalars_[stmt.outputs[0]] = ret;
-  ret.value->setName(stmt.outputs[0]);
+  ret.value->setName(stmt.outputs[0].str());
 }
 
 void Compiler::AsUInt(const stripe::Intrinsic& stmt) {
   assert(2 == stmt.inputs.size());
   Scalar inStmt2 = scalars_[stmt.inputs[1]];
-  int bits = llvm::cast<llvm::ConstantInt>(*inStmt2.value).getValue().getLimitedValue();
+  int bits = llvm::cast<llvm::Constant>(inStmt2.value)->getUniqueInteger().getLimitedValue();
   DataType type = DataType::INVALID;
   switch (bits) {
     case 8:
@@ -1441,7 +2115,7 @@ void Compiler::AsUInt(const stripe::Intrinsic& stmt) {
   Scalar ret = Cast(scalars_[stmt.inputs[0]], type);
   assert(1 == stmt.outputs.size());
   scalars_[stmt.outputs[0]] = ret;
-  ret.value->setName(stmt.outputs[0]);
+  ret.value->setName(stmt.outputs[0].str());
 }
 
 void Compiler::AsBool(const stripe::Intrinsic& stmt) {
@@ -1449,7 +2123,7 @@ void Compiler::AsBool(const stripe::Intrinsic& stmt) {
   Scalar ret = Cast(scalars_[stmt.inputs[0]], DataType::BOOLEAN);
   assert(1 == stmt.outputs.size());
   scalars_[stmt.outputs[0]] = ret;
-  ret.value->setName(stmt.outputs[0]);
+  ret.value->setName(stmt.outputs[0].str());
 }
 
 void Compiler::BitRight(const stripe::Intrinsic& stmt) {
@@ -1574,7 +2248,7 @@ void Compiler::AggInitAdd(const stripe::Special& agg_init) {
   Buffer dest = buffers_[agg_init.outputs[0]];
   auto& dest_shape = dest.refinement->interior_shape;
   size_t bits = bit_width(dest_shape.type);
-  llvm::Type* eltype = CType(dest_shape.type);
+  llvm::Type* eltype = CType(ComputeType(dest_shape.type));
   llvm::Value* init_val = nullptr;
   if (is_float(dest_shape.type)) {
     init_val = llvm::ConstantFP::get(eltype, 0.0);
@@ -1594,7 +2268,7 @@ void Compiler::AggInitMul(const stripe::Special& agg_init) {
   Buffer dest = buffers_[agg_init.outputs[0]];
   auto& dest_shape = dest.refinement->interior_shape;
   size_t bits = bit_width(dest_shape.type);
-  llvm::Type* eltype = CType(dest_shape.type);
+  llvm::Type* eltype = CType(ComputeType(dest_shape.type));
   llvm::Value* init_val = nullptr;
   if (is_float(dest_shape.type)) {
     init_val = llvm::ConstantFP::get(eltype, 1.0);
@@ -1614,7 +2288,7 @@ void Compiler::AggInitMin(const stripe::Special& agg_init) {
   Buffer dest = buffers_[agg_init.outputs[0]];
   auto& dest_shape = dest.refinement->interior_shape;
   size_t bits = bit_width(dest_shape.type);
-  llvm::Type* eltype = CType(dest_shape.type);
+  llvm::Type* eltype = CType(ComputeType(dest_shape.type));
   llvm::Value* init_val = nullptr;
   if (is_float(dest_shape.type)) {
     init_val = llvm::ConstantFP::getInfinity(eltype, /*Negative*/ false);
@@ -1637,7 +2311,7 @@ void Compiler::AggInitMax(const stripe::Special& agg_init) {
   Buffer dest = buffers_[agg_init.outputs[0]];
   auto& dest_shape = dest.refinement->interior_shape;
   size_t bits = bit_width(dest_shape.type);
-  llvm::Type* eltype = CType(dest_shape.type);
+  llvm::Type* eltype = CType(ComputeType(dest_shape.type));
   llvm::Value* init_val = nullptr;
   if (is_float(dest_shape.type)) {
     init_val = llvm::ConstantFP::getInfinity(eltype, /*Negative*/ true);
@@ -1683,6 +2357,9 @@ void Compiler::AggInit(const Buffer& dest, llvm::Value* init_val) {
   if (!init_val) {
     throw Error("Undefined agg_op init for " + to_string(dest_shape.type));
   }
+  if (dest_shape.type == DataType::BFLOAT16) {
+    init_val = FloatToBF16(init_val);
+  }
 
   // Compute the element offset for these indexes.
   llvm::Value* dest_idx = IndexConst(0);
@@ -1701,16 +2378,32 @@ void Compiler::AggInit(const Buffer& dest, llvm::Value* init_val) {
   }
 }
 
-void Compiler::ParallelFor(llvm::Value* refs, llvm::Value* idxs, size_t range, llvm::Function* block) {
+void Compiler::ParallelFor(llvm::Value* refs, llvm::Value* idxs, size_t range, size_t grain,
+                           ParallelSchedule schedule, llvm::Function* block) {
   llvm::Type* ptrArrayType = builder_.getInt8Ty()->getPointerTo()->getPointerTo();
   llvm::Type* idxArrayType = IndexType()->getPointerTo();
   std::vector<llvm::Type*> blockArgTypes{ptrArrayType, idxArrayType, IndexType(), IndexType()};
   llvm::Type* blockType = llvm::FunctionType::get(builder_.getVoidTy(), blockArgTypes, false);
   llvm::Type* blockPtrType = blockType->getPointerTo();
-  std::vector<llvm::Type*> fnArgTypes{ptrArrayType, idxArrayType, IndexType(), blockPtrType};
+  std::vector<llvm::Type*> fnArgTypes{ptrArrayType, idxArrayType, IndexType(), IndexType(), builder_.getInt8PtrTy(),
+                                      blockPtrType};
   auto fnType = llvm::FunctionType::get(builder_.getVoidTy(), fnArgTypes, false);
   auto fn = module_->getOrInsertFunction("ParallelFor", fnType).getCallee();
-  std::vector<llvm::Value*> argvals{refs, idxs, IndexConst(range), block};
+  // A statically scheduled loop replays its chunk-to-worker mapping through its own slot in the executable's
+  // partitioner table; a dynamically scheduled one passes no partitioner.
+  llvm::Value* partitioner = llvm::Constant::getNullValue(builder_.getInt8PtrTy());
+  if (schedule == ParallelSchedule::Static) {
+    auto slot = (*parallel_blocks_)++;
+    auto tabletype = builder_.getInt8PtrTy()->getPointerTo();
+    module_->getOrInsertGlobal(partitioners_name_, tabletype);
+    auto gval = module_->getNamedGlobal(partitioners_name_);
+    if (!gval->hasInitializer()) {
+      gval->setInitializer(llvm::Constant::getNullValue(tabletype));
+    }
+    llvm::Value* table = builder_.CreateLoad(gval);
+    partitioner = builder_.CreateLoad(builder_.CreateConstGEP1_64(table, slot));
+  }
+  std::vector<llvm::Value*> argvals{refs, idxs, IndexConst(range), IndexConst(grain), partitioner, block};
   builder_.CreateCall(fn, argvals, "");
 }
 
@@ -1906,6 +2599,257 @@ void Compiler::Gather(const stripe::Special& gather) {
   }
 }
 
+void Compiler::Scan(const stripe::Special& scan) {
+  // One input and one output, of the same shape. Along the "axis" dimension,
+  // each output element combines its input element into the output element
+  // before it (after it, for "reverse"), as "agg_op" specifies. The rows along
+  // the axis are independent: each is one sequential pass, and the rows are
+  // divided among threads. When there are too few rows to occupy the threads,
+  // long rows are scanned in blocks instead; see ScanBlocked.
+  assert(1 == scan.inputs.size());
+  Buffer src = buffers_[scan.inputs[0]];
+  assert(1 == scan.outputs.size());
+  Buffer dest = buffers_[scan.outputs[0]];
+  auto& dest_shape = dest.refinement->interior_shape;
+  size_t axis = scan.int_params.at("axis");
+  uint64_t size = dest_shape.dims[axis].size;
+  size_t rows = 1;
+  for (size_t i = 0; i < dest_shape.dims.size(); ++i) {
+    if (i != axis) {
+      rows *= dest_shape.dims[i].size;
+    }
+  }
+  if (rows < std::max(1u, std::thread::hardware_concurrency()) && size >= 2 * kParallelChunkWork) {
+    ScanBlocked(scan, rows, kParallelChunkWork);
+    return;
+  }
+  if (rows == 1) {
+    ScanRows(scan, src.base, dest.base, IndexConst(0), IndexConst(1));
+    return;
+  }
+  size_t grain = std::max<uint64_t>(1, kParallelChunkWork / size);
+  ScanParallel(scan, "scan_" + scan.outputs[0], rows, grain,
+               [&](llvm::Value* src_base, llvm::Value* dest_base, llvm::Value* begin, llvm::Value* end) {
+                 ScanRows(scan, src_base, dest_base, begin, end);
+               });
+}
+
+void Compiler::ScanBlocked(const stripe::Special& scan, size_t rows, uint64_t block_size) {
+  // A two-pass scan. Each row is cut into blocks of block_size positions, and
+  // every block of every row is scanned in parallel as though it began the
+  // row. A serial carry pass then folds each block's last element into the
+  // next block's last element, so that the last element of each block holds
+  // the scan of the row up to it. Finally, every other element of each block
+  // after the first folds in the last element of the block before it, again
+  // in parallel. This reads the output once more than a sequential scan, so it
+  // only pays off when the rows alone cannot keep the threads busy.
+  Buffer dest = buffers_[scan.outputs[0]];
+  size_t axis = scan.int_params.at("axis");
+  uint64_t size = dest.refinement->interior_shape.dims[axis].size;
+  uint64_t blocks = (size + block_size - 1) / block_size;
+  auto block_end = [&](llvm::Value* block) {
+    llvm::Value* end = builder_.CreateMul(builder_.CreateAdd(block, IndexConst(1)), IndexConst(block_size));
+    return builder_.CreateSelect(builder_.CreateICmpULT(end, IndexConst(size)), end, IndexConst(size));
+  };
+
+  // Scan each block on its own.
+  ScanParallel(scan, "scan_" + scan.outputs[0] + "_blocks", rows * blocks, 1,
+               [&](llvm::Value* src_base, llvm::Value* dest_base, llvm::Value* begin, llvm::Value* end) {
+                 llvm::Value* task_var = IndexVariable("task");
+                 Loop task_loop;
+                 CreateLoop(&task_loop, "task");
+                 EnterLoop(&task_loop, task_var, begin, end);
+                 llvm::Value* task = builder_.CreateLoad(task_var);
+                 llvm::Value* block = builder_.CreateURem(task, IndexConst(blocks));
+                 auto offsets = ScanRowOffsets(scan, builder_.CreateUDiv(task, IndexConst(blocks)));
+                 ScanRange(scan, src_base, dest_base, offsets.first, offsets.second,
+                           builder_.CreateMul(block, IndexConst(block_size)), block_end(block));
+                 LeaveLoop(&task_loop, task_var);
+               });
+
+  // Carry the running result from the end of each block to the end of the next.
+  llvm::Value* row_var = IndexVariable("carry_row");
+  llvm::Value* block_var = IndexVariable("carry_block");
+  Loop row_loop;
+  CreateLoop(&row_loop, "carry_row");
+  EnterLoop(&row_loop, row_var, IndexConst(0), IndexConst(rows));
+  llvm::Value* dest_row = ScanRowOffsets(scan, builder_.CreateLoad(row_var)).second;
+  Loop block_loop;
+  CreateLoop(&block_loop, "carry_block");
+  EnterLoop(&block_loop, block_var, IndexConst(1), IndexConst(blocks));
+  llvm::Value* block = builder_.CreateLoad(block_var);
+  llvm::Value* last = builder_.CreateSub(block_end(block), IndexConst(1));
+  llvm::Value* carry_pos = builder_.CreateSub(builder_.CreateMul(block, IndexConst(block_size)), IndexConst(1));
+  ScanCarry(scan, dest.base, dest_row, carry_pos, last, builder_.CreateAdd(last, IndexConst(1)));
+  LeaveLoop(&block_loop, block_var);
+  LeaveLoop(&row_loop, row_var);
+
+  // Fold the carry into the rest of every block but the first.
+  ScanParallel(scan, "scan_" + scan.outputs[0] + "_carry", rows * (blocks - 1), 1,
+               [&](llvm::Value* src_base, llvm::Value* dest_base, llvm::Value* begin, llvm::Value* end) {
+                 llvm::Value* task_var = IndexVariable("task");
+                 Loop task_loop;
+                 CreateLoop(&task_loop, "task");
+                 EnterLoop(&task_loop, task_var, begin, end);
+                 llvm::Value* task = builder_.CreateLoad(task_var);
+                 llvm::Value* block = builder_.CreateURem(task, IndexConst(blocks - 1));
+                 block = builder_.CreateAdd(block, IndexConst(1));
+                 auto offsets = ScanRowOffsets(scan, builder_.CreateUDiv(task, IndexConst(blocks - 1)));
+                 llvm::Value* start = builder_.CreateMul(block, IndexConst(block_size));
+                 ScanCarry(scan, dest_base, offsets.second, builder_.CreateSub(start, IndexConst(1)), start,
+                           builder_.CreateSub(block_end(block), IndexConst(1)));
+                 LeaveLoop(&task_loop, task_var);
+               });
+}
+
+void Compiler::ScanParallel(
+    const stripe::Special& scan, const std::string& name, size_t range, size_t grain,
+    const std::function<void(llvm::Value* src_base, llvm::Value* dest_base, llvm::Value* begin, llvm::Value* end)>&
+        body) {
+  // Build a function of the cpu_thread_block type whose body covers a range of
+  // iterations.
+  Buffer src = buffers_[scan.inputs[0]];
+  Buffer dest = buffers_[scan.outputs[0]];
+  auto int8PtrType = builder_.getInt8Ty()->getPointerTo();
+  std::vector<llvm::Type*> param_types{int8PtrType->getPointerTo(), IndexType()->getPointerTo(), IndexType(),
+                                       IndexType()};
+  auto func_type = llvm::FunctionType::get(builder_.getVoidTy(), param_types, false);
+  auto linkage = llvm::Function::ExternalLinkage;
+  auto function = llvm::Function::Create(func_type, linkage, name, module_);
+  auto saved_ip = builder_.saveIP();
+  builder_.SetInsertPoint(llvm::BasicBlock::Create(context_, "entry", function));
+  llvm::Value* refsArray = function->getArg(0);
+  llvm::Value* src_base = builder_.CreateLoad(builder_.CreateConstGEP1_32(refsArray, 0));
+  src_base = builder_.CreateBitCast(src_base, src.base->getType());
+  llvm::Value* dest_base = builder_.CreateLoad(builder_.CreateConstGEP1_32(refsArray, 1));
+  dest_base = builder_.CreateBitCast(dest_base, dest.base->getType());
+  body(src_base, dest_base, function->getArg(2), function->getArg(3));
+  builder_.CreateRetVoid();
+  builder_.restoreIP(saved_ip);
+
+  // Pass it the two buffers, and no index inits.
+  auto int8PtrArrayType = llvm::ArrayType::get(int8PtrType, 2);
+  llvm::Value* bufsArg = builder_.CreateAlloca(int8PtrArrayType);
+  bufsArg = builder_.CreateBitCast(bufsArg, int8PtrType->getPointerTo());
+  builder_.CreateStore(builder_.CreateBitCast(src.base, int8PtrType), builder_.CreateConstGEP1_32(bufsArg, 0));
+  builder_.CreateStore(builder_.CreateBitCast(dest.base, int8PtrType), builder_.CreateConstGEP1_32(bufsArg, 1));
+  llvm::Value* initsArg = llvm::ConstantPointerNull::get(IndexType()->getPointerTo());
+  ParallelFor(bufsArg, initsArg, range, grain, ParallelSchedule::Static, function);
+}
+
+llvm::Value* Compiler::IndexVariable(const std::string& name) {
+  // Like StackBuffer, the variable lives in the entry block so that loops nested in other loops reuse it.
+  auto function = builder_.GetInsertBlock()->getParent();
+  llvm::IRBuilder<> entry(&function->getEntryBlock(), function->getEntryBlock().begin());
+  return entry.CreateAlloca(IndexType(), nullptr, name);
+}
+
+void Compiler::ScanRows(const stripe::Special& scan, llvm::Value* src_base, llvm::Value* dest_base,
+                        llvm::Value* row_begin, llvm::Value* row_end) {
+  size_t axis = scan.int_params.at("axis");
+  int64_t size = buffers_[scan.outputs[0]].refinement->interior_shape.dims[axis].size;
+  llvm::Value* row_var = IndexVariable("row");
+  Loop row_loop;
+  CreateLoop(&row_loop, "row");
+  EnterLoop(&row_loop, row_var, row_begin, row_end);
+  auto offsets = ScanRowOffsets(scan, builder_.CreateLoad(row_var));
+  ScanRange(scan, src_base, dest_base, offsets.first, offsets.second, IndexConst(0), IndexConst(size));
+  LeaveLoop(&row_loop, row_var);
+}
+
+std::pair<llvm::Value*, llvm::Value*> Compiler::ScanRowOffsets(const stripe::Special& scan, llvm::Value* row) {
+  // Decompose the row number into an index per dimension other than the axis;
+  // the last varies fastest.
+  auto& src_shape = buffers_[scan.inputs[0]].refinement->interior_shape;
+  auto& dest_shape = buffers_[scan.outputs[0]].refinement->interior_shape;
+  size_t ndims = dest_shape.dims.size();
+  assert(ndims == src_shape.dims.size());
+  size_t axis = scan.int_params.at("axis");
+  llvm::Value* src_row = IndexConst(0);
+  llvm::Value* dest_row = IndexConst(0);
+  for (size_t i = ndims; i-- > 0;) {
+    if (i == axis) {
+      continue;
+    }
+    llvm::Value* idx_val = builder_.CreateURem(row, IndexConst(dest_shape.dims[i].size));
+    row = builder_.CreateUDiv(row, IndexConst(dest_shape.dims[i].size));
+    src_row = builder_.CreateAdd(src_row, builder_.CreateMul(idx_val, IndexConst(src_shape.dims[i].stride)));
+    dest_row = builder_.CreateAdd(dest_row, builder_.CreateMul(idx_val, IndexConst(dest_shape.dims[i].stride)));
+  }
+  return std::make_pair(src_row, dest_row);
+}
+
+llvm::Value* Compiler::ScanElement(const stripe::Special& scan, const TensorShape& shape, llvm::Value* row,
+                                   llvm::Value* pos) {
+  // Positions count along the direction of the scan: a reverse scan walks the
+  // axis backward.
+  size_t axis = scan.int_params.at("axis");
+  bool reverse = scan.int_params.at("reverse");
+  int64_t size = shape.dims[axis].size;
+  llvm::Value* idx_val = reverse ? builder_.CreateSub(IndexConst(size - 1), pos) : pos;
+  return builder_.CreateAdd(row, builder_.CreateMul(idx_val, IndexConst(shape.dims[axis].stride)));
+}
+
+void Compiler::ScanRange(const stripe::Special& scan, llvm::Value* src_base, llvm::Value* dest_base,
+                         llvm::Value* src_row, llvm::Value* dest_row, llvm::Value* pos_begin, llvm::Value* pos_end) {
+  auto& src_shape = buffers_[scan.inputs[0]].refinement->interior_shape;
+  auto& dest_shape = buffers_[scan.outputs[0]].refinement->interior_shape;
+  const auto& agg_op = scan.str_params.at("agg_op");
+  llvm::Value* pos_var = IndexVariable("pos");
+  Loop pos_loop;
+  CreateLoop(&pos_loop, "pos");
+  EnterLoop(&pos_loop, pos_var, pos_begin, pos_end);
+
+  // Body: locate the elements.
+  llvm::Value* pos = builder_.CreateLoad(pos_var);
+  llvm::Value* first = builder_.CreateICmpEQ(pos, pos_begin);
+  llvm::Value* src_idx = ScanElement(scan, src_shape, src_row, pos);
+  llvm::Value* dest_idx = ScanElement(scan, dest_shape, dest_row, pos);
+  llvm::Value* value = builder_.CreateLoad(builder_.CreateGEP(src_base, src_idx));
+  if (src_shape.type == DataType::BFLOAT16) {
+    value = BF16ToFloat(value);
+  }
+  Scalar in = Cast(Scalar{value, ComputeType(src_shape.type)}, dest_shape.type);
+
+  // The first element of the range has no predecessor; it reads itself, and
+  // discards the result.
+  llvm::Value* prev_pos = builder_.CreateSelect(first, pos, builder_.CreateSub(pos, IndexConst(1)));
+  llvm::Value* prev_idx = ScanElement(scan, dest_shape, dest_row, prev_pos);
+  llvm::Value* prev = builder_.CreateLoad(builder_.CreateGEP(dest_base, prev_idx));
+  bool bf16 = dest_shape.type == DataType::BFLOAT16;
+  llvm::Value* result = Aggregate(agg_op, in.type, bf16 ? BF16ToFloat(prev) : prev, in.value);
+  result = builder_.CreateSelect(first, in.value, result);
+  if (bf16) {
+    result = FloatToBF16(result);
+  }
+  builder_.CreateStore(result, builder_.CreateGEP(dest_base, dest_idx));
+
+  LeaveLoop(&pos_loop, pos_var);
+}
+
+void Compiler::ScanCarry(const stripe::Special& scan, llvm::Value* dest_base, llvm::Value* dest_row,
+                         llvm::Value* carry_pos, llvm::Value* pos_begin, llvm::Value* pos_end) {
+  auto& dest_shape = buffers_[scan.outputs[0]].refinement->interior_shape;
+  const auto& agg_op = scan.str_params.at("agg_op");
+  bool bf16 = dest_shape.type == DataType::BFLOAT16;
+  DataType type = ComputeType(dest_shape.type);
+  llvm::Value* carry_idx = ScanElement(scan, dest_shape, dest_row, carry_pos);
+  llvm::Value* carry = builder_.CreateLoad(builder_.CreateGEP(dest_base, carry_idx));
+  if (bf16) {
+    carry = BF16ToFloat(carry);
+  }
+  llvm::Value* pos_var = IndexVariable("carry_pos");
+  Loop pos_loop;
+  CreateLoop(&pos_loop, "carry_pos");
+  EnterLoop(&pos_loop, pos_var, pos_begin, pos_end);
+  llvm::Value* dest_idx = ScanElement(scan, dest_shape, dest_row, builder_.CreateLoad(pos_var));
+  llvm::Value* element = builder_.CreateGEP(dest_base, dest_idx);
+  llvm::Value* value = builder_.CreateLoad(element);
+  llvm::Value* result = Aggregate(agg_op, type, carry, bf16 ? BF16ToFloat(value) : value);
+  builder_.CreateStore(bf16 ? FloatToBF16(result) : result, element);
+  LeaveLoop(&pos_loop, pos_var);
+}
+
 void Compiler::CreateLoop(Loop* loop, std::string name) {
   llvm::Function* func = builder_.GetInsertBlock()->getParent();
   loop->init = llvm::BasicBlock::Create(context_, "init_" + name, func);
@@ -1926,19 +2870,23 @@ void Compiler::EnterLoop(Loop* loop, llvm::Value* variable, llvm::Value* init, l
   builder_.SetInsertPoint(loop->body);
 }
 
-void Compiler::LeaveLoop(Loop* loop, llvm::Value* variable) {
+void Compiler::LeaveLoop(Loop* loop, llvm::Value* variable, size_t step) {
   llvm::Value* index = builder_.CreateLoad(variable);
-  index = builder_.CreateAdd(index, IndexConst(1));
+  index = builder_.CreateAdd(index, IndexConst(step));
   builder_.CreateStore(index, variable);
   builder_.CreateBr(loop->test);
   builder_.SetInsertPoint(loop->done);
 }
 
 Compiler::Scalar Compiler::Cast(Scalar v, DataType to_type) {
+  to_type = ComputeType(to_type);
   if (v.type == to_type) {
     return v;
   }
   llvm::Type* to_llvmtype = CType(to_type);
+  if (auto vec_type = llvm::dyn_cast<llvm::VectorType>(v.value->getType())) {
+    to_llvmtype = llvm::VectorType::get(to_llvmtype, vec_type->getNumElements());
+  }
   bool from_signed = is_int(v.type) || is_float(v.type);
   bool to_signed = is_int(to_type) || is_float(to_type);
   auto op = llvm::CastInst::getCastOpcode(v.value, from_signed, to_llvmtype, to_signed);
@@ -1946,6 +2894,25 @@ Compiler::Scalar Compiler::Cast(Scalar v, DataType to_type) {
   return Scalar{ret, to_type};
 }
 
+llvm::Value* Compiler::BF16ToFloat(llvm::Value* value) {
+  // A bfloat16 is the upper half of the float32 with the same value.
+  auto widened = builder_.CreateZExt(value, SameShape(value->getType(), builder_.getInt32Ty()));
+  auto bits = builder_.CreateShl(widened, 16);
+  return builder_.CreateBitCast(bits, SameShape(value->getType(), builder_.getFloatTy()));
+}
+
+llvm::Value* Compiler::FloatToBF16(llvm::Value* value) {
+  // Truncates a float32 to its upper half, rounding to nearest even; NaNs stay quiet NaNs.
+  auto int_type = SameShape(value->getType(), builder_.getInt32Ty());
+  auto bits = builder_.CreateBitCast(value, int_type);
+  auto lsb = builder_.CreateAnd(builder_.CreateLShr(bits, 16), llvm::ConstantInt::get(int_type, 1));
+  auto bias = builder_.CreateAdd(lsb, llvm::ConstantInt::get(int_type, 0x7fff));
+  auto rounded = builder_.CreateLShr(builder_.CreateAdd(bits, bias), 16);
+  auto nan = builder_.CreateFCmpUNO(value, value);
+  auto result = builder_.CreateSelect(nan, llvm::ConstantInt::get(int_type, 0x7fc0), rounded);
+  return builder_.CreateTrunc(result, SameShape(value->getType(), builder_.getInt16Ty()));
+}
+
 Compiler::Scalar Compiler::CheckNotFloat(Scalar v) {
   if (is_float(v.type) || v.type == DataType::INVALID) {
     throw Error("Expected non-float, actually found " + to_string(v.type));
@@ -1971,6 +2938,8 @@ llvm::Type* Compiler::CType(DataType type) {
       return builder_.getInt64Ty();
     case DataType::FLOAT16:
       return builder_.getHalfTy();
+    case DataType::BFLOAT16:
+      return builder_.getInt16Ty();
     case DataType::FLOAT32:
       return builder_.getFloatTy();
     case DataType::FLOAT64:
@@ -2009,14 +2978,14 @@ llvm::Value* Compiler::Eval(const stripe::Affine& access) {
 
 void Compiler::OutputType(llvm::Value* ret, const stripe::Intrinsic& intrinsic) {
   assert(1 == intrinsic.outputs.size());
-  scalars_[intrinsic.outputs[0]] = Scalar{ret, intrinsic.type};
-  ret->setName(intrinsic.outputs[0]);
+  scalars_[intrinsic.outputs[0]] = Scalar{ret, ComputeType(intrinsic.type)};
+  ret->setName(intrinsic.outputs[0].str());
 }
 
 void Compiler::OutputBool(llvm::Value* ret, const stripe::Intrinsic& intrinsic) {
   assert(1 == intrinsic.outputs.size());
   scalars_[intrinsic.outputs[0]] = Scalar{ret, DataType::BOOLEAN};
-  ret->setName(intrinsic.outputs[0]);
+  ret->setName(intrinsic.outputs[0].str());
 }
 
 void Compiler::CallIntrinsicFunc(const stripe::Intrinsic& stmt, const char* name_f32, const char* name_f64,
@@ -2051,8 +3020,8 @@ void Compiler::CallIntrinsicFunc(const stripe::Intrinsic& stmt, const char* name
   }
 
   // C intrinsics come in either f32 or f64 flavors. We'll use f32 for single
-  // and half-precision float inputs, f64 for ints and doubles
-  bool use_f32 = (stmt.type == DataType::FLOAT16 || stmt.type == DataType::FLOAT32);
+  // and half-precision (including bfloat16) float inputs, f64 for ints and doubles
+  bool use_f32 = (stmt.type == DataType::FLOAT16 || ComputeType(stmt.type) == DataType::FLOAT32);
   const char* name = use_f32 ? name_f32 : name_f64;
   llvm::Type* ctype = use_f32 ? builder_.getFloatTy() : builder_.getDoubleTy();
   std::vector<llvm::Type*> argtypes;
@@ -2062,6 +3031,22 @@ void Compiler::CallIntrinsicFunc(const stripe::Intrinsic& stmt, const char* name
   }
   auto functype = llvm::FunctionType::get(ctype, argtypes, false);
   auto func = module_->getOrInsertFunction(name, functype).getCallee();
+  if (lanes_) {
+    // Prefer a vectorized implementation; otherwise, call the scalar function once per lane.
+    llvm::Value* ret = EmitVectorMath(&builder_, module_, name, argvals);
+    if (!ret) {
+      ret = llvm::UndefValue::get(argvals[0]->getType());
+      for (size_t i = 0; i < lanes_; ++i) {
+        std::vector<llvm::Value*> lane_args;
+        for (auto arg : argvals) {
+          lane_args.push_back(builder_.CreateExtractElement(arg, i));
+        }
+        ret = builder_.CreateInsertElement(ret, builder_.CreateCall(func, lane_args), i);
+      }
+    }
+    OutputType(ret, stmt);
+    return;
+  }
   llvm::Value* ret = builder_.CreateCall(func, argvals, "");
   OutputType(ret, stmt);
 }
@@ -2090,9 +3075,12 @@ llvm::FunctionType* Compiler::BlockType(const stripe::Block& block) {
     for (size_t i = 0; i < block.idxs.size(); ++i) {
       param_types.push_back(IndexType());
     }
+    // The last parameter is the base address of the arena.
+    param_types.push_back(builder_.getInt8PtrTy());
   } else {
     // This block function will be executed via ParallelFor.
-    // First parameter is a pointer to an array of refinement base addresses.
+    // First parameter is a pointer to an array of refinement base addresses,
+    // followed by the base address of the arena.
     // Since all block functions must have the same type signature, we will
     // define this as int8_t** instead and bitcast whenever we use it.
     auto int8PtrType = builder_.getInt8Ty()->getPointerTo();
@@ -2108,32 +3096,6 @@ llvm::FunctionType* Compiler::BlockType(const stripe::Block& block) {
   return llvm::FunctionType::get(return_type, param_types, false);
 }
 
-llvm::Value* Compiler::XSMMDispatchFunction(llvm::Type* alphaPtrType, llvm::Type* betaPtrType, llvm::Type* aPtrType,
-                                            llvm::Type* bPtrType, llvm::Type* cPtrType,
-                                            const std::string& functionName) {
-  llvm::Type* iptr = llvm::Type::getInt32PtrTy(context_);
-  std::vector<llvm::Type*> param_types{
-      aPtrType,  // a
-      bPtrType,  // b
-      cPtrType,  // c
-  };
-  llvm::FunctionType* rftype = llvm::FunctionType::get(builder_.getVoidTy(), param_types, false);
-  std::vector<llvm::Type*> argtypes{
-      builder_.getInt32Ty(),  // m
-      builder_.getInt32Ty(),  // n
-      builder_.getInt32Ty(),  // k
-      iptr,                   // lda
-      iptr,                   // ldb
-      iptr,                   // ldc
-      alphaPtrType,           // alpha
-      betaPtrType,            // beta
-      iptr,                   // flags
-      iptr,                   // prefetch
-  };
-  auto functype = llvm::FunctionType::get(rftype->getPointerTo(), argtypes, false);
-  return module_->getOrInsertFunction(functionName.c_str(), functype).getCallee();
-}
-
 llvm::Value* Compiler::Malloc(size_t size) {
   std::vector<llvm::Type*> argtypes{IndexType()
   // MacOS RT doesn't have the align_alloc function and the allocations
@@ -2167,6 +3129,18 @@ llvm::Value* Compiler::Malloc(size_t size) {
   return buffer;
 }  // namespace cpu
 
+llvm::Value* Compiler::ArenaAcquireFunction() {
+  auto voidptr = builder_.getInt8PtrTy();
+  auto functype = llvm::FunctionType::get(voidptr, {voidptr, IndexType()}, false);
+  return module_->getOrInsertFunction("ArenaAcquire", functype).getCallee();
+}
+
+llvm::Value* Compiler::ArenaReleaseFunction() {
+  auto voidptr = builder_.getInt8PtrTy();
+  auto functype = llvm::FunctionType::get(builder_.getVoidTy(), {voidptr, voidptr}, false);
+  return module_->getOrInsertFunction("ArenaRelease", functype).getCallee();
+}
+
 llvm::Value* Compiler::RunTimeLogEntry(void) {
   std::vector<llvm::Type*> argtypes{
       builder_.getInt8Ty()->getPointerTo(),
@@ -8,29 +8,24 @@
 
 #include <algorithm>
 #include <deque>
+#include <functional>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "tile/stripe/stripe.h"
 #include "tile/targets/cpu/config.h"
 #include "tile/targets/cpu/programmodule.h"
+#include "tile/targets/cpu/schedule.h"
 
 namespace vertexai {
 namespace tile {
 namespace targets {
 namespace cpu {
 
-enum class XSMMDispatch : int {
-  NONE = 0,  // No XSMM dispatch function to call.
-  SMM = 1,   // singe float
-  DMM = 2,   // double float
-  WIMM = 3,  // int8, uint8 ---> int
-  BSMM = 4,  // TODO: Need Stripe support for bfloat16.
-  BMMM = 5,  // TODO: Need Stripe support for bfloat16.
-};
-
 // What block we are compiling.
 enum CompileFor {
   NORMAL_BLOCK,
@@ -63,9 +58,11 @@ class Compiler : private stripe::ConstStmtVisitor {
   explicit Compiler(llvm::LLVMContext* context, llvm::Module* module, const Config& config);
   void GenerateInvoker(const stripe::Block& program, llvm::Function* main);
   uint64_t MeasureArena(const stripe::Block& block);
-  void GenerateArena(const stripe::Block& block);
+  void PlanArena(const stripe::Block& program);
   llvm::Function* CompileXSMMBlock(const stripe::Block& block, const XSMMDispatch xsmmDispatch,
                                    const XSMMCallData& xsmmCallData);
+  bool XSMMNest(const stripe::Block& block, std::set<std::string>* batch_idxs);
+  void CompileXSMMNest(const stripe::Block& block, const std::set<std::string>& batch_idxs);
   llvm::Function* CompileThreadedBlock(const stripe::Block& block);
   llvm::Function* CompileBlock(const stripe::Block& block);
   void Visit(const stripe::Load&) override;
@@ -127,6 +124,30 @@ class Compiler : private stripe::ConstStmtVisitor {
   void AggInitMax(const stripe::Special&);
   void Scatter(const stripe::Special&);
   void Gather(const stripe::Special&);
+  void Scan(const stripe::Special&);
+  // Scans long rows of a scan special in blocks of block_size positions, in parallel.
+  void ScanBlocked(const stripe::Special& scan, size_t rows, uint64_t block_size);
+  // Builds a cpu_thread_block function over a scan special's input and output whose body covers iterations
+  // [begin, end), and runs it over [0, range) in parallel.
+  void ScanParallel(
+      const stripe::Special& scan, const std::string& name, size_t range, size_t grain,
+      const std::function<void(llvm::Value* src_base, llvm::Value* dest_base, llvm::Value* begin, llvm::Value* end)>&
+          body);
+  // Scans rows [row_begin, row_end) of a scan special's input into its output.
+  void ScanRows(const stripe::Special& scan, llvm::Value* src_base, llvm::Value* dest_base, llvm::Value* row_begin,
+                llvm::Value* row_end);
+  // Returns the offsets of the start of a row in a scan special's input and output.
+  std::pair<llvm::Value*, llvm::Value*> ScanRowOffsets(const stripe::Special& scan, llvm::Value* row);
+  // Returns the offset of the element at position pos, counted in the direction of the scan, in a row of a buffer.
+  llvm::Value* ScanElement(const stripe::Special& scan, const TensorShape& shape, llvm::Value* row, llvm::Value* pos);
+  // Scans positions [pos_begin, pos_end) of a row, as though pos_begin were the first.
+  void ScanRange(const stripe::Special& scan, llvm::Value* src_base, llvm::Value* dest_base, llvm::Value* src_row,
+                 llvm::Value* dest_row, llvm::Value* pos_begin, llvm::Value* pos_end);
+  // Combines the output element at carry_pos into those at positions [pos_begin, pos_end) of a row.
+  void ScanCarry(const stripe::Special& scan, llvm::Value* dest_base, llvm::Value* dest_row, llvm::Value* carry_pos,
+                 llvm::Value* pos_begin, llvm::Value* pos_end);
+  // Allocates an index variable in the entry block of the function being built.
+  llvm::Value* IndexVariable(const std::string& name);
   void AsFloat(const stripe::Intrinsic&);
   void AsInt(const stripe::Intrinsic&);
   void AsUInt(const stripe::Intrinsic&);
@@ -148,6 +169,15 @@ class Compiler : private stripe::ConstStmtVisitor {
     llvm::Value* init = nullptr;
   };
 
+  // A temporary buffer planned into the arena, live across the [first, last] span of block visits.
+  struct ArenaAllocation {
+    const stripe::Refinement* ref = nullptr;
+    uint64_t size = 0;
+    uint64_t first = 0;
+    uint64_t last = 0;
+    uint64_t offset = 0;
+  };
+
   struct Loop {
     llvm::BasicBlock* init = nullptr;
     llvm::BasicBlock* test = nullptr;
@@ -158,8 +188,19 @@ class Compiler : private stripe::ConstStmtVisitor {
  private:
   void CreateLoop(Loop* loop, std::string name);
   void EnterLoop(Loop* loop, llvm::Value* variable, llvm::Value* init, llvm::Value* limit);
-  void LeaveLoop(Loop* loop, llvm::Value* variable);
+  void LeaveLoop(Loop* loop, llvm::Value* variable, size_t step = 1);
+  size_t VectorLanes(const stripe::Block& block);
+  void VectorLoop(const stripe::Block& block, size_t lanes);
+  llvm::Value* LaneMask(const stripe::Block& block, llvm::Value* active);
+  llvm::Value* VectorLoad(llvm::Value* element);
+  llvm::Value* VectorGather(llvm::Value* element);
+  void VectorStore(llvm::Value* value, llvm::Value* element);
+  llvm::Value* SafeDivisor(llvm::Value* divisor);
+  const stripe::Refinement* BaseRef(const std::string& name);
+  llvm::Value* Aggregate(const std::string& agg_op, DataType type, llvm::Value* prev, llvm::Value* value);
   Scalar Cast(Scalar, DataType);
+  llvm::Value* BF16ToFloat(llvm::Value* value);
+  llvm::Value* FloatToBF16(llvm::Value* value);
   Scalar CheckNotFloat(Scalar);
   llvm::Type* CType(DataType);
   llvm::Value* ElementPtr(const Buffer& buf);
@@ -171,9 +212,19 @@ class Compiler : private stripe::ConstStmtVisitor {
   llvm::Type* IndexType();
   llvm::Value* IndexConst(ssize_t val);
   llvm::FunctionType* BlockType(const stripe::Block&);
-  llvm::Value* XSMMDispatchFunction(llvm::Type* alphaPtrType, llvm::Type* betaPtrType, llvm::Type* aPtrType,
-                                    llvm::Type* bPtrType, llvm::Type* cPtrType, const std::string& funcionName);
+  void CollectArenaAllocations(const stripe::Block& block, bool parallel, uint64_t* clock,
+                               std::vector<ArenaAllocation>* allocs);
+  llvm::Value* ArenaBuffer(uint64_t offset);
+  llvm::Value* StackBuffer(uint64_t size);
+  XSMMKernel GetXSMMKernel(const stripe::Block& block, const XSMMDispatch xsmmDispatch,
+                           const XSMMCallData& xsmmCallData);
+  llvm::Value* XSMMKernelFunction(const XSMMKernel& kernel, llvm::FunctionType* type);
+  // Copies the A operand of a bfloat16 kernel into the VNNI layout libxsmm expects; returns the packed copy.  If the
+  // copy is on the heap, *heap is set to it, and the caller frees it once the kernel has run.
+  llvm::Value* PackVNNI(llvm::Value* a, const XSMMKernel& kernel, int32_t lda, llvm::Value** heap);
   llvm::Value* Malloc(size_t size);
+  llvm::Value* ArenaAcquireFunction();
+  llvm::Value* ArenaReleaseFunction();
   void Free(llvm::Value* buffer);
   llvm::Value* PrngStepFunction();
   llvm::Value* ReadCycleCounter();
@@ -187,7 +238,8 @@ class Compiler : private stripe::ConstStmtVisitor {
   void EmitRunTimeLogEntry(const std::string& str, const std::string& extra, llvm::Value* value = nullptr);
   void PrintOutputAssembly(llvm::TargetMachine* machine);
   void AggInit(const Buffer& dest, llvm::Value* init_val);
-  void ParallelFor(llvm::Value* refs, llvm::Value* idxs, size_t range, llvm::Function* func);
+  void ParallelFor(llvm::Value* refs, llvm::Value* idxs, size_t range, size_t grain, ParallelSchedule schedule,
+                   llvm::Function* func);
   CompileFor getCompileFor(const stripe::Block& block);
 
   // Gets the leading dimensions and the buffers for an XSMM call if available.
@@ -204,6 +256,24 @@ class Compiler : private stripe::ConstStmtVisitor {
   std::map<std::string, Buffer> buffers_;
   std::map<std::string, Index> indexes_;
   uint64_t arenaSize_ = 0;
+  // Arena offsets for local refinements which are not allocated by the placer, shared with nested compilers.
+  std::shared_ptr<const std::map<const stripe::Refinement*, uint64_t>> arena_offsets_;
+  // The base address of the current invocation's arena, passed to every block function.
+  llvm::Value* arena_ = nullptr;
+  // The libxsmm kernels called by the program, in the order of their slots in its kernel table; shared with nested
+  // compilers.
+  std::shared_ptr<std::vector<XSMMKernel>> xsmm_kernels_;
+  // The number of statically scheduled ParallelFor calls, which index the executable's partitioner table; shared with
+  // nested compilers.
+  std::shared_ptr<uint64_t> parallel_blocks_;
+  // For each refinement passed in from an enclosing block, the outermost refinement it is a view of (as with
+  // codegen's AliasInfo::base_ref); refinements which are not listed are their own base.
+  std::map<std::string, const stripe::Refinement*> bases_;
+  // While emitting a vector loop: the number of lanes, the index which advances across them, and the mask of active
+  // lanes (null when all are active).
+  size_t lanes_ = 0;
+  std::string vector_idx_;
+  llvm::Value* mask_ = nullptr;
 };
 
 }  // namespace cpu
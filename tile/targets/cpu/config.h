@@ -26,6 +26,10 @@ struct Config {
   bool print_llvm_ir_simple = VLOG_IS_ON(3);
   bool print_llvm_ir_optimized = VLOG_IS_ON(4);
   bool print_assembly = VLOG_IS_ON(4);
+  // The width in bytes of the vector registers used when emitting explicit vector code for unit-stride innermost
+  // indexes.  Zero uses the widest registers the host CPU supports; a width too narrow for two lanes leaves every block
+  // to LLVM's auto-vectorizer.
+  size_t vector_bytes = 0;
   std::map<std::string, External> externals;
 };
 
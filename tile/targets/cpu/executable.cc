@@ -8,16 +8,29 @@
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/IR/Module.h>
+#include <llvm/Object/ObjectFile.h>
 #include <llvm/Support/DynamicLibrary.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/MemoryBuffer.h>
 #include <llvm/Support/ToolOutputFile.h>
 #include <llvm/Transforms/IPO/PassManagerBuilder.h>
 #include <llvm/Transforms/Utils/Cloning.h>
 
 #include <algorithm>
+#include <atomic>
 #include <deque>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <utility>
+#include <vector>
 
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif  // __linux__
+
+#include <boost/align/aligned_alloc.hpp>
 #include <half.hpp>
 
 #include "base/util/env.h"
@@ -51,7 +64,126 @@ class Runtime : public llvm::LegacyJITSymbolResolver {
   std::map<std::string, void*> externals_;
 };
 
-Executable::Executable(const ProgramModule& module) : parameters_(module.parameters) {
+// The partitioner of a statically scheduled parallel loop.  Each run of the loop replays the chunk-to-worker mapping
+// of the previous one, so each chunk keeps running on the core whose caches it last touched.  A partitioner must not
+// be used by two parallel_for calls at once; a run which finds it busy (the same program running concurrently, or the
+// loop nested in another parallel loop) balances its chunks without affinity instead.
+struct BlockPartitioner {
+  std::atomic_flag busy = ATOMIC_FLAG_INIT;
+  tbb::affinity_partitioner partitioner;
+};
+
+// Recycles the arenas holding a program's temporaries.  Each invocation acquires an arena on entry and releases it on
+// exit, so concurrent invocations of the same program never share one, while repeated invocations reuse memory rather
+// than returning to the system allocator.
+class ArenaPool {
+ public:
+  static constexpr size_t kAlignment = 64;
+
+  ~ArenaPool() {
+    for (auto arena : free_) {
+      boost::alignment::aligned_free(arena);
+    }
+  }
+
+  // Every arena in a pool is requested at the same size: that of its program.
+  void* Acquire(size_t size) {
+    {
+      std::lock_guard<std::mutex> lock{mu_};
+      if (!free_.empty()) {
+        auto arena = free_.back();
+        free_.pop_back();
+        return arena;
+      }
+    }
+    auto arena = boost::alignment::aligned_alloc(kAlignment, (size + kAlignment - 1) / kAlignment * kAlignment);
+    if (!arena) {
+      throw std::bad_alloc();
+    }
+    return arena;
+  }
+
+  void Release(void* arena) {
+    std::lock_guard<std::mutex> lock{mu_};
+    free_.push_back(arena);
+  }
+
+ private:
+  std::mutex mu_;
+  std::vector<void*> free_;
+};
+
+constexpr size_t ArenaPool::kAlignment;
+
+void* DispatchXSMMKernel(const XSMMKernel& kernel) {
+  libxsmm_blasint lda = kernel.lda;
+  libxsmm_blasint ldb = kernel.ldb;
+  libxsmm_blasint ldc = kernel.ldc;
+  int prefetch = kernel.prefetch ? LIBXSMM_GEMM_PREFETCH_AL2BL2_VIA_C : LIBXSMM_GEMM_PREFETCH_NONE;
+  void* func = nullptr;
+  switch (kernel.dispatch) {
+    case XSMMDispatch::SMM: {
+      float alpha = 1.0f;
+      float beta = 1.0f;
+      if (kernel.batch_reduce) {
+        func = reinterpret_cast<void*>(libxsmm_smmdispatch_reducebatch(kernel.m, kernel.n, kernel.k, &lda, &ldb, &ldc,
+                                                                       &alpha, &beta, nullptr, nullptr));
+      } else {
+        func = reinterpret_cast<void*>(
+            libxsmm_smmdispatch(kernel.m, kernel.n, kernel.k, &lda, &ldb, &ldc, &alpha, &beta, nullptr, &prefetch));
+      }
+    } break;
+    case XSMMDispatch::DMM: {
+      double alpha = 1.0;
+      double beta = 1.0;
+      func = reinterpret_cast<void*>(
+          libxsmm_dmmdispatch(kernel.m, kernel.n, kernel.k, &lda, &ldb, &ldc, &alpha, &beta, nullptr, &prefetch));
+    } break;
+    case XSMMDispatch::WIMM: {
+      int alpha = 1;
+      int beta = 1;
+      func = reinterpret_cast<void*>(
+          libxsmm_wimmdispatch(kernel.m, kernel.n, kernel.k, &lda, &ldb, &ldc, &alpha, &beta, nullptr, &prefetch));
+    } break;
+    case XSMMDispatch::BSMM: {
+      float alpha = 1.0f;
+      float beta = 1.0f;
+      func = reinterpret_cast<void*>(
+          libxsmm_bsmmdispatch(kernel.m, kernel.n, kernel.k, &lda, &ldb, &ldc, &alpha, &beta, nullptr, &prefetch));
+    } break;
+    case XSMMDispatch::BMMM: {
+      float alpha = 1.0f;
+      float beta = 1.0f;
+      func = reinterpret_cast<void*>(
+          libxsmm_bmmdispatch(kernel.m, kernel.n, kernel.k, &lda, &ldb, &ldc, &alpha, &beta, nullptr, &prefetch));
+    } break;
+    default:
+      break;
+  }
+  return func;
+}
+
+// Records the object code MCJIT emits for a module, so that it can be written
+// to the on-disk object cache and reloaded without recompiling.
+class Executable::ObjectCapture : public llvm::ObjectCache {
+ public:
+  void notifyObjectCompiled(const llvm::Module*, llvm::MemoryBufferRef obj) override {
+    object_ = obj.getBuffer().str();
+  }
+  std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module*) override { return nullptr; }
+  const std::string& object() const { return object_; }
+
+ private:
+  std::string object_;
+};
+
+Executable::Executable(const ProgramModule& module)
+    : capture_{new ObjectCapture},
+      arenas_{new ArenaPool},
+      parameters_(module.parameters),
+      arena_size_{module.arena_size},
+      xsmm_kernels_(module.xsmm_kernels),
+      parallel_blocks_{module.parallel_blocks} {
   std::string errStr;
   std::unique_ptr<llvm::LegacyJITSymbolResolver> rez(new Runtime(module.externals));
   assert(module.module);
@@ -66,28 +198,117 @@ Executable::Executable(const ProgramModule& module) : parameters_(module.paramet
     if (env::Get("VTUNE_PROFILE") == "1") {
       ee->RegisterJITEventListener(llvm::JITEventListener::createIntelJITEventListener());
     }
+    ee->setObjectCache(capture_.get());
     ee->finalizeObject();
     engine_.reset(ee);
+    ResolveEntry();
   } else {
     throw std::runtime_error("Failed to create ExecutionEngine: " + errStr);
   }
 }
 
-void Executable::Run(const std::map<std::string, void*>& buffers) {
-  std::vector<void*> args(parameters_.size());
-  for (size_t i = 0; i < args.size(); ++i) {
-    args[i] = safe_at(buffers, parameters_[i]);
+Executable::Executable(llvm::LLVMContext* context, const std::string& object,
+                       const std::vector<std::string>& parameters, uint64_t arena_size,
+                       const std::vector<XSMMKernel>& xsmm_kernels, uint64_t parallel_blocks)
+    : arenas_{new ArenaPool},
+      parameters_(parameters),
+      arena_size_{arena_size},
+      xsmm_kernels_(xsmm_kernels),
+      parallel_blocks_{parallel_blocks} {
+  // MCJIT requires a module to build an engine around; the actual code comes
+  // entirely from the cached object file.
+  auto module = std::make_unique<llvm::Module>("stripe", *context);
+  module->setTargetTriple(llvm::sys::getProcessTriple());
+  std::string errStr;
+  std::unique_ptr<llvm::LegacyJITSymbolResolver> rez(new Runtime({}));
+  auto ee = llvm::EngineBuilder(std::move(module))
+                .setErrorStr(&errStr)
+                .setEngineKind(llvm::EngineKind::JIT)
+                .setSymbolResolver(std::move(rez))
+                .create();
+  if (!ee) {
+    throw std::runtime_error("Failed to create ExecutionEngine: " + errStr);
+  }
+  engine_.reset(ee);
+  auto buffer = llvm::MemoryBuffer::getMemBufferCopy(object, "stripe.o");
+  auto obj = llvm::object::ObjectFile::createObjectFile(buffer->getMemBufferRef());
+  if (!obj) {
+    throw std::runtime_error("Invalid cached object code: " + llvm::toString(obj.takeError()));
+  }
+  engine_->addObjectFile(llvm::object::OwningBinary<llvm::object::ObjectFile>(std::move(*obj), std::move(buffer)));
+  if (env::Get("VTUNE_PROFILE") == "1") {
+    engine_->RegisterJITEventListener(llvm::JITEventListener::createIntelJITEventListener());
+  }
+  engine_->finalizeObject();
+  ResolveEntry();
+}
+
+Executable::~Executable() {}
+
+void Executable::ResolveEntry() {
+  entry_ = reinterpret_cast<void (*)(void**)>(engine_->getFunctionAddress(invoker_name_));
+  if (!entry_) {
+    throw std::runtime_error("Unable to resolve program entry point");
+  }
+  // Programs without temporaries have no arena, and so no pool reference.
+  auto pool_addr = engine_->getGlobalValueAddress(arena_pool_name_);
+  if (pool_addr) {
+    *reinterpret_cast<ArenaPool**>(pool_addr) = arenas_.get();
+  }
+  // Dispatch every kernel up front, so that the generated code never pays for a lookup (or for code generation) on
+  // the way to a GEMM.
+  xsmm_table_.clear();
+  for (const auto& kernel : xsmm_kernels_) {
+    // The compiler only calls kernels which dispatched on this machine, but cached object code may come from another.
+    void* func = DispatchXSMMKernel(kernel);
+    if (!func) {
+      throw std::runtime_error("Unable to dispatch XSMM kernel for m=" + std::to_string(kernel.m) +
+                               ", n=" + std::to_string(kernel.n) + ", k=" + std::to_string(kernel.k));
+    }
+    xsmm_table_.push_back(func);
+  }
+  auto table_addr = engine_->getGlobalValueAddress(xsmm_kernels_name_);
+  if (table_addr) {
+    *reinterpret_cast<void***>(table_addr) = xsmm_table_.data();
+  }
+  partitioners_.reset(new BlockPartitioner[parallel_blocks_]);
+  partitioner_table_.clear();
+  for (uint64_t i = 0; i < parallel_blocks_; ++i) {
+    partitioner_table_.push_back(&partitioners_[i]);
+  }
+  auto partitioners_addr = engine_->getGlobalValueAddress(partitioners_name_);
+  if (partitioners_addr) {
+    *reinterpret_cast<void***>(partitioners_addr) = partitioner_table_.data();
   }
-  void* argvec = args.data();
-  uint64_t entrypoint = engine_->getFunctionAddress(invoker_name_);
+}
+
+const std::string& Executable::object() const {
+  if (!capture_) {
+    throw std::runtime_error("Executable has no captured object code");
+  }
+  return capture_->object();
+}
+
+void Executable::Run(const std::map<std::string, void*>& buffers) {
+  auto args = Arguments(buffers);
   // To get the raw execution time for generated code.
   auto start = std::chrono::high_resolution_clock::now();
-  ((void (*)(void*))entrypoint)(argvec);
+  Run(args.data());
   auto stop = std::chrono::high_resolution_clock::now();
   auto diff = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
   IVLOG(1, "Total program execution duration: " << diff)
 }
 
+std::vector<void*> Executable::Arguments(const std::map<std::string, void*>& buffers) const {
+  std::vector<void*> args(parameters_.size());
+  for (size_t i = 0; i < args.size(); ++i) {
+    args[i] = safe_at(buffers, parameters_[i]);
+  }
+  return args;
+}
+
+void Executable::Run(void** args) const { entry_(args); }
+
 void Executable::SetPerfAttrs(stripe::Block* block) {
   // Look up the performance counters for this block.
   // Apply their values as tags.
@@ -139,13 +360,131 @@ void RunTimeLogEntry(char* str, char* extra, float address) {
   IVLOG(1, "RunTimeLogEntry: " << str << ":" << extra << ":" /* 0x" << std::hex */ << address);
 }
 
-typedef void (*libxsmm_function)(const void* a, const void* b, void* c);
-void XSMMRTCaller(libxsmm_function func, const void* aPtr, const void* bPtr, void* cPtr) { func(aPtr, bPtr, cPtr); }
+void* ArenaAcquire(void* pool, size_t size) { return static_cast<ArenaPool*>(pool)->Acquire(size); }
+void ArenaRelease(void* pool, void* arena) { static_cast<ArenaPool*>(pool)->Release(arena); }
+
+// The CPUs of the process's affinity mask, in order.  Empty where affinity is not supported.
+std::vector<int> AffinityCpus() {
+  std::vector<int> cpus;
+#if defined(__linux__)
+  cpu_set_t mask;
+  if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &mask)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+#endif  // __linux__
+  return cpus;
+}
+
+// Pins each thread which enters an arena to its own CPU for as long as it stays in the arena, so that static
+// schedules which replay their chunk assignment also keep the memory those chunks first touched on the local NUMA
+// node.  Threads get their full affinity mask back when they leave, so that TBB workers serving other arenas are
+// not confined to one CPU.
+class WorkerPinner : public tbb::task_scheduler_observer {
+ public:
+  WorkerPinner(tbb::task_arena& arena, const std::vector<int>& cpus)  // NOLINT(runtime/references)
+      : tbb::task_scheduler_observer(arena), cpus_(cpus) {
+    observe(true);
+  }
+
+  ~WorkerPinner() { observe(false); }
+
+  void on_scheduler_entry(bool is_worker) override {
+#if defined(__linux__)
+    if (!is_worker) {
+      // The thread calling into the arena belongs to the caller; leave its affinity alone.
+      return;
+    }
+    // Slot indexes are unique among the threads in the arena, and the calling thread holds slot 0.
+    auto slot = static_cast<size_t>(tbb::this_task_arena::current_thread_index());
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    CPU_SET(cpus_[slot % cpus_.size()], &mask);
+    pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask);
+#endif  // __linux__
+  }
+
+  void on_scheduler_exit(bool is_worker) override {
+#if defined(__linux__)
+    if (!is_worker) {
+      return;
+    }
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (auto cpu : cpus_) {
+      CPU_SET(cpu, &mask);
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask);
+#endif  // __linux__
+  }
+
+ private:
+  std::vector<int> cpus_;
+};
+
+// The threads which run cpu_thread blocks: one TBB arena with a slot per CPU of the process's affinity mask, created
+// on first use and kept for the life of the process, so that every parallel loop of every program is spread over the
+// same workers.  Workers are pinned unless PLAIDML_CPU_PIN_THREADS=0.
+class WorkerPool {
+ public:
+  static WorkerPool& Get() {
+    // Never destroyed, so that programs still running during shutdown keep their workers.
+    static WorkerPool* pool = new WorkerPool;
+    return *pool;
+  }
+
+  template <typename F>
+  void Execute(const F& f) {
+    arena_.execute(f);
+  }
+
+ private:
+  WorkerPool()
+      : cpus_{AffinityCpus()},  //
+        arena_{cpus_.empty() ? tbb::task_arena::automatic : static_cast<int>(cpus_.size())} {
+    arena_.initialize();
+    if (cpus_.size() > 1 && env::Get("PLAIDML_CPU_PIN_THREADS") != "0") {
+      pinner_.reset(new WorkerPinner(arena_, cpus_));
+    }
+  }
+
+  std::vector<int> cpus_;
+  tbb::task_arena arena_;
+  std::unique_ptr<WorkerPinner> pinner_;
+};
+
+// Marks a partitioner idle again when its parallel loop finishes, however it finishes.
+class BusyGuard {
+ public:
+  explicit BusyGuard(std::atomic_flag* busy) : busy_{busy} {}
+  ~BusyGuard() { busy_->clear(std::memory_order_release); }
+
+ private:
+  std::atomic_flag* busy_;
+};
 
 typedef void (*cpu_thread_block)(void** refs, ssize_t* inits, size_t range_begin, size_t range_end);
-void ParallelFor(void** refs, ssize_t* inits, size_t range_size, cpu_thread_block func) {
-  tbb::parallel_for(tbb::blocked_range<size_t>(0, range_size),
-                    [=](const tbb::blocked_range<size_t>& r) { func(refs, inits, r.begin(), r.end()); });
+void ParallelFor(void** refs, ssize_t* inits, size_t range_size, size_t grain, void* partitioner,
+                 cpu_thread_block func) {
+  WorkerPool::Get().Execute([&] {
+    // Don't let a coarse compile-time grain leave workers idle on small ranges.
+    size_t max_chunks = 4 * static_cast<size_t>(tbb::this_task_arena::max_concurrency());
+    size_t chunk_grain = std::max<size_t>(1, std::min(grain, range_size / max_chunks));
+    tbb::blocked_range<size_t> range(0, range_size, chunk_grain);
+    auto body = [=](const tbb::blocked_range<size_t>& r) { func(refs, inits, r.begin(), r.end()); };
+    auto block = static_cast<BlockPartitioner*>(partitioner);
+    if (!block) {
+      tbb::parallel_for(range, body, tbb::simple_partitioner());
+    } else if (!block->busy.test_and_set(std::memory_order_acquire)) {
+      BusyGuard guard{&block->busy};
+      tbb::parallel_for(range, body, block->partitioner);
+    } else {
+      tbb::parallel_for(range, body, tbb::auto_partitioner());
+    }
+  });
 }
 
 }  // namespace rt
@@ -163,20 +502,16 @@ llvm::JITSymbol Runtime::findSymbol(const std::string& name) {
       {"__gnu_f2h_ieee", symInfo(rt::f2h)},
       {"___extendhfsf2", symInfo(rt::h2f)},
       {"___truncsfhf2", symInfo(rt::f2h)},
-      {"_libxsmm_dmmdispatch", symInfo(libxsmm_dmmdispatch)},
-      {"_libxsmm_smmdispatch", symInfo(libxsmm_smmdispatch)},
-      {"_libxsmm_wimmdispatch", symInfo(libxsmm_wimmdispatch)},
       {"_prng_step", symInfo(rt::prng_step)},
       {"_RunTimeLogEntry", symInfo(rt::RunTimeLogEntry)},  // For debugging
-      {"_XSMMRTCaller", symInfo(rt::XSMMRTCaller)},
       {"_ParallelFor", symInfo(rt::ParallelFor)},
-      {"libxsmm_dmmdispatch", symInfo(libxsmm_dmmdispatch)},
-      {"libxsmm_smmdispatch", symInfo(libxsmm_smmdispatch)},
-      {"libxsmm_wimmdispatch", symInfo(libxsmm_wimmdispatch)},
+      {"_ArenaAcquire", symInfo(rt::ArenaAcquire)},
+      {"_ArenaRelease", symInfo(rt::ArenaRelease)},
       {"prng_step", symInfo(rt::prng_step)},
       {"RunTimeLogEntry", symInfo(rt::RunTimeLogEntry)},  // For debugging
-      {"XSMMRTCaller", symInfo(rt::XSMMRTCaller)},
       {"ParallelFor", symInfo(rt::ParallelFor)},
+      {"ArenaAcquire", symInfo(rt::ArenaAcquire)},
+      {"ArenaRelease", symInfo(rt::ArenaRelease)},
   };
   auto loc_rt = symbols.find(name);
   if (loc_rt != symbols.end()) {
@@ -3,6 +3,7 @@
 #pragma once
 
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
+#include <llvm/ExecutionEngine/ObjectCache.h>
 
 #include <map>
 #include <memory>
@@ -17,16 +18,57 @@ namespace tile {
 namespace targets {
 namespace cpu {
 
+class ArenaPool;
+struct BlockPartitioner;
+
+// Looks up (generating on first use) the libxsmm code for a kernel; returns nullptr if libxsmm cannot generate the
+// kernel for this machine.
+void* DispatchXSMMKernel(const XSMMKernel& kernel);
+
 class Executable {
  public:
   explicit Executable(const ProgramModule& module);
+  // Loads previously compiled object code (see object()), skipping code generation entirely.
+  Executable(llvm::LLVMContext* context, const std::string& object, const std::vector<std::string>& parameters,
+             uint64_t arena_size, const std::vector<XSMMKernel>& xsmm_kernels, uint64_t parallel_blocks);
+  ~Executable();
   void Run(const std::map<std::string, void*>& buffers);
+  // Arranges the buffers in the order of the program's parameters, for use with Run(void**).
+  std::vector<void*> Arguments(const std::map<std::string, void*>& buffers) const;
+  // Runs the program with pre-arranged arguments; this performs no lookups or allocations.
+  void Run(void** args) const;
   void Save(const std::string& filename);
   void SetPerfAttrs(stripe::Block* block);
 
+  // The native object code produced by the JIT, suitable for reloading.
+  const std::string& object() const;
+  const std::vector<std::string>& parameters() const { return parameters_; }
+  // The size of the arena holding the program's temporaries; each concurrent invocation uses one.
+  uint64_t arena_size() const { return arena_size_; }
+  // The libxsmm kernels the program calls.
+  const std::vector<XSMMKernel>& xsmm_kernels() const { return xsmm_kernels_; }
+  // The number of statically scheduled parallel loops in the program.
+  uint64_t parallel_blocks() const { return parallel_blocks_; }
+
  private:
+  class ObjectCapture;
+
+  std::unique_ptr<ObjectCapture> capture_;
+  void ResolveEntry();
+
+  std::unique_ptr<ArenaPool> arenas_;
   std::unique_ptr<llvm::ExecutionEngine> engine_;
   std::vector<std::string> parameters_;
+  uint64_t arena_size_ = 0;
+  std::vector<XSMMKernel> xsmm_kernels_;
+  // The dispatched kernels, indexed by the generated code.
+  std::vector<void*> xsmm_table_;
+  uint64_t parallel_blocks_ = 0;
+  // The partitioners of the statically scheduled parallel loops, and the table of their addresses indexed by the
+  // generated code.
+  std::unique_ptr<BlockPartitioner[]> partitioners_;
+  std::vector<void*> partitioner_table_;
+  void (*entry_)(void**) = nullptr;
 };
 
 }  // namespace cpu
@@ -42,6 +42,29 @@ struct Native::Impl {
     executable.reset(new Executable(module));
   }
 
+  bool load(const ObjectCache& cache, const std::string& key, std::map<std::string, std::string>* constants) {
+    CachedObject entry;
+    if (!cache.Load(key, &entry)) {
+      return false;
+    }
+    try {
+      executable.reset(new Executable(&context, entry.object, entry.parameters, entry.arena_size, entry.xsmm_kernels,
+                                      entry.parallel_blocks));
+    } catch (const std::exception& ex) {
+      LOG(WARNING) << "Unable to load cached CPU object code: " << ex.what();
+      return false;
+    }
+    if (constants) {
+      *constants = std::move(entry.constants);
+    }
+    return true;
+  }
+
+  void store(const ObjectCache& cache, const std::string& key, const std::map<std::string, std::string>& constants) {
+    cache.Store(key, CachedObject{executable->parameters(), executable->object(), executable->arena_size(),
+                                  executable->xsmm_kernels(), executable->parallel_blocks(), constants});
+  }
+
   void run(const std::map<std::string, void*>& buffers) { executable->Run(buffers); }
 
   void save(const std::string& filename) {
@@ -57,7 +80,19 @@ struct Native::Impl {
 Native::Native() : m_impl(new Native::Impl) {}
 Native::~Native() {}
 void Native::compile(const stripe::Block& program, const Config& config) { m_impl->compile(program, config); }
+bool Native::load(const ObjectCache& cache, const std::string& key, std::map<std::string, std::string>* constants) {
+  return m_impl->load(cache, key, constants);
+}
+void Native::store(const ObjectCache& cache, const std::string& key,
+                   const std::map<std::string, std::string>& constants) {
+  m_impl->store(cache, key, constants);
+}
 void Native::run(const std::map<std::string, void*>& buffers) { m_impl->run(buffers); }
+std::vector<void*> Native::arguments(const std::map<std::string, void*>& buffers) const {
+  return m_impl->executable->Arguments(buffers);
+}
+void Native::run(void** args) { m_impl->executable->Run(args); }
+uint64_t Native::arena_size() const { return m_impl->executable->arena_size(); }
 void Native::save(const std::string& filename) { m_impl->save(filename); }
 void Native::set_perf_attrs(stripe::Block* program) { m_impl->set_perf_attrs(program); }
 
@@ -9,6 +9,7 @@
 
 #include "tile/stripe/stripe.h"
 #include "tile/targets/cpu/config.h"
+#include "tile/targets/cpu/objcache.h"
 
 namespace vertexai {
 namespace tile {
@@ -24,7 +25,20 @@ class Native {
   ~Native();
 
   void compile(const stripe::Block& program, const Config& config);
+  // Loads a previously stored program from the object cache, along with the contents of the constants stored with
+  // it; returns false on a miss.
+  bool load(const ObjectCache& cache, const std::string& key, std::map<std::string, std::string>* constants = nullptr);
+  // Stores the compiled program into the object cache, along with the contents of the constants it was compiled to
+  // read.
+  void store(const ObjectCache& cache, const std::string& key,
+             const std::map<std::string, std::string>& constants = {});
   void run(const std::map<std::string, void*>& buffers);
+  // Arranges buffers into the argument order expected by run(void**).
+  std::vector<void*> arguments(const std::map<std::string, void*>& buffers) const;
+  // Runs with pre-arranged arguments, without any per-run lookups or allocations.
+  void run(void** args);
+  // The size of the arena holding the program's temporaries.
+  uint64_t arena_size() const;
   void save(const std::string& filename);
   void set_perf_attrs(stripe::Block* program);
 };
@@ -8,7 +8,9 @@ namespace targets {
 namespace cpu {
 
 extern const char invoker_name_[];
-extern const char arena_name_[];
+extern const char arena_pool_name_[];
+extern const char xsmm_kernels_name_[];
+extern const char partitioners_name_[];
 extern const char profile_count_name_[];
 extern const char profile_ticks_name_[];
 extern const char profile_loop_body_name_[];
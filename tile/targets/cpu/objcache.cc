@@ -0,0 +1,278 @@
+// Copyright 2020, Intel Corp.
+
+#include "tile/targets/cpu/objcache.h"
+
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/SHA1.h>
+
+#include <fstream>
+#include <map>
+#include <utility>
+
+#include <boost/filesystem.hpp>
+
+#include "base/util/env.h"
+#include "base/util/logging.h"
+
+namespace fs = boost::filesystem;
+
+namespace vertexai {
+namespace tile {
+namespace targets {
+namespace cpu {
+
+namespace {
+
+// Bump this whenever the layout of cache entries or the generated code's
+// calling convention changes, so that stale entries are never loaded.
+const char kMagic[] = "PLAIDCPU0006";
+constexpr size_t kMagicSize = sizeof(kMagic) - 1;
+
+std::string HostCpuDescription() {
+  std::string desc = llvm::sys::getProcessTriple();
+  desc += ';';
+  desc += llvm::sys::getHostCPUName();
+  llvm::StringMap<bool> features;
+  if (llvm::sys::getHostCPUFeatures(features)) {
+    // Sort the features so that the description is stable across runs.
+    std::map<std::string, bool> sorted;
+    for (const auto& feature : features) {
+      sorted.emplace(feature.getKey().str(), feature.getValue());
+    }
+    for (const auto& kvp : sorted) {
+      desc += kvp.second ? ";+" : ";-";
+      desc += kvp.first;
+    }
+  }
+  return desc;
+}
+
+void WriteString(std::ostream& out, const std::string& str) {
+  uint64_t size = str.size();
+  out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+  out.write(str.data(), str.size());
+}
+
+// The number of bytes left to read in a file of the given size.
+uint64_t Remaining(std::istream& in, uint64_t file_size) {
+  auto pos = in.tellg();
+  if (pos < 0 || file_size < static_cast<uint64_t>(pos)) {
+    return 0;
+  }
+  return file_size - static_cast<uint64_t>(pos);
+}
+
+bool ReadString(std::istream& in, uint64_t file_size, std::string* str) {
+  uint64_t size = 0;
+  if (!in.read(reinterpret_cast<char*>(&size), sizeof(size))) {
+    return false;
+  }
+  // Check the size before allocating for it, so that a corrupt entry cannot request an arbitrary amount of memory.
+  if (Remaining(in, file_size) < size) {
+    return false;
+  }
+  str->resize(size);
+  return static_cast<bool>(in.read(&(*str)[0], size));
+}
+
+void WriteKernel(std::ostream& out, const XSMMKernel& kernel) {
+  int32_t fields[] = {static_cast<int32_t>(kernel.dispatch),
+                      kernel.m,
+                      kernel.n,
+                      kernel.k,
+                      kernel.lda,
+                      kernel.ldb,
+                      kernel.ldc,
+                      kernel.prefetch,
+                      kernel.batch_reduce};
+  out.write(reinterpret_cast<const char*>(fields), sizeof(fields));
+}
+
+constexpr uint64_t kKernelSize = 9 * sizeof(int32_t);
+
+bool ReadKernel(std::istream& in, XSMMKernel* kernel) {
+  int32_t fields[9];
+  if (!in.read(reinterpret_cast<char*>(fields), sizeof(fields))) {
+    return false;
+  }
+  kernel->dispatch = static_cast<XSMMDispatch>(fields[0]);
+  kernel->m = fields[1];
+  kernel->n = fields[2];
+  kernel->k = fields[3];
+  kernel->lda = fields[4];
+  kernel->ldb = fields[5];
+  kernel->ldc = fields[6];
+  kernel->prefetch = fields[7] != 0;
+  kernel->batch_reduce = fields[8] != 0;
+  return true;
+}
+
+}  // namespace
+
+ObjectCache::ObjectCache(const fs::path& dir) : dir_{dir} {}
+
+std::unique_ptr<ObjectCache> ObjectCache::FromEnv() {
+  auto dir = env::Get("PLAIDML_CPU_CACHE_DIR");
+  if (dir.empty()) {
+    return nullptr;
+  }
+  return std::make_unique<ObjectCache>(dir);
+}
+
+std::string ObjectCache::ComputeKey(const std::string& program, const std::string& target_config,
+                                    const std::vector<ConstantBytes>& constants) {
+  static const std::string host = HostCpuDescription();
+  llvm::SHA1 hash;
+  auto update = [&hash](llvm::StringRef part) {
+    uint64_t size = part.size();
+    hash.update(llvm::StringRef(reinterpret_cast<const char*>(&size), sizeof(size)));
+    hash.update(part);
+  };
+  update(kMagic);
+  update(LLVM_VERSION_STRING);
+  update(host);
+  update(target_config);
+  update(program);
+  uint64_t num_constants = constants.size();
+  update(llvm::StringRef(reinterpret_cast<const char*>(&num_constants), sizeof(num_constants)));
+  for (const auto& constant : constants) {
+    update(constant.name);
+    update(llvm::StringRef(constant.data, constant.size));
+  }
+  return llvm::toHex(hash.result(), /*LowerCase=*/true);
+}
+
+bool ObjectCache::IsCacheable(const Config& config) {
+  return config.externals.empty() && !config.profile_block_execution && !config.profile_loop_body;
+}
+
+fs::path ObjectCache::PathFor(const std::string& key) const { return dir_ / (key + ".obj"); }
+
+bool ObjectCache::Load(const std::string& key, CachedObject* entry) const {
+  auto path = PathFor(key);
+  boost::system::error_code ec;
+  auto file_size = fs::file_size(path, ec);
+  if (ec) {
+    return false;
+  }
+  auto invalid = [&path]() {
+    LOG(WARNING) << "Ignoring invalid CPU object cache entry: " << path;
+    return false;
+  };
+  try {
+    std::ifstream in(path.string(), std::ios::binary);
+    if (!in) {
+      return false;
+    }
+    std::string magic(kMagicSize, '\0');
+    if (!in.read(&magic[0], kMagicSize) || magic != kMagic) {
+      return invalid();
+    }
+    // Each count is checked against what is left of the file (every parameter takes at least its size field, and
+    // every kernel a fixed record) before anything is allocated for it.
+    uint64_t num_params = 0;
+    if (!in.read(reinterpret_cast<char*>(&num_params), sizeof(num_params)) ||
+        Remaining(in, file_size) / sizeof(uint64_t) < num_params) {
+      return invalid();
+    }
+    CachedObject loaded;
+    loaded.parameters.resize(num_params);
+    for (auto& param : loaded.parameters) {
+      if (!ReadString(in, file_size, &param)) {
+        return invalid();
+      }
+    }
+    if (!in.read(reinterpret_cast<char*>(&loaded.arena_size), sizeof(loaded.arena_size))) {
+      return invalid();
+    }
+    uint64_t num_kernels = 0;
+    if (!in.read(reinterpret_cast<char*>(&num_kernels), sizeof(num_kernels)) ||
+        Remaining(in, file_size) / kKernelSize < num_kernels) {
+      return invalid();
+    }
+    loaded.xsmm_kernels.resize(num_kernels);
+    for (auto& kernel : loaded.xsmm_kernels) {
+      if (!ReadKernel(in, &kernel)) {
+        return invalid();
+      }
+    }
+    if (!in.read(reinterpret_cast<char*>(&loaded.parallel_blocks), sizeof(loaded.parallel_blocks))) {
+      return invalid();
+    }
+    // Every constant takes at least the size fields of its name and its contents.
+    uint64_t num_constants = 0;
+    if (!in.read(reinterpret_cast<char*>(&num_constants), sizeof(num_constants)) ||
+        Remaining(in, file_size) / (2 * sizeof(uint64_t)) < num_constants) {
+      return invalid();
+    }
+    for (uint64_t i = 0; i < num_constants; ++i) {
+      std::string name;
+      std::string contents;
+      if (!ReadString(in, file_size, &name) || !ReadString(in, file_size, &contents)) {
+        return invalid();
+      }
+      loaded.constants.emplace(std::move(name), std::move(contents));
+    }
+    // The object code runs to the end of the entry; anything else means the counts above were misread.
+    if (!ReadString(in, file_size, &loaded.object) || Remaining(in, file_size) != 0) {
+      return invalid();
+    }
+    IVLOG(1, "Loaded cached CPU object code: " << path);
+    *entry = std::move(loaded);
+    return true;
+  } catch (const std::exception& ex) {
+    LOG(WARNING) << "Unable to load CPU object cache entry " << path << ": " << ex.what();
+    return false;
+  }
+}
+
+void ObjectCache::Store(const std::string& key, const CachedObject& entry) const {
+  auto path = PathFor(key);
+  // Write to a unique temporary name and rename into place, so that concurrent
+  // readers never observe a partially-written entry.
+  auto tmp_path = dir_ / fs::unique_path(key + ".%%%%-%%%%-%%%%.tmp");
+  try {
+    fs::create_directories(dir_);
+    {
+      std::ofstream out(tmp_path.string(), std::ios::binary);
+      out.write(kMagic, kMagicSize);
+      uint64_t num_params = entry.parameters.size();
+      out.write(reinterpret_cast<const char*>(&num_params), sizeof(num_params));
+      for (const auto& param : entry.parameters) {
+        WriteString(out, param);
+      }
+      out.write(reinterpret_cast<const char*>(&entry.arena_size), sizeof(entry.arena_size));
+      uint64_t num_kernels = entry.xsmm_kernels.size();
+      out.write(reinterpret_cast<const char*>(&num_kernels), sizeof(num_kernels));
+      for (const auto& kernel : entry.xsmm_kernels) {
+        WriteKernel(out, kernel);
+      }
+      out.write(reinterpret_cast<const char*>(&entry.parallel_blocks), sizeof(entry.parallel_blocks));
+      uint64_t num_constants = entry.constants.size();
+      out.write(reinterpret_cast<const char*>(&num_constants), sizeof(num_constants));
+      for (const auto& kvp : entry.constants) {
+        WriteString(out, kvp.first);
+        WriteString(out, kvp.second);
+      }
+      WriteString(out, entry.object);
+      if (!out) {
+        throw std::runtime_error("write failed");
+      }
+    }
+    fs::rename(tmp_path, path);
+    IVLOG(1, "Stored CPU object code in cache: " << path);
+  } catch (const std::exception& ex) {
+    // The cache is an optimization; failing to populate it is not an error.
+    LOG(WARNING) << "Unable to store CPU object cache entry " << path << ": " << ex.what();
+    boost::system::error_code ec;
+    fs::remove(tmp_path, ec);
+  }
+}
+
+}  // namespace cpu
+}  // namespace targets
+}  // namespace tile
+}  // namespace vertexai
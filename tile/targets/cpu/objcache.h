@@ -0,0 +1,76 @@
+// Copyright 2020, Intel Corp.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "tile/targets/cpu/config.h"
+#include "tile/targets/cpu/programmodule.h"
+
+namespace vertexai {
+namespace tile {
+namespace targets {
+namespace cpu {
+
+// A compiled program as stored in the object cache: the native object code
+// emitted by the JIT, plus the names of the user buffers in parameter order,
+// the size of the arena the program's temporaries are planned into, the
+// libxsmm kernels to dispatch when the program is loaded, the number of
+// statically scheduled parallel loops, and the contents of the constant
+// buffers which constant propagation produced while compiling the program.
+struct CachedObject {
+  std::vector<std::string> parameters;
+  std::string object;
+  uint64_t arena_size = 0;
+  std::vector<XSMMKernel> xsmm_kernels;
+  uint64_t parallel_blocks = 0;
+  std::map<std::string, std::string> constants;
+};
+
+// The name and contents of a constant buffer a program is compiled with.
+struct ConstantBytes {
+  std::string name;
+  const char* data;
+  uint64_t size;
+};
+
+// ObjectCache is a content-addressed, on-disk store of JIT-compiled programs.
+// Entries are written atomically, so a cache directory may be shared by
+// several processes; unreadable or truncated entries are treated as misses.
+class ObjectCache {
+ public:
+  explicit ObjectCache(const boost::filesystem::path& dir);
+
+  // Returns the cache configured by PLAIDML_CPU_CACHE_DIR, or nullptr if caching is disabled.
+  static std::unique_ptr<ObjectCache> FromEnv();
+
+  // Computes the key for a program from the serialized Stripe program, the
+  // serialized target configuration, the host's CPU name and features, and the
+  // contents of the constants the program is compiled with (which constant
+  // propagation may fold into the generated code).
+  static std::string ComputeKey(const std::string& program, const std::string& target_config,
+                                const std::vector<ConstantBytes>& constants = {});
+
+  // Programs compiled with profiling or external intrinsic handlers embed
+  // process-specific state and must not be cached.
+  static bool IsCacheable(const Config& config);
+
+  bool Load(const std::string& key, CachedObject* entry) const;
+  void Store(const std::string& key, const CachedObject& entry) const;
+
+ private:
+  boost::filesystem::path PathFor(const std::string& key) const;
+
+  boost::filesystem::path dir_;
+};
+
+}  // namespace cpu
+}  // namespace targets
+}  // namespace tile
+}  // namespace vertexai
@@ -4,9 +4,11 @@
 
 #include <llvm/IR/Module.h>
 
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <string>
+#include <tuple>
 #include <vector>
 
 namespace vertexai {
@@ -14,10 +16,45 @@ namespace tile {
 namespace targets {
 namespace cpu {
 
+enum class XSMMDispatch : int {
+  NONE = 0,  // No XSMM dispatch function to call.
+  SMM = 1,   // singe float
+  DMM = 2,   // double float
+  WIMM = 3,  // int8, uint8 ---> int
+  BSMM = 4,  // bfloat16, bfloat16 ---> single float
+  BMMM = 5,  // bfloat16, bfloat16 ---> bfloat16
+};
+
+// A libxsmm GEMM kernel called by a program.  Kernels are dispatched once, when the program is loaded, into a table
+// which the generated code indexes directly.
+struct XSMMKernel {
+  XSMMDispatch dispatch = XSMMDispatch::NONE;
+  int32_t m = 0;
+  int32_t n = 0;
+  int32_t k = 0;
+  int32_t lda = 0;
+  int32_t ldb = 0;
+  int32_t ldc = 0;
+  // Takes three further pointers to the operands of the next call, to be prefetched.
+  bool prefetch = false;
+  // Takes arrays of a and b pointers and a count, and accumulates every product into c.
+  bool batch_reduce = false;
+
+  bool operator==(const XSMMKernel& other) const {
+    return std::tie(dispatch, m, n, k, lda, ldb, ldc, prefetch, batch_reduce) ==
+           std::tie(other.dispatch, other.m, other.n, other.k, other.lda, other.ldb, other.ldc, other.prefetch,
+                    other.batch_reduce);
+  }
+};
+
 struct ProgramModule {
   std::unique_ptr<llvm::Module> module;
   std::vector<std::string> parameters;
   std::map<std::string, void*> externals;
+  uint64_t arena_size = 0;
+  std::vector<XSMMKernel> xsmm_kernels;
+  // The number of statically scheduled parallel loops, each of which keeps a partitioner in the executable.
+  uint64_t parallel_blocks = 0;
 };
 
 }  // namespace cpu
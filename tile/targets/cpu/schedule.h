@@ -0,0 +1,33 @@
+// Copyright 2020, Intel Corp.
+
+#pragma once
+
+#include <cstdint>
+
+namespace vertexai {
+namespace tile {
+namespace targets {
+namespace cpu {
+
+// How the iterations of a cpu_thread block are distributed over worker
+// threads. The compiler picks a schedule for each threaded block; statically
+// scheduled blocks pass the ParallelFor runtime function their own partitioner
+// from the executable, dynamically scheduled ones pass none.
+enum class ParallelSchedule : int64_t {
+  // Iterations cost roughly the same: chunks are split statically and the
+  // chunk-to-thread assignment is replayed on later runs, so each chunk keeps
+  // running on the core (and NUMA node) whose caches and memory it last touched.
+  Static = 0,
+  // Iteration costs vary: chunks are split down to the grain and idle workers
+  // steal from busy ones.
+  Dynamic = 1,
+};
+
+// The estimated number of statement executions each parallel chunk should
+// perform, so that scheduling overhead stays small relative to useful work.
+constexpr uint64_t kParallelChunkWork = 16 * 1024;
+
+}  // namespace cpu
+}  // namespace targets
+}  // namespace tile
+}  // namespace vertexai
@@ -3,6 +3,13 @@
 #include <gmock/gmock.h>
 #include <google/protobuf/text_format.h>
 
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+#include <boost/format.hpp>
+
 #include "tile/codegen/tile.h"
 #include "tile/lang/gen_stripe.h"
 #include "tile/lang/runinfo.h"
@@ -1107,6 +1114,799 @@ TEST(Jit, JitSpecialZero) {
   EXPECT_THAT(b1[3], Eq(0));
 }
 
+TEST(Jit, JitSpecialScan) {
+  stripe::proto::Block input_proto;
+  gp::TextFormat::ParseFromString(R"(
+    loc {}
+    refs [
+      {
+        key: "a"
+        value {
+          attrs: { key: "user" value: {} }
+          dir: 1
+          interior_shape { type: FLOAT32 dims: {size:2 stride:3} dims: {size:3 stride:1} }
+          access { } access { }
+        }
+      },
+      {
+        key: "b"
+        value {
+          attrs: { key: "user" value: {} }
+          dir: 2
+          interior_shape { type: FLOAT32 dims: {size:2 stride:3} dims: {size:3 stride:1} }
+          access { } access { }
+        }
+      }
+    ]
+    stmts {
+      special {
+        name:"scan" inputs:"a" outputs:"b"
+        int_params { key:"axis" value:1 }
+        int_params { key:"reverse" value:1 }
+        str_params { key:"agg_op" value:"add" }
+      }
+    }
+  )",
+                                  &input_proto);
+  std::shared_ptr<stripe::Block> block{stripe::FromProto(input_proto)};
+
+  std::vector<float> a{1, 2, 3, 4, 5, 6};
+  std::vector<float> b(6);
+  std::map<std::string, void*> buffers{{"a", a.data()}, {"b", b.data()}};
+  JitExecute(*block, buffers);
+
+  std::vector<float> expected{6, 5, 3, 15, 11, 6};
+  EXPECT_THAT(b, ContainerEq(expected));
+}
+
+TEST(Jit, JitSpecialScanOuterAxis) {
+  // Scanning along the outer dimension, so that each row steps through the buffers by the outer stride.
+  stripe::proto::Block input_proto;
+  gp::TextFormat::ParseFromString(R"(
+    loc {}
+    refs [
+      {
+        key: "a"
+        value {
+          attrs: { key: "user" value: {} }
+          dir: 1
+          interior_shape { type: FLOAT32 dims: {size:3 stride:2} dims: {size:2 stride:1} }
+          access { } access { }
+        }
+      },
+      {
+        key: "b"
+        value {
+          attrs: { key: "user" value: {} }
+          dir: 2
+          interior_shape { type: FLOAT32 dims: {size:3 stride:2} dims: {size:2 stride:1} }
+          access { } access { }
+        }
+      }
+    ]
+    stmts {
+      special {
+        name:"scan" inputs:"a" outputs:"b"
+        int_params { key:"axis" value:0 }
+        int_params { key:"reverse" value:0 }
+        str_params { key:"agg_op" value:"mul" }
+      }
+    }
+  )",
+                                  &input_proto);
+  std::shared_ptr<stripe::Block> block{stripe::FromProto(input_proto)};
+
+  std::vector<float> a{1, 2, 3, 4, 5, 6};
+  std::vector<float> b(6);
+  std::map<std::string, void*> buffers{{"a", a.data()}, {"b", b.data()}};
+  JitExecute(*block, buffers);
+
+  std::vector<float> expected{1, 2, 3, 8, 15, 48};
+  EXPECT_THAT(b, ContainerEq(expected));
+}
+
+TEST(Jit, JitSpecialScanLongRows) {
+  // Two rows, each several blocks long, so that the blocks of a row are scanned in parallel and then carried.
+  stripe::proto::Block input_proto;
+  gp::TextFormat::ParseFromString(R"(
+    loc {}
+    refs [
+      {
+        key: "a"
+        value {
+          attrs: { key: "user" value: {} }
+          dir: 1
+          interior_shape { type: INT32 dims: {size:2 stride:40000} dims: {size:40000 stride:1} }
+          access { } access { }
+        }
+      },
+      {
+        key: "b"
+        value {
+          attrs: { key: "user" value: {} }
+          dir: 2
+          interior_shape { type: INT32 dims: {size:2 stride:40000} dims: {size:40000 stride:1} }
+          access { } access { }
+        }
+      }
+    ]
+    stmts {
+      special {
+        name:"scan" inputs:"a" outputs:"b"
+        int_params { key:"axis" value:1 }
+        int_params { key:"reverse" value:1 }
+        str_params { key:"agg_op" value:"add" }
+      }
+    }
+  )",
+                                  &input_proto);
+  std::shared_ptr<stripe::Block> block{stripe::FromProto(input_proto)};
+
+  std::vector<int32_t> a(80000);
+  for (size_t i = 0; i < a.size(); ++i) {
+    a[i] = i % 7;
+  }
+  std::vector<int32_t> b(80000);
+  std::map<std::string, void*> buffers{{"a", a.data()}, {"b", b.data()}};
+  JitExecute(*block, buffers);
+
+  std::vector<int32_t> expected(80000);
+  for (size_t row = 0; row < 2; ++row) {
+    int32_t sum = 0;
+    for (size_t i = 40000; i-- > 0;) {
+      sum += a[row * 40000 + i];
+      expected[row * 40000 + i] = sum;
+    }
+  }
+  EXPECT_THAT(b, ContainerEq(expected));
+}
+
+TEST(Jit, JitXSMMBatchReduce) {
+  // C[r, c] = +(A[r, p] * B[p, c]), with p split into four tiles of two, each tile a call to the same XSMM kernel.
+  stripe::proto::Block input_proto;
+  gp::TextFormat::ParseFromString(R"(
+    loc {}
+    refs [
+      {
+        key: "A"
+        value {
+          attrs: { key: "user" value: {} }
+          dir: 1
+          access { } access { }
+          interior_shape { type: FLOAT32 dims: {size:4 stride:8} dims: {size:8 stride:1} }
+        }
+      },
+      {
+        key: "B"
+        value {
+          attrs: { key: "user" value: {} }
+          dir: 1
+          access { } access { }
+          interior_shape { type: FLOAT32 dims: {size:8 stride:4} dims: {size:4 stride:1} }
+        }
+      },
+      {
+        key: "C"
+        value {
+          attrs: { key: "user" value: {} }
+          dir: 3
+          agg_op: "add"
+          access { } access { }
+          interior_shape { type: FLOAT32 dims: {size:4 stride:4} dims: {size:4 stride:1} }
+        }
+      }
+    ]
+    stmts { block {
+      name: "mac"
+      idxs { name: "k" range: 4 }
+      refs [
+        {
+          key: "A"
+          value {
+            from: "A"
+            dir: 1
+            access { } access { terms {key:"k" value:2} }
+            interior_shape { type: FLOAT32 dims: {size:4 stride:8} dims: {size:2 stride:1} }
+          }
+        },
+        {
+          key: "B"
+          value {
+            from: "B"
+            dir: 1
+            access { terms {key:"k" value:2} } access { }
+            interior_shape { type: FLOAT32 dims: {size:2 stride:4} dims: {size:4 stride:1} }
+          }
+        },
+        {
+          key: "C"
+          value {
+            from: "C"
+            dir: 3
+            agg_op: "add"
+            access { } access { }
+            interior_shape { type: FLOAT32 dims: {size:4 stride:4} dims: {size:4 stride:1} }
+          }
+        }
+      ]
+      stmts { block {
+        name: "xsmm"
+        attrs: { key: "xsmm" value: {} }
+        idxs { name: "r" range: 4 attrs: { key: "stencil_n" value: {} } }
+        idxs { name: "c" range: 4 attrs: { key: "stencil_m" value: {} } }
+        idxs { name: "k" range: 2 attrs: { key: "stencil_k" value: {} } }
+        refs [
+          {
+            key: "A"
+            value {
+              from: "A"
+              dir: 1
+              attrs: { key: "A" value: {} }
+              access { terms {key:"r" value:1} } access { terms {key:"k" value:1} }
+              interior_shape { type: FLOAT32 dims: {size:1 stride:8} dims: {size:1 stride:1} }
+            }
+          },
+          {
+            key: "B"
+            value {
+              from: "B"
+              dir: 1
+              attrs: { key: "B" value: {} }
+              access { terms {key:"k" value:1} } access { terms {key:"c" value:1} }
+              interior_shape { type: FLOAT32 dims: {size:1 stride:4} dims: {size:1 stride:1} }
+            }
+          },
+          {
+            key: "C"
+            value {
+              from: "C"
+              dir: 3
+              agg_op: "add"
+              attrs: { key: "C" value: {} }
+              access { terms {key:"r" value:1} } access { terms {key:"c" value:1} }
+              interior_shape { type: FLOAT32 dims: {size:1 stride:4} dims: {size:1 stride:1} }
+            }
+          }
+        ]
+        stmts { load { from:"A" into:"$a" } }
+        stmts { load { from:"B" into:"$b" } }
+        stmts { intrinsic { name:"mul" type:FLOAT32 inputs:"$a" inputs:"$b" outputs:"$c"} }
+        stmts { store { from:"$c" into:"C"} }
+      } }
+    } }
+  )",
+                                  &input_proto);
+  std::shared_ptr<stripe::Block> block{stripe::FromProto(input_proto)};
+
+  std::vector<float> A(4 * 8);
+  std::vector<float> B(8 * 4);
+  std::vector<float> C(4 * 4, 1);
+  std::vector<float> expected(4 * 4, 1);
+  for (int r = 0; r < 4; ++r) {
+    for (int p = 0; p < 8; ++p) {
+      A[r * 8 + p] = r + p;
+      B[p * 4 + r] = p - r;
+    }
+  }
+  for (int r = 0; r < 4; ++r) {
+    for (int c = 0; c < 4; ++c) {
+      for (int p = 0; p < 8; ++p) {
+        expected[r * 4 + c] += A[r * 8 + p] * B[p * 4 + c];
+      }
+    }
+  }
+
+  std::map<std::string, void*> buffers{{"A", A.data()}, {"B", B.data()}, {"C", C.data()}};
+  JitExecute(*block, buffers);
+
+  EXPECT_THAT(C, ContainerEq(expected));
+}
+
+static uint16_t BF16Bits(float value) {
+  // Only used for values that are exact in bfloat16, so truncation is enough.
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return static_cast<uint16_t>(bits >> 16);
+}
+
+static float FloatFromBits(uint32_t bits) {
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+TEST(Jit, JitBF16LoadStore) {
+  // F32 -> BF16 stores round to nearest even and keep NaNs quiet; BF16 -> F32 loads are exact.
+  stripe::proto::Block input_proto;
+  gp::TextFormat::ParseFromString(R"(
+    loc {}
+    idxs { name: "i" range: 6 }
+    refs [
+      {
+        key: "X"
+        value {
+          attrs: { key: "user" value: {} }
+          dir: 1
+          interior_shape { type: FLOAT32 dims: {size:6 stride:1} }
+          access { terms {key:"i" value:1} }
+        }
+      },
+      {
+        key: "Y"
+        value {
+          attrs: { key: "user" value: {} }
+          dir: 2
+          interior_shape { type: BFLOAT16 dims: {size:6 stride:1} }
+          access { terms {key:"i" value:1} }
+        }
+      },
+      {
+        key: "B"
+        value {
+          attrs: { key: "user" value: {} }
+          dir: 1
+          interior_shape { type: BFLOAT16 dims: {size:6 stride:1} }
+          access { terms {key:"i" value:1} }
+        }
+      },
+      {
+        key: "F"
+        value {
+          attrs: { key: "user" value: {} }
+          dir: 2
+          interior_shape { type: FLOAT32 dims: {size:6 stride:1} }
+          access { terms {key:"i" value:1} }
+        }
+      }
+    ]
+    stmts { load { from:"X" into:"$X" } }
+    stmts { store { from:"$X" into:"Y"} }
+    stmts { load { from:"B" into:"$B" } }
+    stmts { store { from:"$B" into:"F"} }
+  )",
+                                  &input_proto);
+  std::shared_ptr<stripe::Block> block{stripe::FromProto(input_proto)};
+
+  std::vector<float> X{
+      FloatFromBits(0x3F800000),  // 1.0, exact
+      FloatFromBits(0x3F807FFF),  // below the halfway point: rounds down
+      FloatFromBits(0x3F808000),  // halfway, even lsb: rounds down
+      FloatFromBits(0x3F818000),  // halfway, odd lsb: rounds up
+      FloatFromBits(0x3F808001),  // above the halfway point: rounds up
+      FloatFromBits(0x7F800001),  // signalling NaN: becomes the quiet NaN
+  };
+  std::vector<uint16_t> Y(6, 0);
+  std::vector<uint16_t> B{0x3F80, 0xC000, 0x0000, 0x8000, 0x7F80, 0x3E20};
+  std::vector<float> F(6, 0);
+  std::map<std::string, void*> buffers{{"X", X.data()}, {"Y", Y.data()}, {"B", B.data()}, {"F", F.data()}};
+  JitExecute(*block, buffers);
+
+  std::vector<uint16_t> expected_y{0x3F80, 0x3F80, 0x3F80, 0x3F82, 0x3F81, 0x7FC0};
+  EXPECT_THAT(Y, ContainerEq(expected_y));
+  for (size_t i = 0; i < B.size(); ++i) {
+    EXPECT_THAT(BF16Bits(F[i]), Eq(B[i]));
+  }
+}
+
+TEST(Jit, JitBF16AggInit) {
+  stripe::proto::Block input_proto;
+  gp::TextFormat::ParseFromString(R"(
+    loc {}
+    refs [
+      {
+        key: "M"
+        value {
+          attrs: { key: "user" value: {} }
+          dir: 2
+          agg_op: "mul"
+          interior_shape { type: BFLOAT16 dims: {size:2 stride:3} dims: {size:3 stride:1} }
+          access { } access { }
+        }
+      },
+      {
+        key: "X"
+        value {
+          attrs: { key: "user" value: {} }
+          dir: 2
+          agg_op: "max"
+          interior_shape { type: BFLOAT16 dims: {size:2 stride:3} dims: {size:3 stride:1} }
+          access { } access { }
+        }
+      }
+    ]
+    stmts { special { name:"agg_init_mul" outputs:"M" } }
+    stmts { special { name:"agg_init_max" outputs:"X" } }
+  )",
+                                  &input_proto);
+  std::shared_ptr<stripe::Block> block{stripe::FromProto(input_proto)};
+
+  std::vector<uint16_t> M(6, 0x1234);
+  std::vector<uint16_t> X(6, 0x1234);
+  std::map<std::string, void*> buffers{{"M", M.data()}, {"X", X.data()}};
+  JitExecute(*block, buffers);
+
+  EXPECT_THAT(M, ContainerEq(std::vector<uint16_t>(6, 0x3F80)));  // 1.0
+  EXPECT_THAT(X, ContainerEq(std::vector<uint16_t>(6, 0xFF80)));  // -inf
+}
+
+// Runs C[r, c] = +(A[r, p] * B[p, c]) with bfloat16 inputs and a float32 accumulator over an n x k by k x m product,
+// as a single XSMM block. The result is the same whether libxsmm provides a bf16 kernel on this machine or the block
+// falls back to the loop nest.
+static void CheckXSMMBF16(int n, int m, int k) {
+  stripe::proto::Block input_proto;
+  gp::TextFormat::ParseFromString(str(boost::format(R"(
+    loc {}
+    refs [
+      {
+        key: "A"
+        value {
+          attrs: { key: "user" value: {} }
+          dir: 1
+          access { } access { }
+          interior_shape { type: BFLOAT16 dims: {size:%1% stride:%3%} dims: {size:%3% stride:1} }
+        }
+      },
+      {
+        key: "B"
+        value {
+          attrs: { key: "user" value: {} }
+          dir: 1
+          access { } access { }
+          interior_shape { type: BFLOAT16 dims: {size:%3% stride:%2%} dims: {size:%2% stride:1} }
+        }
+      },
+      {
+        key: "C"
+        value {
+          attrs: { key: "user" value: {} }
+          dir: 3
+          agg_op: "add"
+          access { } access { }
+          interior_shape { type: FLOAT32 dims: {size:%1% stride:%2%} dims: {size:%2% stride:1} }
+        }
+      }
+    ]
+    stmts { block {
+      name: "xsmm"
+      attrs: { key: "xsmm" value: {} }
+      idxs { name: "r" range: %1% attrs: { key: "stencil_n" value: {} } }
+      idxs { name: "c" range: %2% attrs: { key: "stencil_m" value: {} } }
+      idxs { name: "k" range: %3% attrs: { key: "stencil_k" value: {} } }
+      refs [
+        {
+          key: "A"
+          value {
+            from: "A"
+            dir: 1
+            attrs: { key: "A" value: {} }
+            access { terms {key:"r" value:1} } access { terms {key:"k" value:1} }
+            interior_shape { type: BFLOAT16 dims: {size:1 stride:%3%} dims: {size:1 stride:1} }
+          }
+        },
+        {
+          key: "B"
+          value {
+            from: "B"
+            dir: 1
+            attrs: { key: "B" value: {} }
+            access { terms {key:"k" value:1} } access { terms {key:"c" value:1} }
+            interior_shape { type: BFLOAT16 dims: {size:1 stride:%2%} dims: {size:1 stride:1} }
+          }
+        },
+        {
+          key: "C"
+          value {
+            from: "C"
+            dir: 3
+            agg_op: "add"
+            attrs: { key: "C" value: {} }
+            access { terms {key:"r" value:1} } access { terms {key:"c" value:1} }
+            interior_shape { type: FLOAT32 dims: {size:1 stride:%2%} dims: {size:1 stride:1} }
+          }
+        }
+      ]
+      stmts { load { from:"A" into:"$a" } }
+      stmts { load { from:"B" into:"$b" } }
+      stmts { intrinsic { name:"mul" type:FLOAT32 inputs:"$a" inputs:"$b" outputs:"$c"} }
+      stmts { store { from:"$c" into:"C"} }
+    } }
+  )") % n % m % k),
+                                  &input_proto);
+  std::shared_ptr<stripe::Block> block{stripe::FromProto(input_proto)};
+
+  // Integers up to 256 are exact in bfloat16, and so are their products and sums in float32.
+  std::vector<uint16_t> A(n * k);
+  std::vector<uint16_t> B(k * m);
+  std::vector<float> C(n * m, 1);
+  std::vector<float> expected(n * m, 1);
+  for (int r = 0; r < n; ++r) {
+    for (int p = 0; p < k; ++p) {
+      A[r * k + p] = BF16Bits(r + p);
+    }
+  }
+  for (int p = 0; p < k; ++p) {
+    for (int c = 0; c < m; ++c) {
+      B[p * m + c] = BF16Bits(p - c);
+    }
+  }
+  for (int r = 0; r < n; ++r) {
+    for (int c = 0; c < m; ++c) {
+      for (int p = 0; p < k; ++p) {
+        expected[r * m + c] += static_cast<float>(r + p) * static_cast<float>(p - c);
+      }
+    }
+  }
+
+  std::map<std::string, void*> buffers{{"A", A.data()}, {"B", B.data()}, {"C", C.data()}};
+  JitExecute(*block, buffers);
+
+  EXPECT_THAT(C, ContainerEq(expected));
+}
+
+TEST(Jit, JitXSMMBF16) { CheckXSMMBF16(4, 4, 8); }
+
+TEST(Jit, JitXSMMBF16LargePanel) {
+  // The packed copy of a 128 x 128 operand is too large for the stack, so it is made on the heap.
+  CheckXSMMBF16(4, 128, 128);
+}
+
+TEST(Jit, JitVectorMath) {
+  // The range is not a multiple of the vector width, so the final vector is masked.
+  stripe::proto::Block input_proto;
+  gp::TextFormat::ParseFromString(R"(
+    loc {}
+    idxs { name: "i" range: 19 }
+    refs [
+      {
+        key: "X"
+        value {
+          loc {}
+          attrs: { key: "user" value: {} }
+          dir: 1
+          interior_shape { type: FLOAT32 dims: {size:19 stride:1} }
+          access { offset: 0 terms {key:"i" value:1} }
+        }
+      },
+      {
+        key: "E"
+        value {
+          loc {}
+          attrs: { key: "user" value: {} }
+          dir: 2
+          interior_shape { type: FLOAT32 dims: {size:19 stride:1} }
+          access { offset: 0 terms {key:"i" value:1} }
+        }
+      },
+      {
+        key: "L"
+        value {
+          loc {}
+          attrs: { key: "user" value: {} }
+          dir: 2
+          interior_shape { type: FLOAT32 dims: {size:19 stride:1} }
+          access { offset: 0 terms {key:"i" value:1} }
+        }
+      },
+      {
+        key: "T"
+        value {
+          loc {}
+          attrs: { key: "user" value: {} }
+          dir: 2
+          interior_shape { type: FLOAT32 dims: {size:19 stride:1} }
+          access { offset: 0 terms {key:"i" value:1} }
+        }
+      }
+    ]
+    stmts { load { from:"X" into:"$X" } }
+    stmts { intrinsic { name:"exp" type:FLOAT32 inputs:"$X" outputs:"$E" } }
+    stmts { intrinsic { name:"log" type:FLOAT32 inputs:"$E" outputs:"$L" } }
+    stmts { intrinsic { name:"tanh" type:FLOAT32 inputs:"$X" outputs:"$T" } }
+    stmts { store { from:"$E" into:"E"} }
+    stmts { store { from:"$L" into:"L"} }
+    stmts { store { from:"$T" into:"T"} }
+  )",
+                                  &input_proto);
+  std::shared_ptr<stripe::Block> block{stripe::FromProto(input_proto)};
+
+  std::vector<float> X(19);
+  for (size_t i = 0; i < X.size(); ++i) {
+    X[i] = -9.0f + i;
+  }
+  std::vector<float> E(19, 0), L(19, 0), T(19, 0);
+  std::map<std::string, void*> buffers{{"X", X.data()}, {"E", E.data()}, {"L", L.data()}, {"T", T.data()}};
+  JitExecute(*block, buffers);
+
+  for (size_t i = 0; i < X.size(); ++i) {
+    EXPECT_NEAR(E[i], std::exp(X[i]), 1e-6 * std::exp(X[i]));
+    EXPECT_NEAR(L[i], X[i], 1e-5);
+    EXPECT_NEAR(T[i], std::tanh(X[i]), 1e-6);
+  }
+}
+
+TEST(Jit, JitVectorRelu) {
+  // Compares and conditionals vectorize as lane masks and selects, and the constraint, which skips the first few
+  // and last few elements, is checked lane by lane.
+  stripe::proto::Block input_proto;
+  gp::TextFormat::ParseFromString(R"(
+    loc {}
+    idxs { name: "i" range: 37 }
+    constraints { offset: -3 terms {key:"i" value:1} }
+    constraints { offset: 30 terms {key:"i" value:-1} }
+    refs [
+      {
+        key: "X"
+        value {
+          loc {}
+          attrs: { key: "user" value: {} }
+          dir: 1
+          interior_shape { type: FLOAT32 dims: {size:37 stride:1} }
+          access { offset: 0 terms {key:"i" value:1} }
+        }
+      },
+      {
+        key: "Z"
+        value {
+          loc {}
+          attrs: { key: "user" value: {} }
+          dir: 1
+          interior_shape { type: FLOAT32 dims: {size:1 stride:1} }
+          access { offset: 0 }
+        }
+      },
+      {
+        key: "M"
+        value {
+          loc {}
+          attrs: { key: "user" value: {} }
+          dir: 2
+          interior_shape { type: BOOLEAN dims: {size:37 stride:1} }
+          access { offset: 0 terms {key:"i" value:1} }
+        }
+      },
+      {
+        key: "R"
+        value {
+          loc {}
+          attrs: { key: "user" value: {} }
+          dir: 2
+          interior_shape { type: FLOAT32 dims: {size:37 stride:1} }
+          access { offset: 0 terms {key:"i" value:1} }
+        }
+      }
+    ]
+    stmts { load { from:"X" into:"$X" } }
+    stmts { load { from:"Z" into:"$Z" } }
+    stmts { intrinsic { name:"cmp_lt" type:FLOAT32 inputs:"$X" inputs:"$Z" outputs:"$M" } }
+    stmts { intrinsic { name:"cond" type:FLOAT32 inputs:"$M" inputs:"$Z" inputs:"$X" outputs:"$R" } }
+    stmts { store { from:"$M" into:"M"} }
+    stmts { store { from:"$R" into:"R"} }
+  )",
+                                  &input_proto);
+  std::shared_ptr<stripe::Block> block{stripe::FromProto(input_proto)};
+
+  std::vector<float> X(37);
+  for (size_t i = 0; i < X.size(); ++i) {
+    X[i] = (i % 3 ? 1.0f : -1.0f) * i;
+  }
+  std::vector<float> Z{0};
+  std::vector<uint8_t> M(37, 2);
+  std::vector<float> R(37, -7);
+  std::map<std::string, void*> buffers{{"X", X.data()}, {"Z", Z.data()}, {"M", M.data()}, {"R", R.data()}};
+  JitExecute(*block, buffers);
+
+  for (size_t i = 0; i < X.size(); ++i) {
+    if (i < 3 || i > 30) {
+      EXPECT_THAT(M[i], Eq(2));
+      EXPECT_THAT(R[i], Eq(-7));
+    } else {
+      EXPECT_THAT(M[i], Eq(X[i] < 0 ? 1 : 0));
+      EXPECT_THAT(R[i], Eq(std::max(X[i], 0.0f)));
+    }
+  }
+}
+
+TEST(Jit, JitObjectCacheRoundTrip) {
+  lang::RunInfo runinfo;
+  runinfo.program_name = "matmul";
+  runinfo.code = "function (A[M, K], B[K, N]) -> (C) { C[m, n : M, N] = +(A[m, k] * B[k, n]); }";
+  runinfo.input_shapes.emplace("A", SimpleShape(DataType::FLOAT32, {2, 2}));
+  runinfo.input_shapes.emplace("B", SimpleShape(DataType::FLOAT32, {2, 2}));
+  runinfo.output_shapes.emplace("C", SimpleShape(DataType::FLOAT32, {2, 2}));
+  auto program = GenerateStripe(runinfo);
+
+  auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  ObjectCache cache(dir);
+  auto key = ObjectCache::ComputeKey("matmul", "");
+  EXPECT_NE(key, ObjectCache::ComputeKey("matmul", "other"));
+  const char weights[] = "abcd";
+  EXPECT_NE(key, ObjectCache::ComputeKey("matmul", "", {{"W", weights, 4}}));
+  EXPECT_NE(ObjectCache::ComputeKey("matmul", "", {{"W", weights, 4}}),
+            ObjectCache::ComputeKey("matmul", "", {{"W", weights, 3}}));
+
+  Native compiled;
+  EXPECT_FALSE(compiled.load(cache, key));
+  compiled.compile(*program->entry, Config{});
+  compiled.store(cache, key);
+
+  Native loaded;
+  ASSERT_TRUE(loaded.load(cache, key));
+  std::vector<float> A{1, 2, 3, 4};
+  std::vector<float> B{5, 6, 7, 8};
+  std::vector<float> C{0, 0, 0, 0};
+  std::map<std::string, void*> data{{"A", A.data()}, {"B", B.data()}, {"C", C.data()}};
+  loaded.run(data);
+  EXPECT_THAT(C, ContainerEq(std::vector<float>{19, 22, 43, 50}));
+
+  boost::filesystem::remove_all(dir);
+}
+
+TEST(Jit, JitObjectCacheRejectsCorruptEntries) {
+  auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  ObjectCache cache(dir);
+  auto key = ObjectCache::ComputeKey("corrupt", "");
+  auto path = (dir / (key + ".obj")).string();
+
+  CachedObject entry;
+  entry.parameters = {"A", "B"};
+  entry.object = "object code";
+  entry.xsmm_kernels.resize(1);
+  entry.constants = {{"T", "contents"}};
+  cache.Store(key, entry);
+  CachedObject loaded;
+  ASSERT_TRUE(cache.Load(key, &loaded));
+  EXPECT_THAT(loaded.parameters, ContainerEq(entry.parameters));
+  EXPECT_THAT(loaded.constants, ContainerEq(entry.constants));
+
+  // Rewrites the stored entry with a 64-bit value at the given offset, or truncates it there.
+  std::string original;
+  {
+    std::ifstream in(path, std::ios::binary);
+    original.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+  auto rewrite = [&](size_t offset, const uint64_t* value) {
+    auto contents = original.substr(0, value ? original.size() : offset);
+    if (value) {
+      std::memcpy(&contents[offset], value, sizeof(*value));
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(contents.data(), contents.size());
+  };
+
+  // The magic is followed by the parameter count, then the size of the first parameter name.
+  constexpr size_t kNumParams = 12;
+  constexpr size_t kFirstParam = kNumParams + sizeof(uint64_t);
+  const uint64_t huge = uint64_t{1} << 62;
+  for (uint64_t value : {uint64_t{3}, huge, ~uint64_t{0}}) {
+    rewrite(kNumParams, &value);
+    EXPECT_FALSE(cache.Load(key, &loaded)) << "parameter count " << value;
+  }
+  for (uint64_t value : {uint64_t{1} << 20, huge, ~uint64_t{0}}) {
+    rewrite(kFirstParam, &value);
+    EXPECT_FALSE(cache.Load(key, &loaded)) << "parameter size " << value;
+  }
+  // The kernel count follows the parameters and the arena size.
+  size_t num_kernels = kFirstParam + 2 * (sizeof(uint64_t) + 1) + sizeof(uint64_t);
+  for (uint64_t value : {uint64_t{2}, huge}) {
+    rewrite(num_kernels, &value);
+    EXPECT_FALSE(cache.Load(key, &loaded)) << "kernel count " << value;
+  }
+  // The constant count follows the kernels and the parallel block count.
+  size_t num_constants = num_kernels + sizeof(uint64_t) + 9 * sizeof(int32_t) + sizeof(uint64_t);
+  for (uint64_t value : {uint64_t{3}, huge}) {
+    rewrite(num_constants, &value);
+    EXPECT_FALSE(cache.Load(key, &loaded)) << "constant count " << value;
+  }
+  for (size_t size = 0; size < original.size(); ++size) {
+    rewrite(size, nullptr);
+    EXPECT_FALSE(cache.Load(key, &loaded)) << "truncated to " << size;
+  }
+
+  // The entries that failed to load left the output alone.
+  EXPECT_THAT(loaded.parameters, ContainerEq(entry.parameters));
+  boost::filesystem::remove_all(dir);
+}
+
 }  // namespace test
 }  // namespace cpu
 }  // namespace targets
@@ -0,0 +1,192 @@
+// Copyright 2020, Intel Corp.
+
+#include <gmock/gmock.h>
+#include <google/protobuf/text_format.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include <boost/format.hpp>
+
+#include "tile/stripe/stripe.h"
+#include "tile/stripe/stripe.pb.h"
+#include "tile/targets/cpu/jit.h"
+
+namespace gp = google::protobuf;
+
+using ::testing::ContainerEq;
+using ::testing::Eq;
+
+namespace vertexai {
+namespace tile {
+namespace targets {
+namespace cpu {
+namespace test {
+
+// The vector approximations promise a few ulp of the correctly rounded result.
+constexpr int64_t kMaxUlp = 4;
+
+// Runs O[i] = name(X[i]) for every element of X.  The size is deliberately left to the caller, so that both the full
+// vectors and the masked remainder are exercised.
+static std::vector<float> RunUnary(const std::string& name, std::vector<float> X) {
+  auto code = boost::format(R"(
+    loc {}
+    idxs { name: "i" range: %1% }
+    refs [
+      {
+        key: "X"
+        value {
+          attrs: { key: "user" value: {} }
+          dir: 1
+          interior_shape { type: FLOAT32 dims: {size:%1% stride:1} }
+          access { terms {key:"i" value:1} }
+        }
+      },
+      {
+        key: "O"
+        value {
+          attrs: { key: "user" value: {} }
+          dir: 2
+          interior_shape { type: FLOAT32 dims: {size:%1% stride:1} }
+          access { terms {key:"i" value:1} }
+        }
+      }
+    ]
+    stmts { load { from:"X" into:"$X" } }
+    stmts { intrinsic { name:"%2%" type:FLOAT32 inputs:"$X" outputs:"$O" } }
+    stmts { store { from:"$O" into:"O"} }
+  )") % X.size() % name;
+  stripe::proto::Block input_proto;
+  gp::TextFormat::ParseFromString(code.str(), &input_proto);
+  std::shared_ptr<stripe::Block> block{stripe::FromProto(input_proto)};
+
+  std::vector<float> O(X.size(), 0);
+  std::map<std::string, void*> buffers{{"X", X.data()}, {"O", O.data()}};
+  JitExecute(*block, buffers);
+  return O;
+}
+
+// The distance between two finite floats, in units in the last place.
+static int64_t UlpDistance(float a, float b) {
+  auto ordered = [](float value) {
+    int32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits < 0 ? static_cast<int64_t>(INT32_MIN) - bits : static_cast<int64_t>(bits);
+  };
+  return std::abs(ordered(a) - ordered(b));
+}
+
+// Inputs spread over [lo, hi], plus a few either side of zero.
+static std::vector<float> Sweep(float lo, float hi, size_t count) {
+  std::vector<float> ret;
+  for (size_t i = 0; i < count; ++i) {
+    ret.push_back(lo + (hi - lo) * i / (count - 1));
+  }
+  for (float tiny : {1e-3f, 1e-7f, 1e-30f}) {
+    if (lo < tiny && tiny < hi) {
+      ret.push_back(tiny);
+      ret.push_back(-tiny);
+    }
+  }
+  return ret;
+}
+
+static void ExpectAccurate(const std::string& name, double (*reference)(double), const std::vector<float>& X) {
+  auto O = RunUnary(name, X);
+  for (size_t i = 0; i < X.size(); ++i) {
+    float expected = static_cast<float>(reference(X[i]));
+    EXPECT_LE(UlpDistance(O[i], expected), kMaxUlp) << name << "(" << X[i] << ") = " << O[i] << ", not " << expected;
+  }
+}
+
+TEST(VectorMath, ExpAccuracy) {
+  // Covers the whole range in which the result is a normal float.
+  ExpectAccurate("exp", std::exp, Sweep(-87.0f, 88.0f, 4001));
+}
+
+TEST(VectorMath, LogAccuracy) {
+  std::vector<float> X = Sweep(1e-3f, 1e3f, 4001);
+  for (float x = 1e-38f; x < 1e38f; x *= 3.7f) {
+    X.push_back(x);
+  }
+  X.push_back(std::numeric_limits<float>::max());
+  X.push_back(std::numeric_limits<float>::min());
+  X.push_back(std::numeric_limits<float>::denorm_min());
+  X.push_back(std::numeric_limits<float>::min() / 3);
+  ExpectAccurate("log", std::log, X);
+}
+
+TEST(VectorMath, TanhAccuracy) { ExpectAccurate("tanh", std::tanh, Sweep(-12.0f, 12.0f, 4001)); }
+
+TEST(VectorMath, SpecialValues) {
+  constexpr float inf = std::numeric_limits<float>::infinity();
+  constexpr float nan = std::numeric_limits<float>::quiet_NaN();
+
+  auto exp = RunUnary("exp", {-inf, inf, nan, 89.0f, -110.0f, 0.0f});
+  EXPECT_THAT(exp[0], Eq(0.0f));
+  EXPECT_THAT(exp[1], Eq(inf));
+  EXPECT_TRUE(std::isnan(exp[2]));
+  EXPECT_THAT(exp[3], Eq(inf));
+  EXPECT_THAT(exp[4], Eq(0.0f));
+  EXPECT_THAT(exp[5], Eq(1.0f));
+
+  auto log = RunUnary("log", {0.0f, -0.0f, -1.0f, inf, nan, 1.0f});
+  EXPECT_THAT(log[0], Eq(-inf));
+  EXPECT_THAT(log[1], Eq(-inf));
+  EXPECT_TRUE(std::isnan(log[2]));
+  EXPECT_THAT(log[3], Eq(inf));
+  EXPECT_TRUE(std::isnan(log[4]));
+  EXPECT_THAT(log[5], Eq(0.0f));
+
+  auto tanh = RunUnary("tanh", {-inf, inf, nan, 0.0f, -0.0f, 50.0f});
+  EXPECT_THAT(tanh[0], Eq(-1.0f));
+  EXPECT_THAT(tanh[1], Eq(1.0f));
+  EXPECT_TRUE(std::isnan(tanh[2]));
+  EXPECT_THAT(tanh[3], Eq(0.0f));
+  EXPECT_TRUE(std::signbit(tanh[4]));
+  EXPECT_THAT(tanh[5], Eq(1.0f));
+}
+
+TEST(VectorMath, MaskedIntegerDivision) {
+  // O[i] = 100 / (19 - i) over i < 19: the lanes past the end of the masked remainder would divide by zero.
+  stripe::proto::Block input_proto;
+  gp::TextFormat::ParseFromString(R"(
+    loc {}
+    idxs { name: "i" range: 19 }
+    refs [
+      {
+        key: "O"
+        value {
+          attrs: { key: "user" value: {} }
+          dir: 2
+          interior_shape { type: INT32 dims: {size:19 stride:1} }
+          access { terms {key:"i" value:1} }
+        }
+      }
+    ]
+    stmts { constant { name: "$n" iconst: 100 } }
+    stmts { load_index { from { offset: 19 terms {key:"i" value:-1} } into: "$d" } }
+    stmts { intrinsic { name:"div" type:INT32 inputs:"$n" inputs:"$d" outputs:"$q" } }
+    stmts { store { from:"$q" into:"O"} }
+  )",
+                                  &input_proto);
+  std::shared_ptr<stripe::Block> block{stripe::FromProto(input_proto)};
+
+  std::vector<int32_t> O(19, 0);
+  std::map<std::string, void*> buffers{{"O", O.data()}};
+  JitExecute(*block, buffers);
+
+  std::vector<int32_t> expected;
+  for (int32_t i = 0; i < 19; ++i) {
+    expected.push_back(100 / (19 - i));
+  }
+  EXPECT_THAT(O, ContainerEq(expected));
+}
+
+}  // namespace test
+}  // namespace cpu
+}  // namespace targets
+}  // namespace tile
+}  // namespace vertexai
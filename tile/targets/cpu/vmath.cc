@@ -0,0 +1,173 @@
+// Copyright 2020, Intel Corp.
+
+#include "tile/targets/cpu/vmath.h"
+
+#include <llvm/IR/Intrinsics.h>
+
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <map>
+
+namespace vertexai {
+namespace tile {
+namespace targets {
+namespace cpu {
+
+namespace {
+
+using Emitter = std::function<llvm::Value*(llvm::IRBuilder<>*, llvm::Module*, llvm::Value*)>;
+
+constexpr double kInf = std::numeric_limits<double>::infinity();
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+llvm::Constant* FloatConst(llvm::Type* type, double value) { return llvm::ConstantFP::get(type, value); }
+
+llvm::Constant* IntConst(llvm::Type* type, uint64_t value) { return llvm::ConstantInt::get(type, value); }
+
+llvm::Type* IntType(llvm::Type* type) { return llvm::VectorType::getInteger(llvm::cast<llvm::VectorType>(type)); }
+
+llvm::Value* CallIntrinsic(llvm::IRBuilder<>* builder, llvm::Module* module, llvm::Intrinsic::ID id,
+                           llvm::Value* x) {
+  auto func = llvm::Intrinsic::getDeclaration(module, id, {x->getType()});
+  return builder->CreateCall(func, {x});
+}
+
+// Evaluates a polynomial by Horner's rule; coefficients run from the highest degree to the constant term.
+llvm::Value* Horner(llvm::IRBuilder<>* builder, llvm::Value* x, std::initializer_list<double> coeffs) {
+  auto type = x->getType();
+  auto it = coeffs.begin();
+  llvm::Value* poly = FloatConst(type, *it++);
+  for (; it != coeffs.end(); ++it) {
+    poly = builder->CreateFAdd(builder->CreateFMul(poly, x), FloatConst(type, *it));
+  }
+  return poly;
+}
+
+// Returns y * 2^n for an integer vector n in [-150, 128], scaling by two normal powers of two in turn so that neither
+// overflows nor underflows on its own.
+llvm::Value* Ldexp(llvm::IRBuilder<>* builder, llvm::Value* y, llvm::Value* n) {
+  auto itype = n->getType();
+  auto half = builder->CreateAShr(n, IntConst(itype, 1));
+  auto rest = builder->CreateSub(n, half);
+  auto scale = [&](llvm::Value* e) {
+    auto bits = builder->CreateShl(builder->CreateAdd(e, IntConst(itype, 127)), IntConst(itype, 23));
+    return builder->CreateBitCast(bits, y->getType());
+  };
+  return builder->CreateFMul(builder->CreateFMul(y, scale(half)), scale(rest));
+}
+
+llvm::Value* ExpF32(llvm::IRBuilder<>* builder, llvm::Module* module, llvm::Value* x) {
+  auto type = x->getType();
+  // Beyond these bounds the result is respectively infinite and zero.
+  auto hi = FloatConst(type, 88.72283935546875);
+  auto lo = FloatConst(type, -103.97207708399179);
+  auto clamped = builder->CreateSelect(builder->CreateFCmpOGT(x, hi), hi, x);
+  clamped = builder->CreateSelect(builder->CreateFCmpOLT(clamped, lo), lo, clamped);
+  // Reduce x = n*ln(2) + r, with |r| <= ln(2)/2; ln(2) is split in two so that n*ln(2) is exact.
+  auto fx = builder->CreateFAdd(builder->CreateFMul(clamped, FloatConst(type, 1.44269504088896341)),
+                                FloatConst(type, 0.5));
+  auto n = CallIntrinsic(builder, module, llvm::Intrinsic::floor, fx);
+  auto r = builder->CreateFSub(clamped, builder->CreateFMul(n, FloatConst(type, 0.693359375)));
+  r = builder->CreateFSub(r, builder->CreateFMul(n, FloatConst(type, -2.12194440e-4)));
+  auto poly = Horner(builder, r,
+                     {1.9875691500E-4, 1.3981999507E-3, 8.3334519073E-3, 4.1665795894E-2, 1.6666665459E-1,
+                      5.0000001201E-1});
+  auto y = builder->CreateFAdd(builder->CreateFAdd(builder->CreateFMul(poly, builder->CreateFMul(r, r)), r),
+                               FloatConst(type, 1.0));
+  auto ret = Ldexp(builder, y, builder->CreateFPToSI(n, IntType(type)));
+  ret = builder->CreateSelect(builder->CreateFCmpOGT(x, hi), FloatConst(type, kInf), ret);
+  ret = builder->CreateSelect(builder->CreateFCmpOLT(x, lo), FloatConst(type, 0.0), ret);
+  return builder->CreateSelect(builder->CreateFCmpUNO(x, x), x, ret);
+}
+
+llvm::Value* LogF32(llvm::IRBuilder<>* builder, llvm::Module* module, llvm::Value* x) {
+  auto type = x->getType();
+  auto itype = IntType(type);
+  // Bring denormal inputs into the normal range, so that the exponent can be read directly from the bits.
+  auto tiny = builder->CreateFCmpOLT(x, FloatConst(type, std::numeric_limits<float>::min()));
+  auto scaled = builder->CreateSelect(tiny, builder->CreateFMul(x, FloatConst(type, 8388608.0)), x);
+  auto bias = builder->CreateSelect(tiny, IntConst(itype, 126 + 23), IntConst(itype, 126));
+  // Split x = m * 2^e, with m in [sqrt(0.5), sqrt(2)).
+  auto bits = builder->CreateBitCast(scaled, itype);
+  auto e = builder->CreateSub(builder->CreateLShr(bits, IntConst(itype, 23)), bias);
+  auto mbits = builder->CreateOr(builder->CreateAnd(bits, IntConst(itype, 0x807FFFFF)), IntConst(itype, 0x3F000000));
+  auto m = builder->CreateBitCast(mbits, type);
+  auto small = builder->CreateFCmpOLT(m, FloatConst(type, 0.707106781186547524));
+  auto fe = builder->CreateSIToFP(builder->CreateSelect(small, builder->CreateSub(e, IntConst(itype, 1)), e), type);
+  auto f = builder->CreateFSub(builder->CreateSelect(small, builder->CreateFAdd(m, m), m), FloatConst(type, 1.0));
+  auto z = builder->CreateFMul(f, f);
+  auto poly = Horner(builder, f,
+                     {7.0376836292E-2, -1.1514610310E-1, 1.1676998740E-1, -1.2420140846E-1, 1.4249322787E-1,
+                      -1.6668057665E-1, 2.0000714765E-1, -2.4999993993E-1, 3.3333331174E-1});
+  auto y = builder->CreateFMul(builder->CreateFMul(poly, f), z);
+  y = builder->CreateFAdd(y, builder->CreateFMul(fe, FloatConst(type, -2.12194440e-4)));
+  y = builder->CreateFSub(y, builder->CreateFMul(z, FloatConst(type, 0.5)));
+  auto ret = builder->CreateFAdd(builder->CreateFAdd(f, y), builder->CreateFMul(fe, FloatConst(type, 0.693359375)));
+  ret = builder->CreateSelect(builder->CreateFCmpOEQ(x, FloatConst(type, 0.0)), FloatConst(type, -kInf), ret);
+  ret = builder->CreateSelect(builder->CreateFCmpOLT(x, FloatConst(type, 0.0)), FloatConst(type, kNaN), ret);
+  ret = builder->CreateSelect(builder->CreateFCmpOEQ(x, FloatConst(type, kInf)), x, ret);
+  return builder->CreateSelect(builder->CreateFCmpUNO(x, x), x, ret);
+}
+
+llvm::Value* TanhF32(llvm::IRBuilder<>* builder, llvm::Module* module, llvm::Value* x) {
+  auto type = x->getType();
+  auto ax = CallIntrinsic(builder, module, llvm::Intrinsic::fabs, x);
+  // Near zero, an odd polynomial; elsewhere, 1 - 2 / (exp(2|x|) + 1) with the sign of x.
+  auto z = builder->CreateFMul(x, x);
+  auto poly = Horner(builder, z,
+                     {-5.70498872745E-3, 2.06390887954E-2, -5.37397155531E-2, 1.33314422036E-1, -3.33332819422E-1});
+  auto small = builder->CreateFAdd(builder->CreateFMul(builder->CreateFMul(poly, z), x), x);
+  auto e = ExpF32(builder, module, builder->CreateFAdd(ax, ax));
+  auto denom = builder->CreateFAdd(e, FloatConst(type, 1.0));
+  auto large = builder->CreateFSub(FloatConst(type, 1.0), builder->CreateFDiv(FloatConst(type, 2.0), denom));
+  large = builder->CreateSelect(builder->CreateFCmpOLT(x, FloatConst(type, 0.0)), builder->CreateFNeg(large), large);
+  return builder->CreateSelect(builder->CreateFCmpOLT(ax, FloatConst(type, 0.625)), small, large);
+}
+
+Emitter LlvmIntrinsic(llvm::Intrinsic::ID id) {
+  return [id](llvm::IRBuilder<>* builder, llvm::Module* module, llvm::Value* x) {
+    return CallIntrinsic(builder, module, id, x);
+  };
+}
+
+}  // namespace
+
+llvm::Value* EmitVectorMath(llvm::IRBuilder<>* builder, llvm::Module* module, const std::string& name,
+                            const std::vector<llvm::Value*>& args) {
+  // Functions LLVM lowers to vector instructions directly, for any floating-point element type.
+  static std::map<std::string, Emitter> any_float{
+      {"sqrtf", LlvmIntrinsic(llvm::Intrinsic::sqrt)},    //
+      {"sqrt", LlvmIntrinsic(llvm::Intrinsic::sqrt)},     //
+      {"floorf", LlvmIntrinsic(llvm::Intrinsic::floor)},  //
+      {"floor", LlvmIntrinsic(llvm::Intrinsic::floor)},   //
+      {"ceilf", LlvmIntrinsic(llvm::Intrinsic::ceil)},    //
+      {"ceil", LlvmIntrinsic(llvm::Intrinsic::ceil)},     //
+      {"roundf", LlvmIntrinsic(llvm::Intrinsic::round)},  //
+      {"round", LlvmIntrinsic(llvm::Intrinsic::round)},   //
+  };
+  // Functions implemented here, for single-precision elements only.
+  static std::map<std::string, Emitter> f32_only{
+      {"expf", ExpF32},
+      {"logf", LogF32},
+      {"tanhf", TanhF32},
+  };
+  if (args.size() != 1 || !args[0]->getType()->isVectorTy()) {
+    return nullptr;
+  }
+  auto x = args[0];
+  auto it = any_float.find(name);
+  if (it != any_float.end()) {
+    return it->second(builder, module, x);
+  }
+  it = f32_only.find(name);
+  if (it != f32_only.end() && x->getType()->getScalarType()->isFloatTy()) {
+    return it->second(builder, module, x);
+  }
+  return nullptr;
+}
+
+}  // namespace cpu
+}  // namespace targets
+}  // namespace tile
+}  // namespace vertexai
@@ -0,0 +1,28 @@
+// Copyright 2020, Intel Corp.
+
+#pragma once
+
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+
+#include <string>
+#include <vector>
+
+namespace vertexai {
+namespace tile {
+namespace targets {
+namespace cpu {
+
+// Emits a vectorized implementation of the C math library function `name`, applied lane-wise to the vector operands
+// in `args`.  Returns nullptr if there is no vectorized implementation for the function and operand type, in which
+// case the caller must fall back to calling the scalar function once per lane.
+//
+// The single-precision exp, log, and tanh implementations are polynomial approximations (after Cephes) accurate to a
+// few ulp over the whole range, including infinities, NaNs, and denormals.
+llvm::Value* EmitVectorMath(llvm::IRBuilder<>* builder, llvm::Module* module, const std::string& name,
+                            const std::vector<llvm::Value*>& args);
+
+}  // namespace cpu
+}  // namespace targets
+}  // namespace tile
+}  // namespace vertexai